@@ -0,0 +1,568 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "concurrent_buffers.h"
+#include "expected.h"
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <stop_token>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>) && !defined(GHPL_NO_IO_URING)
+#define GHPL_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#else
+#define GHPL_HAS_IO_URING 0
+#endif
+
+#define GHPL_HAS_ASYNC_FILES
+
+namespace ghassanpl
+{
+	/// \defgroup AsyncFiles Batched file loading
+	/// Loading many files at once, using io_uring on Linux and a thread pool elsewhere
+	/// @{
+
+	/// Called for every loaded file with the index of its path in the input, its contents, and an error (if any).
+	/// \attention `contents` is only valid for the duration of the call - the memory is reused for subsequent files
+	template <typename T>
+	concept file_load_callback = std::invocable<T, size_t, std::span<char const>, std::error_code>;
+
+	struct batch_file_loader_options
+	{
+		/// The maximum number of reads in flight at once
+		size_t queue_depth = 64;
+		/// The size of each pre-registered read buffer; bigger files get a buffer of their own
+		size_t buffer_size = 256 * 1024;
+		/// The number of worker threads used when io_uring is unavailable (0 means `std::thread::hardware_concurrency()`)
+		size_t fallback_threads = 0;
+		/// Don't use io_uring even if it is available
+		bool force_fallback = false;
+	};
+
+	namespace detail
+	{
+#if GHPL_HAS_IO_URING
+		/// A minimal io_uring wrapper using the raw system calls, so we don't depend on liburing
+		struct io_uring_ring
+		{
+			io_uring_ring() noexcept = default;
+			io_uring_ring(io_uring_ring const&) = delete;
+			io_uring_ring& operator=(io_uring_ring const&) = delete;
+			~io_uring_ring() { close(); }
+
+			void open(unsigned entries, std::error_code& error) noexcept
+			{
+				error.clear();
+				io_uring_params params{};
+				const auto fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+				if (fd < 0)
+				{
+					error.assign(errno, std::system_category());
+					return;
+				}
+				m_fd = fd;
+
+				m_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+				m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+				const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+				if (single_mmap)
+					m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+
+				m_sq_ptr = ::mmap(nullptr, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+				if (m_sq_ptr == MAP_FAILED) { m_sq_ptr = nullptr; return fail(error); }
+				if (single_mmap)
+					m_cq_ptr = m_sq_ptr;
+				else
+				{
+					m_cq_ptr = ::mmap(nullptr, m_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+					if (m_cq_ptr == MAP_FAILED) { m_cq_ptr = nullptr; return fail(error); }
+				}
+				m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+				m_sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+				if (m_sqes == MAP_FAILED) { m_sqes = nullptr; return fail(error); }
+
+				const auto sq = static_cast<char*>(m_sq_ptr);
+				m_sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+				m_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+				m_sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+				m_sq_entries = params.sq_entries;
+				m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+				const auto cq = static_cast<char*>(m_cq_ptr);
+				m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+				m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+				m_cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+				m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+			}
+
+			void register_buffers(std::span<iovec const> buffers, std::error_code& error) noexcept
+			{
+				error.clear();
+				if (::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS, buffers.data(), unsigned(buffers.size())) < 0)
+					error.assign(errno, std::system_category());
+			}
+
+			/// \returns a zeroed submission queue entry, or `nullptr` if the queue is full
+			io_uring_sqe* next_sqe() noexcept
+			{
+				const auto head = std::atomic_ref{ *m_sq_head }.load(std::memory_order_acquire);
+				const auto tail = m_local_tail;
+				if (tail - head >= m_sq_entries)
+					return nullptr;
+				const auto index = tail & m_sq_mask;
+				m_sq_array[index] = index;
+				++m_local_tail;
+				auto sqe = &m_sqes[index];
+				*sqe = {};
+				return sqe;
+			}
+
+			/// Submits all prepared entries and waits for at least `wait_for` completions
+			void submit_and_wait(unsigned wait_for, std::error_code& error) noexcept
+			{
+				error.clear();
+				auto tail = std::atomic_ref{ *m_sq_tail };
+				const auto to_submit = m_local_tail - tail.load(std::memory_order_relaxed);
+				tail.store(m_local_tail, std::memory_order_release);
+				while (::syscall(__NR_io_uring_enter, m_fd, to_submit, wait_for, wait_for ? IORING_ENTER_GETEVENTS : 0, nullptr, 0) < 0)
+				{
+					if (errno != EINTR)
+					{
+						error.assign(errno, std::system_category());
+						return;
+					}
+				}
+			}
+
+			/// Calls `func` with every available completion; each one is consumed before `func` is called, so if `func` throws,
+			/// it will not be seen again
+			template <typename FUNC>
+			void for_each_completion(FUNC&& func)
+			{
+				auto head = *m_cq_head;
+				const auto tail = std::atomic_ref{ *m_cq_tail }.load(std::memory_order_acquire);
+				while (head != tail)
+				{
+					const auto cqe = m_cqes[head & m_cq_mask];
+					std::atomic_ref{ *m_cq_head }.store(++head, std::memory_order_release);
+					func(cqe);
+				}
+			}
+
+		private:
+
+			void fail(std::error_code& error) noexcept
+			{
+				error.assign(errno, std::system_category());
+				close();
+			}
+
+			void close() noexcept
+			{
+				if (m_sqes) ::munmap(m_sqes, m_sqes_size);
+				if (m_cq_ptr && m_cq_ptr != m_sq_ptr) ::munmap(m_cq_ptr, m_cq_size);
+				if (m_sq_ptr) ::munmap(m_sq_ptr, m_sq_size);
+				if (m_fd >= 0) ::close(m_fd);
+				m_sqes = nullptr;
+				m_cq_ptr = m_sq_ptr = nullptr;
+				m_fd = -1;
+			}
+
+			int m_fd = -1;
+			void* m_sq_ptr = nullptr;
+			void* m_cq_ptr = nullptr;
+			size_t m_sq_size = 0;
+			size_t m_cq_size = 0;
+			size_t m_sqes_size = 0;
+
+			unsigned* m_sq_head = nullptr;
+			unsigned* m_sq_tail = nullptr;
+			unsigned* m_sq_array = nullptr;
+			unsigned m_sq_mask = 0;
+			unsigned m_sq_entries = 0;
+			unsigned m_local_tail = 0;
+			io_uring_sqe* m_sqes = nullptr;
+
+			unsigned* m_cq_head = nullptr;
+			unsigned* m_cq_tail = nullptr;
+			unsigned m_cq_mask = 0;
+			io_uring_cqe* m_cqes = nullptr;
+		};
+#endif
+
+		inline std::error_code read_whole_file(std::filesystem::path const& path, std::string& contents) noexcept
+		{
+			contents.clear();
+			std::error_code error;
+			const auto size = std::filesystem::file_size(path, error);
+			if (error)
+				return error;
+#ifdef _WIN32
+			std::FILE* file = ::_wfopen(path.c_str(), L"rb");
+#else
+			std::FILE* file = std::fopen(path.c_str(), "rb");
+#endif
+			if (!file)
+				return std::error_code{ errno, std::generic_category() };
+			try { contents.resize(size); }
+			catch (...) { std::fclose(file); return std::make_error_code(std::errc::not_enough_memory); }
+			contents.resize(std::fread(contents.data(), 1, contents.size(), file));
+			if (std::ferror(file))
+				error = std::make_error_code(std::errc::io_error);
+			std::fclose(file);
+			return error;
+		}
+	}
+
+	/// Loads many files at once, calling a callback (on the calling thread) as each one completes.
+	///
+	/// On Linux, this uses a single io_uring: up to `queue_depth` files are read at once, straight into pre-registered buffers,
+	/// with one system call per batch of completions. If io_uring is unavailable (other OSes, old kernels, or when forbidden by seccomp policy),
+	/// files are read by a pool of worker threads instead, and handed over to the calling thread through a \ref mpmc_queue.
+	///
+	/// Reusing the same loader for subsequent batches reuses the ring and the registered buffers.
+	///
+	/// \note Completions are only delivered to callbacks; there is no coroutine interface, as the callback form can be wrapped by whichever
+	/// coroutine library the caller uses. Only reading is batched; files are still written with the blocking `save_file` functions.
+	struct batch_file_loader
+	{
+		explicit batch_file_loader(batch_file_loader_options options = {})
+			: m_options(options)
+		{
+			m_options.queue_depth = std::clamp<size_t>(m_options.queue_depth, 1, 4096);
+			m_options.buffer_size = std::max<size_t>(m_options.buffer_size, 4096);
+#if GHPL_HAS_IO_URING
+			if (!m_options.force_fallback)
+				init_ring();
+#endif
+		}
+
+		batch_file_loader(batch_file_loader const&) = delete;
+		batch_file_loader& operator=(batch_file_loader const&) = delete;
+
+		/// \returns true if files are loaded using io_uring
+		[[nodiscard]] bool uses_io_uring() const noexcept { return m_uses_io_uring; }
+
+		/// Loads all the files in `paths`, calling `callback` (on the calling thread) for each one, in completion order.
+		/// If `callback` throws, the reads still in flight are waited for (and their results dropped) before the exception is rethrown.
+		template <file_load_callback CALLBACK>
+		void load_files(std::span<std::filesystem::path const> paths, CALLBACK&& callback)
+		{
+#if GHPL_HAS_IO_URING
+			if (m_uses_io_uring)
+			{
+				try { load_with_io_uring(paths, callback); }
+				catch (...)
+				{
+					drain_ring();
+					throw;
+				}
+				return;
+			}
+#endif
+			load_with_threads(paths, callback);
+		}
+
+		/// Loads the contents of all the files in `paths`
+		/// \returns the contents of (or the error that occured when loading) each file, in the same order as `paths`
+		[[nodiscard]] std::vector<expected<std::string, std::error_code>> load_files(std::span<std::filesystem::path const> paths)
+		{
+			std::vector<expected<std::string, std::error_code>> result(paths.size());
+			load_files(paths, [&](size_t index, std::span<char const> contents, std::error_code error) {
+				if (error)
+					result[index] = unexpected(error);
+				else
+					result[index] = std::string{ contents.begin(), contents.end() };
+			});
+			return result;
+		}
+
+	private:
+
+		template <typename CALLBACK>
+		void load_with_threads(std::span<std::filesystem::path const> paths, CALLBACK& callback)
+		{
+			struct completion
+			{
+				size_t index = 0;
+				std::string contents;
+				std::error_code error;
+			};
+
+			const auto thread_count = std::min(paths.size(), m_options.fallback_threads ? m_options.fallback_threads : std::max(1u, std::thread::hardware_concurrency()));
+			mpmc_queue<completion> completed{ m_options.queue_depth };
+			std::atomic<size_t> next_index = 0;
+
+			{
+				/// If `callback` throws, destroying the workers asks them to stop, so they don't wait forever on a full queue
+				std::vector<std::jthread> workers;
+				workers.reserve(thread_count);
+				for (size_t i = 0; i < thread_count; ++i)
+				{
+					workers.emplace_back([&](std::stop_token stop) {
+						for (auto index = next_index++; index < paths.size() && !stop.stop_requested(); index = next_index++)
+						{
+							completion done{ index, {}, {} };
+							done.error = detail::read_whole_file(paths[index], done.contents);
+							while (!completed.try_push(std::move(done)))
+							{
+								if (stop.stop_requested())
+									return;
+								std::this_thread::yield();
+							}
+						}
+					});
+				}
+
+				for (size_t received = 0; received < paths.size(); )
+				{
+					if (auto done = completed.try_pop())
+					{
+						callback(done->index, std::span<char const>{ done->contents }, done->error);
+						++received;
+					}
+					else
+						std::this_thread::yield();
+				}
+			}
+		}
+
+#if GHPL_HAS_IO_URING
+		void init_ring() noexcept
+		{
+			std::error_code error;
+			m_ring.open(unsigned(std::bit_ceil(m_options.queue_depth)), error);
+			if (error)
+				return;
+
+			m_buffers.reset(new (std::align_val_t{ 4096 }, std::nothrow) char[m_options.queue_depth * m_options.buffer_size]);
+			if (!m_buffers)
+				return;
+			std::vector<iovec> iovecs(m_options.queue_depth);
+			for (size_t i = 0; i < iovecs.size(); ++i)
+				iovecs[i] = { m_buffers.get() + i * m_options.buffer_size, m_options.buffer_size };
+			m_ring.register_buffers(iovecs, error);
+			if (error)
+				return;
+
+			m_slots.resize(m_options.queue_depth);
+			m_uses_io_uring = true;
+		}
+
+		struct read_slot
+		{
+			size_t index = 0;
+			int fd = -1;
+			size_t size = 0;
+			size_t done = 0;
+			std::unique_ptr<char[]> big_buffer; /// for files bigger than `buffer_size`
+			bool busy = false;
+		};
+
+		char* slot_data(size_t slot) noexcept
+		{
+			auto& s = m_slots[slot];
+			return s.big_buffer ? s.big_buffer.get() : m_buffers.get() + slot * m_options.buffer_size;
+		}
+
+		void prepare_read(size_t slot) noexcept
+		{
+			auto& s = m_slots[slot];
+			auto sqe = m_ring.next_sqe(); /// never full; we never have more reads in flight than queue entries
+			sqe->fd = s.fd;
+			sqe->off = s.done;
+			sqe->addr = reinterpret_cast<uint64_t>(slot_data(slot) + s.done);
+			sqe->len = unsigned(std::min<size_t>(s.size - s.done, 1u << 30));
+			sqe->user_data = slot;
+			if (s.big_buffer)
+				sqe->opcode = IORING_OP_READ;
+			else
+			{
+				sqe->opcode = IORING_OP_READ_FIXED;
+				sqe->buf_index = uint16_t(slot);
+			}
+		}
+
+		template <typename CALLBACK>
+		void finish(size_t slot, std::error_code error, CALLBACK& callback)
+		{
+			auto& s = m_slots[slot];
+			::close(s.fd);
+			s.fd = -1;
+			s.busy = false;
+			callback(s.index, std::span<char const>{ slot_data(slot), error ? 0 : s.done }, error);
+			s.big_buffer.reset();
+		}
+
+		template <typename CALLBACK>
+		void load_with_io_uring(std::span<std::filesystem::path const> paths, CALLBACK& callback)
+		{
+			size_t next_path = 0;
+			size_t in_flight = 0;
+			size_t free_slot_hint = 0;
+
+			while (next_path < paths.size() || in_flight > 0)
+			{
+				/// Fill all the free slots
+				for (size_t slot = free_slot_hint; slot < m_slots.size() && next_path < paths.size(); ++slot)
+				{
+					if (m_slots[slot].busy)
+						continue;
+
+					const auto index = next_path++;
+					const int fd = ::open(paths[index].c_str(), O_RDONLY | O_CLOEXEC);
+					struct stat st {};
+					if (fd < 0 || ::fstat(fd, &st) != 0)
+					{
+						const std::error_code error{ errno, std::system_category() };
+						if (fd >= 0) ::close(fd);
+						callback(index, std::span<char const>{}, error);
+						--slot;
+						continue;
+					}
+
+					auto& s = m_slots[slot];
+					s.index = index;
+					s.fd = fd;
+					s.size = size_t(st.st_size);
+					s.done = 0;
+					if (s.size == 0)
+					{
+						s.busy = true;
+						finish(slot, {}, callback);
+						--slot;
+						continue;
+					}
+					if (s.size > m_options.buffer_size)
+						s.big_buffer.reset(new char[s.size]);
+					s.busy = true;
+					prepare_read(slot);
+					++in_flight;
+				}
+				free_slot_hint = m_slots.size();
+
+				if (in_flight == 0)
+					continue;
+
+				std::error_code error;
+				m_ring.submit_and_wait(1, error);
+				if (error)
+				{
+					/// Should not happen, but if it does, finish everything synchronously
+					for (size_t slot = 0; slot < m_slots.size(); ++slot)
+						if (m_slots[slot].busy)
+							finish(slot, error, callback);
+					for (; next_path < paths.size(); ++next_path)
+						callback(next_path, std::span<char const>{}, error);
+					return;
+				}
+
+				m_ring.for_each_completion([&](io_uring_cqe const& cqe) {
+					const auto slot = size_t(cqe.user_data);
+					auto& s = m_slots[slot];
+					if (cqe.res < 0)
+					{
+						finish(slot, std::error_code{ -cqe.res, std::system_category() }, callback);
+						--in_flight;
+					}
+					else if (cqe.res == 0 || (s.done += size_t(cqe.res)) >= s.size) /// a read of 0 means the file got shorter
+					{
+						finish(slot, {}, callback);
+						--in_flight;
+					}
+					else
+						prepare_read(slot); /// short read, read the rest
+					free_slot_hint = std::min(free_slot_hint, slot);
+				});
+			}
+		}
+
+		/// Waits for all the reads still in flight, dropping their results; used when a callback throws, so that the kernel doesn't
+		/// write into buffers that are about to be freed
+		void drain_ring() noexcept
+		{
+			const auto any_busy = [&] { return std::ranges::any_of(m_slots, &read_slot::busy); };
+			while (any_busy())
+			{
+				std::error_code error;
+				m_ring.submit_and_wait(1, error);
+				if (error)
+				{
+					/// The reads can't be waited for, so their buffers are leaked rather than freed under the kernel, and the ring is not used again
+					for (auto& s : m_slots)
+						if (s.busy)
+							(void)s.big_buffer.release();
+					m_uses_io_uring = false;
+					break;
+				}
+				m_ring.for_each_completion([&](io_uring_cqe const& cqe) {
+					auto& s = m_slots[size_t(cqe.user_data)];
+					if (!s.busy)
+						return;
+					::close(s.fd);
+					s.fd = -1;
+					s.busy = false;
+				});
+			}
+
+			for (auto& s : m_slots)
+			{
+				if (s.busy)
+					continue;
+				if (s.fd >= 0)
+					::close(s.fd);
+				s.fd = -1;
+				s.big_buffer.reset();
+			}
+		}
+
+		struct aligned_delete { void operator()(char* ptr) const noexcept { ::operator delete[](ptr, std::align_val_t{ 4096 }); } };
+
+		detail::io_uring_ring m_ring;
+		std::unique_ptr<char[], aligned_delete> m_buffers;
+		std::vector<read_slot> m_slots;
+#endif
+
+		batch_file_loader_options m_options;
+		bool m_uses_io_uring = false;
+	};
+
+	/// Loads all the files in `paths`, calling `callback` (on the calling thread) for each one, in completion order
+	/// \sa batch_file_loader
+	template <file_load_callback CALLBACK>
+	void load_files(std::span<std::filesystem::path const> paths, CALLBACK&& callback, batch_file_loader_options options = {})
+	{
+		batch_file_loader loader{ options };
+		loader.load_files(paths, std::forward<CALLBACK>(callback));
+	}
+
+	/// Loads the contents of all the files in `paths`
+	/// \returns the contents of (or the error that occured when loading) each file, in the same order as `paths`
+	/// \sa batch_file_loader
+	[[nodiscard]] inline std::vector<expected<std::string, std::error_code>> load_files(std::span<std::filesystem::path const> paths, batch_file_loader_options options = {})
+	{
+		batch_file_loader loader{ options };
+		return loader.load_files(paths);
+	}
+
+	/// @}
+}
+
+#ifdef GHPL_HAS_JSON_HELPERS
+#include "json_helpers+async_files.h"
+#endif
@@ -9,6 +9,13 @@
 
 #include "cpp23.h"
 
+#if (defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))) && (defined(__x86_64__) || defined(_M_X64))
+#define GHPL_HAS_BMI2 1
+#include <immintrin.h>
+#else
+#define GHPL_HAS_BMI2 0
+#endif
+
 #if !defined(__cpp_concepts)
 #error "This library requires concepts"
 #endif
@@ -172,6 +179,57 @@ namespace ghassanpl
 		return std::make_pair(most_significant_half(v), least_significant_half(v));
 	}
 
+	/// \name Morton codes
+	/// Z-order curve indices, interleaving the bits of two coordinates. Uses the BMI2 `pdep`/`pext` instructions where available.
+	/// @{
+
+	namespace detail
+	{
+		constexpr uint64_t spread_bits(uint32_t value) noexcept
+		{
+			uint64_t result = value;
+			result = (result | (result << 16)) & 0x0000FFFF0000FFFFull;
+			result = (result | (result << 8)) & 0x00FF00FF00FF00FFull;
+			result = (result | (result << 4)) & 0x0F0F0F0F0F0F0F0Full;
+			result = (result | (result << 2)) & 0x3333333333333333ull;
+			result = (result | (result << 1)) & 0x5555555555555555ull;
+			return result;
+		}
+
+		constexpr uint32_t compact_bits(uint64_t value) noexcept
+		{
+			value &= 0x5555555555555555ull;
+			value = (value | (value >> 1)) & 0x3333333333333333ull;
+			value = (value | (value >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+			value = (value | (value >> 4)) & 0x00FF00FF00FF00FFull;
+			value = (value | (value >> 8)) & 0x0000FFFF0000FFFFull;
+			value = (value | (value >> 16)) & 0x00000000FFFFFFFFull;
+			return uint32_t(value);
+		}
+	}
+
+	/// Returns the Morton code of (`x`, `y`): the bits of `x` in the even bits of the result, the bits of `y` in the odd bits
+	[[nodiscard]] constexpr uint64_t morton_encode(uint32_t x, uint32_t y) noexcept
+	{
+#if GHPL_HAS_BMI2
+		if (!std::is_constant_evaluated())
+			return _pdep_u64(x, 0x5555555555555555ull) | _pdep_u64(y, 0xAAAAAAAAAAAAAAAAull);
+#endif
+		return detail::spread_bits(x) | (detail::spread_bits(y) << 1);
+	}
+
+	/// Returns the coordinates encoded in the Morton code `code`
+	[[nodiscard]] constexpr std::pair<uint32_t, uint32_t> morton_decode(uint64_t code) noexcept
+	{
+#if GHPL_HAS_BMI2
+		if (!std::is_constant_evaluated())
+			return { uint32_t(_pext_u64(code, 0x5555555555555555ull)), uint32_t(_pext_u64(code, 0xAAAAAAAAAAAAAAAAull)) };
+#endif
+		return { detail::compact_bits(code), detail::compact_bits(code >> 1) };
+	}
+
+	/// @}
+
 	/// \name Endianness
 	/// @{
 
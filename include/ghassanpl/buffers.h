@@ -36,7 +36,11 @@ namespace ghassanpl
 	template <typename BUFFER, typename T>
 	bool buffer_append(BUFFER&& buffer, T&& val)
 	{
-		if constexpr (requires { buffer.append(val); })
+		if constexpr (requires { { buffer.try_append(val) } -> std::convertible_to<bool>; }) /// for bounded buffers, like `spsc_queue`
+		{
+			return buffer.try_append(val);
+		}
+		else if constexpr (requires { buffer.append(val); })
 		{
 			buffer.append(val);
 			return true;
@@ -90,7 +94,11 @@ namespace ghassanpl
 		if constexpr (std::ranges::sized_range<RANGE>)
 			buffer_reserve(buffer, std::ranges::size(range));
 
-		if constexpr (requires { buffer.append(std::to_address(std::ranges::begin(range)), std::ranges::size(range)); } && std::ranges::sized_range<RANGE>) /// for strings etc
+		if constexpr (requires { { buffer.try_append(std::to_address(std::ranges::begin(range)), std::ranges::size(range)) } -> std::convertible_to<size_t>; } && std::ranges::sized_range<RANGE>) /// for bounded buffers, like `spsc_byte_ring`
+		{
+			return buffer.try_append(std::to_address(std::ranges::begin(range)), std::ranges::size(range));
+		}
+		else if constexpr (requires { buffer.append(std::to_address(std::ranges::begin(range)), std::ranges::size(range)); } && std::ranges::sized_range<RANGE>) /// for strings etc
 		{
 			const auto size = std::ranges::size(range);
 			buffer.append(std::to_address(std::ranges::begin(range)), size);
@@ -0,0 +1,223 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "pixels.h"
+#include <vector>
+
+namespace ghassanpl
+{
+	/// \ingroup Colors
+	///@{
+
+	/// The color space in which a \ref color_gradient interpolates between its stops
+	enum class gradient_space
+	{
+		/// Directly between the sRGB-encoded colors, like most image editors and CSS (by default) do
+		srgb,
+		/// Between the linear colors; physically correct for light, but dark parts look too short
+		linear,
+		/// Between the OKLab colors; perceived lightness changes evenly, but colors with distant hues meet closer to gray
+		oklab,
+		/// Between the OKLCh colors, going the shorter way around the hue circle; keeps the colors saturated
+		oklch,
+		/// Between the CIELAB colors
+		cielab,
+	};
+
+	struct gradient_stop
+	{
+		float position = 0;
+		color_t color{};
+	};
+
+	namespace detail
+	{
+		[[nodiscard]] inline glm::vec4 ToGradientSpace(color_t const& srgb, gradient_space space)
+		{
+			switch (space)
+			{
+			case gradient_space::linear: return srgb_to_linear(srgb);
+			case gradient_space::oklab: return *to_oklab(srgb_to_linear(srgb));
+			case gradient_space::oklch: return *to_oklch(srgb_to_linear(srgb));
+			case gradient_space::cielab: return *to_lab(srgb_to_linear(srgb));
+			default: return srgb;
+			}
+		}
+
+		[[nodiscard]] inline color_t FromGradientSpace(glm::vec4 const& value, gradient_space space)
+		{
+			switch (space)
+			{
+			case gradient_space::linear: return linear_to_srgb(saturated(value));
+			case gradient_space::oklab: return linear_to_srgb(saturated(to_rgb(color_oklab_t{ value })));
+			case gradient_space::oklch: return linear_to_srgb(saturated(to_rgb(color_oklch_t{ value })));
+			case gradient_space::cielab: return linear_to_srgb(saturated(to_rgb(color_lab_t{ value })));
+			default: return saturated(value);
+			}
+		}
+
+		[[nodiscard]] inline glm::vec4 MixInGradientSpace(glm::vec4 a, glm::vec4 b, float t, gradient_space space)
+		{
+			if (space == gradient_space::oklch)
+			{
+				/// A gray stop has no hue, so it takes the other one's
+				if (a.y <= 1e-6f) a.z = b.z;
+				if (b.y <= 1e-6f) b.z = a.z;
+				if (b.z - a.z > 180.0f) b.z -= 360.0f;
+				else if (a.z - b.z > 180.0f) b.z += 360.0f;
+				auto result = a + (b - a) * t;
+				if (result.z < 0) result.z += 360.0f;
+				return result;
+			}
+			return a + (b - a) * t;
+		}
+	}
+
+	/// A gradient between sRGB-encoded colors (like the ones in \ref colors), with stops at ascending positions in [0, 1], interpolated in a
+	/// chosen \ref gradient_space.
+	///
+	/// All the color space conversions happen once, when the gradient is made: it is sampled into a table of \ref options::resolution
+	/// colors, so sampling it is a table lookup and a linear interpolation between two neighboring entries (or, for packed pixels, a
+	/// lookup of the nearest entry). Positions outside [0, 1] are clamped.
+	class color_gradient
+	{
+	public:
+
+		struct options
+		{
+			gradient_space space = gradient_space::oklab;
+			/// Number of entries in the table; at least 2
+			size_t resolution = 256;
+		};
+
+		explicit color_gradient(std::span<gradient_stop const> stops) : color_gradient(stops, options{}) {}
+
+		color_gradient(std::span<gradient_stop const> stops, options const& opts)
+			: m_options(opts)
+		{
+			if (stops.empty())
+				throw std::invalid_argument("a gradient needs at least one stop");
+			if (m_options.resolution < 2)
+				throw std::invalid_argument("gradient resolution must be at least 2");
+			if (!std::ranges::is_sorted(stops, {}, &gradient_stop::position))
+				throw std::invalid_argument("gradient stops must be in ascending order");
+
+			std::vector<glm::vec4> converted;
+			converted.reserve(stops.size());
+			for (auto const& stop : stops)
+				converted.push_back(detail::ToGradientSpace(stop.color, m_options.space));
+
+			m_table.resize(m_options.resolution);
+			size_t next_stop = 0;
+			for (size_t i = 0; i < m_table.size(); ++i)
+			{
+				const auto position = float(i) / float(m_table.size() - 1);
+				while (next_stop < stops.size() && stops[next_stop].position <= position)
+					++next_stop;
+
+				glm::vec4 value;
+				if (next_stop == 0)
+					value = converted.front();
+				else if (next_stop == stops.size())
+					value = converted.back();
+				else
+				{
+					const auto& from = stops[next_stop - 1];
+					const auto& to = stops[next_stop];
+					const auto t = (position - from.position) / (to.position - from.position);
+					value = detail::MixInGradientSpace(converted[next_stop - 1], converted[next_stop], t, m_options.space);
+				}
+				m_table[i] = detail::FromGradientSpace(value, m_options.space);
+			}
+
+			m_packed_table.resize(m_table.size());
+			pack_pixels(m_table, m_packed_table, detail::float_order);
+			m_scale = float(m_table.size() - 1);
+		}
+
+		/// Makes a gradient with the colors evenly spaced from 0 to 1
+		explicit color_gradient(std::span<color_t const> colors) : color_gradient(colors, options{}) {}
+
+		color_gradient(std::span<color_t const> colors, options const& opts)
+			: color_gradient(EvenlySpaced(colors), opts)
+		{
+		}
+
+		[[nodiscard]] options const& settings() const noexcept { return m_options; }
+		[[nodiscard]] std::span<color_t const> table() const noexcept { return m_table; }
+
+		/// Returns the color at `position`
+		[[nodiscard]] color_t sample(float position) const noexcept
+		{
+			const auto x = Clamped(position) * m_scale;
+			const auto index = std::min(size_t(x), m_table.size() - 2);
+			const auto t = x - float(index);
+			const auto& a = m_table[index];
+			const auto& b = m_table[index + 1];
+			return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t };
+		}
+
+		[[nodiscard]] color_t operator()(float position) const noexcept { return sample(position); }
+
+		/// Fills `out` with the colors at `positions`
+		void fill(std::span<float const> positions, std::span<color_t> out) const
+		{
+			detail::CheckPixelSpans(positions.size(), out.size());
+			for (size_t i = 0; i < positions.size(); ++i)
+				out[i] = sample(positions[i]);
+		}
+
+		/// Fills `out` with the whole gradient, evenly spaced from 0 to 1
+		void fill(std::span<color_t> out) const noexcept
+		{
+			const auto step = out.size() > 1 ? 1.0f / float(out.size() - 1) : 0.0f;
+			for (size_t i = 0; i < out.size(); ++i)
+				out[i] = sample(float(i) * step);
+		}
+
+		/// Fills `out` with the table entries nearest to `positions`, as packed pixels in the given format
+		void fill(std::span<float const> positions, std::span<uint32_t> out, pixel_format format) const
+		{
+			detail::CheckPixelSpans(positions.size(), out.size());
+			const auto permutation = detail::PermutationBetween(detail::float_order, format);
+			size_t i = 0;
+#if GHPL_HAS_AVX2
+			const auto table = reinterpret_cast<int const*>(m_packed_table.data());
+			const auto scale = _mm256_set1_ps(m_scale);
+			for (; i + 8 <= positions.size(); i += 8)
+			{
+				/// max/min return the second operand for NaNs, so NaNs become 0 like in Clamped
+				const auto clamped = _mm256_min_ps(_mm256_set1_ps(1.0f), _mm256_max_ps(_mm256_loadu_ps(positions.data() + i), _mm256_setzero_ps()));
+				const auto indices = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(clamped, scale), _mm256_set1_ps(0.5f)));
+				detail::avx2_pixels::store(detail::avx2_pixels::permute({ _mm256_i32gather_epi32(table, indices, 4) }, permutation), out.data() + i);
+			}
+#endif
+			for (; i < positions.size(); ++i)
+				out[i] = detail::Permute(m_packed_table[size_t(Clamped(positions[i]) * m_scale + 0.5f)], permutation);
+		}
+
+	private:
+
+		static float Clamped(float position) noexcept { return position > 0 ? (position < 1 ? position : 1.0f) : 0.0f; }
+
+		static std::vector<gradient_stop> EvenlySpaced(std::span<color_t const> colors)
+		{
+			std::vector<gradient_stop> stops;
+			stops.reserve(colors.size());
+			for (size_t i = 0; i < colors.size(); ++i)
+				stops.push_back({ colors.size() > 1 ? float(i) / float(colors.size() - 1) : 0.0f, colors[i] });
+			return stops;
+		}
+
+		options m_options;
+		std::vector<color_t> m_table;
+		/// The same table, packed in \ref detail::float_order
+		std::vector<uint32_t> m_packed_table;
+		float m_scale = 1;
+	};
+
+	///@}
+}
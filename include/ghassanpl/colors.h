@@ -6,6 +6,8 @@
 
 #include <charconv>
 #include <string_view>
+#include <cmath>
+#include <numbers>
 #include <glm/common.hpp>
 #include <glm/fwd.hpp>
 //#include <glm/ext/vector_float4.hpp>
@@ -29,12 +31,22 @@ namespace ghassanpl
 		hsva,
 
 		rgbe, /// Radiant HDR
+
+		oklab,
+		oklch,
+		cielab,
 	};
 
 	/// Represents a color in RGBA color space, with 0.0-1.0 float elements
 	using color_rgba_t = glm::vec4;
 	/// Represents a color in HSVA color space, with H=0.0-6.0, S=0.0-1.0, V=0.0-1.0, A=0.0-1.0 float elements
 	using color_hsva_t = named<glm::vec4, "color_hsva">;
+	/// Represents a color in OKLab color space, with L=0.0-1.0 (perceived lightness), a and b roughly between -0.4 and 0.4, and A=0.0-1.0 float elements
+	using color_oklab_t = named<glm::vec4, "color_oklab">;
+	/// Represents a color in OKLCh color space (OKLab in polar coordinates), with L=0.0-1.0, C=0.0-0.4 (chroma), h=0.0-360.0 (hue in degrees), A=0.0-1.0 float elements
+	using color_oklch_t = named<glm::vec4, "color_oklch">;
+	/// Represents a color in CIELAB color space (with the D65 white point), with L=0.0-100.0, a and b roughly between -128 and 128, and A=0.0-1.0 float elements
+	using color_lab_t = named<glm::vec4, "color_lab">;
 	/// Default `color_t` type is RGBA
 	using color_t = color_rgba_t;
 
@@ -131,6 +143,30 @@ namespace ghassanpl
 		return { cem::pow(color.x, gamma_correct), cem::pow(color.y, gamma_correct), cem::pow(color.z, gamma_correct), color.w };
 	}
 
+	/// Converts an sRGB-encoded channel value to linear
+	[[nodiscard]] constexpr float srgb_to_linear(float value)
+	{
+		return value <= 0.04045f ? value * (1.0f / 12.92f) : cem::pow((value + 0.055f) * (1.0f / 1.055f), 2.4f);
+	}
+
+	/// Converts a linear channel value to sRGB encoding
+	[[nodiscard]] constexpr float linear_to_srgb(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * cem::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	/// Converts an sRGB-encoded color to linear; alpha is not encoded, so it stays the same
+	[[nodiscard]] constexpr color_t srgb_to_linear(color_t const& color)
+	{
+		return { srgb_to_linear(color.x), srgb_to_linear(color.y), srgb_to_linear(color.z), color.w };
+	}
+
+	/// Converts a linear color to sRGB encoding; alpha is not encoded, so it stays the same
+	[[nodiscard]] constexpr color_t linear_to_srgb(color_t const& color)
+	{
+		return { linear_to_srgb(color.x), linear_to_srgb(color.y), linear_to_srgb(color.z), color.w };
+	}
+
 	/// Returns an inverted color, i.e. with (1.0-x) on all of its elements, excluding its alpha
 	[[nodiscard]] constexpr color_t inverted(color_t const& color)
 	{
@@ -259,7 +295,10 @@ namespace ghassanpl
 		if (delta != 0)
 		{
 			if (rgba.x == max)
-				h = fmod((rgba.y - rgba.z) / delta, 6.0f);
+			{
+				h = (rgba.y - rgba.z) / delta;
+				if (h < 0) h += 6.0f;
+			}
 			else if (rgba.y == max)
 				h = 2 + (rgba.z - rgba.x) / delta;
 			else
@@ -274,6 +313,120 @@ namespace ghassanpl
 		};
 	}
 
+	namespace detail
+	{
+		[[nodiscard]] constexpr float Cbrt(float value)
+		{
+			if (std::is_constant_evaluated())
+				return value < 0 ? -cem::pow(-value, 1.0f / 3.0f) : cem::pow(value, 1.0f / 3.0f);
+			return std::cbrt(value);
+		}
+
+		/// The CIELAB companding function and its inverse
+		[[nodiscard]] constexpr float LabF(float t)
+		{
+			constexpr float delta = 6.0f / 29.0f;
+			return t > delta * delta * delta ? Cbrt(t) : t / (3.0f * delta * delta) + 4.0f / 29.0f;
+		}
+		[[nodiscard]] constexpr float LabFInverse(float t)
+		{
+			constexpr float delta = 6.0f / 29.0f;
+			return t > delta ? t * t * t : 3.0f * delta * delta * (t - 4.0f / 29.0f);
+		}
+
+		/// D65 white point
+		constexpr float lab_white_x = 0.95047f;
+		constexpr float lab_white_z = 1.08883f;
+	}
+
+	/// \name Perceptual color spaces
+	/// These conversions take and return *linear* RGB colors; use \ref srgb_to_linear and \ref linear_to_srgb for sRGB-encoded ones
+	///@{
+
+	/// Converts a linear RGBA color to OKLab space
+	[[nodiscard]] constexpr color_oklab_t to_oklab(color_t const& linear)
+	{
+		const auto l = detail::Cbrt(0.4122214708f * linear.x + 0.5363325363f * linear.y + 0.0514459929f * linear.z);
+		const auto m = detail::Cbrt(0.2119034982f * linear.x + 0.6806995451f * linear.y + 0.1073969566f * linear.z);
+		const auto s = detail::Cbrt(0.0883024619f * linear.x + 0.2817188376f * linear.y + 0.6299787005f * linear.z);
+		return color_oklab_t{
+			0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s,
+			1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s,
+			0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s,
+			linear.w
+		};
+	}
+
+	/// Converts an OKLab color to linear RGBA space
+	[[nodiscard]] constexpr color_t to_rgb(color_oklab_t const& lab)
+	{
+		const auto l_ = lab->x + 0.3963377774f * lab->y + 0.2158037573f * lab->z;
+		const auto m_ = lab->x - 0.1055613458f * lab->y - 0.0638541728f * lab->z;
+		const auto s_ = lab->x - 0.0894841775f * lab->y - 1.2914855480f * lab->z;
+		const auto l = l_ * l_ * l_, m = m_ * m_ * m_, s = s_ * s_ * s_;
+		return {
+			4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s,
+			-1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s,
+			-0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s,
+			lab->w
+		};
+	}
+
+	/// Converts an OKLab color to OKLCh space; achromatic colors get a hue of 0
+	[[nodiscard]] inline color_oklch_t to_oklch(color_oklab_t const& lab)
+	{
+		const auto chroma = std::hypot(lab->y, lab->z);
+		auto hue = chroma > 0 ? std::atan2(lab->z, lab->y) * (180.0f / std::numbers::pi_v<float>) : 0.0f;
+		if (hue < 0) hue += 360.0f;
+		return color_oklch_t{ lab->x, chroma, hue, lab->w };
+	}
+
+	/// Converts an OKLCh color to OKLab space
+	[[nodiscard]] inline color_oklab_t to_oklab(color_oklch_t const& lch)
+	{
+		const auto hue = lch->z * (std::numbers::pi_v<float> / 180.0f);
+		return color_oklab_t{ lch->x, lch->y * std::cos(hue), lch->y * std::sin(hue), lch->w };
+	}
+
+	/// Converts a linear RGBA color to OKLCh space
+	[[nodiscard]] inline color_oklch_t to_oklch(color_t const& linear) { return to_oklch(to_oklab(linear)); }
+	/// Converts an OKLCh color to linear RGBA space
+	[[nodiscard]] inline color_t to_rgb(color_oklch_t const& lch) { return to_rgb(to_oklab(lch)); }
+
+	/// Converts a linear RGBA color to CIELAB space
+	[[nodiscard]] constexpr color_lab_t to_lab(color_t const& linear)
+	{
+		const auto x = detail::LabF((0.4124564f * linear.x + 0.3575761f * linear.y + 0.1804375f * linear.z) * (1.0f / detail::lab_white_x));
+		const auto y = detail::LabF(0.2126729f * linear.x + 0.7151522f * linear.y + 0.0721750f * linear.z);
+		const auto z = detail::LabF((0.0193339f * linear.x + 0.1191920f * linear.y + 0.9503041f * linear.z) * (1.0f / detail::lab_white_z));
+		return color_lab_t{ 116.0f * y - 16.0f, 500.0f * (x - y), 200.0f * (y - z), linear.w };
+	}
+
+	/// Converts a CIELAB color to linear RGBA space
+	[[nodiscard]] constexpr color_t to_rgb(color_lab_t const& lab)
+	{
+		const auto fy = (lab->x + 16.0f) * (1.0f / 116.0f);
+		const auto x = detail::LabFInverse(fy + lab->y * (1.0f / 500.0f)) * detail::lab_white_x;
+		const auto y = detail::LabFInverse(fy);
+		const auto z = detail::LabFInverse(fy - lab->z * (1.0f / 200.0f)) * detail::lab_white_z;
+		return {
+			3.2404542f * x - 1.5371385f * y - 0.4985314f * z,
+			-0.9692660f * x + 1.8760108f * y + 0.0415560f * z,
+			0.0556434f * x - 0.2040259f * y + 1.0572252f * z,
+			lab->w
+		};
+	}
+
+	/// Mixes two sRGB-encoded colors in OKLab space, which keeps the perceived lightness and hue changing evenly
+	[[nodiscard]] constexpr color_t mix_oklab(color_t const& a, color_t const& b, float t)
+	{
+		const auto lab_a = to_oklab(srgb_to_linear(a));
+		const auto lab_b = to_oklab(srgb_to_linear(b));
+		return linear_to_srgb(to_rgb(color_oklab_t{ lab_a.value + (lab_b.value - lab_a.value) * t }));
+	}
+
+	///@}
+
 	/// Converts a HTML color string (like \#FBA or fafafa) to an RGBA color
 	[[nodiscard]] constexpr color_rgba_t from_html(const char* str, size_t n)
 	{
@@ -0,0 +1,429 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "buffers.h"
+#include <atomic>
+#include <optional>
+#include <new>
+
+namespace ghassanpl
+{
+	/// \ingroup Buffers
+	///@{
+
+	/// The size of a cache line we pad shared indices to, to avoid false sharing.
+	/// \note We don't use `std::hardware_destructive_interference_size` as it is ABI-unstable and some compilers warn about using it in headers
+	inline constexpr size_t cache_line_size = 64;
+
+	namespace detail
+	{
+		[[nodiscard]] constexpr size_t concurrent_buffer_capacity(size_t requested) noexcept
+		{
+			return std::bit_ceil(std::max<size_t>(requested, 2));
+		}
+
+		template <typename T>
+		struct alignas(alignof(T)) uninitialized_slot
+		{
+			std::byte storage[sizeof(T)];
+
+			T* get() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+			T const* get() const noexcept { return std::launder(reinterpret_cast<T const*>(storage)); }
+		};
+	}
+
+	/// A bounded, wait-free, single-producer single-consumer queue.
+	/// Satisfies the \ref buffer_append protocol (via `try_append`), so a producer thread can use e.g. `buffer_append_varint` directly into it,
+	/// as long as it is the only producer.
+	/// \par Thread Safety
+	/// Exactly one thread may call the producer functions (`try_push`, `try_emplace`, `try_append`) and exactly one thread may call the consumer
+	/// functions (`try_pop`, `front`, `pop`) at any given time. `size()`, `empty()` and `capacity()` can be called from both, but `size()` and `empty()`
+	/// are only a snapshot.
+	/// \tparam T the element type; does not need to be default-constructible
+	template <typename T>
+	struct spsc_queue
+	{
+		using value_type = T;
+
+		/// \param capacity the minimum number of elements the queue can hold; will be rounded up to a power of 2
+		explicit spsc_queue(size_t capacity)
+			: m_mask(detail::concurrent_buffer_capacity(capacity) - 1)
+			, m_slots(new detail::uninitialized_slot<T>[m_mask + 1])
+		{
+		}
+
+		spsc_queue(spsc_queue const&) = delete;
+		spsc_queue& operator=(spsc_queue const&) = delete;
+
+		~spsc_queue()
+		{
+			if constexpr (!std::is_trivially_destructible_v<T>)
+			{
+				while (front())
+					pop();
+			}
+		}
+
+		[[nodiscard]] size_t capacity() const noexcept { return m_mask + 1; }
+		[[nodiscard]] size_t size() const noexcept { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		/// \name Producer functions
+		///@{
+
+		/// Constructs a new element at the end of the queue
+		/// \returns false if the queue is full
+		template <typename... ARGS>
+		requires std::constructible_from<T, ARGS...>
+		bool try_emplace(ARGS&&... args) noexcept(std::is_nothrow_constructible_v<T, ARGS...>)
+		{
+			const auto tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_cached_head == capacity())
+			{
+				m_cached_head = m_head.load(std::memory_order_acquire);
+				if (tail - m_cached_head == capacity())
+					return false;
+			}
+			std::construct_at(m_slots[tail & m_mask].get(), std::forward<ARGS>(args)...);
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		template <typename U>
+		requires std::constructible_from<T, U>
+		bool try_push(U&& value) noexcept(std::is_nothrow_constructible_v<T, U>) { return try_emplace(std::forward<U>(value)); }
+
+		/// Used by \ref buffer_append
+		template <typename U>
+		requires std::constructible_from<T, U>
+		bool try_append(U&& value) noexcept(std::is_nothrow_constructible_v<T, U>) { return try_emplace(std::forward<U>(value)); }
+
+		///@}
+
+		/// \name Consumer functions
+		///@{
+
+		/// \returns a pointer to the first element in the queue, or `nullptr` if the queue is empty
+		[[nodiscard]] T* front() noexcept
+		{
+			const auto head = m_head.load(std::memory_order_relaxed);
+			if (head == m_cached_tail)
+			{
+				m_cached_tail = m_tail.load(std::memory_order_acquire);
+				if (head == m_cached_tail)
+					return nullptr;
+			}
+			return m_slots[head & m_mask].get();
+		}
+
+		/// Removes the first element of the queue.
+		/// \pre `front()` must have returned a non-null value
+		void pop() noexcept
+		{
+			const auto head = m_head.load(std::memory_order_relaxed);
+			std::destroy_at(m_slots[head & m_mask].get());
+			m_head.store(head + 1, std::memory_order_release);
+		}
+
+		bool try_pop(T& out) noexcept(std::is_nothrow_move_assignable_v<T>)
+		{
+			if (auto ptr = front())
+			{
+				out = std::move(*ptr);
+				pop();
+				return true;
+			}
+			return false;
+		}
+
+		[[nodiscard]] std::optional<T> try_pop() noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			std::optional<T> result;
+			if (auto ptr = front())
+			{
+				result.emplace(std::move(*ptr));
+				pop();
+			}
+			return result;
+		}
+
+		///@}
+
+	private:
+
+		const size_t m_mask;
+		std::unique_ptr<detail::uninitialized_slot<T>[]> m_slots;
+
+		alignas(cache_line_size) std::atomic<size_t> m_tail{ 0 };
+		alignas(cache_line_size) size_t m_cached_head = 0; /// only touched by the producer
+		alignas(cache_line_size) std::atomic<size_t> m_head{ 0 };
+		alignas(cache_line_size) size_t m_cached_tail = 0; /// only touched by the consumer
+		char m_padding[cache_line_size - sizeof(size_t)]{};
+	};
+
+	/// A bounded, lock-free, multi-producer multi-consumer queue, based on Dmitry Vyukov's bounded MPMC queue.
+	/// Satisfies the \ref buffer_append protocol (via `try_append`).
+	/// \note Each `try_append` is a separate, atomic operation, so multi-element appends (like `buffer_append_varint`) from several producers
+	/// may interleave. Push whole messages (or use a `spsc_queue` per producer) if that matters.
+	/// \see https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+	template <typename T>
+	struct mpmc_queue
+	{
+		using value_type = T;
+
+		/// \param capacity the minimum number of elements the queue can hold; will be rounded up to a power of 2
+		explicit mpmc_queue(size_t capacity)
+			: m_mask(detail::concurrent_buffer_capacity(capacity) - 1)
+			, m_cells(new cell[m_mask + 1])
+		{
+			for (size_t i = 0; i <= m_mask; ++i)
+				m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		mpmc_queue(mpmc_queue const&) = delete;
+		mpmc_queue& operator=(mpmc_queue const&) = delete;
+
+		~mpmc_queue()
+		{
+			if constexpr (!std::is_trivially_destructible_v<T>)
+			{
+				while (try_pop()) {}
+			}
+		}
+
+		[[nodiscard]] size_t capacity() const noexcept { return m_mask + 1; }
+
+		/// \returns an approximation of the number of elements in the queue
+		[[nodiscard]] size_t size() const noexcept
+		{
+			const auto enqueued = m_enqueue_pos.load(std::memory_order_acquire);
+			const auto dequeued = m_dequeue_pos.load(std::memory_order_acquire);
+			return enqueued > dequeued ? enqueued - dequeued : 0;
+		}
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		/// Constructs a new element at the end of the queue
+		/// \returns false if the queue is full
+		template <typename... ARGS>
+		requires std::constructible_from<T, ARGS...>
+		bool try_emplace(ARGS&&... args) noexcept(std::is_nothrow_constructible_v<T, ARGS...>)
+		{
+			auto pos = m_enqueue_pos.load(std::memory_order_relaxed);
+			cell* target = nullptr;
+			while (true)
+			{
+				target = &m_cells[pos & m_mask];
+				const auto seq = target->sequence.load(std::memory_order_acquire);
+				const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (diff == 0)
+				{
+					if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false;
+				else
+					pos = m_enqueue_pos.load(std::memory_order_relaxed);
+			}
+			std::construct_at(target->slot.get(), std::forward<ARGS>(args)...);
+			target->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		template <typename U>
+		requires std::constructible_from<T, U>
+		bool try_push(U&& value) noexcept(std::is_nothrow_constructible_v<T, U>) { return try_emplace(std::forward<U>(value)); }
+
+		/// Used by \ref buffer_append
+		template <typename U>
+		requires std::constructible_from<T, U>
+		bool try_append(U&& value) noexcept(std::is_nothrow_constructible_v<T, U>) { return try_emplace(std::forward<U>(value)); }
+
+		bool try_pop(T& out) noexcept(std::is_nothrow_move_assignable_v<T>)
+		{
+			return dequeue([&](T& val) { out = std::move(val); });
+		}
+
+		[[nodiscard]] std::optional<T> try_pop() noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			std::optional<T> result;
+			dequeue([&](T& val) { result.emplace(std::move(val)); });
+			return result;
+		}
+
+	private:
+
+		template <typename FUNC>
+		bool dequeue(FUNC&& func)
+		{
+			auto pos = m_dequeue_pos.load(std::memory_order_relaxed);
+			cell* target = nullptr;
+			while (true)
+			{
+				target = &m_cells[pos & m_mask];
+				const auto seq = target->sequence.load(std::memory_order_acquire);
+				const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+				if (diff == 0)
+				{
+					if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false;
+				else
+					pos = m_dequeue_pos.load(std::memory_order_relaxed);
+			}
+			func(*target->slot.get());
+			std::destroy_at(target->slot.get());
+			target->sequence.store(pos + m_mask + 1, std::memory_order_release);
+			return true;
+		}
+
+		struct cell
+		{
+			std::atomic<size_t> sequence;
+			detail::uninitialized_slot<T> slot;
+		};
+
+		const size_t m_mask;
+		std::unique_ptr<cell[]> m_cells;
+
+		alignas(cache_line_size) std::atomic<size_t> m_enqueue_pos{ 0 };
+		alignas(cache_line_size) std::atomic<size_t> m_dequeue_pos{ 0 };
+		char m_padding[cache_line_size - sizeof(size_t)]{};
+	};
+
+	/// A bounded, wait-free, single-producer single-consumer byte stream.
+	/// Unlike `spsc_queue<std::byte>`, whole ranges are written and read with a single index update, and range appends are all-or-nothing,
+	/// so e.g. `buffer_append_pod` either writes the whole object or nothing.
+	/// \note `buffer_append_varint` appends byte-by-byte, so if the ring is nearly full, only a part of a varint may be written. Check
+	/// `free_space()` first (a varint takes at most `(sizeof(T) * 8 + 6) / 7` bytes) if the consumer cannot handle that.
+	/// \tparam BYTE_TYPE the element type this buffer reports to \ref buffer_element_type
+	template <bytelike BYTE_TYPE = std::byte>
+	struct spsc_byte_ring
+	{
+		using value_type = BYTE_TYPE;
+
+		/// \param capacity the minimum number of bytes the ring can hold; will be rounded up to a power of 2
+		explicit spsc_byte_ring(size_t capacity)
+			: m_mask(detail::concurrent_buffer_capacity(capacity) - 1)
+			, m_data(new BYTE_TYPE[m_mask + 1])
+		{
+		}
+
+		spsc_byte_ring(spsc_byte_ring const&) = delete;
+		spsc_byte_ring& operator=(spsc_byte_ring const&) = delete;
+
+		[[nodiscard]] size_t capacity() const noexcept { return m_mask + 1; }
+		[[nodiscard]] size_t size() const noexcept { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+		[[nodiscard]] size_t free_space() const noexcept { return capacity() - size(); }
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		/// \name Producer functions
+		///@{
+
+		/// Used by \ref buffer_append
+		template <bytelike B>
+		bool try_append(B byte) noexcept
+		{
+			return try_append(&byte, 1) == 1;
+		}
+
+		/// Used by \ref buffer_append_range
+		/// \returns `count` if all the bytes were written, 0 if there was not enough space for all of them
+		template <bytelike B>
+		size_t try_append(B const* bytes, size_t count) noexcept
+		{
+			const auto tail = m_tail.load(std::memory_order_relaxed);
+			if (capacity() - (tail - m_cached_head) < count)
+			{
+				m_cached_head = m_head.load(std::memory_order_acquire);
+				if (capacity() - (tail - m_cached_head) < count)
+					return 0;
+			}
+			const auto start = tail & m_mask;
+			const auto first_part = std::min(count, capacity() - start);
+			std::memcpy(m_data.get() + start, bytes, first_part);
+			std::memcpy(m_data.get(), bytes + first_part, count - first_part);
+			m_tail.store(tail + count, std::memory_order_release);
+			return count;
+		}
+
+		///@}
+
+		/// \name Consumer functions
+		///@{
+
+		/// Copies up to `out.size()` bytes into `out` without consuming them
+		/// \returns the number of bytes copied
+		template <bytelike B>
+		size_t peek(span<B> out) noexcept
+		{
+			const auto head = m_head.load(std::memory_order_relaxed);
+			return copy_out(head, out);
+		}
+
+		/// Moves up to `out.size()` bytes into `out`
+		/// \returns the number of bytes read
+		template <bytelike B>
+		size_t read(span<B> out) noexcept
+		{
+			const auto head = m_head.load(std::memory_order_relaxed);
+			const auto result = copy_out(head, out);
+			m_head.store(head + result, std::memory_order_release);
+			return result;
+		}
+
+		/// Reads a whole POD object (as appended by \ref buffer_append_pod)
+		/// \returns false (and leaves the ring untouched) if not enough bytes are available yet
+		template <typename POD>
+		requires std::is_trivially_copyable_v<POD>
+		bool try_read_pod(POD& out) noexcept
+		{
+			if (available() < sizeof(POD))
+				return false;
+			return read(as_bytelikes<std::byte>(out)) == sizeof(POD);
+		}
+
+		///@}
+
+	private:
+
+		size_t available() noexcept
+		{
+			m_cached_tail = m_tail.load(std::memory_order_acquire);
+			return m_cached_tail - m_head.load(std::memory_order_relaxed);
+		}
+
+		template <bytelike B>
+		size_t copy_out(size_t head, span<B> out) noexcept
+		{
+			auto count = m_cached_tail - head;
+			if (count < out.size())
+			{
+				m_cached_tail = m_tail.load(std::memory_order_acquire);
+				count = m_cached_tail - head;
+			}
+			count = std::min(count, out.size());
+			const auto start = head & m_mask;
+			const auto first_part = std::min(count, capacity() - start);
+			std::memcpy(out.data(), m_data.get() + start, first_part);
+			std::memcpy(out.data() + first_part, m_data.get(), count - first_part);
+			return count;
+		}
+
+		const size_t m_mask;
+		std::unique_ptr<BYTE_TYPE[]> m_data;
+
+		alignas(cache_line_size) std::atomic<size_t> m_tail{ 0 };
+		alignas(cache_line_size) size_t m_cached_head = 0; /// only touched by the producer
+		alignas(cache_line_size) std::atomic<size_t> m_head{ 0 };
+		alignas(cache_line_size) size_t m_cached_tail = 0; /// only touched by the consumer
+		char m_padding[cache_line_size - sizeof(size_t)]{};
+	};
+
+	///@}
+}
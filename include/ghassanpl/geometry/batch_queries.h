@@ -0,0 +1,162 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "circle.h"
+#include "triangles.h"
+#include "polygon.h"
+#include "segment.h"
+#include "ray.h"
+#include <span>
+#include <stdexcept>
+#include "../simd.h"
+
+/// Queries that test many points or rays against the same shape at once. The inputs are in structure-of-arrays form, and for `float`s
+/// are processed 8 (with AVX2) or 4 (with SSE2) at a time. Each result matches what the shape's scalar function would return.
+///
+/// Point results are written as bits: point `i` is bit `i % 64` of `out_bits[i / 64]`, with the unused bits of the last word cleared.
+
+namespace ghassanpl::geometry
+{
+	/// A set of rays in structure-of-arrays form
+	template <std::floating_point T>
+	struct trays_soa
+	{
+		std::span<T const> start_xs;
+		std::span<T const> start_ys;
+		std::span<T const> dir_xs;
+		std::span<T const> dir_ys;
+
+		[[nodiscard]] size_t size() const noexcept { return start_xs.size(); }
+	};
+
+	using rays_soa = trays_soa<float>;
+
+	namespace detail
+	{
+		/// Calls `kernel(L{}, x, y)` for every group of lanes and stores the resulting masks as bits
+		template <typename T, typename KERNEL>
+		void ContainsBatch(std::span<T const> xs, std::span<T const> ys, std::span<uint64_t> out_bits, KERNEL const& kernel)
+		{
+			const auto count = xs.size();
+			if (ys.size() != count)
+				throw std::invalid_argument{ "xs and ys must have the same size" };
+			if (out_bits.size() * 64 < count)
+				throw std::invalid_argument{ "not enough space for the results" };
+			std::fill_n(out_bits.begin(), (count + 63) / 64, uint64_t{});
+
+			static_assert(64 % simd::batch_lanes<T>::width == 0);
+			simd::ForEachLaneGroup<T>(count, [&]<typename L>(L, size_t i) {
+				out_bits[i / 64] |= uint64_t(L::bits(kernel(L{}, L::load(xs.data() + i), L::load(ys.data() + i)))) << (i % 64);
+			});
+		}
+
+		/// Calls `kernel(L{}, start_x, start_y, dir_x, dir_y)` for every group of lanes and stores the resulting values
+		template <typename T, typename KERNEL>
+		void RayBatch(trays_soa<T> const& rays, std::span<T> out, KERNEL const& kernel)
+		{
+			const auto count = rays.size();
+			if (rays.start_ys.size() != count || rays.dir_xs.size() != count || rays.dir_ys.size() != count)
+				throw std::invalid_argument{ "all ray component spans must have the same size" };
+			if (out.size() < count)
+				throw std::invalid_argument{ "not enough space for the results" };
+
+			simd::ForEachLaneGroup<T>(count, [&]<typename L>(L, size_t i) {
+				L::store(kernel(L{}, L::load(rays.start_xs.data() + i), L::load(rays.start_ys.data() + i), L::load(rays.dir_xs.data() + i), L::load(rays.dir_ys.data() + i)), out.data() + i);
+			});
+		}
+
+		/// The distance along the rays to `segment`, or infinity where they miss it; the same math as \ref tray::intersection_distance
+		template <typename L, typename T>
+		typename L::f RaySegmentDistance(typename L::f start_x, typename L::f start_y, typename L::f dir_x, typename L::f dir_y, tsegment<T> const& segment) noexcept
+		{
+			const auto sx = L::broadcast(segment.end.x - segment.start.x), sy = L::broadcast(segment.end.y - segment.start.y);
+			const auto qx = L::broadcast(segment.start.x) - start_x, qy = L::broadcast(segment.start.y) - start_y;
+			const auto zero = L::broadcast(T{}), one = L::broadcast(T(1));
+			const auto denominator = dir_x * sy - dir_y * sx;
+			const auto t = (qx * sy - qy * sx) / denominator;
+			const auto u = (qx * dir_y - qy * dir_x) / denominator;
+			const auto hit = L::not_equal(denominator, zero) & L::greater_equal(t, zero) & L::greater_equal(u, zero) & L::less_equal(u, one);
+			return L::select(hit, t, L::broadcast(std::numeric_limits<T>::infinity()));
+		}
+	}
+
+	/// Tests which of the points (`xs[i]`, `ys[i]`) are inside `circle`, like \ref tcircle::contains
+	template <std::floating_point T>
+	void contains_batch(tcircle<T> const& circle, std::span<T const> xs, std::span<T const> ys, std::span<uint64_t> out_bits)
+	{
+		const auto radius_squared = circle.radius * circle.radius;
+		detail::ContainsBatch(xs, ys, out_bits, [&]<typename L>(L, typename L::f x, typename L::f y) {
+			const auto dx = x - L::broadcast(circle.center.x), dy = y - L::broadcast(circle.center.y);
+			return L::less_equal(dx * dx + dy * dy, L::broadcast(radius_squared));
+		});
+	}
+
+	/// Tests which of the points (`xs[i]`, `ys[i]`) are inside `rect`, like \ref trec2::contains
+	template <std::floating_point T>
+	void contains_batch(trec2<T> const& rect, std::span<T const> xs, std::span<T const> ys, std::span<uint64_t> out_bits)
+	{
+		detail::ContainsBatch(xs, ys, out_bits, [&]<typename L>(L, typename L::f x, typename L::f y) {
+			return L::greater_equal(x, L::broadcast(rect.p1.x)) & L::greater_equal(y, L::broadcast(rect.p1.y)) & L::less(x, L::broadcast(rect.p2.x)) & L::less(y, L::broadcast(rect.p2.y));
+		});
+	}
+
+	/// Tests which of the points (`xs[i]`, `ys[i]`) are inside `triangle`, like \ref ttriangle::contains
+	template <std::floating_point T>
+	void contains_batch(ttriangle<T> const& triangle, std::span<T const> xs, std::span<T const> ys, std::span<uint64_t> out_bits)
+	{
+		detail::ContainsBatch(xs, ys, out_bits, [&]<typename L>(L, typename L::f x, typename L::f y) {
+			/// `ttriangle::sign(pt, p, q)` for each edge
+			const auto side = [&](glm::tvec2<T> p, glm::tvec2<T> q) {
+				return (x - L::broadcast(q.x)) * L::broadcast(p.y - q.y) - L::broadcast(p.x - q.x) * (y - L::broadcast(q.y));
+			};
+			const auto d1 = side(triangle.a, triangle.b), d2 = side(triangle.b, triangle.c), d3 = side(triangle.c, triangle.a);
+			const auto zero = L::broadcast(T{});
+			const auto has_negative = L::less(d1, zero) | L::less(d2, zero) | L::less(d3, zero);
+			const auto has_positive = L::greater(d1, zero) | L::greater(d2, zero) | L::greater(d3, zero);
+			return L::is_zero(has_negative & has_positive);
+		});
+	}
+
+	/// Tests which of the points (`xs[i]`, `ys[i]`) are inside `poly`, like \ref tpolygon::contains
+	template <std::floating_point T>
+	void contains_batch(tpolygon<T> const& poly, std::span<T const> xs, std::span<T const> ys, std::span<uint64_t> out_bits)
+	{
+		auto const& vertices = poly.vertices;
+		detail::ContainsBatch(xs, ys, out_bits, [&]<typename L>(L, typename L::f x, typename L::f y) {
+			auto inside = L::broadcast(int32_t(0));
+			for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++)
+			{
+				const auto xi = L::broadcast(vertices[i].x), yi = L::broadcast(vertices[i].y);
+				const auto xj = L::broadcast(vertices[j].x), yj = L::broadcast(vertices[j].y);
+				const auto crosses = L::greater(yi, y) ^ L::greater(yj, y);
+				const auto left = L::less(x, (xj - xi) * (y - yi) / (yj - yi) + xi);
+				inside = inside ^ (crosses & left);
+			}
+			return inside;
+		});
+	}
+
+	/// Writes the distance along each ray (in multiples of its direction's length) at which it crosses `segment`, or infinity if it misses
+	template <std::floating_point T>
+	void intersect_batch(trays_soa<T> const& rays, tsegment<T> const& segment, std::span<T> out_distances)
+	{
+		detail::RayBatch(rays, out_distances, [&]<typename L>(L, typename L::f start_x, typename L::f start_y, typename L::f dir_x, typename L::f dir_y) {
+			return detail::RaySegmentDistance<L>(start_x, start_y, dir_x, dir_y, segment);
+		});
+	}
+
+	/// Writes the distance along each ray to the first of `segments` it crosses, or infinity if it misses them all, e.g. for casting light rays against occluders
+	template <std::floating_point T>
+	void intersect_batch(trays_soa<T> const& rays, std::span<tsegment<T> const> segments, std::span<T> out_distances)
+	{
+		detail::RayBatch(rays, out_distances, [&]<typename L>(L, typename L::f start_x, typename L::f start_y, typename L::f dir_x, typename L::f dir_y) {
+			auto closest = L::broadcast(std::numeric_limits<T>::infinity());
+			for (auto const& segment : segments)
+				closest = L::min(closest, detail::RaySegmentDistance<L>(start_x, start_y, dir_x, dir_y, segment));
+			return closest;
+		});
+	}
+}
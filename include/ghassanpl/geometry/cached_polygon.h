@@ -0,0 +1,373 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "polygon.h"
+#include "spatial_index.h"
+#include "../enum_flags.h"
+
+namespace ghassanpl::geometry
+{
+	/// A polygon that lazily calculates and keeps data derived from its vertices: the bounding box, cumulative edge lengths
+	/// (making \ref edge_point a binary search), area, centroid, classification, and a \ref tbvh "bounding volume hierarchy" of its edges
+	/// (used by \ref contains, \ref closest_point_to and \ref classify).
+	///
+	/// The vertices can only be changed through the member functions of this class, each of which invalidates the data it affects.
+	/// \attention As the data is calculated on first use, concurrent calls to const member functions are not safe until each
+	/// cached value has been calculated (e.g. by calling \ref precalculate).
+	template <std::floating_point T>
+	class tcached_polygon
+	{
+	public:
+
+		using tvec = glm::tvec2<T>;
+		using value_type = T;
+		using mutable_polygon = tpolygon<T>;
+
+		tcached_polygon() noexcept = default;
+		explicit tcached_polygon(tpolygon<T> poly) noexcept : m_poly(std::move(poly)) {}
+		explicit tcached_polygon(std::vector<tvec> vertices) noexcept : m_poly{ std::move(vertices) } {}
+
+		/// Vertex access
+
+		[[nodiscard]] tpolygon<T> const& polygon() const noexcept { return m_poly; }
+		[[nodiscard]] std::vector<tvec> const& vertices() const noexcept { return m_poly.vertices; }
+		tvec const& operator[](size_t index) const { return m_poly.vertices.at(index); }
+
+		auto cbegin() const noexcept { return std::ranges::cbegin(m_poly.vertices); }
+		auto cend() const noexcept { return std::ranges::cend(m_poly.vertices); }
+		auto begin() const noexcept { return std::ranges::cbegin(m_poly.vertices); }
+		auto end() const noexcept { return std::ranges::cend(m_poly.vertices); }
+		auto size() const noexcept { return std::ranges::size(m_poly.vertices); }
+
+		bool is_valid() const noexcept { return m_poly.is_valid(); }
+		size_t vertex_count() const { return m_poly.vertex_count(); }
+		size_t edge_count() const { return m_poly.edge_count(); }
+		auto edge(size_t index) const { return m_poly.edge(index); }
+		auto vertex(size_t index) const { return m_poly.vertex(index); }
+		template <typename FUNC> void for_each_vertex(FUNC&& func) const { m_poly.for_each_vertex(std::forward<FUNC>(func)); }
+		template <typename FUNC> void for_each_edge(FUNC&& func) const { m_poly.for_each_edge(std::forward<FUNC>(func)); }
+
+		/// Modification
+
+		void set_vertex(size_t index, tvec const& vertex)
+		{
+			m_poly.vertices.at(index) = vertex;
+			Invalidate();
+		}
+
+		void push_back(tvec const& vertex)
+		{
+			m_poly.vertices.push_back(vertex);
+			Invalidate();
+		}
+
+		void insert(size_t index, tvec const& vertex)
+		{
+			if (index > m_poly.vertices.size())
+				throw std::invalid_argument("index");
+			m_poly.vertices.insert(m_poly.vertices.begin() + index, vertex);
+			Invalidate();
+		}
+
+		void erase(size_t index)
+		{
+			if (index >= m_poly.vertices.size())
+				throw std::invalid_argument("index");
+			m_poly.vertices.erase(m_poly.vertices.begin() + index);
+			Invalidate();
+		}
+
+		void assign(std::vector<tvec> vertices)
+		{
+			m_poly.vertices = std::move(vertices);
+			Invalidate();
+		}
+
+		void clear()
+		{
+			m_poly.vertices.clear();
+			Invalidate();
+		}
+
+		/// Moves all the vertices by `offset`; the edge lengths, area and classification stay valid, and the other data is moved along
+		void translate(tvec offset)
+		{
+			for (auto& v : m_poly.vertices)
+				v += offset;
+			m_bounds = m_bounds + offset;
+			m_centroid += offset;
+			if (m_valid.is_set(cached::edge_index))
+			{
+				for (uint32_t i = 0; i < m_poly.vertices.size(); ++i)
+					m_edge_index.update(i, m_edge_index.box(i) + offset);
+				m_edge_index.refit();
+			}
+		}
+
+		/// Calls `func(vertices)` with the vertex vector for arbitrary modifications, and invalidates all the cached data afterwards
+		template <typename FUNC>
+		void modify(FUNC&& func)
+		{
+			struct invalidate_on_exit { tcached_polygon& self; ~invalidate_on_exit() { self.Invalidate(); } } guard{ *this };
+			std::forward<FUNC>(func)(m_poly.vertices);
+		}
+
+		/// Calculates all the cached data now, instead of on first use
+		void precalculate() const
+		{
+			Bounds();
+			CumulativeLengths();
+			Area();
+			Centroid();
+			Classification();
+			EdgeIndex();
+		}
+
+		/// Cached queries
+
+		T edge_length() const
+		{
+			auto const& lengths = CumulativeLengths();
+			return lengths.empty() ? T{} : lengths.back();
+		}
+
+		/// Same as \ref tpolygon::edge_point, but in O(log n)
+		tvec edge_point(T t) const
+		{
+			return EdgePoint(t, edge_length());
+		}
+
+		tvec edge_point_alpha(T t) const
+		{
+			const auto el = edge_length();
+			return EdgePoint(t * el, el);
+		}
+
+		/// Distance along the vertex chain to each vertex, as used by \ref edge_point
+		std::span<T const> cumulative_edge_lengths() const { return CumulativeLengths(); }
+
+		trec2<T> bounding_box() const { return Bounds(); }
+		T calculate_area() const { return Area(); }
+		tvec centroid() const { return Centroid(); }
+		polygon_classification classify() const { return Classification(); }
+
+		/// Bounding volume hierarchy of the boxes of the edges; edge `i` goes from vertex `i` to vertex `(i + 1) % size()`
+		tbvh<T> const& edge_index() const { return EdgeIndex(); }
+
+		/// Same as \ref tpolygon::contains, only testing the edges that can cross the ray to the right of `pt`
+		bool contains(tvec pt) const
+		{
+			auto const& v = m_poly.vertices;
+			if (v.size() < 3 || !Bounds().contains(pt))
+				return false;
+
+			bool result = false;
+			const auto n = uint32_t(v.size());
+			EdgeIndex().query(trec2<T>{ pt.x, pt.y, Bounds().right(), pt.y }, [&](uint32_t edge) {
+				const auto i = (edge + 1) % n;
+				const auto j = edge;
+				if (((v[i].y > pt.y) != (v[j].y > pt.y)) &&
+					(pt.x < (v[j].x - v[i].x) * (pt.y - v[i].y) / (v[j].y - v[i].y) + v[i].x))
+				{
+					result = !result;
+				}
+			});
+			return result;
+		}
+
+		/// \returns `pt` if it is inside the polygon, or the closest point on its edges otherwise
+		tvec closest_point_to(tvec pt) const
+		{
+			return contains(pt) ? pt : projected_on_edge(pt);
+		}
+
+		/// \returns the point on the edges of the polygon (including the closing edge) closest to `pt`
+		tvec projected_on_edge(tvec pt) const
+		{
+			auto const& v = m_poly.vertices;
+			if (v.size() < 2)
+				return v.empty() ? pt : v[0];
+
+			const auto hit = EdgeIndex().nearest(pt, [&](uint32_t edge, tvec p) { return glm::distance(Edge(edge).closest_point_to(p), p); });
+			return Edge(hit->id).closest_point_to(pt);
+		}
+
+	private:
+
+		enum class cached
+		{
+			bounds,
+			lengths,
+			area,
+			centroid,
+			classification,
+			edge_index,
+		};
+
+		tpolygon<T> m_poly;
+
+		mutable enum_flags<cached> m_valid;
+		mutable trec2<T> m_bounds = trec2<T>::exclusive();
+		mutable std::vector<T> m_cumulative_lengths;
+		mutable T m_area{};
+		mutable tvec m_centroid{};
+		mutable polygon_classification m_classification;
+		mutable tbvh<T> m_edge_index;
+
+		void Invalidate() noexcept { m_valid = {}; }
+
+		tsegment<T> Edge(uint32_t edge) const
+		{
+			auto const& v = m_poly.vertices;
+			return { v[edge], v[(edge + 1) % v.size()] };
+		}
+
+		trec2<T> const& Bounds() const
+		{
+			if (!m_valid.is_set(cached::bounds))
+			{
+				m_bounds = m_poly.bounding_box();
+				m_valid.set(cached::bounds);
+			}
+			return m_bounds;
+		}
+
+		std::vector<T> const& CumulativeLengths() const
+		{
+			if (!m_valid.is_set(cached::lengths))
+			{
+				auto const& v = m_poly.vertices;
+				m_cumulative_lengths.resize(v.size());
+				T sum{};
+				for (size_t i = 0; i < v.size(); ++i)
+				{
+					if (i > 0)
+						sum += glm::distance(v[i - 1], v[i]);
+					m_cumulative_lengths[i] = sum;
+				}
+				m_valid.set(cached::lengths);
+			}
+			return m_cumulative_lengths;
+		}
+
+		T Area() const
+		{
+			if (!m_valid.is_set(cached::area))
+			{
+				m_area = m_poly.calculate_area();
+				m_valid.set(cached::area);
+			}
+			return m_area;
+		}
+
+		tvec Centroid() const
+		{
+			if (!m_valid.is_set(cached::centroid))
+			{
+				m_centroid = m_poly.centroid();
+				m_valid.set(cached::centroid);
+			}
+			return m_centroid;
+		}
+
+		tbvh<T> const& EdgeIndex() const
+		{
+			if (!m_valid.is_set(cached::edge_index))
+			{
+				auto const& v = m_poly.vertices;
+				std::vector<trec2<T>> boxes(v.size() < 2 ? 0 : v.size());
+				for (uint32_t i = 0; i < boxes.size(); ++i)
+					boxes[i] = Edge(i).bounding_box();
+				m_edge_index.build(boxes);
+				m_valid.set(cached::edge_index);
+			}
+			return m_edge_index;
+		}
+
+		polygon_classification const& Classification() const
+		{
+			if (!m_valid.is_set(cached::classification))
+			{
+				m_classification = Classify();
+				m_valid.set(cached::classification);
+			}
+			return m_classification;
+		}
+
+		polygon_classification Classify() const
+		{
+			polygon_classification result;
+			auto const& v = m_poly.vertices;
+			const auto n = v.size();
+			if (n < 3)
+				return result;
+
+			result.winding = Area() >= T{} ? winding_order::counter_clockwise : winding_order::clockwise;
+
+			bool left_turns = false, right_turns = false;
+			for (size_t i = 0; i < n; ++i)
+			{
+				const auto turn = Cross(v[(i + n - 1) % n], v[i], v[(i + 1) % n]);
+				left_turns |= turn > T{};
+				right_turns |= turn < T{};
+			}
+
+			/// Only edges that do not share a vertex can cross in a simple polygon
+			const auto crossing = EdgeIndex().for_each_overlapping_pair([&](uint32_t a, uint32_t b) {
+				const auto gap = b - a;
+				if (gap == 1 || gap == n - 1)
+					return false;
+				return SegmentsIntersect(v[a], v[(a + 1) % n], v[b], v[(b + 1) % n]);
+			});
+
+			result.simple = !crossing;
+			result.convex = result.simple && !(left_turns && right_turns);
+			return result;
+		}
+
+		static T Cross(tvec a, tvec b, tvec c) { return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x); }
+
+		static bool SegmentsIntersect(tvec p1, tvec q1, tvec p2, tvec q2)
+		{
+			const auto sign = [](T v) { return (v > T{}) - (v < T{}); };
+			const auto on_segment = [](tvec p, tvec q, tvec r) {
+				return q.x <= std::max(p.x, r.x) && q.x >= std::min(p.x, r.x) && q.y <= std::max(p.y, r.y) && q.y >= std::min(p.y, r.y);
+			};
+
+			const auto o1 = sign(Cross(p1, q1, p2));
+			const auto o2 = sign(Cross(p1, q1, q2));
+			const auto o3 = sign(Cross(p2, q2, p1));
+			const auto o4 = sign(Cross(p2, q2, q1));
+
+			if (o1 != o2 && o3 != o4) return true;
+			return (o1 == 0 && on_segment(p1, p2, q1)) || (o2 == 0 && on_segment(p1, q2, q1)) || (o3 == 0 && on_segment(p2, p1, q2)) || (o4 == 0 && on_segment(p2, q1, q2));
+		}
+
+		tvec EdgePoint(T t, T precalced_length) const
+		{
+			auto const& v = m_poly.vertices;
+			const auto c = v.size();
+			if (c < 2)
+				return c ? v[0] : tvec{};
+
+			t = std::fmod(t, precalced_length);
+
+			/// First vertex whose distance along the chain is at least `t`; the point is on the edge leading to it
+			auto const& lengths = CumulativeLengths();
+			const auto it = std::lower_bound(lengths.begin() + 1, lengths.end(), t);
+			if (it == lengths.end())
+				return v[0];
+
+			const auto i = size_t(it - lengths.begin()) - 1;
+			const auto d = lengths[i + 1] - lengths[i];
+			return glm::mix(v[i], v[i + 1], d > T{} ? (t - lengths[i]) / d : T{});
+		}
+	};
+
+	using cached_polygon = tcached_polygon<float>;
+	static_assert(area_shape<float, cached_polygon>);
+	static_assert(polygon_shape<float, cached_polygon>);
+}
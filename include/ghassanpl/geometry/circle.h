@@ -31,7 +31,7 @@ namespace ghassanpl::geometry
 		constexpr bool contains(glm::tvec2<T> pt) const noexcept
 		{
 			const auto d = pt - center;
-			return (d.x * d.x) / (radius * radius) + (d.y * d.y) / (radius * radius) <= T(1);
+			return d.x * d.x + d.y * d.y <= radius * radius;
 		}
 
 		constexpr T edge_length() const noexcept
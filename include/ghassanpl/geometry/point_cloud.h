@@ -8,6 +8,8 @@
 #include "geometry_common.h"
 #include "points.h"
 #include "triangles.h"
+#include <algorithm>
+#include <cmath>
 
 namespace ghassanpl::geometry
 {
@@ -19,22 +21,425 @@ namespace ghassanpl::geometry
 		size_t index = invalid_index;
 		T weight = {};
 	};
-	/// TODO: https://github.com/delfrrr/delaunator-cpp/blob/master/include/delaunator.hpp
-	/// https://en.wikipedia.org/wiki/Delaunay_triangulation
 
+	namespace detail
+	{
+		/// Sweep-hull Delaunay triangulation (the algorithm of delaunator): points are inserted in order of distance from
+		/// the seed triangle's circumcenter, each one is connected to the visible part of the convex hull, found through an
+		/// angular hash, and the new triangles are legalized by edge flips. Predicates are evaluated in double.
+		template <typename T>
+		struct delaunay_sweep
+		{
+			std::span<glm::tvec2<T> const> points;
+
+			std::vector<size_t> vertices; /// the start vertex of each halfedge, 3 per triangle
+			std::vector<size_t> halfedges; /// the opposite halfedge of each halfedge, or `invalid_index` on the hull
+			std::vector<size_t> hull_prev, hull_next, hull_tri, hull_hash;
+			std::vector<size_t> edge_stack;
+			size_t hull_start = invalid_index;
+			double center_x = 0, center_y = 0;
+
+			explicit delaunay_sweep(std::span<glm::tvec2<T> const> points) noexcept : points(points) {}
+
+			glm::dvec2 P(size_t i) const { return { double(points[i].x), double(points[i].y) }; }
+
+			static double DistanceSquared(glm::dvec2 a, glm::dvec2 b)
+			{
+				const auto d = a - b;
+				return d.x * d.x + d.y * d.y;
+			}
+
+			/// True if the triangle is counter-clockwise in a y-down coordinate system
+			static bool Orient(glm::dvec2 p, glm::dvec2 q, glm::dvec2 r)
+			{
+				return (q.y - p.y) * (r.x - q.x) - (q.x - p.x) * (r.y - q.y) < 0;
+			}
+
+			static bool InCircle(glm::dvec2 a, glm::dvec2 b, glm::dvec2 c, glm::dvec2 p)
+			{
+				const double dx = a.x - p.x, dy = a.y - p.y;
+				const double ex = b.x - p.x, ey = b.y - p.y;
+				const double fx = c.x - p.x, fy = c.y - p.y;
+
+				const double ap = dx * dx + dy * dy;
+				const double bp = ex * ex + ey * ey;
+				const double cp = fx * fx + fy * fy;
+
+				return dx * (ey * cp - bp * fy) - dy * (ex * cp - bp * fx) + ap * (ex * fy - ey * fx) < 0;
+			}
+
+			static glm::dvec2 CircumcenterOffset(glm::dvec2 a, glm::dvec2 b, glm::dvec2 c)
+			{
+				const auto d = b - a;
+				const auto e = c - a;
+				const double bl = d.x * d.x + d.y * d.y;
+				const double cl = e.x * e.x + e.y * e.y;
+				const double f = 0.5 / (d.x * e.y - d.y * e.x);
+				return { (e.y * bl - d.y * cl) * f, (d.x * cl - e.x * bl) * f };
+			}
+
+			/// Monotonic in the angle of (dx, dy), in the [0, 1] range
+			static double PseudoAngle(double dx, double dy)
+			{
+				const double p = dx / (std::abs(dx) + std::abs(dy));
+				return (dy > 0 ? 3.0 - p : 1.0 + p) / 4.0;
+			}
+
+			size_t HashKey(glm::dvec2 p) const
+			{
+				return size_t(std::floor(PseudoAngle(p.x - center_x, p.y - center_y) * double(hull_hash.size()))) % hull_hash.size();
+			}
+
+			void Link(size_t a, size_t b)
+			{
+				halfedges[a] = b;
+				if (b != invalid_index)
+					halfedges[b] = a;
+			}
+
+			size_t AddTriangle(size_t i0, size_t i1, size_t i2, size_t a, size_t b, size_t c)
+			{
+				const auto t = vertices.size();
+				vertices.insert(vertices.end(), { i0, i1, i2 });
+				halfedges.insert(halfedges.end(), 3, invalid_index);
+				Link(t, a);
+				Link(t + 1, b);
+				Link(t + 2, c);
+				return t;
+			}
+
+			/// Flips edges until every triangle around halfedge `a` satisfies the Delaunay condition
+			size_t Legalize(size_t a)
+			{
+				size_t ar = 0;
+				while (true)
+				{
+					const auto b = halfedges[a];
+					const auto a0 = a - a % 3;
+					ar = a0 + (a + 2) % 3;
+
+					if (b == invalid_index)
+					{
+						if (edge_stack.empty())
+							break;
+						a = edge_stack.back();
+						edge_stack.pop_back();
+						continue;
+					}
+
+					const auto b0 = b - b % 3;
+					const auto al = a0 + (a + 1) % 3;
+					const auto bl = b0 + (b + 2) % 3;
+
+					const auto p0 = vertices[ar];
+					const auto pr = vertices[a];
+					const auto pl = vertices[al];
+					const auto p1 = vertices[bl];
+
+					if (InCircle(P(p0), P(pr), P(pl), P(p1)))
+					{
+						vertices[a] = p1;
+						vertices[b] = p0;
+
+						const auto hbl = halfedges[bl];
+
+						/// The edge was swapped on the other side of the hull (rare); fix the hull's triangle reference
+						if (hbl == invalid_index)
+						{
+							auto e = hull_start;
+							do
+							{
+								if (hull_tri[e] == bl)
+								{
+									hull_tri[e] = a;
+									break;
+								}
+								e = hull_prev[e];
+							} while (e != hull_start);
+						}
+
+						Link(a, hbl);
+						Link(b, halfedges[ar]);
+						Link(ar, bl);
+
+						edge_stack.push_back(b0 + (b + 1) % 3);
+					}
+					else
+					{
+						if (edge_stack.empty())
+							break;
+						a = edge_stack.back();
+						edge_stack.pop_back();
+					}
+				}
+				return ar;
+			}
+
+			/// \returns the convex hull; leaves `vertices` empty if all the points are collinear or coincident
+			std::vector<size_t> Run()
+			{
+				const auto n = points.size();
+				if (n < 3)
+					return {};
+
+				constexpr auto inf = std::numeric_limits<double>::infinity();
+
+				glm::dvec2 min{ inf, inf }, max{ -inf, -inf };
+				for (size_t i = 0; i < n; ++i)
+				{
+					min = glm::min(min, P(i));
+					max = glm::max(max, P(i));
+				}
+				const glm::dvec2 bbox_center = (min + max) * 0.5;
+
+				/// Seed triangle: the point closest to the center, its closest neighbor, and the point that makes the smallest circumcircle with them
+				size_t i0 = invalid_index, i1 = invalid_index, i2 = invalid_index;
+				double min_distance = inf;
+				for (size_t i = 0; i < n; ++i)
+				{
+					if (const auto d = DistanceSquared(bbox_center, P(i)); d < min_distance)
+					{
+						i0 = i;
+						min_distance = d;
+					}
+				}
+
+				min_distance = inf;
+				for (size_t i = 0; i < n; ++i)
+				{
+					if (i == i0) continue;
+					if (const auto d = DistanceSquared(P(i0), P(i)); d < min_distance && d > 0)
+					{
+						i1 = i;
+						min_distance = d;
+					}
+				}
+				if (i1 == invalid_index)
+					return {};
+
+				double min_radius = inf;
+				for (size_t i = 0; i < n; ++i)
+				{
+					if (i == i0 || i == i1) continue;
+					const auto offset = CircumcenterOffset(P(i0), P(i1), P(i));
+					if (const auto r = offset.x * offset.x + offset.y * offset.y; r < min_radius)
+					{
+						i2 = i;
+						min_radius = r;
+					}
+				}
+				if (i2 == invalid_index)
+					return {};
+
+				if (Orient(P(i0), P(i1), P(i2)))
+					std::swap(i1, i2);
+
+				const auto center = P(i0) + CircumcenterOffset(P(i0), P(i1), P(i2));
+				center_x = center.x;
+				center_y = center.y;
+
+				std::vector<double> distances(n);
+				std::vector<size_t> ids(n);
+				for (size_t i = 0; i < n; ++i)
+				{
+					distances[i] = DistanceSquared(P(i), center);
+					ids[i] = i;
+				}
+				std::ranges::sort(ids, [&](size_t a, size_t b) { return distances[a] < distances[b]; });
+
+				hull_prev.assign(n, invalid_index);
+				hull_next.assign(n, invalid_index);
+				hull_tri.assign(n, invalid_index);
+				hull_hash.assign(size_t(std::ceil(std::sqrt(double(n)))), invalid_index);
+
+				hull_start = i0;
+				hull_next[i0] = hull_prev[i2] = i1;
+				hull_next[i1] = hull_prev[i0] = i2;
+				hull_next[i2] = hull_prev[i1] = i0;
+
+				hull_tri[i0] = 0;
+				hull_tri[i1] = 1;
+				hull_tri[i2] = 2;
+
+				hull_hash[HashKey(P(i0))] = i0;
+				hull_hash[HashKey(P(i1))] = i1;
+				hull_hash[HashKey(P(i2))] = i2;
+
+				const auto max_triangles = 2 * n - 5;
+				vertices.reserve(max_triangles * 3);
+				halfedges.reserve(max_triangles * 3);
+				AddTriangle(i0, i1, i2, invalid_index, invalid_index, invalid_index);
+
+				glm::dvec2 previous{};
+				for (size_t k = 0; k < n; ++k)
+				{
+					const auto i = ids[k];
+					const auto p = P(i);
+
+					/// Skip near-duplicate points
+					if (k > 0 && std::abs(p.x - previous.x) <= std::numeric_limits<double>::epsilon() && std::abs(p.y - previous.y) <= std::numeric_limits<double>::epsilon())
+						continue;
+					previous = p;
+
+					if (i == i0 || i == i1 || i == i2)
+						continue;
+
+					/// Find a visible edge on the convex hull using the edge hash
+					size_t start = 0;
+					for (size_t j = 0, key = HashKey(p); j < hull_hash.size(); ++j)
+					{
+						start = hull_hash[(key + j) % hull_hash.size()];
+						if (start != invalid_index && start != hull_next[start])
+							break;
+					}
+
+					start = hull_prev[start];
+					auto e = start;
+					size_t q = 0;
+					while (q = hull_next[e], !Orient(p, P(e), P(q)))
+					{
+						e = q;
+						if (e == start)
+						{
+							e = invalid_index;
+							break;
+						}
+					}
+					if (e == invalid_index)
+						continue; /// Likely a near-duplicate point
+
+					/// Add the first triangle from the point and flip until it is legal
+					auto t = AddTriangle(e, i, hull_next[e], invalid_index, invalid_index, hull_tri[e]);
+					hull_tri[i] = Legalize(t + 2);
+					hull_tri[e] = t;
+
+					/// Walk forward through the hull, adding more triangles
+					auto next = hull_next[e];
+					while (q = hull_next[next], Orient(p, P(next), P(q)))
+					{
+						t = AddTriangle(next, i, q, hull_tri[i], invalid_index, hull_tri[next]);
+						hull_tri[i] = Legalize(t + 2);
+						hull_next[next] = next; /// Mark as removed
+						next = q;
+					}
+
+					/// Walk backward from the other side
+					if (e == start)
+					{
+						while (q = hull_prev[e], Orient(p, P(q), P(e)))
+						{
+							t = AddTriangle(q, i, e, invalid_index, hull_tri[e], hull_tri[q]);
+							Legalize(t + 2);
+							hull_tri[q] = t;
+							hull_next[e] = e;
+							e = q;
+						}
+					}
+
+					hull_start = hull_prev[i] = e;
+					hull_next[e] = hull_prev[next] = i;
+					hull_next[i] = next;
+
+					hull_hash[HashKey(p)] = i;
+					hull_hash[HashKey(P(e))] = e;
+				}
+
+				std::vector<size_t> hull;
+				auto e = hull_start;
+				do
+				{
+					hull.push_back(e);
+					e = hull_next[e];
+				} while (e != hull_start);
+				return hull;
+			}
+		};
+	}
+
+	/// https://en.wikipedia.org/wiki/Delaunay_triangulation
 	template <typename T>
 	struct delaunay_triangulation
 	{
 		using tvec = glm::tvec2<T>;
 
 		tvec_span<T> points;
+		/// Counter-clockwise triangles; edge `k` of a triangle connects its vertices `k` and `(k + 1) % 3`
 		std::vector<tindexed_triangle<>> triangles;
-		/// TODO: hull
-		/// TODO: halfedges
+		/// For each triangle, the index of the triangle across each of its edges, or `invalid_index` on the convex hull
+		std::vector<std::array<size_t, 3>> neighbors;
+		/// Indices of the points on the convex hull, in clockwise order
+		std::vector<size_t> hull;
 		/// TODO: voronoi data
-		
-		size_t triangle_at(tvec const& pt) const;
-		
+
+		delaunay_triangulation() noexcept = default;
+		explicit delaunay_triangulation(tvec_span<T> points) : points(points) { rebuild(); }
+
+		/// Triangulates `points` again, in O(n log n); call after the points have changed
+		void rebuild()
+		{
+			triangles.clear();
+			neighbors.clear();
+
+			detail::delaunay_sweep<T> sweep{ points };
+			hull = sweep.Run();
+
+			/// The sweep produces clockwise triangles, flip them and their edges
+			const auto count = sweep.vertices.size() / 3;
+			const auto opposite = [&](size_t e) { return sweep.halfedges[e] == invalid_index ? invalid_index : sweep.halfedges[e] / 3; };
+			triangles.resize(count);
+			neighbors.resize(count);
+			for (size_t t = 0; t < count; ++t)
+			{
+				triangles[t].indices = { sweep.vertices[t * 3], sweep.vertices[t * 3 + 2], sweep.vertices[t * 3 + 1] };
+				neighbors[t] = { opposite(t * 3 + 2), opposite(t * 3 + 1), opposite(t * 3) };
+			}
+		}
+
+		/// \returns the index of the triangle containing `pt`, or `invalid_index` if it lies outside the convex hull.
+		/// Uses jump-and-walk: starts from the nearest of about cbrt(n) sampled triangles and walks towards the point,
+		/// which takes O(n^(1/3)) steps on average
+		size_t triangle_at(tvec const& pt) const
+		{
+			return triangle_at(pt, invalid_index);
+		}
+
+		/// \param hint a triangle to start the walk from, e.g. the result of a query for a nearby point; `invalid_index` to pick one
+		size_t triangle_at(tvec const& pt, size_t hint) const
+		{
+			if (triangles.empty())
+				return invalid_index;
+
+			auto current = hint < triangles.size() ? hint : JumpTo(pt);
+			const glm::dvec2 p{ pt };
+			for (size_t steps = 0; steps <= triangles.size(); ++steps)
+			{
+				/// Start the edge tests after a step-dependent edge, so that degenerate configurations cannot make the walk cycle
+				size_t k = 0;
+				for (; k < 3; ++k)
+				{
+					const auto edge = (k + steps) % 3;
+					if (EdgeSide(current, edge, p) < 0)
+						break;
+				}
+
+				if (k == 3)
+					return current;
+
+				const auto next = neighbors[current][(k + steps) % 3];
+				if (next == invalid_index)
+					return invalid_index;
+				current = next;
+			}
+
+			/// Should not happen for a valid triangulation, but stay correct anyway
+			for (size_t t = 0; t < triangles.size(); ++t)
+			{
+				if (EdgeSide(t, 0, p) >= 0 && EdgeSide(t, 1, p) >= 0 && EdgeSide(t, 2, p) >= 0)
+					return t;
+			}
+			return invalid_index;
+		}
+
 		std::array<vertex_weight<T>, 3> interpolation_of(tvec const& pt) const
 		{
 			const auto idx = triangle_at(pt);
@@ -48,8 +453,42 @@ namespace ghassanpl::geometry
 				vertex_weight{triangles[idx].indices[2], bary.z}
 			};
 		}
+
+	private:
+
+		/// Twice the signed area of the triangle made by edge `edge` of triangle `t` and `p`; negative if `p` is outside the edge
+		double EdgeSide(size_t t, size_t edge, glm::dvec2 p) const
+		{
+			const glm::dvec2 a{ points[triangles[t].indices[edge]] };
+			const glm::dvec2 b{ points[triangles[t].indices[(edge + 1) % 3]] };
+			return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+		}
+
+		size_t JumpTo(tvec const& pt) const
+		{
+			const auto count = triangles.size();
+			const auto samples = std::max(size_t(1), size_t(std::cbrt(double(count))));
+			const glm::dvec2 p{ pt };
+
+			size_t best = 0;
+			double best_distance = std::numeric_limits<double>::infinity();
+			for (size_t i = 0; i < samples; ++i)
+			{
+				const auto t = i * count / samples;
+				const auto d = glm::dvec2{ points[triangles[t].indices[0]] } - p;
+				if (const auto distance = d.x * d.x + d.y * d.y; distance < best_distance)
+				{
+					best = t;
+					best_distance = distance;
+				}
+			}
+			return best;
+		}
 	};
 
+	template <typename T>
+	delaunay_triangulation(std::vector<glm::tvec2<T>>&) -> delaunay_triangulation<T>;
+
 	template <typename T, typename FUNC>
 	auto linear_interpolation(std::span<vertex_weight<T>> weights, FUNC&& value_func)
 	{
@@ -8,7 +8,9 @@
 #include "./segment.h"
 #include "./triangles.h"
 #include "shape_concepts.h"
+#include "../bits.h"
 #include <array>
+#include <deque>
 
 namespace ghassanpl::geometry
 {
@@ -211,9 +213,8 @@ namespace ghassanpl::geometry
 		T calculate_area() const
 		{
 			T result{};
-			for_each_edge([&](tvec const& v1, tvec const& v2) {
-				result += v1.x * v2.y - v2.x * v1.y;
-			});
+			for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++)
+				result += vertices[j].x * vertices[i].y - vertices[i].x * vertices[j].y;
 			return result * T(0.5);
 		}
 
@@ -283,6 +284,31 @@ namespace ghassanpl::geometry
 		}
 	};
 
+	template <std::floating_point T>
+	auto tpolygon<T>::closest_point_to(tvec pt) const -> tvec
+	{
+		if (vertices.empty())
+			return pt;
+		if (vertices.size() == 1)
+			return vertices[0];
+		if (contains(pt))
+			return pt;
+
+		tvec result = vertices[0];
+		auto best = std::numeric_limits<T>::infinity();
+		for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++)
+		{
+			const auto on_edge = tsegment<T>{ vertices[j], vertices[i] }.closest_point_to(pt);
+			const auto d = on_edge - pt;
+			if (const auto distance = glm::dot(d, d); distance < best)
+			{
+				best = distance;
+				result = on_edge;
+			}
+		}
+		return result;
+	}
+
 	using polygon = tpolygon<float>;
 	static_assert(polygon_shape<float, polygon>);
 	static_assert(std::ranges::random_access_range<polygon>);
@@ -301,7 +327,7 @@ namespace ghassanpl::geometry
 		{
 			for (auto& tr : triangles)
 			{
-				return tr.as_triangle(poly);
+				func(tr.as_triangle(poly.vertices));
 			}
 		}
 
@@ -355,130 +381,599 @@ namespace ghassanpl::geometry
 	template <typename TR>
 	auto calculate_total_area(TR const& trpoly)
 	{
-		using T = decltype(trpoly.poly)::value_type;
+		using T = typename std::remove_cvref_t<decltype(trpoly.poly)>::value_type;
 		T result{};
 		for (auto& tr : trpoly.triangles)
 			result += calculate_indexed_triangle_area(trpoly.poly, tr);
 		return result;
 	}
 
-	/*
-	public static void Triangulate(IList<Vector2> points, List<int> populate)
+	namespace detail
 	{
-		IList<Vector2> points2 = points;
-		if (points2.Count < 3)
+		/// Ear clipping over a doubly linked vertex ring, after mapbox's earcut; coordinates are kept in double
+		/// so that float inputs do not lose the orientation tests on large polygons
+		template <std::integral IDX>
+		struct earcut_state
 		{
-			return;
-		}
+			struct node
+			{
+				size_t index = 0;
+				double x = 0, y = 0;
+				node* prev = nullptr;
+				node* next = nullptr;
+				uint64_t z = 0;
+				node* prev_z = nullptr;
+				node* next_z = nullptr;
+				bool steiner = false;
+			};
+
+			std::vector<tindexed_triangle<IDX>>& triangles;
+			std::deque<node> nodes; /// deque, so that splitting rings does not invalidate links
+			double min_x = 0, min_y = 0, inv_size = 0;
+
+			explicit earcut_state(std::vector<tindexed_triangle<IDX>>& triangles) noexcept : triangles(triangles) {}
+
+			template <typename T>
+			void Run(std::span<glm::tvec2<T> const> vertices, std::span<size_t const> hole_starts)
+			{
+				const auto outer_end = hole_starts.empty() ? vertices.size() : hole_starts.front();
+				auto outer = LinkedList(vertices, 0, outer_end, true);
+				if (!outer || outer->next == outer->prev)
+					return;
 
-		Span<int> span = ((points2.Count >= 1000) ? ((Span<int>)new int[points2.Count]) : stackalloc int[points2.Count]);
-		Span<int> list2 = span;
-		if (Area() > 0f)
-		{
-			for (int i = 0; i < points2.Count; i++)
+				if (!hole_starts.empty())
+					outer = EliminateHoles(vertices, hole_starts, outer);
+
+				/// Only hash big polygons, the z-order curve does not pay off for small ones
+				if (vertices.size() > 80)
+				{
+					double max_x = min_x = vertices[0].x, max_y = min_y = vertices[0].y;
+					for (size_t i = 1; i < outer_end; ++i)
+					{
+						min_x = std::min(min_x, double(vertices[i].x));
+						min_y = std::min(min_y, double(vertices[i].y));
+						max_x = std::max(max_x, double(vertices[i].x));
+						max_y = std::max(max_y, double(vertices[i].y));
+					}
+					inv_size = std::max(max_x - min_x, max_y - min_y);
+					inv_size = inv_size != 0 ? 32767.0 / inv_size : 0;
+				}
+
+				EarcutLinked(outer, 0);
+			}
+
+			template <typename T>
+			node* LinkedList(std::span<glm::tvec2<T> const> vertices, size_t start, size_t end, bool clockwise)
 			{
-				list2[i] = i;
+				double area = 0;
+				for (size_t i = start, j = end - 1; i < end; j = i++)
+					area += (double(vertices[j].x) - vertices[i].x) * (double(vertices[i].y) + vertices[j].y);
+
+				node* last = nullptr;
+				if (clockwise == (area > 0))
+				{
+					for (size_t i = start; i < end; ++i)
+						last = InsertNode(i, vertices[i], last);
+				}
+				else
+				{
+					for (size_t i = end; i-- > start;)
+						last = InsertNode(i, vertices[i], last);
+				}
+
+				if (last && Equals(last, last->next))
+				{
+					RemoveNode(last);
+					last = last->next;
+				}
+				return last;
 			}
-		}
-		else
-		{
-			for (int j = 0; j < points2.Count; j++)
+
+			node* FilterPoints(node* start, node* end = nullptr)
 			{
-				list2[j] = points2.Count - 1 - j;
+				if (!start) return start;
+				if (!end) end = start;
+
+				node* p = start;
+				bool again = false;
+				do
+				{
+					again = false;
+					if (!p->steiner && (Equals(p, p->next) || Area(p->prev, p, p->next) == 0))
+					{
+						RemoveNode(p);
+						p = end = p->prev;
+						if (p == p->next)
+							break;
+						again = true;
+					}
+					else
+						p = p->next;
+				} while (again || p != end);
+
+				return end;
 			}
-		}
 
-		int num = points2.Count;
-		int num2 = 2 * num;
-		int num3 = num - 1;
-		while (num > 2)
-		{
-			if (num2-- <= 0)
+			void EarcutLinked(node* ear, int pass)
 			{
-				return;
+				if (!ear) return;
+
+				if (!pass && inv_size)
+					IndexCurve(ear);
+
+				node* stop = ear;
+				while (ear->prev != ear->next)
+				{
+					node* prev = ear->prev;
+					node* next = ear->next;
+
+					if (inv_size ? IsEarHashed(ear) : IsEar(ear))
+					{
+						triangles.push_back({ { IDX(prev->index), IDX(ear->index), IDX(next->index) } });
+						RemoveNode(ear);
+						ear = next->next;
+						stop = next->next;
+						continue;
+					}
+
+					ear = next;
+					if (ear == stop)
+					{
+						/// No ears left; first remove degenerate vertices, then untangle small self-intersections,
+						/// and as a last resort split the ring along a valid diagonal
+						if (pass == 0)
+							EarcutLinked(FilterPoints(ear), 1);
+						else if (pass == 1)
+							EarcutLinked(CureLocalIntersections(FilterPoints(ear)), 2);
+						else if (pass == 2)
+							SplitEarcut(ear);
+						break;
+					}
+				}
 			}
 
-			int num4 = num3;
-			if (num <= num4)
+			bool IsEar(node* ear) const
 			{
-				num4 = 0;
+				node const* a = ear->prev;
+				node const* b = ear;
+				node const* c = ear->next;
+				if (Area(a, b, c) >= 0) return false; /// reflex
+
+				const double x0 = std::min({ a->x, b->x, c->x }), y0 = std::min({ a->y, b->y, c->y });
+				const double x1 = std::max({ a->x, b->x, c->x }), y1 = std::max({ a->y, b->y, c->y });
+
+				for (node const* p = c->next; p != a; p = p->next)
+				{
+					if (p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && PointInTriangle(a, b, c, p) && Area(p->prev, p, p->next) >= 0)
+						return false;
+				}
+				return true;
 			}
 
-			num3 = num4 + 1;
-			if (num <= num3)
+			bool IsEarHashed(node* ear) const
 			{
-				num3 = 0;
+				node const* a = ear->prev;
+				node const* b = ear;
+				node const* c = ear->next;
+				if (Area(a, b, c) >= 0) return false;
+
+				const double x0 = std::min({ a->x, b->x, c->x }), y0 = std::min({ a->y, b->y, c->y });
+				const double x1 = std::max({ a->x, b->x, c->x }), y1 = std::max({ a->y, b->y, c->y });
+
+				const auto min_z = ZOrder(x0, y0);
+				const auto max_z = ZOrder(x1, y1);
+
+				const auto blocks = [&](node const* p) {
+					return p != a && p != c && p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && PointInTriangle(a, b, c, p) && Area(p->prev, p, p->next) >= 0;
+				};
+
+				/// Look for points inside the triangle in both directions along the z-order curve
+				node const* p = ear->prev_z;
+				node const* n = ear->next_z;
+				while (p && p->z >= min_z && n && n->z <= max_z)
+				{
+					if (blocks(p)) return false;
+					p = p->prev_z;
+					if (blocks(n)) return false;
+					n = n->next_z;
+				}
+				for (; p && p->z >= min_z; p = p->prev_z)
+					if (blocks(p)) return false;
+				for (; n && n->z <= max_z; n = n->next_z)
+					if (blocks(n)) return false;
+				return true;
 			}
 
-			int num5 = num3 + 1;
-			if (num <= num5)
+			node* CureLocalIntersections(node* start)
 			{
-				num5 = 0;
+				node* p = start;
+				do
+				{
+					node* a = p->prev;
+					node* b = p->next->next;
+
+					if (!Equals(a, b) && Intersects(a, p, p->next, b) && LocallyInside(a, b) && LocallyInside(b, a))
+					{
+						triangles.push_back({ { IDX(a->index), IDX(p->index), IDX(b->index) } });
+						RemoveNode(p);
+						RemoveNode(p->next);
+						p = start = b;
+					}
+					p = p->next;
+				} while (p != start);
+
+				return FilterPoints(p);
 			}
 
-			if (Snip(num4, num3, num5, num, list2))
+			void SplitEarcut(node* start)
 			{
-				populate.Add(list2[num4]);
-				populate.Add(list2[num3]);
-				populate.Add(list2[num5]);
-				int num6 = num3;
-				for (int k = num3 + 1; k < num; k++)
+				node* a = start;
+				do
 				{
-					list2[num6] = list2[k];
-					num6++;
+					for (node* b = a->next->next; b != a->prev; b = b->next)
+					{
+						if (a->index != b->index && IsValidDiagonal(a, b))
+						{
+							node* c = SplitPolygon(a, b);
+							a = FilterPoints(a, a->next);
+							c = FilterPoints(c, c->next);
+							EarcutLinked(a, 0);
+							EarcutLinked(c, 0);
+							return;
+						}
+					}
+					a = a->next;
+				} while (a != start);
+			}
+
+			template <typename T>
+			node* EliminateHoles(std::span<glm::tvec2<T> const> vertices, std::span<size_t const> hole_starts, node* outer)
+			{
+				std::vector<node*> queue;
+				queue.reserve(hole_starts.size());
+				for (size_t i = 0; i < hole_starts.size(); ++i)
+				{
+					const auto start = hole_starts[i];
+					const auto end = i + 1 < hole_starts.size() ? hole_starts[i + 1] : vertices.size();
+					if (start > end || end > vertices.size())
+						throw std::invalid_argument("hole_starts");
+					if (start == end)
+						continue;
+					auto list = LinkedList(vertices, start, end, false);
+					if (list == list->next)
+						list->steiner = true;
+					queue.push_back(GetLeftmost(list));
 				}
 
-				num--;
-				num2 = 2 * num;
+				std::ranges::sort(queue, [](node const* a, node const* b) { return a->x < b->x || (a->x == b->x && a->y < b->y); });
+
+				/// Bridge holes from left to right so that every bridge connects to a ring that is already part of the outline
+				for (auto hole : queue)
+					outer = EliminateHole(hole, outer);
+				return outer;
 			}
-		}
 
-		populate.Reverse();
-		float Area()
-		{
-			float num7 = 0f;
-			int index = points2.Count - 1;
-			int num8 = 0;
-			while (num8 < points2.Count)
+			node* EliminateHole(node* hole, node* outer)
 			{
-				Vector2 vector = points2[index];
-				Vector2 vector2 = points2[num8];
-				num7 += vector.X * vector2.Y - vector2.X * vector.Y;
-				index = num8++;
+				node* bridge = FindHoleBridge(hole, outer);
+				if (!bridge)
+					return outer;
+
+				node* bridge_reverse = SplitPolygon(bridge, hole);
+				FilterPoints(bridge_reverse, bridge_reverse->next);
+				return FilterPoints(bridge, bridge->next);
 			}
 
-			return num7 * 0.5f;
-		}
+			/// David Eberly's algorithm for finding a bridge between a hole and the outer polygon
+			node* FindHoleBridge(node* hole, node* outer) const
+			{
+				node* p = outer;
+				const double hx = hole->x, hy = hole->y;
+				double qx = -std::numeric_limits<double>::infinity();
+				node* m = nullptr;
 
-		bool Snip(int u, int v, int w, int n, Span<int> list)
-		{
-			Vector2 a = points2[list[u]];
-			Vector2 b = points2[list[v]];
-			Vector2 c = points2[list[w]];
-			if (float.Epsilon > (b.X - a.X) * (c.Y - a.Y) - (b.Y - a.Y) * (c.X - a.X))
+				/// Find a segment intersected by a ray from the hole's leftmost point to the left
+				do
+				{
+					if (hy <= p->y && hy >= p->next->y && p->next->y != p->y)
+					{
+						const double x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+						if (x <= hx && x > qx)
+						{
+							qx = x;
+							m = p->x < p->next->x ? p : p->next;
+							if (x == hx)
+								return m; /// hole touches outer segment; pick leftmost endpoint
+						}
+					}
+					p = p->next;
+				} while (p != outer);
+
+				if (!m)
+					return nullptr;
+
+				/// Look for points inside the triangle of hole point, segment intersection and endpoint;
+				/// if there are none, the endpoint is visible, otherwise pick the one with the minimum angle to the ray
+				node* const stop = m;
+				const double mx = m->x, my = m->y;
+				double tan_min = std::numeric_limits<double>::infinity();
+
+				p = m;
+				do
+				{
+					if (hx >= p->x && p->x >= mx && hx != p->x &&
+						PointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y))
+					{
+						const double tan = std::abs(hy - p->y) / (hx - p->x);
+						if (LocallyInside(p, hole) && (tan < tan_min || (tan == tan_min && (p->x > m->x || (p->x == m->x && SectorContainsSector(m, p))))))
+						{
+							m = p;
+							tan_min = tan;
+						}
+					}
+					p = p->next;
+				} while (p != stop);
+
+				return m;
+			}
+
+			static bool SectorContainsSector(node const* m, node const* p)
+			{
+				return Area(m->prev, m, p->prev) < 0 && Area(p->next, m, m->next) < 0;
+			}
+
+			void IndexCurve(node* start) const
 			{
+				node* p = start;
+				do
+				{
+					if (p->z == 0)
+						p->z = ZOrder(p->x, p->y);
+					p->prev_z = p->prev;
+					p->next_z = p->next;
+					p = p->next;
+				} while (p != start);
+
+				p->prev_z->next_z = nullptr;
+				p->prev_z = nullptr;
+
+				SortLinked(p);
+			}
+
+			/// Simon Tatham's linked list merge sort
+			static node* SortLinked(node* list)
+			{
+				size_t in_size = 1;
+				size_t merges = 0;
+				do
+				{
+					node* p = list;
+					list = nullptr;
+					node* tail = nullptr;
+					merges = 0;
+
+					while (p)
+					{
+						++merges;
+						node* q = p;
+						size_t p_size = 0;
+						for (size_t i = 0; i < in_size && q; ++i)
+						{
+							++p_size;
+							q = q->next_z;
+						}
+						size_t q_size = in_size;
+
+						while (p_size > 0 || (q_size > 0 && q))
+						{
+							node* e = nullptr;
+							if (p_size != 0 && (q_size == 0 || !q || p->z <= q->z))
+							{
+								e = p;
+								p = p->next_z;
+								--p_size;
+							}
+							else
+							{
+								e = q;
+								q = q->next_z;
+								--q_size;
+							}
+
+							if (tail)
+								tail->next_z = e;
+							else
+								list = e;
+							e->prev_z = tail;
+							tail = e;
+						}
+						p = q;
+					}
+
+					tail->next_z = nullptr;
+					in_size *= 2;
+				} while (merges > 1);
+
+				return list;
+			}
+
+			uint64_t ZOrder(double x, double y) const
+			{
+				return morton_encode(uint32_t(std::max((x - min_x) * inv_size, 0.0)), uint32_t(std::max((y - min_y) * inv_size, 0.0)));
+			}
+
+			static node* GetLeftmost(node* start)
+			{
+				node* p = start;
+				node* leftmost = start;
+				do
+				{
+					if (p->x < leftmost->x || (p->x == leftmost->x && p->y < leftmost->y))
+						leftmost = p;
+					p = p->next;
+				} while (p != start);
+				return leftmost;
+			}
+
+			static bool PointInTriangle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py)
+			{
+				return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+					(ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+					(bx - px) * (cy - py) >= (cx - px) * (by - py);
+			}
+
+			static bool PointInTriangle(node const* a, node const* b, node const* c, node const* p)
+			{
+				return PointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y);
+			}
+
+			static bool IsValidDiagonal(node const* a, node const* b)
+			{
+				return a->next->index != b->index && a->prev->index != b->index && !IntersectsPolygon(a, b) &&
+					((LocallyInside(a, b) && LocallyInside(b, a) && MiddleInside(a, b) && (Area(a->prev, a, b->prev) != 0 || Area(a, b->prev, b) != 0)) ||
+					(Equals(a, b) && Area(a->prev, a, a->next) > 0 && Area(b->prev, b, b->next) > 0));
+			}
+
+			/// Twice the signed area of a triangle, negative for counter-clockwise triangles
+			static double Area(node const* p, node const* q, node const* r)
+			{
+				return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+			}
+
+			static bool Equals(node const* a, node const* b) { return a->x == b->x && a->y == b->y; }
+
+			static int Sign(double v) { return (v > 0) - (v < 0); }
+
+			static bool OnSegment(node const* p, node const* q, node const* r)
+			{
+				return q->x <= std::max(p->x, r->x) && q->x >= std::min(p->x, r->x) && q->y <= std::max(p->y, r->y) && q->y >= std::min(p->y, r->y);
+			}
+
+			static bool Intersects(node const* p1, node const* q1, node const* p2, node const* q2)
+			{
+				const int o1 = Sign(Area(p1, q1, p2));
+				const int o2 = Sign(Area(p1, q1, q2));
+				const int o3 = Sign(Area(p2, q2, p1));
+				const int o4 = Sign(Area(p2, q2, q1));
+
+				if (o1 != o2 && o3 != o4) return true;
+				if (o1 == 0 && OnSegment(p1, p2, q1)) return true;
+				if (o2 == 0 && OnSegment(p1, q2, q1)) return true;
+				if (o3 == 0 && OnSegment(p2, p1, q2)) return true;
+				if (o4 == 0 && OnSegment(p2, q1, q2)) return true;
 				return false;
 			}
 
-			for (int l = 0; l < n; l++)
+			static bool IntersectsPolygon(node const* a, node const* b)
+			{
+				node const* p = a;
+				do
+				{
+					if (p->index != a->index && p->next->index != a->index && p->index != b->index && p->next->index != b->index && Intersects(p, p->next, a, b))
+						return true;
+					p = p->next;
+				} while (p != a);
+				return false;
+			}
+
+			static bool LocallyInside(node const* a, node const* b)
+			{
+				return Area(a->prev, a, a->next) < 0
+					? Area(a, b, a->next) >= 0 && Area(a, a->prev, b) >= 0
+					: Area(a, b, a->prev) < 0 || Area(a, a->next, b) < 0;
+			}
+
+			static bool MiddleInside(node const* a, node const* b)
+			{
+				node const* p = a;
+				bool inside = false;
+				const double px = (a->x + b->x) / 2, py = (a->y + b->y) / 2;
+				do
+				{
+					if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y && (px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x))
+						inside = !inside;
+					p = p->next;
+				} while (p != a);
+				return inside;
+			}
+
+			/// Links a and b with a bridge; if they are on the same ring this splits it in two, otherwise merges the two rings
+			node* SplitPolygon(node* a, node* b)
+			{
+				node* a2 = &nodes.emplace_back(node{ .index = a->index, .x = a->x, .y = a->y });
+				node* b2 = &nodes.emplace_back(node{ .index = b->index, .x = b->x, .y = b->y });
+				node* an = a->next;
+				node* bp = b->prev;
+
+				a->next = b;
+				b->prev = a;
+
+				a2->next = an;
+				an->prev = a2;
+
+				b2->next = a2;
+				a2->prev = b2;
+
+				bp->next = b2;
+				b2->prev = bp;
+
+				return b2;
+			}
+
+			template <typename T>
+			node* InsertNode(size_t i, glm::tvec2<T> const& pt, node* last)
 			{
-				if (l != u && l != v && l != w && InsideTriangle(a, b, c, points2[list[l]]))
+				node* p = &nodes.emplace_back(node{ .index = i, .x = double(pt.x), .y = double(pt.y) });
+				if (!last)
 				{
-					return false;
+					p->prev = p;
+					p->next = p;
 				}
+				else
+				{
+					p->next = last->next;
+					p->prev = last;
+					last->next->prev = p;
+					last->next = p;
+				}
+				return p;
 			}
 
-			return true;
-		}
+			static void RemoveNode(node* p)
+			{
+				p->next->prev = p->prev;
+				p->prev->next = p->next;
+
+				if (p->prev_z) p->prev_z->next_z = p->next_z;
+				if (p->next_z) p->next_z->prev_z = p->prev_z;
+			}
+		};
 	}
-	*/
+
+	/// Triangulates a polygon, optionally with holes, by ear clipping in O(n log n) on typical inputs
+	/// (the same algorithm as mapbox's earcut: z-order hashed ear tests, hole bridging, and fallbacks for degenerate input).
+	/// \param vertices the vertices of the outer ring, followed by the vertices of every hole, in any winding order
+	/// \param hole_starts the index into `vertices` of the first vertex of each hole, in increasing order
+	/// \returns counter-clockwise triangles indexing into `vertices`; `vertices.size() - 2 + 2 * hole count` of them for valid input
+	template <std::integral IDX = size_t, std::ranges::contiguous_range RANGE>
+	requires std::floating_point<typename std::ranges::range_value_t<RANGE>::value_type>
+	std::vector<tindexed_triangle<IDX>> earcut(RANGE const& vertices, std::span<size_t const> hole_starts = {})
+	{
+		using T = typename std::ranges::range_value_t<RANGE>::value_type;
+		std::vector<tindexed_triangle<IDX>> result;
+		const auto count = std::ranges::size(vertices);
+		if (count < 3)
+			return result;
+		result.reserve(count - 2 + hole_starts.size() * 2);
+		detail::earcut_state<IDX> state{ result };
+		state.Run(std::span<glm::tvec2<T> const>{ std::ranges::data(vertices), count }, hole_starts);
+		return result;
+	}
+
 	template <typename T>
 	polygon_triangulation<T> triangulate(tpolygon<T> const& poly)
 	{
-		polygon_triangulation<T> result{poly};
-		/// https://github.com/mapbox/earcut.hpp
-		throw "unimplemented";
-		return result;
+		return { poly, earcut(poly.vertices) };
 	}
 
 	namespace immutable
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "geometry_common.h"
+#include "segment.h"
 
 namespace ghassanpl::geometry
 {
@@ -41,6 +42,19 @@ namespace ghassanpl::geometry
 			const auto d = pt - start;
 			return glm::dot(d, dir);
 		}
+
+		/// \returns the distance along the ray (in multiples of `dir`'s length) at which it crosses `seg`, if it does
+		std::optional<T> intersection_distance(segment const& seg) const noexcept
+		{
+			const auto s = seg.vec();
+			const auto q = seg.start - start;
+			const auto denominator = dir.x * s.y - dir.y * s.x;
+			const auto t = (q.x * s.y - q.y * s.x) / denominator;
+			const auto u = (q.x * dir.y - q.y * dir.x) / denominator;
+			if (denominator != T{} && t >= T{} && u >= T{} && u <= T(1))
+				return t;
+			return std::nullopt;
+		}
 	};
 
 	using ray = tray<float>;
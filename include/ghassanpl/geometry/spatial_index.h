@@ -0,0 +1,1282 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "shape_concepts.h"
+#include "../parallel.h"
+#include <vector>
+#include <array>
+#include <span>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+#include <stdexcept>
+
+/// Spatial indices over the bounding boxes of many objects, each identified by a `uint32_t` id.
+///
+/// All of them share the same set of queries:
+/// - `query(range, func)` calls `func(id)` for each object whose box overlaps `range`
+/// - `raycast(start, dir, max_distance, func)` calls `func(id, distance)` for each object whose box is crossed by the ray, with the distance at which the ray enters the box
+/// - `closest_hit(start, dir, max_distance[, hit_func])` finds the object hit first, with `hit_func(id, box_distance)` giving the exact distance (or nullopt for a miss)
+/// - `nearest(point[, distance_func][, max_distance])` finds the object closest to `point`, with `distance_func(id, point)` giving the exact distance
+/// - `for_each_overlapping_pair(func)` calls `func(a, b)` with `a < b` for each pair of objects whose boxes overlap
+/// - `overlapping_pairs([narrow_phase, ]thread_count)` collects those pairs (that pass `narrow_phase(a, b)`), spreading the work over threads
+///
+/// Distances along rays are measured in multiples of `dir`'s length. The exact distance functions must never return less than the distance to the object's box.
+/// Callbacks that return something convertible to bool can stop the iteration by returning true, in which case the query returns true as well.
+
+namespace ghassanpl::geometry
+{
+	/// An object found by a ray or nearest-object query on a spatial index
+	template <typename T>
+	struct tspatial_hit
+	{
+		uint32_t id = 0;
+		T distance{};
+	};
+
+	using spatial_hit = tspatial_hit<float>;
+
+	namespace detail
+	{
+		template <typename FUNC, typename... ARGS>
+		bool invoke_until(FUNC& func, ARGS&&... args)
+		{
+			if constexpr (std::is_convertible_v<std::invoke_result_t<FUNC&, ARGS...>, bool>)
+				return bool(func(std::forward<ARGS>(args)...));
+			else
+			{
+				func(std::forward<ARGS>(args)...);
+				return false;
+			}
+		}
+
+		template <typename T>
+		[[nodiscard]] T box_distance_squared(trec2<T> const& box, glm::tvec2<T> pt) noexcept
+		{
+			const auto d = glm::max(glm::max(box.p1 - pt, pt - box.p2), glm::tvec2<T>{});
+			return glm::dot(d, d);
+		}
+
+		template <typename T>
+		[[nodiscard]] trec2<T> box_union(trec2<T> a, trec2<T> const& b) noexcept { return a.include(b); }
+
+		/// Half of the perimeter, the 2D equivalent of the surface area used by the SAH
+		template <typename T>
+		[[nodiscard]] T half_perimeter(trec2<T> const& box) noexcept { return box.width() + box.height(); }
+
+		template <typename T>
+		struct ray_segment
+		{
+			glm::tvec2<T> start{};
+			glm::tvec2<T> dir{};
+			glm::tvec2<T> inv_dir{};
+			T max_distance{};
+
+			ray_segment(glm::tvec2<T> start, glm::tvec2<T> dir, T max_distance) noexcept
+				: start(start), dir(dir), inv_dir(T(1) / dir.x, T(1) / dir.y), max_distance(max_distance)
+			{
+			}
+
+			/// \returns the range of distances at which the ray is inside `box`, if any
+			[[nodiscard]] std::optional<std::pair<T, T>> span(trec2<T> const& box) const noexcept
+			{
+				T near = 0, far = max_distance;
+				for (int axis = 0; axis < 2; ++axis)
+				{
+					if (dir[axis] == T{})
+					{
+						if (start[axis] < box.p1[axis] || start[axis] > box.p2[axis])
+							return std::nullopt;
+						continue;
+					}
+					auto t1 = (box.p1[axis] - start[axis]) * inv_dir[axis];
+					auto t2 = (box.p2[axis] - start[axis]) * inv_dir[axis];
+					if (t1 > t2) std::swap(t1, t2);
+					near = std::max(near, t1);
+					far = std::min(far, t2);
+					if (near > far)
+						return std::nullopt;
+				}
+				return std::pair{ near, far };
+			}
+
+			[[nodiscard]] std::optional<T> entry(trec2<T> const& box) const noexcept
+			{
+				if (const auto range = span(box)) return range->first;
+				return std::nullopt;
+			}
+		};
+
+		using id_pair = std::pair<uint32_t, uint32_t>;
+
+		/// Splits [0, `count`) into chunks handed out to `thread_count` threads (0 meaning one per hardware thread), calls `func(begin, end, pairs)`
+		/// for each chunk, and concatenates the pairs in chunk order, so that the result doesn't depend on the number of threads
+		template <typename FUNC>
+		[[nodiscard]] std::vector<id_pair> collect_pairs(size_t count, unsigned thread_count, FUNC const& func)
+		{
+			static constexpr size_t min_chunk_size = 256;
+			const auto workers = parallel_worker_count(count, thread_count);
+			const auto chunk_size = std::max(min_chunk_size, count / (size_t(workers) * 8) + 1);
+			const auto chunk_count = (count + chunk_size - 1) / chunk_size;
+
+			std::vector<std::vector<id_pair>> chunk_pairs(chunk_count);
+			parallel_for_each_index(chunk_count, workers, [&](size_t chunk) {
+				func(chunk * chunk_size, std::min(count, (chunk + 1) * chunk_size), chunk_pairs[chunk]);
+			});
+
+			std::vector<id_pair> result;
+			size_t total = 0;
+			for (auto const& pairs : chunk_pairs)
+				total += pairs.size();
+			result.reserve(total);
+			for (auto const& pairs : chunk_pairs)
+				result.insert(result.end(), pairs.begin(), pairs.end());
+			return result;
+		}
+
+		template <typename T, typename SHAPE>
+		[[nodiscard]] std::vector<trec2<T>> bounding_boxes_of(std::span<SHAPE const> shapes)
+		{
+			std::vector<trec2<T>> result;
+			result.reserve(shapes.size());
+			for (auto const& shape : shapes)
+				result.push_back(trec2<T>(shape.bounding_box()));
+			return result;
+		}
+	}
+
+	/// A bounding volume hierarchy built using the surface area heuristic (with binning), for mostly static sets of objects,
+	/// or ones that move coherently enough that refitting the boxes (see \ref refit) keeps the tree good
+	template <std::floating_point T>
+	class tbvh
+	{
+	public:
+
+		using tvec = glm::tvec2<T>;
+		using box_type = trec2<T>;
+		using hit_type = tspatial_hit<T>;
+
+		struct options
+		{
+			/// Nodes with more objects than this are always split
+			uint32_t max_leaf_size = 4;
+			/// Number of candidate split positions tried on each axis
+			uint32_t bin_count = 16;
+		};
+
+		tbvh() noexcept = default;
+		explicit tbvh(options opts) : m_options(opts) { ValidateOptions(); }
+		explicit tbvh(std::span<box_type const> boxes) { build(boxes); }
+		tbvh(std::span<box_type const> boxes, options opts) : m_options(opts) { ValidateOptions(); build(boxes); }
+
+		[[nodiscard]] options const& get_options() const noexcept { return m_options; }
+
+		/// Rebuilds the tree from scratch, with object `i` having box `boxes[i]`
+		void build(std::span<box_type const> boxes)
+		{
+			const auto count = uint32_t(boxes.size());
+			m_items.resize(count);
+			std::iota(m_items.begin(), m_items.end(), 0u);
+			m_item_boxes.assign(boxes.begin(), boxes.end());
+			Build();
+		}
+
+		/// Rebuilds the tree from the bounding boxes of `shapes`
+		template <typename SHAPE>
+		requires shape<T, SHAPE>
+		void build(std::span<SHAPE const> shapes) { build(detail::bounding_boxes_of<T>(shapes)); }
+
+		[[nodiscard]] size_t size() const noexcept { return m_items.size(); }
+		[[nodiscard]] bool empty() const noexcept { return m_items.empty(); }
+		[[nodiscard]] size_t node_count() const noexcept { return m_nodes.size(); }
+		[[nodiscard]] box_type const& box(uint32_t id) const noexcept { return m_item_boxes[m_slot_of[id]]; }
+		[[nodiscard]] box_type bounds() const noexcept { return m_nodes.empty() ? box_type::invalid() : m_nodes[0].bounds; }
+
+		/// Changes the box of object `id`; call \ref refit afterwards, before any queries
+		void update(uint32_t id, box_type const& box)
+		{
+			if (id >= m_slot_of.size())
+				throw std::invalid_argument{ "object id out of range" };
+			m_item_boxes[m_slot_of[id]] = box;
+		}
+
+		/// Recalculates the boxes of all nodes after objects were \ref update "updated", keeping the structure of the tree
+		void refit() noexcept
+		{
+			/// Children are always created after their parents, so going backwards visits them first
+			for (size_t i = m_nodes.size(); i-- > 0;)
+			{
+				auto& node = m_nodes[i];
+				if (node.count)
+				{
+					node.bounds = box_type::exclusive();
+					for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+						node.bounds.include(m_item_boxes[slot]);
+				}
+				else
+					node.bounds = detail::box_union(m_nodes[node.first].bounds, m_nodes[node.first + 1].bounds);
+			}
+		}
+
+		/// Sets the boxes of all objects at once and \ref refit "refits" the tree
+		void refit(std::span<box_type const> boxes)
+		{
+			if (boxes.size() != m_items.size())
+				throw std::invalid_argument{ "box count doesn't match the number of objects" };
+			for (size_t slot = 0; slot < m_items.size(); ++slot)
+				m_item_boxes[slot] = boxes[m_items[slot]];
+			refit();
+		}
+
+		template <typename FUNC>
+		bool query(box_type const& range, FUNC&& func) const
+		{
+			return Traverse(
+				[&](box_type const& bounds) { return bounds.intersects(range); },
+				[&](uint32_t slot) { return m_item_boxes[slot].intersects(range) && detail::invoke_until(func, m_items[slot]); });
+		}
+
+		template <typename FUNC>
+		bool raycast(tvec start, tvec dir, T max_distance, FUNC&& func) const
+		{
+			const detail::ray_segment<T> ray{ start, dir, max_distance };
+			return Traverse(
+				[&](box_type const& bounds) { return ray.span(bounds).has_value(); },
+				[&](uint32_t slot) {
+					const auto entry = ray.entry(m_item_boxes[slot]);
+					return entry && detail::invoke_until(func, m_items[slot], *entry);
+				});
+		}
+
+		template <typename HIT_FUNC>
+		[[nodiscard]] std::optional<hit_type> closest_hit(tvec start, tvec dir, T max_distance, HIT_FUNC&& hit) const
+		{
+			const detail::ray_segment<T> ray{ start, dir, max_distance };
+			return ClosestFirst(
+				[&](box_type const& bounds) { return ray.entry(bounds); },
+				[&](uint32_t id, T box_distance) -> std::optional<T> { return hit(id, box_distance); });
+		}
+
+		[[nodiscard]] std::optional<hit_type> closest_hit(tvec start, tvec dir, T max_distance = std::numeric_limits<T>::infinity()) const
+		{
+			return closest_hit(start, dir, max_distance, [](uint32_t, T box_distance) { return std::optional{ box_distance }; });
+		}
+
+		template <typename DISTANCE_FUNC>
+		requires std::is_invocable_r_v<T, DISTANCE_FUNC&, uint32_t, tvec>
+		[[nodiscard]] std::optional<hit_type> nearest(tvec pt, DISTANCE_FUNC&& distance, T max_distance = std::numeric_limits<T>::infinity()) const
+		{
+			return ClosestFirst(
+				[&](box_type const& bounds) -> std::optional<T> {
+					const auto d = std::sqrt(detail::box_distance_squared(bounds, pt));
+					return d <= max_distance ? std::optional{ d } : std::nullopt;
+				},
+				[&](uint32_t id, T) -> std::optional<T> {
+					const auto d = T(distance(id, pt));
+					return d <= max_distance ? std::optional{ d } : std::nullopt;
+				});
+		}
+
+		[[nodiscard]] std::optional<hit_type> nearest(tvec pt, T max_distance = std::numeric_limits<T>::infinity()) const
+		{
+			return nearest(pt, [&](uint32_t id, tvec p) { return std::sqrt(detail::box_distance_squared(box(id), p)); }, max_distance);
+		}
+
+		template <typename FUNC>
+		bool for_each_overlapping_pair(FUNC&& func) const
+		{
+			for (uint32_t slot = 0; slot < m_items.size(); ++slot)
+				if (PairsOf(slot, func))
+					return true;
+			return false;
+		}
+
+		template <typename FILTER_FUNC>
+		requires std::predicate<FILTER_FUNC const&, uint32_t, uint32_t>
+		[[nodiscard]] std::vector<detail::id_pair> overlapping_pairs(FILTER_FUNC const& narrow_phase, unsigned thread_count = 0) const
+		{
+			return detail::collect_pairs(m_items.size(), thread_count, [&](size_t begin, size_t end, std::vector<detail::id_pair>& pairs) {
+				for (auto slot = uint32_t(begin); slot < end; ++slot)
+					PairsOf(slot, [&](uint32_t a, uint32_t b) { if (narrow_phase(a, b)) pairs.emplace_back(a, b); });
+			});
+		}
+
+		[[nodiscard]] std::vector<detail::id_pair> overlapping_pairs(unsigned thread_count = 0) const
+		{
+			return overlapping_pairs([](uint32_t, uint32_t) { return true; }, thread_count);
+		}
+
+	private:
+
+		struct node
+		{
+			box_type bounds;
+			/// The first slot for leaves, or the left child for inner nodes (the right one follows it)
+			uint32_t first = 0;
+			/// The number of objects in leaves, 0 for inner nodes
+			uint32_t count = 0;
+		};
+
+		/// The build switches to median splits below this depth, so that the depth of the tree (and thus the traversal stacks) stays bounded
+		static constexpr uint32_t max_sah_depth = 64;
+		static constexpr size_t max_stack_size = max_sah_depth + 64;
+
+		void ValidateOptions() const
+		{
+			if (m_options.max_leaf_size == 0)
+				throw std::invalid_argument{ "max_leaf_size must be positive" };
+			if (m_options.bin_count < 2)
+				throw std::invalid_argument{ "bin_count must be at least 2" };
+		}
+
+		void Build()
+		{
+			const auto count = uint32_t(m_items.size());
+			m_nodes.clear();
+			m_slot_of.resize(count);
+			if (count == 0)
+				return;
+
+			std::vector<tvec> centroids(count);
+			for (uint32_t id = 0; id < count; ++id)
+				centroids[id] = m_item_boxes[id].center();
+
+			struct bin
+			{
+				box_type bounds = box_type::exclusive();
+				uint32_t count = 0;
+			};
+			std::vector<bin> bins(m_options.bin_count);
+			std::vector<T> right_costs(m_options.bin_count);
+
+			struct task { uint32_t node, depth; };
+			std::vector<task> tasks{ { 0, 0 } };
+			m_nodes.reserve(2 * size_t(count));
+			m_nodes.push_back({ {}, 0, count });
+			while (!tasks.empty())
+			{
+				const auto [node_index, depth] = tasks.back();
+				tasks.pop_back();
+
+				const auto first = m_nodes[node_index].first, node_count = m_nodes[node_index].count;
+				const auto items = std::span{ m_items }.subspan(first, node_count);
+				if (node_count <= m_options.max_leaf_size)
+					continue;
+
+				auto centroid_bounds = box_type::exclusive();
+				for (const auto id : items)
+					centroid_bounds.include(centroids[id]);
+
+				/// Find the binned split with the lowest SAH cost over both axes
+				int best_axis = -1;
+				uint32_t best_split = 0;
+				auto best_cost = std::numeric_limits<T>::infinity();
+				const auto bin_count = m_options.bin_count;
+				for (int axis = 0; axis < 2 && depth < max_sah_depth; ++axis)
+				{
+					const auto low = centroid_bounds.p1[axis], extent = centroid_bounds.p2[axis] - low;
+					if (!(extent > T{}))
+						continue;
+
+					const auto scale = T(bin_count) / extent;
+					std::ranges::fill(bins, bin{});
+					for (const auto id : items)
+					{
+						auto& b = bins[std::min(bin_count - 1, uint32_t((centroids[id][axis] - low) * scale))];
+						b.bounds.include(m_item_boxes[id]);
+						++b.count;
+					}
+
+					auto right = bin{};
+					for (uint32_t i = bin_count - 1; i > 0; --i)
+					{
+						right.bounds.include(bins[i].bounds);
+						right.count += bins[i].count;
+						right_costs[i] = right.count ? detail::half_perimeter(right.bounds) * T(right.count) : T{};
+					}
+					auto left = bin{};
+					for (uint32_t split = 1; split < bin_count; ++split)
+					{
+						left.bounds.include(bins[split - 1].bounds);
+						left.count += bins[split - 1].count;
+						if (left.count == 0 || left.count == node_count)
+							continue;
+						const auto cost = detail::half_perimeter(left.bounds) * T(left.count) + right_costs[split];
+						if (cost < best_cost)
+						{
+							best_cost = cost;
+							best_axis = axis;
+							best_split = split;
+						}
+					}
+				}
+
+				uint32_t left_count = 0;
+				if (best_axis >= 0)
+				{
+					const auto low = centroid_bounds.p1[best_axis];
+					const auto scale = T(bin_count) / (centroid_bounds.p2[best_axis] - low);
+					const auto middle = std::partition(items.begin(), items.end(), [&](uint32_t id) {
+						return std::min(bin_count - 1, uint32_t((centroids[id][best_axis] - low) * scale)) < best_split;
+					});
+					left_count = uint32_t(middle - items.begin());
+				}
+				else
+				{
+					/// All centroids in one spot, or the tree got too deep: split in half along the longer axis
+					const auto axis = centroid_bounds.width() >= centroid_bounds.height() ? 0 : 1;
+					left_count = node_count / 2;
+					std::nth_element(items.begin(), items.begin() + left_count, items.end(), [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+				}
+
+				const auto left_child = uint32_t(m_nodes.size());
+				m_nodes[node_index] = { {}, left_child, 0 };
+				m_nodes.push_back({ {}, first, left_count });
+				m_nodes.push_back({ {}, first + left_count, node_count - left_count });
+				tasks.push_back({ left_child, depth + 1 });
+				tasks.push_back({ left_child + 1, depth + 1 });
+			}
+
+			/// Store the boxes in leaf order, so that leaves read them from consecutive memory
+			std::vector<box_type> boxes_in_leaf_order(count);
+			for (uint32_t slot = 0; slot < count; ++slot)
+			{
+				boxes_in_leaf_order[slot] = m_item_boxes[m_items[slot]];
+				m_slot_of[m_items[slot]] = slot;
+			}
+			m_item_boxes = std::move(boxes_in_leaf_order);
+			refit();
+		}
+
+		template <typename NODE_FUNC, typename ITEM_FUNC>
+		bool Traverse(NODE_FUNC&& enter_node, ITEM_FUNC&& visit_item) const
+		{
+			if (m_nodes.empty() || !enter_node(m_nodes[0].bounds))
+				return false;
+
+			std::array<uint32_t, max_stack_size> stack;
+			size_t stack_size = 0;
+			stack[stack_size++] = 0;
+			while (stack_size)
+			{
+				auto const& node = m_nodes[stack[--stack_size]];
+				if (node.count)
+				{
+					for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+						if (visit_item(slot))
+							return true;
+					continue;
+				}
+				for (const auto child : { node.first, node.first + 1 })
+					if (enter_node(m_nodes[child].bounds))
+						stack[stack_size++] = child;
+			}
+			return false;
+		}
+
+		/// Finds the object with the lowest `item_distance(id, box_distance)`, given that it is never lower than `box_distance(box)`,
+		/// visiting nearer children first and skipping subtrees that can't contain anything closer than the best object so far
+		template <typename BOX_DISTANCE_FUNC, typename ITEM_DISTANCE_FUNC>
+		[[nodiscard]] std::optional<hit_type> ClosestFirst(BOX_DISTANCE_FUNC&& box_distance, ITEM_DISTANCE_FUNC&& item_distance) const
+		{
+			std::optional<hit_type> best;
+			if (m_nodes.empty())
+				return best;
+			const auto root_distance = box_distance(m_nodes[0].bounds);
+			if (!root_distance)
+				return best;
+
+			std::array<std::pair<uint32_t, T>, max_stack_size> stack;
+			size_t stack_size = 0;
+			stack[stack_size++] = { 0, *root_distance };
+			while (stack_size)
+			{
+				const auto [node_index, distance] = stack[--stack_size];
+				if (best && distance >= best->distance)
+					continue;
+
+				auto const& node = m_nodes[node_index];
+				if (node.count)
+				{
+					for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+					{
+						const auto d = box_distance(m_item_boxes[slot]);
+						if (!d || (best && *d >= best->distance))
+							continue;
+						if (const auto exact = item_distance(m_items[slot], *d); exact && (!best || *exact < best->distance))
+							best = hit_type{ m_items[slot], *exact };
+					}
+					continue;
+				}
+
+				auto left = box_distance(m_nodes[node.first].bounds), right = box_distance(m_nodes[node.first + 1].bounds);
+				auto left_child = node.first, right_child = node.first + 1;
+				if (left && right && *right < *left)
+				{
+					std::swap(left, right);
+					std::swap(left_child, right_child);
+				}
+				if (right) stack[stack_size++] = { right_child, *right };
+				if (left) stack[stack_size++] = { left_child, *left };
+			}
+			return best;
+		}
+
+		template <typename FUNC>
+		bool PairsOf(uint32_t slot, FUNC&& func) const
+		{
+			const auto id = m_items[slot];
+			auto const& box = m_item_boxes[slot];
+			return Traverse(
+				[&](box_type const& bounds) { return bounds.intersects(box); },
+				[&](uint32_t other) { return m_items[other] > id && m_item_boxes[other].intersects(box) && detail::invoke_until(func, id, m_items[other]); });
+		}
+
+		options m_options{};
+		std::vector<node> m_nodes;
+		/// Object ids in leaf order
+		std::vector<uint32_t> m_items;
+		/// Object boxes in leaf order
+		std::vector<box_type> m_item_boxes;
+		std::vector<uint32_t> m_slot_of;
+	};
+
+	using bvh = tbvh<float>;
+
+	/// A quadtree where each node's bounds are twice the size of its cell, so that every object can be stored in exactly one node,
+	/// picked from its size and center. Objects can be inserted, moved and removed cheaply.
+	template <std::floating_point T>
+	class tloose_quadtree
+	{
+	public:
+
+		using tvec = glm::tvec2<T>;
+		using box_type = trec2<T>;
+		using hit_type = tspatial_hit<T>;
+
+		struct options
+		{
+			/// The area covered by the root cell; objects outside of it are still found, but are all kept in the root
+			box_type bounds{ { T(-1024), T(-1024) }, { T(1024), T(1024) } };
+			uint32_t max_depth = 8;
+		};
+
+		tloose_quadtree() { Reset(); }
+		explicit tloose_quadtree(options opts) : m_options(opts) { Reset(); }
+
+		[[nodiscard]] options const& get_options() const noexcept { return m_options; }
+
+		/// Removes all objects and inserts object `i` with box `boxes[i]`
+		void build(std::span<box_type const> boxes)
+		{
+			clear();
+			m_items.reserve(boxes.size());
+			for (uint32_t id = 0; id < boxes.size(); ++id)
+				insert(id, boxes[id]);
+		}
+
+		template <typename SHAPE>
+		requires shape<T, SHAPE>
+		void build(std::span<SHAPE const> shapes) { build(detail::bounding_boxes_of<T>(shapes)); }
+
+		void clear() { Reset(); }
+
+		[[nodiscard]] size_t size() const noexcept { return m_nodes[0].subtree_items; }
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+		[[nodiscard]] size_t node_count() const noexcept { return m_nodes.size(); }
+		[[nodiscard]] bool contains(uint32_t id) const noexcept { return id < m_items.size() && m_items[id].node != no_index; }
+		[[nodiscard]] box_type const& box(uint32_t id) const noexcept { return m_items[id].box; }
+
+		void insert(uint32_t id, box_type const& box)
+		{
+			if (contains(id))
+				throw std::invalid_argument{ "object is already in the quadtree" };
+			if (id >= m_items.size())
+				m_items.resize(size_t(id) + 1);
+			m_items[id].box = box;
+			Link(id, NodeFor(box));
+		}
+
+		void update(uint32_t id, box_type const& box)
+		{
+			if (!contains(id))
+				throw std::invalid_argument{ "object is not in the quadtree" };
+			m_items[id].box = box;
+			const auto node = NodeFor(box);
+			if (node == m_items[id].node)
+				return;
+			Unlink(id);
+			Link(id, node);
+		}
+
+		/// \returns whether the object was in the quadtree
+		bool remove(uint32_t id)
+		{
+			if (!contains(id))
+				return false;
+			Unlink(id);
+			return true;
+		}
+
+		template <typename FUNC>
+		bool query(box_type const& range, FUNC&& func) const
+		{
+			return Traverse(
+				[&](box_type const& bounds) { return bounds.intersects(range); },
+				[&](uint32_t id) { return m_items[id].box.intersects(range) && detail::invoke_until(func, id); });
+		}
+
+		template <typename FUNC>
+		bool raycast(tvec start, tvec dir, T max_distance, FUNC&& func) const
+		{
+			const detail::ray_segment<T> ray{ start, dir, max_distance };
+			return Traverse(
+				[&](box_type const& bounds) { return ray.span(bounds).has_value(); },
+				[&](uint32_t id) {
+					const auto entry = ray.entry(m_items[id].box);
+					return entry && detail::invoke_until(func, id, *entry);
+				});
+		}
+
+		template <typename HIT_FUNC>
+		[[nodiscard]] std::optional<hit_type> closest_hit(tvec start, tvec dir, T max_distance, HIT_FUNC&& hit) const
+		{
+			const detail::ray_segment<T> ray{ start, dir, max_distance };
+			return ClosestFirst(
+				[&](box_type const& bounds) { return ray.entry(bounds); },
+				[&](uint32_t id, T box_distance) -> std::optional<T> { return hit(id, box_distance); });
+		}
+
+		[[nodiscard]] std::optional<hit_type> closest_hit(tvec start, tvec dir, T max_distance = std::numeric_limits<T>::infinity()) const
+		{
+			return closest_hit(start, dir, max_distance, [](uint32_t, T box_distance) { return std::optional{ box_distance }; });
+		}
+
+		template <typename DISTANCE_FUNC>
+		requires std::is_invocable_r_v<T, DISTANCE_FUNC&, uint32_t, tvec>
+		[[nodiscard]] std::optional<hit_type> nearest(tvec pt, DISTANCE_FUNC&& distance, T max_distance = std::numeric_limits<T>::infinity()) const
+		{
+			return ClosestFirst(
+				[&](box_type const& bounds) -> std::optional<T> {
+					const auto d = std::sqrt(detail::box_distance_squared(bounds, pt));
+					return d <= max_distance ? std::optional{ d } : std::nullopt;
+				},
+				[&](uint32_t id, T) -> std::optional<T> {
+					const auto d = T(distance(id, pt));
+					return d <= max_distance ? std::optional{ d } : std::nullopt;
+				});
+		}
+
+		[[nodiscard]] std::optional<hit_type> nearest(tvec pt, T max_distance = std::numeric_limits<T>::infinity()) const
+		{
+			return nearest(pt, [&](uint32_t id, tvec p) { return std::sqrt(detail::box_distance_squared(box(id), p)); }, max_distance);
+		}
+
+		template <typename FUNC>
+		bool for_each_overlapping_pair(FUNC&& func) const
+		{
+			for (uint32_t id = 0; id < m_items.size(); ++id)
+				if (contains(id) && PairsOf(id, func))
+					return true;
+			return false;
+		}
+
+		template <typename FILTER_FUNC>
+		requires std::predicate<FILTER_FUNC const&, uint32_t, uint32_t>
+		[[nodiscard]] std::vector<detail::id_pair> overlapping_pairs(FILTER_FUNC const& narrow_phase, unsigned thread_count = 0) const
+		{
+			return detail::collect_pairs(m_items.size(), thread_count, [&](size_t begin, size_t end, std::vector<detail::id_pair>& pairs) {
+				for (auto id = uint32_t(begin); id < end; ++id)
+					if (contains(id))
+						PairsOf(id, [&](uint32_t a, uint32_t b) { if (narrow_phase(a, b)) pairs.emplace_back(a, b); });
+			});
+		}
+
+		[[nodiscard]] std::vector<detail::id_pair> overlapping_pairs(unsigned thread_count = 0) const
+		{
+			return overlapping_pairs([](uint32_t, uint32_t) { return true; }, thread_count);
+		}
+
+	private:
+
+		static constexpr uint32_t no_index = ~0u;
+		static constexpr uint32_t max_max_depth = 16;
+
+		struct node
+		{
+			/// The cell grown by half its size on each side
+			box_type loose_bounds;
+			uint32_t parent = no_index;
+			/// The first of the 4 children, 0 if there are none
+			uint32_t children = 0;
+			uint32_t first_item = no_index;
+			uint32_t subtree_items = 0;
+			uint32_t depth = 0;
+		};
+
+		struct item
+		{
+			box_type box;
+			uint32_t node = no_index;
+			uint32_t previous = no_index;
+			uint32_t next = no_index;
+		};
+
+		void Reset()
+		{
+			if (!m_options.bounds.is_valid() || !(m_options.bounds.width() > T{}) || !(m_options.bounds.height() > T{}))
+				throw std::invalid_argument{ "quadtree bounds must have a positive size" };
+			if (m_options.max_depth > max_max_depth)
+				throw std::invalid_argument{ "quadtree max_depth cannot be larger than 16" };
+			m_nodes.clear();
+			m_items.clear();
+			const auto& bounds = m_options.bounds;
+			m_nodes.push_back({ bounds.grown(bounds.half_size()) });
+		}
+
+		/// \returns the deepest node whose loose bounds contain `box` and whose cell is at least as large as it
+		uint32_t NodeFor(box_type const& box)
+		{
+			const auto size = box.size();
+			const auto center = box.center();
+			uint32_t node_index = 0;
+			while (m_nodes[node_index].depth < m_options.max_depth)
+			{
+				const auto& node = m_nodes[node_index];
+				const auto child_cell_size = node.loose_bounds.size() / T(4);
+				if (size.x > child_cell_size.x || size.y > child_cell_size.y)
+					break;
+
+				const auto node_center = node.loose_bounds.center();
+				const auto quadrant = uint32_t(center.x >= node_center.x) | (uint32_t(center.y >= node_center.y) << 1);
+				if (node.children == 0)
+					Subdivide(node_index);
+				const auto child = m_nodes[node_index].children + quadrant;
+				if (!m_nodes[child].loose_bounds.contains(box))
+					break;
+				node_index = child;
+			}
+			return node_index;
+		}
+
+		void Subdivide(uint32_t node_index)
+		{
+			const auto loose = m_nodes[node_index].loose_bounds;
+			const auto depth = m_nodes[node_index].depth + 1;
+			const auto child_cell_size = loose.size() / T(4);
+			const auto cell_p1 = loose.p1 + child_cell_size;
+			m_nodes[node_index].children = uint32_t(m_nodes.size());
+			for (uint32_t quadrant = 0; quadrant < 4; ++quadrant)
+			{
+				const auto cell = box_type::from_size(cell_p1 + child_cell_size * tvec{ T(quadrant & 1), T(quadrant >> 1) }, child_cell_size);
+				m_nodes.push_back({ cell.grown(child_cell_size / T(2)), node_index, 0, no_index, 0, depth });
+			}
+		}
+
+		void Link(uint32_t id, uint32_t node_index)
+		{
+			auto& item = m_items[id];
+			item.node = node_index;
+			item.previous = no_index;
+			item.next = m_nodes[node_index].first_item;
+			if (item.next != no_index)
+				m_items[item.next].previous = id;
+			m_nodes[node_index].first_item = id;
+			for (auto i = node_index; i != no_index; i = m_nodes[i].parent)
+				++m_nodes[i].subtree_items;
+		}
+
+		void Unlink(uint32_t id)
+		{
+			auto& item = m_items[id];
+			if (item.previous != no_index)
+				m_items[item.previous].next = item.next;
+			else
+				m_nodes[item.node].first_item = item.next;
+			if (item.next != no_index)
+				m_items[item.next].previous = item.previous;
+			for (auto i = item.node; i != no_index; i = m_nodes[i].parent)
+				--m_nodes[i].subtree_items;
+			item.node = no_index;
+		}
+
+		/// The root is always entered, since objects outside of the bounds end up in it
+		template <typename NODE_FUNC, typename ITEM_FUNC>
+		bool Traverse(NODE_FUNC&& enter_node, ITEM_FUNC&& visit_item) const
+		{
+			std::array<uint32_t, 3 * max_max_depth + 1> stack;
+			size_t stack_size = 0;
+			stack[stack_size++] = 0;
+			while (stack_size)
+			{
+				auto const& node = m_nodes[stack[--stack_size]];
+				for (auto id = node.first_item; id != no_index; id = m_items[id].next)
+					if (visit_item(id))
+						return true;
+				if (node.children == 0)
+					continue;
+				for (auto child = node.children; child < node.children + 4; ++child)
+					if (m_nodes[child].subtree_items && enter_node(m_nodes[child].loose_bounds))
+						stack[stack_size++] = child;
+			}
+			return false;
+		}
+
+		template <typename BOX_DISTANCE_FUNC, typename ITEM_DISTANCE_FUNC>
+		[[nodiscard]] std::optional<hit_type> ClosestFirst(BOX_DISTANCE_FUNC&& box_distance, ITEM_DISTANCE_FUNC&& item_distance) const
+		{
+			std::optional<hit_type> best;
+			std::array<std::pair<uint32_t, T>, 3 * max_max_depth + 1> stack;
+			size_t stack_size = 0;
+			stack[stack_size++] = { 0, T{} };
+			while (stack_size)
+			{
+				const auto [node_index, distance] = stack[--stack_size];
+				if (best && distance >= best->distance)
+					continue;
+
+				auto const& node = m_nodes[node_index];
+				for (auto id = node.first_item; id != no_index; id = m_items[id].next)
+				{
+					const auto d = box_distance(m_items[id].box);
+					if (!d || (best && *d >= best->distance))
+						continue;
+					if (const auto exact = item_distance(id, *d); exact && (!best || *exact < best->distance))
+						best = hit_type{ id, *exact };
+				}
+				if (node.children == 0)
+					continue;
+
+				/// Push the farthest children first, so that the nearest is visited next
+				std::array<std::pair<uint32_t, T>, 4> children;
+				size_t child_count = 0;
+				for (auto child = node.children; child < node.children + 4; ++child)
+					if (m_nodes[child].subtree_items)
+						if (const auto d = box_distance(m_nodes[child].loose_bounds))
+							children[child_count++] = { child, *d };
+				std::sort(children.begin(), children.begin() + child_count, [](auto const& a, auto const& b) { return a.second > b.second; });
+				for (size_t i = 0; i < child_count; ++i)
+					stack[stack_size++] = children[i];
+			}
+			return best;
+		}
+
+		template <typename FUNC>
+		bool PairsOf(uint32_t id, FUNC&& func) const
+		{
+			auto const& box = m_items[id].box;
+			return Traverse(
+				[&](box_type const& bounds) { return bounds.intersects(box); },
+				[&](uint32_t other) { return other > id && m_items[other].box.intersects(box) && detail::invoke_until(func, id, other); });
+		}
+
+		options m_options{};
+		std::vector<node> m_nodes;
+		std::vector<item> m_items;
+	};
+
+	using loose_quadtree = tloose_quadtree<float>;
+
+	/// A uniform grid of square cells, stored sparsely in a hash map, with each object kept in every cell its box overlaps.
+	/// Works best as a broad phase for objects of similar sizes, no larger than a few cells.
+	template <std::floating_point T>
+	class thash_grid
+	{
+	public:
+
+		using tvec = glm::tvec2<T>;
+		using box_type = trec2<T>;
+		using hit_type = tspatial_hit<T>;
+
+		struct options
+		{
+			T cell_size = T(64);
+		};
+
+		thash_grid() = default;
+		explicit thash_grid(options opts) : m_options(opts)
+		{
+			if (!(m_options.cell_size > T{}))
+				throw std::invalid_argument{ "cell_size must be positive" };
+		}
+
+		[[nodiscard]] options const& get_options() const noexcept { return m_options; }
+
+		/// Removes all objects and inserts object `i` with box `boxes[i]`
+		void build(std::span<box_type const> boxes)
+		{
+			clear();
+			m_items.reserve(boxes.size());
+			for (uint32_t id = 0; id < boxes.size(); ++id)
+				insert(id, boxes[id]);
+		}
+
+		template <typename SHAPE>
+		requires shape<T, SHAPE>
+		void build(std::span<SHAPE const> shapes) { build(detail::bounding_boxes_of<T>(shapes)); }
+
+		void clear()
+		{
+			m_cells.clear();
+			m_items.clear();
+			m_size = 0;
+			m_occupied = irec2::exclusive();
+		}
+
+		[[nodiscard]] size_t size() const noexcept { return m_size; }
+		[[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+		[[nodiscard]] size_t cell_count() const noexcept { return m_cells.size(); }
+		[[nodiscard]] bool contains(uint32_t id) const noexcept { return id < m_items.size() && m_items[id].present; }
+		[[nodiscard]] box_type const& box(uint32_t id) const noexcept { return m_items[id].box; }
+
+		[[nodiscard]] glm::ivec2 cell_of(tvec pt) const noexcept
+		{
+			return { int(std::floor(pt.x / m_options.cell_size)), int(std::floor(pt.y / m_options.cell_size)) };
+		}
+
+		void insert(uint32_t id, box_type const& box)
+		{
+			if (contains(id))
+				throw std::invalid_argument{ "object is already in the grid" };
+			if (id >= m_items.size())
+				m_items.resize(size_t(id) + 1);
+			auto& item = m_items[id];
+			item.box = box;
+			item.cells = CellsOf(box);
+			item.present = true;
+			++m_size;
+			AddToCells(id, item.cells);
+		}
+
+		void update(uint32_t id, box_type const& box)
+		{
+			if (!contains(id))
+				throw std::invalid_argument{ "object is not in the grid" };
+			auto& item = m_items[id];
+			item.box = box;
+			const auto cells = CellsOf(box);
+			if (cells == item.cells)
+				return;
+			RemoveFromCells(id, item.cells);
+			item.cells = cells;
+			AddToCells(id, cells);
+		}
+
+		/// \returns whether the object was in the grid
+		bool remove(uint32_t id)
+		{
+			if (!contains(id))
+				return false;
+			RemoveFromCells(id, m_items[id].cells);
+			m_items[id].present = false;
+			--m_size;
+			return true;
+		}
+
+		template <typename FUNC>
+		bool query(box_type const& range, FUNC&& func) const
+		{
+			/// An object is reported only from the cell that holds the corner of its overlap with `range`, so that it is reported once
+			const auto visit_cell = [&](glm::ivec2 cell, std::vector<uint32_t> const& ids) {
+				for (const auto id : ids)
+				{
+					auto const& box = m_items[id].box;
+					if (box.intersects(range) && cell_of(glm::max(box.p1, range.p1)) == cell && detail::invoke_until(func, id))
+						return true;
+				}
+				return false;
+			};
+
+			const auto range_cells = CellsOf(range);
+			const irec2 cells{ glm::max(range_cells.p1, m_occupied.p1), glm::min(range_cells.p2, m_occupied.p2) };
+			if (!cells.is_valid())
+				return false;
+			if (uint64_t(cells.width() + 1) * uint64_t(cells.height() + 1) > m_cells.size())
+			{
+				for (auto const& [key, ids] : m_cells)
+					if (InRange(cells, KeyCell(key)) && visit_cell(KeyCell(key), ids))
+						return true;
+				return false;
+			}
+
+			for (int y = cells.p1.y; y <= cells.p2.y; ++y)
+				for (int x = cells.p1.x; x <= cells.p2.x; ++x)
+					if (const auto it = m_cells.find(Key({ x, y })); it != m_cells.end() && visit_cell({ x, y }, it->second))
+						return true;
+			return false;
+		}
+
+		template <typename FUNC>
+		bool raycast(tvec start, tvec dir, T max_distance, FUNC&& func) const
+		{
+			const detail::ray_segment<T> ray{ start, dir, max_distance };
+			return WalkCells(ray, [&](T, std::vector<uint32_t> const& ids) {
+				for (const auto id : ids)
+				{
+					const auto entry = ray.entry(m_items[id].box);
+					if (entry && detail::invoke_until(func, id, *entry))
+						return true;
+				}
+				return false;
+			});
+		}
+
+		template <typename HIT_FUNC>
+		[[nodiscard]] std::optional<hit_type> closest_hit(tvec start, tvec dir, T max_distance, HIT_FUNC&& hit) const
+		{
+			const detail::ray_segment<T> ray{ start, dir, max_distance };
+			std::optional<hit_type> best;
+			WalkCells(ray, [&](T cell_entry, std::vector<uint32_t> const& ids) {
+				/// Cells are visited in order, so nothing further can be closer than what's already been hit
+				if (best && cell_entry >= best->distance)
+					return true;
+				for (const auto id : ids)
+				{
+					const auto entry = ray.entry(m_items[id].box);
+					if (!entry || (best && *entry >= best->distance))
+						continue;
+					if (const auto exact = std::optional<T>{ hit(id, *entry) }; exact && (!best || *exact < best->distance))
+						best = hit_type{ id, *exact };
+				}
+				return false;
+			});
+			return best;
+		}
+
+		[[nodiscard]] std::optional<hit_type> closest_hit(tvec start, tvec dir, T max_distance = std::numeric_limits<T>::infinity()) const
+		{
+			return closest_hit(start, dir, max_distance, [](uint32_t, T box_distance) { return std::optional{ box_distance }; });
+		}
+
+		/// Searches rings of cells of growing size around `pt`, until the nearest object found is closer than anything in the next ring can be
+		template <typename DISTANCE_FUNC>
+		requires std::is_invocable_r_v<T, DISTANCE_FUNC&, uint32_t, tvec>
+		[[nodiscard]] std::optional<hit_type> nearest(tvec pt, DISTANCE_FUNC&& distance, T max_distance = std::numeric_limits<T>::infinity()) const
+		{
+			std::optional<hit_type> best;
+			if (m_size == 0)
+				return best;
+
+			const auto center = cell_of(pt);
+			const auto size = m_options.cell_size;
+			const auto visit_cell = [&](glm::ivec2 cell, int ring) {
+				const auto it = m_cells.find(Key(cell));
+				if (it == m_cells.end())
+					return;
+				const auto inner = irec2{ center - (ring - 1), center + (ring - 1) };
+				for (const auto id : it->second)
+				{
+					auto const& item = m_items[id];
+					if (ring > 0 && item.cells.intersects(inner))
+						continue; /// Already seen in an earlier ring
+					const auto box_distance = std::sqrt(detail::box_distance_squared(item.box, pt));
+					if (box_distance > max_distance || (best && box_distance >= best->distance))
+						continue;
+					const auto d = T(distance(id, pt));
+					if (d <= max_distance && (!best || d < best->distance))
+						best = hit_type{ id, d };
+				}
+			};
+
+			/// Rings that don't reach the occupied cells are skipped, and the rest are clipped to them
+			const auto& occupied = m_occupied;
+			const auto first_ring = std::max({ 0, occupied.p1.x - center.x, center.x - occupied.p2.x, occupied.p1.y - center.y, center.y - occupied.p2.y });
+			for (int ring = first_ring;; ++ring)
+			{
+				const irec2 square{ center - ring, center + ring };
+				if (ring == 0)
+					visit_cell(center, 0);
+				else
+				{
+					const auto x_begin = std::max(square.p1.x, occupied.p1.x), x_end = std::min(square.p2.x, occupied.p2.x);
+					const auto y_begin = std::max(square.p1.y + 1, occupied.p1.y), y_end = std::min(square.p2.y - 1, occupied.p2.y);
+					for (int x = x_begin; x <= x_end; ++x)
+					{
+						if (square.p1.y >= occupied.p1.y) visit_cell({ x, square.p1.y }, ring);
+						if (square.p2.y <= occupied.p2.y) visit_cell({ x, square.p2.y }, ring);
+					}
+					for (int y = y_begin; y <= y_end; ++y)
+					{
+						if (square.p1.x >= occupied.p1.x) visit_cell({ square.p1.x, y }, ring);
+						if (square.p2.x <= occupied.p2.x) visit_cell({ square.p2.x, y }, ring);
+					}
+				}
+
+				if (square.contains(m_occupied))
+					break;
+				/// Everything in further rings is at least this far away
+				const auto next_ring_distance = std::min({
+					pt.x - T(square.p1.x) * size, T(square.p2.x + 1) * size - pt.x,
+					pt.y - T(square.p1.y) * size, T(square.p2.y + 1) * size - pt.y });
+				if (next_ring_distance > max_distance || (best && best->distance <= next_ring_distance))
+					break;
+			}
+			return best;
+		}
+
+		[[nodiscard]] std::optional<hit_type> nearest(tvec pt, T max_distance = std::numeric_limits<T>::infinity()) const
+		{
+			return nearest(pt, [&](uint32_t id, tvec p) { return std::sqrt(detail::box_distance_squared(box(id), p)); }, max_distance);
+		}
+
+		template <typename FUNC>
+		bool for_each_overlapping_pair(FUNC&& func) const
+		{
+			for (auto const& [key, ids] : m_cells)
+				if (PairsIn(KeyCell(key), ids, func))
+					return true;
+			return false;
+		}
+
+		template <typename FILTER_FUNC>
+		requires std::predicate<FILTER_FUNC const&, uint32_t, uint32_t>
+		[[nodiscard]] std::vector<detail::id_pair> overlapping_pairs(FILTER_FUNC const& narrow_phase, unsigned thread_count = 0) const
+		{
+			std::vector<typename cell_map::value_type const*> cells;
+			cells.reserve(m_cells.size());
+			for (auto const& cell : m_cells)
+				cells.push_back(&cell);
+			return detail::collect_pairs(cells.size(), thread_count, [&](size_t begin, size_t end, std::vector<detail::id_pair>& pairs) {
+				for (auto i = begin; i < end; ++i)
+					PairsIn(KeyCell(cells[i]->first), cells[i]->second, [&](uint32_t a, uint32_t b) { if (narrow_phase(a, b)) pairs.emplace_back(a, b); });
+			});
+		}
+
+		[[nodiscard]] std::vector<detail::id_pair> overlapping_pairs(unsigned thread_count = 0) const
+		{
+			return overlapping_pairs([](uint32_t, uint32_t) { return true; }, thread_count);
+		}
+
+	private:
+
+		struct item
+		{
+			box_type box;
+			/// The range of cells the box overlaps, inclusive on both ends
+			irec2 cells;
+			bool present = false;
+		};
+
+		using cell_map = std::unordered_map<uint64_t, std::vector<uint32_t>>;
+
+		[[nodiscard]] static uint64_t Key(glm::ivec2 cell) noexcept { return (uint64_t(uint32_t(cell.x)) << 32) | uint32_t(cell.y); }
+		[[nodiscard]] static glm::ivec2 KeyCell(uint64_t key) noexcept { return { int(int32_t(uint32_t(key >> 32))), int(int32_t(uint32_t(key))) }; }
+		[[nodiscard]] irec2 CellsOf(box_type const& box) const noexcept { return { cell_of(box.p1), cell_of(box.p2) }; }
+
+		void AddToCells(uint32_t id, irec2 const& cells)
+		{
+			m_occupied.include(cells);
+			for (int y = cells.p1.y; y <= cells.p2.y; ++y)
+				for (int x = cells.p1.x; x <= cells.p2.x; ++x)
+					m_cells[Key({ x, y })].push_back(id);
+		}
+
+		void RemoveFromCells(uint32_t id, irec2 const& cells)
+		{
+			for (int y = cells.p1.y; y <= cells.p2.y; ++y)
+				for (int x = cells.p1.x; x <= cells.p2.x; ++x)
+				{
+					const auto it = m_cells.find(Key({ x, y }));
+					auto& ids = it->second;
+					*std::ranges::find(ids, id) = ids.back();
+					ids.pop_back();
+					if (ids.empty())
+						m_cells.erase(it);
+				}
+		}
+
+		/// Visits the cells along the ray in order (Amanatides & Woo), calling `func(entry_distance, ids)` for each non-empty one,
+		/// with each object showing up only in the first cell along the ray that it overlaps
+		template <typename FUNC>
+		bool WalkCells(detail::ray_segment<T> const& ray, FUNC&& func) const
+		{
+			if (m_size == 0)
+				return false;
+			const auto size = m_options.cell_size;
+			const auto occupied = box_type{ tvec(m_occupied.p1) * size, tvec(m_occupied.p2 + 1) * size };
+			const auto range = ray.span(occupied);
+			if (!range)
+				return false;
+
+			auto [distance, end_distance] = *range;
+			auto cell = glm::clamp(cell_of(ray.start + ray.dir * distance), m_occupied.p1, m_occupied.p2);
+			glm::ivec2 step{};
+			tvec next{}, delta{};
+			for (int axis = 0; axis < 2; ++axis)
+			{
+				if (ray.dir[axis] > T{})
+				{
+					step[axis] = 1;
+					next[axis] = (T(cell[axis] + 1) * size - ray.start[axis]) * ray.inv_dir[axis];
+					delta[axis] = size * ray.inv_dir[axis];
+				}
+				else if (ray.dir[axis] < T{})
+				{
+					step[axis] = -1;
+					next[axis] = (T(cell[axis]) * size - ray.start[axis]) * ray.inv_dir[axis];
+					delta[axis] = -size * ray.inv_dir[axis];
+				}
+				else
+					next[axis] = delta[axis] = std::numeric_limits<T>::infinity();
+			}
+
+			std::optional<glm::ivec2> previous;
+			std::vector<uint32_t> new_ids;
+			while (distance <= end_distance && m_occupied.contains(irec2{ cell, cell }))
+			{
+				if (const auto it = m_cells.find(Key(cell)); it != m_cells.end())
+				{
+					/// The cells along a line that lie in an object's cell range are consecutive, so an object is new unless it was in the previous cell too
+					new_ids.clear();
+					for (const auto id : it->second)
+						if (!previous || !InRange(m_items[id].cells, *previous))
+							new_ids.push_back(id);
+					if (!new_ids.empty() && func(distance, std::as_const(new_ids)))
+						return true;
+				}
+				previous = cell;
+				const auto axis = next.x < next.y ? 0 : 1;
+				distance = next[axis];
+				next[axis] += delta[axis];
+				cell[axis] += step[axis];
+			}
+			return false;
+		}
+
+		[[nodiscard]] static bool InRange(irec2 const& cells, glm::ivec2 cell) noexcept
+		{
+			return cell.x >= cells.p1.x && cell.y >= cells.p1.y && cell.x <= cells.p2.x && cell.y <= cells.p2.y;
+		}
+
+		/// An overlapping pair is reported only from the cell that holds the corner of the overlap, so that it is reported once
+		template <typename FUNC>
+		bool PairsIn(glm::ivec2 cell, std::vector<uint32_t> const& ids, FUNC&& func) const
+		{
+			for (size_t i = 0; i < ids.size(); ++i)
+			{
+				auto const& a = m_items[ids[i]].box;
+				for (size_t j = i + 1; j < ids.size(); ++j)
+				{
+					auto const& b = m_items[ids[j]].box;
+					if (!a.intersects(b) || cell_of(glm::max(a.p1, b.p1)) != cell)
+						continue;
+					if (detail::invoke_until(func, std::min(ids[i], ids[j]), std::max(ids[i], ids[j])))
+						return true;
+				}
+			}
+			return false;
+		}
+
+		options m_options{};
+		cell_map m_cells;
+		std::vector<item> m_items;
+		size_t m_size = 0;
+		/// The range of cells that have (or had) objects in them
+		irec2 m_occupied = irec2::exclusive();
+	};
+
+	using hash_grid = thash_grid<float>;
+}
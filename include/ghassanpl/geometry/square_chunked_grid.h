@@ -0,0 +1,336 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "square_grid.h"
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <bit>
+
+namespace ghassanpl::geometry::squares
+{
+	/// An unbounded, sparse grid, made out of `CHUNK_SIZE`x`CHUNK_SIZE` chunks of tiles that are only allocated when written to.
+	///
+	/// Chunks are stored in a hash map keyed by chunk coordinate, so tiles can be at any (including negative) coordinate, and the memory used
+	/// only depends on the number of chunks that were written to. Tiles in chunks that were never written to read as the default tile.
+	///
+	/// A tile is "valid" (in the \ref iteration_flags::only_valid sense) if its chunk is allocated. Iterating with `only_valid` (the default)
+	/// skips unallocated chunks entirely; iterating without it allocates the chunks it visits.
+	///
+	/// Iteration goes chunk by chunk (and row by row within a chunk), so it touches each chunk's memory once, in order.
+	template <typename TILE_DATA, int CHUNK_SIZE = 32>
+	requires (CHUNK_SIZE > 0 && std::has_single_bit(unsigned(CHUNK_SIZE)))
+	struct chunked_grid
+	{
+		using tile_data_type = TILE_DATA;
+		static constexpr int chunk_size = CHUNK_SIZE;
+		static constexpr int tiles_per_chunk = CHUNK_SIZE * CHUNK_SIZE;
+
+		struct chunk
+		{
+			std::array<TILE_DATA, tiles_per_chunk> tiles;
+		};
+
+		enum class iteration_flags
+		{
+			with_self,
+			only_valid,
+			diagonals
+		};
+
+		chunked_grid() = default;
+		explicit chunked_grid(TILE_DATA default_tile) : mDefaultTile(std::move(default_tile)) {}
+
+		chunked_grid(chunked_grid&&) noexcept = default;
+		chunked_grid& operator=(chunked_grid&&) noexcept = default;
+		chunked_grid(chunked_grid const& other) : mDefaultTile(other.mDefaultTile)
+		{
+			mChunks.reserve(other.mChunks.size());
+			for (auto& [pos, chunk] : other.mChunks)
+				mChunks.emplace(pos, std::make_unique<struct chunk>(*chunk));
+		}
+		chunked_grid& operator=(chunked_grid const& other) { if (this != &other) *this = chunked_grid{ other }; return *this; }
+
+		/// Coordinates
+
+		/// \returns the coordinate of the chunk containing the tile at `tile_pos`
+		[[nodiscard]] static constexpr glm::ivec2 chunk_of(glm::ivec2 tile_pos) noexcept { return { tile_pos.x >> ChunkShift, tile_pos.y >> ChunkShift }; }
+		/// \returns the position of the tile at `tile_pos` relative to the start of its chunk
+		[[nodiscard]] static constexpr glm::ivec2 local_pos_of(glm::ivec2 tile_pos) noexcept { return { tile_pos.x & ChunkMask, tile_pos.y & ChunkMask }; }
+		/// \returns the index of the tile at `tile_pos` in its chunk's \ref chunk::tiles
+		[[nodiscard]] static constexpr int local_index_of(glm::ivec2 tile_pos) noexcept { return (tile_pos.x & ChunkMask) + (tile_pos.y & ChunkMask) * CHUNK_SIZE; }
+		/// \returns the rectangle of tiles covered by the chunk at `chunk_pos`
+		[[nodiscard]] static constexpr irec2 chunk_tile_rect(glm::ivec2 chunk_pos) noexcept { return irec2::from_size(chunk_pos * CHUNK_SIZE, { CHUNK_SIZE, CHUNK_SIZE }); }
+
+		/// Accessors & Queries
+
+		[[nodiscard]] TILE_DATA const& default_tile() const noexcept { return mDefaultTile; }
+
+		/// \returns the chunk at `chunk_pos`, or `nullptr` if it was not allocated
+		[[nodiscard]] chunk const* find_chunk(glm::ivec2 chunk_pos) const noexcept
+		{
+			const auto it = mChunks.find(chunk_pos);
+			return it != mChunks.end() ? it->second.get() : nullptr;
+		}
+		[[nodiscard]] chunk* find_chunk(glm::ivec2 chunk_pos) noexcept { return const_cast<chunk*>(std::as_const(*this).find_chunk(chunk_pos)); }
+
+		/// \returns the chunk at `chunk_pos`, allocating it (filled with the default tile) if necessary
+		chunk& ensure_chunk(glm::ivec2 chunk_pos)
+		{
+			auto& result = mChunks[chunk_pos];
+			if (!result)
+			{
+				result = std::make_unique<chunk>();
+				result->tiles.fill(mDefaultTile);
+			}
+			return *result;
+		}
+
+		[[nodiscard]] bool is_valid(glm::ivec2 pos) const noexcept { return find_chunk(chunk_of(pos)) != nullptr; }
+		[[nodiscard]] bool is_valid(int x, int y) const noexcept { return is_valid(glm::ivec2{ x, y }); }
+
+		/// \returns a pointer to the tile at `pos`, or `nullptr` if its chunk was not allocated
+		[[nodiscard]] TILE_DATA const* at(glm::ivec2 pos) const noexcept { if (auto c = find_chunk(chunk_of(pos))) return &c->tiles[local_index_of(pos)]; return nullptr; }
+		[[nodiscard]] TILE_DATA const* at(int x, int y) const noexcept { return at(glm::ivec2{ x, y }); }
+		[[nodiscard]] TILE_DATA* at(glm::ivec2 pos) noexcept { if (auto c = find_chunk(chunk_of(pos))) return &c->tiles[local_index_of(pos)]; return nullptr; }
+		[[nodiscard]] TILE_DATA* at(int x, int y) noexcept { return at(glm::ivec2{ x, y }); }
+
+		/// \returns the tile at `pos`, or the default tile if its chunk was not allocated
+		[[nodiscard]] TILE_DATA const& get(glm::ivec2 pos) const noexcept { if (auto tile = at(pos)) return *tile; return mDefaultTile; }
+		[[nodiscard]] TILE_DATA const& get(int x, int y) const noexcept { return get(glm::ivec2{ x, y }); }
+
+		[[nodiscard]] TILE_DATA const& safe_at(glm::ivec2 pos, TILE_DATA const& outside) const noexcept { if (auto at = this->at(pos)) return *at; return outside; }
+		[[nodiscard]] TILE_DATA& safe_at(glm::ivec2 pos, TILE_DATA& outside) noexcept { if (auto at = this->at(pos)) return *at; return outside; }
+
+		/// \returns a reference to the tile at `pos`, allocating its chunk if necessary
+		[[nodiscard]] TILE_DATA& operator[](glm::ivec2 pos) { return ensure_chunk(chunk_of(pos)).tiles[local_index_of(pos)]; }
+		[[nodiscard]] TILE_DATA const& operator[](glm::ivec2 pos) const noexcept { return get(pos); }
+#if defined(__cpp_multidimensional_subscript)
+		[[nodiscard]] TILE_DATA& operator[](int x, int y) { return (*this)[glm::ivec2{ x, y }]; }
+		[[nodiscard]] TILE_DATA const& operator[](int x, int y) const noexcept { return get(glm::ivec2{ x, y }); }
+#endif
+
+		/// Sets the tile at `pos`; setting a tile in an unallocated chunk to the default tile does not allocate the chunk
+		void set(glm::ivec2 pos, TILE_DATA const& value)
+		{
+			if constexpr (std::equality_comparable<TILE_DATA>)
+			{
+				if (value == mDefaultTile)
+				{
+					if (auto tile = at(pos))
+						*tile = value;
+					return;
+				}
+			}
+			(*this)[pos] = value;
+		}
+
+		[[nodiscard]] size_t chunk_count() const noexcept { return mChunks.size(); }
+		[[nodiscard]] size_t tile_count() const noexcept { return mChunks.size() * tiles_per_chunk; }
+		[[nodiscard]] bool empty() const noexcept { return mChunks.empty(); }
+		/// \returns the approximate number of bytes used by the allocated chunks and the chunk map
+		[[nodiscard]] size_t allocated_bytes() const noexcept
+		{
+			return mChunks.size() * (sizeof(chunk) + sizeof(typename chunk_map::value_type) + sizeof(void*)) + mChunks.bucket_count() * sizeof(void*);
+		}
+
+		/// \returns the smallest rectangle of chunk coordinates containing all allocated chunks
+		[[nodiscard]] irec2 chunk_bounds() const noexcept
+		{
+			if (mChunks.empty())
+				return {};
+			auto result = irec2::from_size(mChunks.begin()->first, { 1, 1 });
+			for (auto& [pos, chunk] : mChunks)
+				result.include(irec2::from_size(pos, { 1, 1 }));
+			return result;
+		}
+
+		/// \returns the smallest rectangle of tiles containing all allocated chunks
+		[[nodiscard]] irec2 bounds() const noexcept
+		{
+			const auto chunks = chunk_bounds();
+			return { chunks.p1 * CHUNK_SIZE, chunks.p2 * CHUNK_SIZE };
+		}
+
+		/// Modifiers
+
+		bool remove_chunk(glm::ivec2 chunk_pos) { return mChunks.erase(chunk_pos) != 0; }
+		void clear() noexcept { mChunks.clear(); }
+
+		/// Frees all the chunks whose tiles are all equal to the default tile
+		/// \returns the number of chunks freed
+		size_t compact() requires std::equality_comparable<TILE_DATA>
+		{
+			return std::erase_if(mChunks, [this](auto const& kv) {
+				return std::ranges::all_of(kv.second->tiles, [this](TILE_DATA const& tile) { return tile == mDefaultTile; });
+			});
+		}
+
+		/// Iteration
+
+		/// Calls `func(chunk_pos, std::span<TILE_DATA, tiles_per_chunk> tiles)` for every allocated chunk, in unspecified order
+		template <typename FUNC>
+		void for_each_chunk(FUNC&& func)
+		{
+			for (auto& [pos, chunk] : mChunks)
+				func(pos, std::span<TILE_DATA, tiles_per_chunk>{ chunk->tiles });
+		}
+		template <typename FUNC>
+		void for_each_chunk(FUNC&& func) const
+		{
+			for (auto& [pos, chunk] : mChunks)
+				func(pos, std::span<TILE_DATA const, tiles_per_chunk>{ chunk->tiles });
+		}
+
+		template <bool ONLY_VALID = true, typename FUNC>
+		auto apply(glm::ivec2 to, FUNC&& func)
+		{
+			using return_type = decltype(InvokeOnTile(func, to, std::declval<TILE_DATA&>()));
+			if constexpr (ONLY_VALID)
+			{
+				if (auto tile = at(to))
+					return InvokeOnTile(func, to, *tile);
+				return default_value<return_type>();
+			}
+			else
+				return InvokeOnTile(func, to, (*this)[to]);
+		}
+
+		template <enum_flags<iteration_flags> FLAGS = enum_flags<iteration_flags>{ iteration_flags::with_self, iteration_flags::only_valid }, typename FUNC>
+		auto for_each_neighbor(glm::ivec2 of, FUNC&& func)
+		{
+			static constexpr auto ONLY_VALID = FLAGS.contain(iteration_flags::only_valid);
+			using return_type = decltype(this->template apply<ONLY_VALID>(glm::ivec2{ 0, 0 }, func));
+
+			/// Same order as grid::for_each_neighbor
+			static constexpr glm::ivec2 offsets[] = { { 0, 0 }, { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 }, { -1, -1 }, { 1, 1 }, { 1, -1 }, { -1, 1 } };
+			constexpr size_t first = FLAGS.contain(iteration_flags::with_self) ? 0 : 1;
+			constexpr size_t last = FLAGS.contain(iteration_flags::diagonals) ? 9 : 5;
+			for (size_t i = first; i < last; ++i)
+			{
+				if constexpr (std::is_void_v<return_type>)
+					this->template apply<ONLY_VALID>(of + offsets[i], func);
+				else if (auto ret = this->template apply<ONLY_VALID>(of + offsets[i], func))
+					return ret;
+			}
+			return default_value<return_type>();
+		}
+
+		/// Calls `func` for every tile in `tile_rect`, chunk by chunk. With `only_valid`, only allocated chunks are visited, and if the rectangle spans
+		/// more chunks than are allocated, only the allocated chunks are looked at, so huge rectangles over sparse grids are cheap.
+		template <enum_flags<iteration_flags> FLAGS = enum_flags<iteration_flags>{ iteration_flags::only_valid }, typename FUNC>
+		auto for_each_tile_in_rect(irec2 const& tile_rect, FUNC&& func)
+		{
+			static constexpr auto ONLY_VALID = FLAGS.contain(iteration_flags::only_valid);
+			using return_type = decltype(InvokeOnTile(func, glm::ivec2{}, std::declval<TILE_DATA&>()));
+
+			if (tile_rect.width() <= 0 || tile_rect.height() <= 0)
+				return default_value<return_type>();
+
+			const irec2 chunk_rect{ chunk_of(tile_rect.p1), chunk_of(tile_rect.p2 - 1) + 1 };
+			const auto chunks_in_rect = int64_t(chunk_rect.width()) * chunk_rect.height();
+
+			if (ONLY_VALID && chunks_in_rect > int64_t(mChunks.size()))
+			{
+				std::vector<std::pair<glm::ivec2, chunk*>> chunks;
+				for (auto& [pos, chunk] : mChunks)
+					if (chunk_rect.contains(pos))
+						chunks.emplace_back(pos, chunk.get());
+				std::ranges::sort(chunks, [](auto const& a, auto const& b) { return std::tie(a.first.y, a.first.x) < std::tie(b.first.y, b.first.x); });
+				for (auto& [pos, chunk] : chunks)
+				{
+					if constexpr (std::is_void_v<return_type>)
+						ForEachTileInChunk(pos, *chunk, tile_rect, func);
+					else if (auto ret = ForEachTileInChunk(pos, *chunk, tile_rect, func))
+						return ret;
+				}
+				return default_value<return_type>();
+			}
+
+			for (int cy = chunk_rect.top(); cy < chunk_rect.bottom(); ++cy)
+			{
+				for (int cx = chunk_rect.left(); cx < chunk_rect.right(); ++cx)
+				{
+					const glm::ivec2 chunk_pos{ cx, cy };
+					chunk* c = ONLY_VALID ? find_chunk(chunk_pos) : &ensure_chunk(chunk_pos);
+					if (!c)
+						continue;
+					if constexpr (std::is_void_v<return_type>)
+						ForEachTileInChunk(chunk_pos, *c, tile_rect, func);
+					else if (auto ret = ForEachTileInChunk(chunk_pos, *c, tile_rect, func))
+						return ret;
+				}
+			}
+			return default_value<return_type>();
+		}
+
+		/// Calls `func` for every tile in every allocated chunk
+		template <typename FUNC>
+		auto for_each_tile(FUNC&& func)
+		{
+			return for_each_tile_in_rect(bounds(), std::forward<FUNC>(func));
+		}
+
+		/// Return: Whether the line between `start` and `end` is free of blocing tiles, as determined by `blocks_func`
+		template <typename FUNC>
+		bool line_cast(glm::ivec2 start, glm::ivec2 end, FUNC&& blocks_func, bool ignore_start) const
+		{
+			return squares::line_cast(start, end, std::forward<FUNC>(blocks_func), ignore_start);
+		}
+
+	private:
+
+		static constexpr int ChunkShift = std::countr_zero(unsigned(CHUNK_SIZE));
+		static constexpr int ChunkMask = CHUNK_SIZE - 1;
+
+		struct ChunkHash
+		{
+			size_t operator()(glm::ivec2 pos) const noexcept
+			{
+				const auto key = (uint64_t(uint32_t(pos.x)) << 32) | uint32_t(pos.y);
+				return size_t((key * 0x9E3779B97F4A7C15ull) >> 17);
+			}
+		};
+		using chunk_map = std::unordered_map<glm::ivec2, std::unique_ptr<chunk>, ChunkHash>;
+
+		/// Calls `func` the same way \ref grid::apply does
+		template <typename FUNC>
+		static auto InvokeOnTile(FUNC& func, glm::ivec2 pos, TILE_DATA& tile)
+		{
+			using invocable_type = std::remove_cvref_t<FUNC>;
+			if constexpr (std::invocable<invocable_type, glm::ivec2, TILE_DATA&>)
+				return func(pos, tile);
+			else if constexpr (std::invocable<invocable_type, TILE_DATA&, glm::ivec2>)
+				return func(tile, pos);
+			else if constexpr (std::invocable<invocable_type, TILE_DATA&>)
+				return func(tile);
+			else
+				return func(pos);
+		}
+
+		template <typename FUNC>
+		auto ForEachTileInChunk(glm::ivec2 chunk_pos, chunk& c, irec2 const& tile_rect, FUNC& func)
+		{
+			using return_type = decltype(InvokeOnTile(func, glm::ivec2{}, std::declval<TILE_DATA&>()));
+			const auto rect = chunk_tile_rect(chunk_pos).clipped_to(tile_rect);
+			for (int y = rect.top(); y < rect.bottom(); ++y)
+			{
+				auto tile = c.tiles.data() + local_index_of({ rect.left(), y });
+				for (int x = rect.left(); x < rect.right(); ++x, ++tile)
+				{
+					if constexpr (std::is_void_v<return_type>)
+						InvokeOnTile(func, glm::ivec2{ x, y }, *tile);
+					else if (auto ret = InvokeOnTile(func, glm::ivec2{ x, y }, *tile))
+						return ret;
+				}
+			}
+			return default_value<return_type>();
+		}
+
+		TILE_DATA mDefaultTile{};
+		chunk_map mChunks;
+	};
+}
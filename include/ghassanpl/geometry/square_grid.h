@@ -5,8 +5,11 @@
 #pragma once
 
 #include "squares.h"
+#include "../bits.h"
+#include "../parallel.h"
 #include <vector>
 #include <stdexcept>
+#include <algorithm>
 
 namespace ghassanpl::geometry::squares
 {
@@ -27,13 +30,172 @@ namespace ghassanpl::geometry::squares
 	template <typename FUNC, typename T>
 	concept change_tile_callback = requires (FUNC func, T& td) { { func(glm::ivec2{ 0, 0 }, td) }; };
 
-	template <typename TILE_DATA, bool RESIZABLE = true>
+	/// Function: line_cast
+	/// Return: Whether the line between `start` and `end` is free of blocing tiles, as determined by `blocks_func`
+	template <typename FUNC>
+	bool line_cast(glm::ivec2 start, glm::ivec2 end, FUNC&& blocks_func, bool ignore_start)
+	{
+		int delta_x{ end.x - start.x };
+		// if x1 == x2, then it does not matter what we set here
+		signed char const ix((delta_x > 0) - (delta_x < 0));
+		delta_x = std::abs(delta_x) << 1;
+
+		int delta_y(end.y - start.y);
+		// if y1 == y2, then it does not matter what we set here
+		signed char const iy((delta_y > 0) - (delta_y < 0));
+		delta_y = std::abs(delta_y) << 1;
+
+		if (!ignore_start && blocks_func(start))
+			return false;
+
+		if (delta_x >= delta_y)
+		{
+			// error may go below zero
+			int error(delta_y - (delta_x >> 1));
+
+			while (start.x != end.x)
+			{
+				// reduce error, while taking into account the corner case of error == 0
+				if ((error > 0) || (!error && (ix > 0)))
+				{
+					error -= delta_x;
+					start.y += iy;
+				}
+				// else do nothing
+
+				error += delta_y;
+				start.x += ix;
+
+				if (blocks_func(start))
+					return false;
+			}
+		}
+		else
+		{
+			// error may go below zero
+			int error(delta_x - (delta_y >> 1));
+
+			while (start.y != end.y)
+			{
+				// reduce error, while taking into account the corner case of error == 0
+				if ((error > 0) || (!error && (iy > 0)))
+				{
+					error -= delta_y;
+					start.x += ix;
+				}
+				// else do nothing
+
+				error += delta_x;
+				start.y += iy;
+
+				if (blocks_func(start))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	/// \name Grid layouts
+	/// Policies deciding where in memory the tile at (x, y) of a \ref grid is stored. A layout is constructed with the grid's width and height,
+	/// and provides `index(x, y)`, `storage_size()` (which may be larger than `width * height`, the rest being padding), and `is_row_major`.
+	/// @{
+
+	/// Rows stored one after another; the default
+	struct row_major_layout
+	{
+		static constexpr bool is_row_major = true;
+
+		constexpr row_major_layout() noexcept = default;
+		constexpr row_major_layout(int width, int height) noexcept : mWidth(width), mHeight(height) {}
+
+		[[nodiscard]] constexpr int index(int x, int y) const noexcept { return x + y * mWidth; }
+		[[nodiscard]] constexpr size_t storage_size() const noexcept { return size_t(mWidth) * size_t(mHeight); }
+
+	private:
+		int mWidth = 0;
+		int mHeight = 0;
+	};
+
+	/// Square `BRICK_SIZE`x`BRICK_SIZE` bricks stored one after another (in row order), with the tiles of each brick stored row by row.
+	/// Neighbors in any direction are likely to be in the same brick, and so in the same or adjacent cache lines.
+	template <int BRICK_SIZE = 8>
+	requires (BRICK_SIZE > 0 && std::has_single_bit(unsigned(BRICK_SIZE)))
+	struct tiled_layout
+	{
+		static constexpr bool is_row_major = false;
+		static constexpr int brick_size = BRICK_SIZE;
+
+		constexpr tiled_layout() noexcept = default;
+		constexpr tiled_layout(int width, int height) noexcept : mBricksPerRow((width + BRICK_SIZE - 1) / BRICK_SIZE), mBrickRows((height + BRICK_SIZE - 1) / BRICK_SIZE) {}
+
+		[[nodiscard]] constexpr int index(int x, int y) const noexcept
+		{
+			const auto brick = (y >> Shift) * mBricksPerRow + (x >> Shift);
+			return (brick << (Shift * 2)) | ((y & Mask) << Shift) | (x & Mask);
+		}
+		[[nodiscard]] constexpr size_t storage_size() const noexcept { return size_t(mBricksPerRow) * size_t(mBrickRows) * BRICK_SIZE * BRICK_SIZE; }
+
+	private:
+		static constexpr int Shift = std::countr_zero(unsigned(BRICK_SIZE));
+		static constexpr int Mask = BRICK_SIZE - 1;
+		int mBricksPerRow = 0;
+		int mBrickRows = 0;
+	};
+
+	/// Z-order (Morton) layout: the grid is split into power-of-two squares stored one after another (in row order), with tiles inside each
+	/// square stored in Z-order.
+	///
+	/// The squares start as large as the grid's shorter side (rounded up to a power of two), but since the grid is padded to a whole number
+	/// of squares, that can take up to 4 times as much memory as the tiles need (e.g. for a 65x65 grid). So the squares are halved until the
+	/// padding is at most half the size of the grid; at worst this leaves 1x1 squares, which is the same as \ref row_major_layout.
+	/// \see morton_encode
+	struct morton_layout
+	{
+		static constexpr bool is_row_major = false;
+
+		constexpr morton_layout() noexcept = default;
+		constexpr morton_layout(int width, int height) noexcept
+		{
+			if (width <= 0 || height <= 0)
+				return;
+			const auto tiles = size_t(width) * size_t(height);
+			mSquareShift = int(std::bit_width(std::bit_ceil(unsigned(std::min(width, height)))) - 1);
+			for (;; --mSquareShift)
+			{
+				mSquaresPerRow = ((width - 1) >> mSquareShift) + 1;
+				mSquareRows = ((height - 1) >> mSquareShift) + 1;
+				if (mSquareShift == 0 || storage_size() <= tiles + tiles / 2)
+					break;
+			}
+		}
+
+		[[nodiscard]] constexpr int index(int x, int y) const noexcept
+		{
+			const auto mask = (1 << mSquareShift) - 1;
+			const auto square = (y >> mSquareShift) * mSquaresPerRow + (x >> mSquareShift);
+			return int((uint64_t(square) << (mSquareShift * 2)) | morton_encode(uint32_t(x & mask), uint32_t(y & mask)));
+		}
+		[[nodiscard]] constexpr size_t storage_size() const noexcept { return (size_t(mSquaresPerRow) * size_t(mSquareRows)) << (mSquareShift * 2); }
+
+	private:
+		int mSquareShift = 0;
+		int mSquaresPerRow = 0;
+		int mSquareRows = 0;
+	};
+
+	/// @}
+
+	/// \tparam LAYOUT how tiles are laid out in memory; see \ref row_major_layout, \ref tiled_layout and \ref morton_layout
+	template <typename TILE_DATA, bool RESIZABLE = true, typename LAYOUT = row_major_layout>
 	struct grid
 	{
 	public:
 
 		static constexpr bool resizable = RESIZABLE;
 		using tile_data_type = TILE_DATA;
+		using layout_type = LAYOUT;
+		static constexpr bool is_row_major = LAYOUT::is_row_major;
 
 		grid() requires RESIZABLE = default;
 		grid(int w, int h, TILE_DATA const& default_tile) { Reset(w, h, default_tile); }
@@ -73,10 +235,10 @@ namespace ghassanpl::geometry::squares
 		[[nodiscard]] bool is_valid(glm::vec2 world_pos, glm::vec2 tile_size, int edge_width) const noexcept { return is_valid(world_pos_to_tile_pos(world_pos, tile_size), edge_width); }
 		[[nodiscard]] bool is_valid(glm::ivec2 pos, int edge_width) const noexcept { return is_valid(pos.x, pos.y, edge_width); }
 		
-		[[nodiscard]] inline int index(int x, int y) const noexcept { return x + y * mWidth; }
-		[[nodiscard]] inline int index(glm::ivec2 pos) const noexcept { return pos.x + pos.y * mWidth; }
-		[[nodiscard]] inline int valid_index(int x, int y) const noexcept { return is_valid(x, y) ? x + y * mWidth : -1; }
-		[[nodiscard]] inline int valid_index(glm::ivec2 pos) const noexcept { return is_valid(pos) ? pos.x + pos.y * mWidth : -1; }
+		[[nodiscard]] inline int index(int x, int y) const noexcept { return mLayout.index(x, y); }
+		[[nodiscard]] inline int index(glm::ivec2 pos) const noexcept { return mLayout.index(pos.x, pos.y); }
+		[[nodiscard]] inline int valid_index(int x, int y) const noexcept { return is_valid(x, y) ? mLayout.index(x, y) : -1; }
+		[[nodiscard]] inline int valid_index(glm::ivec2 pos) const noexcept { return is_valid(pos) ? mLayout.index(pos.x, pos.y) : -1; }
 		
 		[[nodiscard]] TILE_DATA const* at(glm::ivec2 pos) const noexcept { if (!is_valid(pos)) return nullptr; return &mTiles[index(pos)]; }
 		[[nodiscard]] TILE_DATA const* at(int x, int y) const noexcept { return at(glm::ivec2{ x, y }); }
@@ -96,15 +258,13 @@ namespace ghassanpl::geometry::squares
 		[[nodiscard]] irec2 perimeter() const noexcept { return irec2::from_size({}, size()); }
 		[[nodiscard]] irec2 bounds() const noexcept { return perimeter(); }
 		[[nodiscard]] rec2 bounds(glm::vec2 tile_size) const noexcept { return perimeter() * tile_size; }
+		/// \returns all the tiles, in storage order (row by row for row-major layouts; in layout order, including padding, otherwise)
 		[[nodiscard]] std::span<TILE_DATA const> tiles() const { return mTiles; }
 		[[nodiscard]] std::span<TILE_DATA> tiles() { return mTiles; }
+		[[nodiscard]] LAYOUT const& layout() const noexcept { return mLayout; }
 		[[nodiscard]] size_t tile_count() const noexcept { return mTiles.size(); }
 
-		/*
-		/// https://github.com/nothings/stb/blob/master/stb_connected_components.h
-		/// Need to determine whether tile is passable or not (maybe enum_flags::is_set(Definition->Flags, TileFlag::IsPassable) ?)
-		bool IsReachable(glm::ivec2 src_tile, glm::ivec2 dest_tile);
-		*/
+		/// For reachability queries, see \ref region_map in square_grid_regions.h
 
 		enum class iteration_flags
 		{
@@ -290,65 +450,7 @@ namespace ghassanpl::geometry::squares
 		template <typename FUNC>
 		bool line_cast(glm::ivec2 start, glm::ivec2 end, FUNC&& blocks_func, bool ignore_start) const
 		{
-			int delta_x{ end.x - start.x };
-			// if x1 == x2, then it does not matter what we set here
-			signed char const ix((delta_x > 0) - (delta_x < 0));
-			delta_x = std::abs(delta_x) << 1;
-
-			int delta_y(end.y - start.y);
-			// if y1 == y2, then it does not matter what we set here
-			signed char const iy((delta_y > 0) - (delta_y < 0));
-			delta_y = std::abs(delta_y) << 1;
-
-			if (!ignore_start && blocks_func(start))
-				return false;
-
-			if (delta_x >= delta_y)
-			{
-				// error may go below zero
-				int error(delta_y - (delta_x >> 1));
-
-				while (start.x != end.x)
-				{
-					// reduce error, while taking into account the corner case of error == 0
-					if ((error > 0) || (!error && (ix > 0)))
-					{
-						error -= delta_x;
-						start.y += iy;
-					}
-					// else do nothing
-
-					error += delta_y;
-					start.x += ix;
-
-					if (blocks_func(start))
-						return false;
-				}
-			}
-			else
-			{
-				// error may go below zero
-				int error(delta_x - (delta_y >> 1));
-
-				while (start.y != end.y)
-				{
-					// reduce error, while taking into account the corner case of error == 0
-					if ((error > 0) || (!error && (iy > 0)))
-					{
-						error -= delta_y;
-						start.x += ix;
-					}
-					// else do nothing
-
-					error += delta_x;
-					start.y += iy;
-
-					if (blocks_func(start))
-						return false;
-				}
-			}
-
-			return true;
+			return squares::line_cast(start, end, std::forward<FUNC>(blocks_func), ignore_start);
 		}
 
 		/// Modifiers
@@ -372,20 +474,34 @@ namespace ghassanpl::geometry::squares
 
 		void flip_row(int row)
 		{
-			if (row >= 0 && row < mHeight)
+			if (row < 0 || row >= mHeight) return;
+			if constexpr (is_row_major)
 				std::reverse(GetRowStart(row), GetRowStart(row) + mWidth);
+			else
+			{
+				for (int x = 0; x < mWidth / 2; x++)
+					std::swap(mTiles[index(x, row)], mTiles[index(mWidth - x - 1, row)]);
+			}
 		}
 
 		void flip_horizontal()
 		{
 			for (int i = 0; i < mHeight; i++)
-				std::reverse(GetRowStart(i), GetRowStart(i) + mWidth);
+				flip_row(i);
 		}
 
 		void flip_vertical()
 		{
 			for (int i = 0; i < mHeight / 2; i++)
-				std::swap_ranges(GetRowStart(i), GetRowStart(i) + mWidth, GetRowStart(mHeight - i - 1));
+			{
+				if constexpr (is_row_major)
+					std::swap_ranges(GetRowStart(i), GetRowStart(i) + mWidth, GetRowStart(mHeight - i - 1));
+				else
+				{
+					for (int x = 0; x < mWidth; x++)
+						std::swap(mTiles[index(x, i)], mTiles[index(x, mHeight - i - 1)]);
+				}
+			}
 		}
 
 		void rotate_row(int row, int by);
@@ -400,6 +516,17 @@ namespace ghassanpl::geometry::squares
 		void shift_rows(int by, TILE_DATA const& add_tile)
 		{
 			if (by == 0) return;
+			else if constexpr (!is_row_major)
+			{
+				const auto shift_row = [&](int y) {
+					for (int x = 0; x < mWidth; x++)
+						mTiles[index(x, y)] = (y - by >= 0 && y - by < mHeight) ? std::move(mTiles[index(x, y - by)]) : add_tile;
+				};
+				if (by > 0)
+					for (int y = mHeight - 1; y >= 0; y--) shift_row(y);
+				else
+					for (int y = 0; y < mHeight; y++) shift_row(y);
+			}
 			else if (by > 0)
 			{
 				auto num_elems_to_shift = by * mWidth;
@@ -417,18 +544,32 @@ namespace ghassanpl::geometry::squares
 
 		void rotate_180() requires RESIZABLE
 		{
-			for (int i = 0; i < mHeight / 2; i++)
-				std::swap_ranges(std::make_reverse_iterator(GetRowStart(i) + mWidth), std::make_reverse_iterator(GetRowStart(i)), GetRowStart(mHeight - i - 1));
+			if constexpr (is_row_major)
+			{
+				for (int i = 0; i < mHeight / 2; i++)
+					std::swap_ranges(std::make_reverse_iterator(GetRowStart(i) + mWidth), std::make_reverse_iterator(GetRowStart(i)), GetRowStart(mHeight - i - 1));
 
-			/// Need to reverse middle row if height is odd
-			if (mHeight % 1)
-				std::reverse(GetRowStart(mHeight / 2 + 1), GetRowStart(mHeight / 2 + 1) + mWidth);
+				/// Need to reverse middle row if height is odd
+				if (mHeight % 2)
+					std::reverse(GetRowStart(mHeight / 2), GetRowStart(mHeight / 2) + mWidth);
+			}
+			else
+			{
+				const auto count = mWidth * mHeight;
+				for (int i = 0; i < count / 2; i++)
+					std::swap(mTiles[index(i % mWidth, i / mWidth)], mTiles[index(mWidth - 1 - i % mWidth, mHeight - 1 - i / mWidth)]);
+			}
 		}
 
 		void resize(glm::uvec2 new_size, const TILE_DATA& new_element) requires RESIZABLE
 		{
-			ResizeY(new_size.y, new_element);
-			ResizeX(new_size.x, new_element);
+			if constexpr (is_row_major)
+			{
+				ResizeY(new_size.y, new_element);
+				ResizeX(new_size.x, new_element);
+			}
+			else
+				Relayout(int(new_size.x), int(new_size.y), new_element);
 		}
 
 		void resize(glm::uvec2 new_size) requires RESIZABLE
@@ -460,7 +601,8 @@ namespace ghassanpl::geometry::squares
 			mTiles.clear();
 			mWidth = w;
 			mHeight = h;
-			mTiles.resize(w * h, default_tile);
+			mLayout = LAYOUT{ w, h };
+			mTiles.resize(mLayout.storage_size(), default_tile);
 		}
 
 		template <change_tile_callback<TILE_DATA> TILE_RESET_FUNC>
@@ -472,7 +614,8 @@ namespace ghassanpl::geometry::squares
 			mTiles.clear();
 			mWidth = w;
 			mHeight = h;
-			mTiles.resize(w * h);
+			mLayout = LAYOUT{ w, h };
+			mTiles.resize(mLayout.storage_size());
 			for_each_tile(tile_reset);
 			//for_each_tile([&tile_reset](glm::ivec2 t, TILE_DATA& tile) { tile_reset(); });
 		}
@@ -485,7 +628,8 @@ namespace ghassanpl::geometry::squares
 			mTiles.clear();
 			mWidth = w;
 			mHeight = h;
-			mTiles.resize(w * h);
+			mLayout = LAYOUT{ w, h };
+			mTiles.resize(mLayout.storage_size());
 		}
 		
 		void Reset(int w, int h, std::vector<TILE_DATA> tiles)
@@ -495,9 +639,20 @@ namespace ghassanpl::geometry::squares
 			if (size_t(w * h) > tiles.size()) throw std::invalid_argument{ "not enough tiles in vector" };
 
 			tiles.resize(w * h);
-			mTiles = std::move(tiles);
 			mWidth = w;
 			mHeight = h;
+			mLayout = LAYOUT{ w, h };
+			if constexpr (is_row_major)
+				mTiles = std::move(tiles);
+			else
+			{
+				/// `tiles` are given row by row
+				mTiles.clear();
+				mTiles.resize(mLayout.storage_size());
+				for (int y = 0; y < h; ++y)
+					for (int x = 0; x < w; ++x)
+						mTiles[index(x, y)] = std::move(tiles[x + y * w]);
+			}
 		}
 
 		void ResizeY(int new_y, const TILE_DATA& new_element)
@@ -507,6 +662,7 @@ namespace ghassanpl::geometry::squares
 			const auto new_count = new_y * mWidth;
 			mTiles.resize(new_count, new_element);
 			mHeight = new_y;
+			mLayout = LAYOUT{ mWidth, mHeight };
 		}
 
 		void ResizeX(int new_x, const TILE_DATA& new_element)
@@ -557,10 +713,30 @@ namespace ghassanpl::geometry::squares
 			}
 
 			mWidth = new_x;
+			mLayout = LAYOUT{ mWidth, mHeight };
+		}
+
+		/// Resizes grids with non-row-major layouts, by moving the overlapping tiles into a new buffer
+		void Relayout(int new_w, int new_h, const TILE_DATA& new_element)
+		{
+			if (new_w < 0) throw std::invalid_argument("new_x cannot be negative");
+			if (new_h < 0) throw std::invalid_argument("new_y cannot be negative");
+
+			const LAYOUT new_layout{ new_w, new_h };
+			std::vector<TILE_DATA> new_tiles(new_layout.storage_size(), new_element);
+			for (int y = 0; y < std::min(mHeight, new_h); ++y)
+				for (int x = 0; x < std::min(mWidth, new_w); ++x)
+					new_tiles[new_layout.index(x, y)] = std::move(mTiles[index(x, y)]);
+
+			mTiles = std::move(new_tiles);
+			mWidth = new_w;
+			mHeight = new_h;
+			mLayout = new_layout;
 		}
 
 		int mWidth = 0;
 		int mHeight = 0;
+		LAYOUT mLayout{};
 		std::vector<TILE_DATA> mTiles;
 	};
 
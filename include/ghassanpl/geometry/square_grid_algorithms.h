@@ -9,20 +9,20 @@
 
 namespace ghassanpl::geometry::squares
 {
-	template <typename TILE_DATA, bool RESIZABLE, typename FUNC>
-	void apply_cellular_automata(grid<TILE_DATA, RESIZABLE>& current_iteration, irec2 const& rect, FUNC&& func)
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, typename FUNC>
+	void apply_cellular_automata(grid<TILE_DATA, RESIZABLE, LAYOUT>& current_iteration, irec2 const& rect, FUNC&& func)
 	{
 		if constexpr (std::invocable<FUNC, TILE_DATA&, std::span<glm::ivec2 const>>)
 		{
-			using iteration_flags = grid<TILE_DATA, RESIZABLE>::iteration_flags;
+			using iteration_flags = grid<TILE_DATA, RESIZABLE, LAYOUT>::iteration_flags;
 			static constexpr enum_flags<iteration_flags> neighbor_iteration_flags = { iteration_flags::only_valid, iteration_flags::diagonals };
 
-			grid<TILE_DATA, RESIZABLE> previous_iteration = current_iteration;
+			grid<TILE_DATA, RESIZABLE, LAYOUT> previous_iteration = current_iteration;
 
 			std::vector<glm::ivec2> neighbors;
 			current_iteration.for_each_tile_in_rect(rect, [&](glm::ivec2 pos) {
 				neighbors.clear();
-				current_iteration.for_each_neighbor<neighbor_iteration_flags>(pos, op::push_back_to(neighbors));
+				current_iteration.template for_each_neighbor<neighbor_iteration_flags>(pos, [&](glm::ivec2 neighbor) { neighbors.push_back(neighbor); });
 				func(previous_iteration[pos], std::span<glm::ivec2 const>{ neighbors });
 			});
 
@@ -43,15 +43,15 @@ namespace ghassanpl::geometry::squares
 		}
 	}
 
-	template <typename TILE_DATA, bool RESIZABLE, typename FUNC>
-	void apply_cellular_automata(grid<TILE_DATA, RESIZABLE>& current_iteration, FUNC&& func)
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, typename FUNC>
+	void apply_cellular_automata(grid<TILE_DATA, RESIZABLE, LAYOUT>& current_iteration, FUNC&& func)
 	{
 		apply_cellular_automata(current_iteration, current_iteration.bounds(), std::forward<FUNC>(func));
 	}
 
 
-	template <typename TILE_DATA, bool RESIZABLE, change_tile_callback<TILE_DATA> REPLACE_FUNC, query_tile_callback<TILE_DATA> SHOULD_FLOOD_FUNC>
-	void flood_at(grid<TILE_DATA, RESIZABLE>& grid, glm::ivec2 start, REPLACE_FUNC&& replace, SHOULD_FLOOD_FUNC&& should_flood)
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, change_tile_callback<TILE_DATA> REPLACE_FUNC, query_tile_callback<TILE_DATA> SHOULD_FLOOD_FUNC>
+	void flood_at(grid<TILE_DATA, RESIZABLE, LAYOUT>& grid, glm::ivec2 start, REPLACE_FUNC&& replace, SHOULD_FLOOD_FUNC&& should_flood)
 	{
 		if (!grid.is_valid(start)) return;
 		if (!should_flood(start, *grid.at(start))) return;
@@ -124,22 +124,24 @@ namespace ghassanpl::geometry::squares
 		//*/
 	}
 
-	template <typename TILE_DATA, bool RESIZABLE, change_tile_callback<TILE_DATA> FLOOD_FUNC>
-	void flood_at(grid<TILE_DATA, RESIZABLE>& grid, glm::ivec2 start, FLOOD_FUNC&& flood)
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, change_tile_callback<TILE_DATA> FLOOD_FUNC>
+	void flood_at(grid<TILE_DATA, RESIZABLE, LAYOUT>& grid, glm::ivec2 start, FLOOD_FUNC&& flood)
 	{
-		const auto data_at_start = grid.at(start);
-		flood_at(grid, start, std::forward<FLOOD_FUNC>(flood), [data_at_start](glm::ivec2 at, TILE_DATA const& data) { return data == *data_at_start; });
+		if (!grid.is_valid(start)) return;
+		/// A copy, as the tile at `start` is replaced before its neighbors are compared to it
+		const auto data_at_start = *grid.at(start);
+		flood_at(grid, start, std::forward<FLOOD_FUNC>(flood), [&data_at_start](glm::ivec2 at, TILE_DATA const& data) { return data == data_at_start; });
 	}
 
 
-	template <typename TILE_DATA, bool RESIZABLE, query_tile_callback<TILE_DATA> SHOULD_FLOOD_FUNC>
-	void flood_at(grid<TILE_DATA, RESIZABLE>& grid, glm::ivec2 start, TILE_DATA const& replace_with, SHOULD_FLOOD_FUNC&& should_flood)
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, query_tile_callback<TILE_DATA> SHOULD_FLOOD_FUNC>
+	void flood_at(grid<TILE_DATA, RESIZABLE, LAYOUT>& grid, glm::ivec2 start, TILE_DATA const& replace_with, SHOULD_FLOOD_FUNC&& should_flood)
 	{
 		flood_at(grid, start, [&](glm::ivec2 at, TILE_DATA& data) { data = replace_with; }, std::forward<SHOULD_FLOOD_FUNC>(should_flood));
 	}
 
-	template <typename TILE_DATA, bool RESIZABLE>
-	void flood_at(grid<TILE_DATA, RESIZABLE>& grid, glm::ivec2 start, TILE_DATA const& replace_with)
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT>
+	void flood_at(grid<TILE_DATA, RESIZABLE, LAYOUT>& grid, glm::ivec2 start, TILE_DATA const& replace_with)
 	{
 		flood_at(grid, start, [&](glm::ivec2 at, TILE_DATA& data) { data = replace_with; });
 	}
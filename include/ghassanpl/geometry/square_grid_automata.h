@@ -0,0 +1,408 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "square_grid.h"
+#include <array>
+#include <bit>
+#include <string_view>
+#include <optional>
+#include <utility>
+
+namespace ghassanpl::geometry::squares
+{
+	/// A tile and its 8 surrounding tiles, as seen by a cellular automaton rule
+	/// Tiles outside the grid have the automaton's `outside` value.
+	template <typename TILE_DATA>
+	struct moore_neighborhood
+	{
+		/// Pointers to the tile in the row above, the tile itself, and the tile in the row below; `rows[1 + dy][dx]` is valid for `dx`, `dy` in [-1, 1]
+		TILE_DATA const* rows[3]{};
+
+		[[nodiscard]] TILE_DATA const& self() const noexcept { return rows[1][0]; }
+		[[nodiscard]] TILE_DATA const& at(int dx, int dy) const noexcept { return rows[1 + dy][dx]; }
+		[[nodiscard]] TILE_DATA const& at(glm::ivec2 offset) const noexcept { return at(offset.x, offset.y); }
+
+		/// \returns the number of surrounding tiles (not including the tile itself) that satisfy `pred`
+		template <typename PRED>
+		requires std::predicate<PRED, TILE_DATA const&>
+		[[nodiscard]] int count(PRED&& pred) const
+		{
+			return
+				int(bool(pred(rows[0][-1]))) + int(bool(pred(rows[0][0]))) + int(bool(pred(rows[0][1]))) +
+				int(bool(pred(rows[1][-1]))) +                                int(bool(pred(rows[1][1]))) +
+				int(bool(pred(rows[2][-1]))) + int(bool(pred(rows[2][0]))) + int(bool(pred(rows[2][1])));
+		}
+
+		/// \returns the number of surrounding tiles (not including the tile itself) equal to `value`
+		[[nodiscard]] int count(TILE_DATA const& value) const
+		{
+			return count([&](TILE_DATA const& tile) { return tile == value; });
+		}
+	};
+
+	template <typename FUNC, typename TILE_DATA>
+	concept automaton_rule = requires (FUNC func, moore_neighborhood<TILE_DATA> const& neighborhood) { { func(neighborhood) } -> std::convertible_to<TILE_DATA>; };
+
+	namespace detail
+	{
+		/// Applies `rule` to the tiles in columns [`x_begin`, `x_end`) and rows [`y_begin`, `y_end`) of `src`, writing them to the same positions in `dst`.
+		/// `outside_row` must point to the second element of an array of `width + 2` copies of the outside value.
+		template <typename TILE_DATA, typename RULE>
+		void apply_automaton_rows(TILE_DATA const* src, TILE_DATA* dst, int width, int height, int x_begin, int x_end, int y_begin, int y_end, TILE_DATA const* outside_row, RULE& rule)
+		{
+			if (x_begin >= x_end)
+				return;
+
+			const auto& outside = outside_row[-1];
+			const auto interior_begin = std::max(x_begin, 1);
+			const auto interior_end = std::min(x_end, width - 1);
+
+			/// Tiles in the first or last column get a neighborhood built from copies (copy-constructed, so TILE_DATA need not be default-constructible)
+			const auto apply_at_edge = [&](TILE_DATA const* const (&rows)[3], int x) {
+				const auto copy_row = [&](TILE_DATA const* row) {
+					return std::array<TILE_DATA, 3>{ x > 0 ? row[x - 1] : outside, row[x], x < width - 1 ? row[x + 1] : outside };
+				};
+				const std::array<std::array<TILE_DATA, 3>, 3> patch{ copy_row(rows[0]), copy_row(rows[1]), copy_row(rows[2]) };
+				const moore_neighborhood<TILE_DATA> neighborhood{ { &patch[0][1], &patch[1][1], &patch[2][1] } };
+				return TILE_DATA(rule(neighborhood));
+			};
+
+			for (int y = y_begin; y < y_end; ++y)
+			{
+				TILE_DATA const* const rows[3] = {
+					y > 0 ? src + size_t(y - 1) * width : outside_row,
+					src + size_t(y) * width,
+					y < height - 1 ? src + size_t(y + 1) * width : outside_row,
+				};
+				const auto dst_row = dst + size_t(y) * width;
+
+				if (x_begin == 0)
+					dst_row[0] = apply_at_edge(rows, 0);
+
+				/// The fast path: no bounds checks, just sliding the row pointers
+				moore_neighborhood<TILE_DATA> neighborhood{ { rows[0] + interior_begin, rows[1] + interior_begin, rows[2] + interior_begin } };
+				for (int x = interior_begin; x < interior_end; ++x)
+				{
+					dst_row[x] = rule(std::as_const(neighborhood));
+					++neighborhood.rows[0];
+					++neighborhood.rows[1];
+					++neighborhood.rows[2];
+				}
+
+				if (x_end == width && width > 1)
+					dst_row[width - 1] = apply_at_edge(rows, width - 1);
+			}
+		}
+	}
+
+	/// Runs cellular automata on grids, without copying the grid on every step.
+	///
+	/// The automaton keeps a second buffer around; each step reads the grid, writes the new generation into that buffer, and swaps the two,
+	/// so stepping the same grid (or grids of the same size) repeatedly does not allocate. Rows are processed in parallel bands.
+	///
+	/// Rules are called as `rule(moore_neighborhood<TILE_DATA> const&)` and return the new value of the tile.
+	/// \attention Rules are called concurrently from several threads, and must not modify shared state without synchronization
+	/// \note For two-state automata, \ref bit_automaton is much faster (and `grid<bool>` is not supported here, as it is backed by `std::vector<bool>`)
+	/// \note Only works with row-major grids, as the fast path walks rows with plain pointers
+	template <typename TILE_DATA, bool RESIZABLE = true>
+	requires (!std::same_as<TILE_DATA, bool>)
+	struct cellular_automaton
+	{
+		using grid_type = grid<TILE_DATA, RESIZABLE>;
+
+		struct options
+		{
+			/// The value of the (virtual) tiles surrounding the grid
+			TILE_DATA outside{};
+			/// The maximum number of threads to use; 0 means `std::thread::hardware_concurrency()`
+			unsigned thread_count = 0;
+			/// Bands of rows smaller than this are not worth a thread
+			int min_rows_per_thread = 64;
+		};
+
+		cellular_automaton() = default;
+		explicit cellular_automaton(options opts) : m_options(std::move(opts)) {}
+
+		/// Replaces `current` with the next generation
+		template <automaton_rule<TILE_DATA> RULE>
+		void step(grid_type& current, RULE&& rule)
+		{
+			PrepareBuffers(current.size());
+			Run(current, *m_back, current.bounds(), rule);
+			std::swap(current, *m_back);
+		}
+
+		/// Replaces `current` with the generation `generations` steps later
+		template <automaton_rule<TILE_DATA> RULE>
+		void step(grid_type& current, RULE&& rule, size_t generations)
+		{
+			for (size_t i = 0; i < generations; ++i)
+				step(current, rule);
+		}
+
+		/// Applies `rule` only to the tiles in `rect`; tiles outside of it are left untouched (but are still seen as neighbors)
+		template <automaton_rule<TILE_DATA> RULE>
+		void step(grid_type& current, irec2 const& rect, RULE&& rule)
+		{
+			const auto clipped = rect.clipped_to(current.bounds());
+			if (clipped.width() <= 0 || clipped.height() <= 0)
+				return;
+			if (clipped == current.bounds())
+				return step(current, rule);
+
+			PrepareBuffers(current.size());
+			Run(current, *m_back, clipped, rule);
+			/// Only the updated tiles are copied back
+			const auto width = current.width();
+			for (int y = clipped.top(); y < clipped.bottom(); ++y)
+			{
+				const auto row = size_t(y) * width;
+				std::copy(m_back->tiles().begin() + row + clipped.left(), m_back->tiles().begin() + row + clipped.right(), current.tiles().begin() + row + clipped.left());
+			}
+		}
+
+		[[nodiscard]] options const& get_options() const noexcept { return m_options; }
+
+	private:
+
+		void PrepareBuffers(glm::ivec2 size)
+		{
+			if (!m_back || m_back->size() != size)
+				m_back.emplace(size, m_options.outside);
+			if (m_outside_row.size() != size_t(size.x) + 2)
+				m_outside_row.assign(size_t(size.x) + 2, m_options.outside);
+		}
+
+		template <typename RULE>
+		void Run(grid_type const& from, grid_type& to, irec2 const& rect, RULE& rule)
+		{
+			const auto src = from.tiles().data();
+			const auto dst = to.tiles().data();
+			const auto outside_row = m_outside_row.data() + 1;
+			parallel_for_each_band(rect.top(), rect.bottom(), m_options.thread_count, m_options.min_rows_per_thread, [&](int row_begin, int row_end) {
+				detail::apply_automaton_rows(src, dst, from.width(), from.height(), rect.left(), rect.right(), row_begin, row_end, outside_row, rule);
+			});
+		}
+
+		options m_options{};
+		std::optional<grid_type> m_back; /// optional, as non-resizable grids are not default-constructible
+		std::vector<TILE_DATA> m_outside_row;
+	};
+
+	/// A Life-like rule for a two-state automaton, e.g. Conway's Game of Life is "B3/S23"
+	struct life_rule
+	{
+		/// Bit `n` is set if a dead tile with `n` live neighbors becomes alive
+		uint16_t birth = 0;
+		/// Bit `n` is set if a live tile with `n` live neighbors stays alive
+		uint16_t survival = 0;
+
+		[[nodiscard]] static constexpr life_rule conway() noexcept { return { 1 << 3, (1 << 2) | (1 << 3) }; }
+
+		/// Parses a rule in the "B3/S23" notation
+		/// \throws std::invalid_argument if `rule` is not a valid rule string
+		[[nodiscard]] static constexpr life_rule from_string(std::string_view rule)
+		{
+			life_rule result{};
+			uint16_t* current = nullptr;
+			for (const auto c : rule)
+			{
+				if (c == 'B' || c == 'b') current = &result.birth;
+				else if (c == 'S' || c == 's') current = &result.survival;
+				else if (c == '/') current = nullptr;
+				else if (c >= '0' && c <= '8' && current) *current |= uint16_t(1 << (c - '0'));
+				else throw std::invalid_argument{ "invalid life rule" };
+			}
+			return result;
+		}
+
+		[[nodiscard]] constexpr bool operator()(bool alive, int live_neighbors) const noexcept { return ((alive ? survival : birth) >> live_neighbors) & 1; }
+		[[nodiscard]] constexpr bool operator==(life_rule const&) const noexcept = default;
+	};
+
+	/// A two-state cellular automaton stored as one bit per tile, stepped 64 tiles at a time.
+	///
+	/// Neighbor counts are computed with bit-sliced adders over whole 64-bit words, so a step costs a few dozen bitwise operations per 64 tiles
+	/// regardless of the rule. Tiles outside of the grid are dead.
+	struct bit_automaton
+	{
+		bit_automaton() noexcept = default;
+		bit_automaton(int width, int height) { reset(width, height); }
+		explicit bit_automaton(glm::ivec2 size) : bit_automaton(size.x, size.y) {}
+
+		/// Creates an automaton from a grid, with tiles for which `is_alive` returns true being alive
+		template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, typename PRED>
+		requires std::predicate<PRED, TILE_DATA const&>
+		bit_automaton(grid<TILE_DATA, RESIZABLE, LAYOUT> const& from, PRED&& is_alive)
+			: bit_automaton(from.size())
+		{
+			for (int y = 0; y < m_height; ++y)
+				for (int x = 0; x < m_width; ++x)
+					if (is_alive(from[glm::ivec2{ x, y }]))
+						set(x, y, true);
+		}
+
+		void reset(int width, int height)
+		{
+			if (width < 0) throw std::invalid_argument{ "width cannot be negative" };
+			if (height < 0) throw std::invalid_argument{ "height cannot be negative" };
+			m_width = width;
+			m_height = height;
+			m_words_per_row = (width + 63) / 64;
+			m_cells.assign(size_t(m_words_per_row) * height, 0);
+			m_next.assign(m_cells.size(), 0);
+			m_dead_row.assign(size_t(m_words_per_row), 0);
+		}
+
+		[[nodiscard]] int width() const noexcept { return m_width; }
+		[[nodiscard]] int height() const noexcept { return m_height; }
+		[[nodiscard]] glm::ivec2 size() const noexcept { return { m_width, m_height }; }
+		[[nodiscard]] bool is_valid(int x, int y) const noexcept { return x >= 0 && y >= 0 && x < m_width && y < m_height; }
+
+		[[nodiscard]] bool get(int x, int y) const noexcept { return is_valid(x, y) && ((Row(y)[x / 64] >> (x % 64)) & 1); }
+		[[nodiscard]] bool get(glm::ivec2 pos) const noexcept { return get(pos.x, pos.y); }
+		void set(int x, int y, bool alive) noexcept
+		{
+			if (!is_valid(x, y)) return;
+			const auto bit = uint64_t(1) << (x % 64);
+			auto& word = Row(y)[x / 64];
+			word = alive ? (word | bit) : (word & ~bit);
+		}
+		void set(glm::ivec2 pos, bool alive) noexcept { set(pos.x, pos.y, alive); }
+
+		/// \returns the words making up row `y`; tile `x` is bit `x % 64` of word `x / 64`, and bits past the width are always 0
+		[[nodiscard]] std::span<uint64_t const> row(int y) const noexcept { return { Row(y), size_t(m_words_per_row) }; }
+
+		/// \returns the number of live tiles
+		[[nodiscard]] size_t population() const noexcept
+		{
+			size_t result = 0;
+			for (const auto word : m_cells)
+				result += size_t(std::popcount(word));
+			return result;
+		}
+
+		void clear() noexcept { std::ranges::fill(m_cells, 0); }
+
+		/// Writes `alive` or `dead` to every tile of `to`, which must be the same size as the automaton
+		template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT>
+		void store(grid<TILE_DATA, RESIZABLE, LAYOUT>& to, TILE_DATA const& alive, TILE_DATA const& dead) const
+		{
+			if (to.size() != size()) throw std::invalid_argument{ "grid size does not match automaton size" };
+			for (int y = 0; y < m_height; ++y)
+				for (int x = 0; x < m_width; ++x)
+					to[glm::ivec2{ x, y }] = get(x, y) ? alive : dead;
+		}
+
+		/// Advances the automaton by one generation
+		/// \param thread_count the maximum number of threads to use; 0 means `std::thread::hardware_concurrency()`
+		void step(life_rule rule, unsigned thread_count = 0)
+		{
+			if (m_cells.empty())
+				return;
+
+			const auto last_word_mask = (m_width % 64) ? (uint64_t(1) << (m_width % 64)) - 1 : ~uint64_t{};
+			/// Bands of rows under ~64k tiles are not worth a thread
+			const auto min_rows = std::max(1, 1024 / m_words_per_row);
+			parallel_for_each_band(0, m_height, thread_count, min_rows, [&](int row_begin, int row_end) {
+				for (int y = row_begin; y < row_end; ++y)
+					StepRow(rule, y, last_word_mask);
+			});
+			std::swap(m_cells, m_next);
+		}
+
+		/// Advances the automaton by `generations` generations
+		/// \param thread_count the maximum number of threads to use; 0 means `std::thread::hardware_concurrency()`
+		void step_generations(life_rule rule, size_t generations, unsigned thread_count = 0)
+		{
+			for (size_t i = 0; i < generations; ++i)
+				step(rule, thread_count);
+		}
+
+	private:
+
+		uint64_t* Row(int y) noexcept { return m_cells.data() + size_t(y) * m_words_per_row; }
+		uint64_t const* Row(int y) const noexcept { return m_cells.data() + size_t(y) * m_words_per_row; }
+
+		void StepRow(life_rule rule, int y, uint64_t last_word_mask) noexcept
+		{
+			static constexpr uint64_t none = 0;
+			const auto words = size_t(m_words_per_row);
+			uint64_t const* const rows[3] = {
+				y > 0 ? Row(y - 1) : m_dead_row.data(),
+				Row(y),
+				y < m_height - 1 ? Row(y + 1) : m_dead_row.data(),
+			};
+			uint64_t* const out = m_next.data() + size_t(y) * words;
+
+			/// Masks of the neighbor counts that make a tile alive, as all-zeros or all-ones words
+			uint64_t birth_if[9], survive_if[9];
+			for (int n = 0; n < 9; ++n)
+			{
+				birth_if[n] = ((rule.birth >> n) & 1) ? ~none : none;
+				survive_if[n] = ((rule.survival >> n) & 1) ? ~none : none;
+			}
+
+			/// Sliding windows of the previous, current and next word of each row
+			uint64_t previous[3]{}, current[3] = { rows[0][0], rows[1][0], rows[2][0] };
+			for (size_t i = 0; i < words; ++i)
+			{
+				uint64_t next[3]{};
+				if (i + 1 < words)
+					for (int r = 0; r < 3; ++r)
+						next[r] = rows[r][i + 1];
+
+				uint64_t neighbors[8];
+				for (int r = 0; r < 3; ++r)
+				{
+					neighbors[r * 2] = (current[r] << 1) | (previous[r] >> 63);
+					neighbors[r * 2 + 1] = (current[r] >> 1) | (next[r] << 63);
+				}
+				neighbors[6] = current[0];
+				neighbors[7] = current[2];
+
+				/// Bit-sliced counter: bit `b` of each tile's neighbor count is in `sum[b]`
+				uint64_t sum[4]{};
+				for (const auto n : neighbors)
+				{
+					const auto carry0 = sum[0] & n;
+					sum[0] ^= n;
+					const auto carry1 = sum[1] & carry0;
+					sum[1] ^= carry0;
+					const auto carry2 = sum[2] & carry1;
+					sum[2] ^= carry1;
+					sum[3] |= carry2;
+				}
+
+				const auto alive = current[1];
+				uint64_t result = 0;
+				for (int n = 0; n < 9; ++n)
+				{
+					const auto has_count =
+						((n & 1) ? sum[0] : ~sum[0]) &
+						((n & 2) ? sum[1] : ~sum[1]) &
+						((n & 4) ? sum[2] : ~sum[2]) &
+						((n & 8) ? sum[3] : ~sum[3]);
+					result |= has_count & ((alive & survive_if[n]) | (~alive & birth_if[n]));
+				}
+				out[i] = i + 1 == words ? result & last_word_mask : result;
+
+				for (int r = 0; r < 3; ++r)
+				{
+					previous[r] = current[r];
+					current[r] = next[r];
+				}
+			}
+		}
+
+		int m_width = 0;
+		int m_height = 0;
+		int m_words_per_row = 0;
+		std::vector<uint64_t> m_cells;
+		std::vector<uint64_t> m_next;
+		std::vector<uint64_t> m_dead_row;
+	};
+}
@@ -0,0 +1,350 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "square_grid_pathfinding.h"
+#include <bit>
+
+namespace ghassanpl::geometry::squares
+{
+	/// A grid of bits, 64 tiles to a word, e.g. for storing which tiles are visible
+	struct bit_grid
+	{
+		bit_grid() noexcept = default;
+		bit_grid(int width, int height) { reset(width, height); }
+		explicit bit_grid(glm::ivec2 size) : bit_grid(size.x, size.y) {}
+
+		void reset(int width, int height)
+		{
+			if (width < 0) throw std::invalid_argument{ "width cannot be negative" };
+			if (height < 0) throw std::invalid_argument{ "height cannot be negative" };
+			m_width = width;
+			m_height = height;
+			m_words_per_row = (width + 63) / 64;
+			m_bits.assign(size_t(m_words_per_row) * height, 0);
+		}
+		void reset(glm::ivec2 size) { reset(size.x, size.y); }
+
+		[[nodiscard]] int width() const noexcept { return m_width; }
+		[[nodiscard]] int height() const noexcept { return m_height; }
+		[[nodiscard]] glm::ivec2 size() const noexcept { return { m_width, m_height }; }
+		[[nodiscard]] bool is_valid(int x, int y) const noexcept { return x >= 0 && y >= 0 && x < m_width && y < m_height; }
+		[[nodiscard]] bool is_valid(glm::ivec2 pos) const noexcept { return is_valid(pos.x, pos.y); }
+
+		[[nodiscard]] bool get(int x, int y) const noexcept { return is_valid(x, y) && ((Row(y)[x / 64] >> (x % 64)) & 1); }
+		[[nodiscard]] bool get(glm::ivec2 pos) const noexcept { return get(pos.x, pos.y); }
+
+		/// Does nothing for tiles outside the grid
+		void set(int x, int y, bool value = true) noexcept
+		{
+			if (!is_valid(x, y)) return;
+			const auto bit = uint64_t(1) << (x % 64);
+			auto& word = Row(y)[x / 64];
+			word = value ? (word | bit) : (word & ~bit);
+		}
+		void set(glm::ivec2 pos, bool value = true) noexcept { set(pos.x, pos.y, value); }
+
+		/// \returns the words making up row `y`; tile `x` is bit `x % 64` of word `x / 64`, and bits past the width are always 0
+		[[nodiscard]] std::span<uint64_t const> row(int y) const noexcept { return { Row(y), size_t(m_words_per_row) }; }
+
+		/// \returns the number of set tiles
+		[[nodiscard]] size_t count() const noexcept
+		{
+			size_t result = 0;
+			for (const auto word : m_bits)
+				result += size_t(std::popcount(word));
+			return result;
+		}
+
+		void clear() noexcept { std::ranges::fill(m_bits, 0); }
+
+		/// Sets all tiles that are set in `other`, which must be the same size
+		bit_grid& operator|=(bit_grid const& other)
+		{
+			if (other.size() != size())
+				throw std::invalid_argument{ "bit grids must be the same size" };
+			for (size_t i = 0; i < m_bits.size(); ++i)
+				m_bits[i] |= other.m_bits[i];
+			return *this;
+		}
+
+		[[nodiscard]] bool operator==(bit_grid const& other) const noexcept = default;
+
+	private:
+
+		[[nodiscard]] uint64_t* Row(int y) noexcept { return m_bits.data() + size_t(y) * m_words_per_row; }
+		[[nodiscard]] uint64_t const* Row(int y) const noexcept { return m_bits.data() + size_t(y) * m_words_per_row; }
+
+		int m_width = 0;
+		int m_height = 0;
+		int m_words_per_row = 0;
+		std::vector<uint64_t> m_bits;
+	};
+
+	namespace detail
+	{
+		[[nodiscard]] constexpr int floor_div(int a, int b) noexcept { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+		[[nodiscard]] constexpr int ceil_div(int a, int b) noexcept { return -floor_div(-a, b); }
+	}
+
+	/// A viewer for the multi-viewer \ref compute_fov
+	struct fov_viewer
+	{
+		glm::ivec2 position{};
+		int radius = 0;
+	};
+
+	/// Marks the tiles visible from `origin` within `radius` in `visible`, using symmetric shadowcasting (as described by Albert Ford).
+	///
+	/// Visibility is symmetric: a floor tile sees another exactly when that one sees it back. Blocking tiles are visible themselves, and tiles
+	/// outside the grid block sight. `visible` must be the size of the grid; it is not cleared first, so calling this for several viewers
+	/// marks everything any of them sees.
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, query_tile_callback<TILE_DATA> BLOCKS_FUNC>
+	void compute_fov(grid<TILE_DATA, RESIZABLE, LAYOUT> const& grid, glm::ivec2 origin, int radius, BLOCKS_FUNC&& blocks_sight, bit_grid& visible)
+	{
+		if (!grid.is_valid(origin))
+			return;
+		visible.set(origin);
+
+		/// Slopes are kept as exact fractions, so that the result doesn't depend on rounding
+		struct fraction { int numerator, denominator; };
+		struct row { int depth; fraction start, end; };
+
+		std::vector<row> rows;
+		const auto radius_squared = radius * radius + radius; /// The extra `radius` makes for rounder circles
+		for (int quadrant = 0; quadrant < 4; ++quadrant)
+		{
+			const auto transform = [&](int depth, int column) -> glm::ivec2 {
+				switch (quadrant)
+				{
+				case 0: return { origin.x + column, origin.y - depth };
+				case 1: return { origin.x + column, origin.y + depth };
+				case 2: return { origin.x + depth, origin.y + column };
+				default: return { origin.x - depth, origin.y + column };
+				}
+			};
+			const auto is_wall = [&](int depth, int column) {
+				const auto pos = transform(depth, column);
+				return !grid.is_valid(pos) || bool(blocks_sight(pos, grid[pos]));
+			};
+
+			rows.assign(1, { 1, { -1, 1 }, { 1, 1 } });
+			while (!rows.empty())
+			{
+				auto current = rows.back();
+				rows.pop_back();
+				if (current.depth > radius)
+					continue;
+
+				const auto depth = current.depth;
+				const auto min_column = detail::floor_div(2 * depth * current.start.numerator + current.start.denominator, 2 * current.start.denominator);
+				const auto max_column = detail::ceil_div(2 * depth * current.end.numerator - current.end.denominator, 2 * current.end.denominator);
+
+				enum { none, wall, floor } previous = none;
+				for (int column = min_column; column <= max_column; ++column)
+				{
+					const auto wall_here = is_wall(depth, column);
+					const auto symmetric =
+						column * current.start.denominator >= depth * current.start.numerator &&
+						column * current.end.denominator <= depth * current.end.numerator;
+					if ((wall_here || symmetric) && column * column + depth * depth <= radius_squared)
+						visible.set(transform(depth, column));
+
+					const fraction slope{ 2 * column - 1, 2 * depth };
+					if (previous == wall && !wall_here)
+						current.start = slope;
+					if (previous == floor && wall_here)
+						rows.push_back({ depth + 1, current.start, slope });
+					previous = wall_here ? wall : floor;
+				}
+				if (previous == floor)
+					rows.push_back({ depth + 1, current.start, current.end });
+			}
+		}
+	}
+
+	/// Computes the field of view of each of `viewers` into the matching element of `visible` (which are reset to the grid's size and cleared),
+	/// spreading them over `thread_count` threads (0 meaning one per hardware thread)
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, query_tile_callback<TILE_DATA> BLOCKS_FUNC>
+	void compute_fov(grid<TILE_DATA, RESIZABLE, LAYOUT> const& grid, std::span<fov_viewer const> viewers, BLOCKS_FUNC const& blocks_sight, std::span<bit_grid> visible, unsigned thread_count = 0)
+	{
+		if (visible.size() < viewers.size())
+			throw std::invalid_argument{ "not enough visibility grids for all viewers" };
+		parallel_for_each_index(viewers.size(), thread_count, [&](size_t i) {
+			visible[i].reset(grid.size());
+			compute_fov(grid, viewers[i].position, viewers[i].radius, blocks_sight, visible[i]);
+		});
+	}
+
+	/// Marks every tile seen by any of `viewers` in `visible` (which is reset to the grid's size and cleared),
+	/// spreading the viewers over `thread_count` threads (0 meaning one per hardware thread)
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, query_tile_callback<TILE_DATA> BLOCKS_FUNC>
+	void compute_combined_fov(grid<TILE_DATA, RESIZABLE, LAYOUT> const& grid, std::span<fov_viewer const> viewers, BLOCKS_FUNC const& blocks_sight, bit_grid& visible, unsigned thread_count = 0)
+	{
+		const auto workers = parallel_worker_count(viewers.size(), thread_count);
+		std::vector<bit_grid> per_worker(workers - 1, bit_grid{ grid.size() });
+		visible.reset(grid.size());
+		parallel_for_each_index(viewers.size(), workers, [&](size_t i, unsigned worker) {
+			compute_fov(grid, viewers[i].position, viewers[i].radius, blocks_sight, worker == 0 ? visible : per_worker[worker - 1]);
+		});
+		for (auto const& partial : per_worker)
+			visible |= partial;
+	}
+
+	/// The cost of the cheapest path from the nearest of a set of source tiles to every tile of a grid (a "Dijkstra map"), together with
+	/// the step to take from each tile towards that source (a flow field).
+	///
+	/// Tile costs are paid on entering a tile, on the way out from the sources. Buffers are kept between calls to \ref compute, so
+	/// recomputing a field for a grid of the same size doesn't allocate or clear memory.
+	class distance_field
+	{
+	public:
+
+		/// Calculates the field, not going further than `max_distance` from the sources
+		template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, tile_cost_callback<TILE_DATA> COST_FUNC>
+		void compute(grid<TILE_DATA, RESIZABLE, LAYOUT> const& grid, std::span<glm::ivec2 const> sources, COST_FUNC&& cost, path_options const& options = {}, float max_distance = std::numeric_limits<float>::infinity())
+		{
+			m_size = grid.size();
+			astar_pathfinder<TILE_DATA, RESIZABLE, LAYOUT>{ grid, options }.explore(sources, cost, m_space, grid.bounds(), max_distance);
+		}
+
+		[[nodiscard]] glm::ivec2 size() const noexcept { return m_size; }
+		[[nodiscard]] bool is_valid(glm::ivec2 pos) const noexcept { return pos.x >= 0 && pos.y >= 0 && pos.x < m_size.x && pos.y < m_size.y; }
+
+		/// \returns the cost of getting to `pos` from the nearest source, or infinity if it can't be reached
+		[[nodiscard]] float distance(glm::ivec2 pos) const noexcept
+		{
+			return is_valid(pos) ? m_space.cost_to(Index(pos)) : std::numeric_limits<float>::infinity();
+		}
+
+		[[nodiscard]] bool is_reachable(glm::ivec2 pos) const noexcept { return distance(pos) != std::numeric_limits<float>::infinity(); }
+
+		/// \returns the tile to step to from `pos` to get closer to the nearest source; `pos` itself for sources and unreachable tiles
+		[[nodiscard]] glm::ivec2 next_step(glm::ivec2 pos) const noexcept
+		{
+			if (!is_valid(pos))
+				return pos;
+			const auto parent = m_space.parent(Index(pos));
+			if (parent == path_search_space::no_node)
+				return pos;
+			return { int(parent % uint32_t(m_size.x)), int(parent / uint32_t(m_size.x)) };
+		}
+
+		/// \returns the direction to step in from `pos`, with each component in [-1, 1]
+		[[nodiscard]] glm::ivec2 flow(glm::ivec2 pos) const noexcept { return next_step(pos) - pos; }
+
+	private:
+
+		[[nodiscard]] uint32_t Index(glm::ivec2 pos) const noexcept { return uint32_t(pos.x + pos.y * m_size.x); }
+
+		glm::ivec2 m_size{};
+		path_search_space m_space;
+	};
+
+	/// Computes `fields[i]` from `sources[i]` for each i, spreading them over `thread_count` threads (0 meaning one per hardware thread)
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, tile_cost_callback<TILE_DATA> COST_FUNC>
+	void compute_distance_fields(grid<TILE_DATA, RESIZABLE, LAYOUT> const& grid, std::span<distance_field> fields, std::span<std::vector<glm::ivec2> const> sources, COST_FUNC const& cost, path_options const& options = {}, unsigned thread_count = 0)
+	{
+		if (fields.size() < sources.size())
+			throw std::invalid_argument{ "not enough distance fields for all source sets" };
+		parallel_for_each_index(sources.size(), thread_count, [&](size_t i) {
+			fields[i].compute(grid, sources[i], cost, options);
+		});
+	}
+
+	namespace detail
+	{
+		/// Felzenszwalb & Huttenlocher's one-dimensional squared distance transform of `f` (of length `n`) into `d`, using `v` (`n` long) and `z` (`n + 1` long) as scratch
+		inline void squared_distance_transform_1d(float const* f, size_t f_stride, float* d, size_t d_stride, int n, int* v, float* z)
+		{
+			static constexpr float infinity = std::numeric_limits<float>::infinity();
+			const auto at = [&](int q) { return f[size_t(q) * f_stride]; };
+
+			/// Parabolas rooted at tiles with no feature in reach don't take part
+			int k = -1;
+			for (int q = 0; q < n; ++q)
+			{
+				if (at(q) == infinity)
+					continue;
+				const auto parabola = at(q) + float(q) * float(q);
+				float s = -infinity;
+				while (k >= 0)
+				{
+					s = (parabola - (at(v[k]) + float(v[k]) * float(v[k]))) / float(2 * q - 2 * v[k]);
+					if (s > z[k])
+						break;
+					--k;
+				}
+				++k;
+				v[k] = q;
+				z[k] = k == 0 ? -infinity : s;
+				z[k + 1] = infinity;
+			}
+
+			if (k < 0)
+			{
+				for (int q = 0; q < n; ++q)
+					d[size_t(q) * d_stride] = infinity;
+				return;
+			}
+
+			k = 0;
+			for (int q = 0; q < n; ++q)
+			{
+				while (z[k + 1] < float(q))
+					++k;
+				const auto dx = float(q - v[k]);
+				d[size_t(q) * d_stride] = dx * dx + at(v[k]);
+			}
+		}
+	}
+
+	/// Calculates the Euclidean distance from every tile of `grid` to the nearest tile for which `is_feature` returns true, in time linear
+	/// in the number of tiles (Felzenszwalb & Huttenlocher). Tiles with no features anywhere get infinity.
+	///
+	/// Works in two passes, the first over columns and the second over rows, each spread over `thread_count` threads (0 meaning one per hardware thread).
+	/// \param squared whether to store squared distances (which are exact integers) instead
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, query_tile_callback<TILE_DATA> FEATURE_FUNC>
+	void euclidean_distance_transform(grid<TILE_DATA, RESIZABLE, LAYOUT> const& grid, FEATURE_FUNC const& is_feature, squares::grid<float>& distances, bool squared = false, unsigned thread_count = 0)
+	{
+		static constexpr int min_lines_per_thread = 32;
+		const auto width = grid.width(), height = grid.height();
+		distances.reset(width, height);
+		if (width == 0 || height == 0)
+			return;
+
+		/// Every worker gets its own scratch buffers, big enough for a row or a column
+		const auto longest = size_t(std::max(width, height));
+		const auto scratch = [&](auto&& func) {
+			return [&](int begin, int end) {
+				std::vector<float> f(longest), z(longest + 1);
+				std::vector<int> v(longest);
+				func(begin, end, f.data(), v.data(), z.data());
+			};
+		};
+
+		float* const out = distances.tiles().data();
+		parallel_for_each_band(0, width, thread_count, min_lines_per_thread, scratch([&](int column_begin, int column_end, float* f, int* v, float* z) {
+			for (int x = column_begin; x < column_end; ++x)
+			{
+				for (int y = 0; y < height; ++y)
+					f[y] = is_feature(glm::ivec2{ x, y }, grid[glm::ivec2{ x, y }]) ? 0.0f : std::numeric_limits<float>::infinity();
+				detail::squared_distance_transform_1d(f, 1, out + x, size_t(width), height, v, z);
+			}
+		}));
+
+		parallel_for_each_band(0, height, thread_count, min_lines_per_thread, scratch([&](int row_begin, int row_end, float* f, int* v, float* z) {
+			for (int y = row_begin; y < row_end; ++y)
+			{
+				float* const row = out + size_t(y) * size_t(width);
+				std::copy_n(row, width, f);
+				detail::squared_distance_transform_1d(f, 1, row, 1, width, v, z);
+				if (!squared)
+					for (int x = 0; x < width; ++x)
+						row[x] = std::sqrt(row[x]);
+			}
+		}));
+	}
+}
@@ -0,0 +1,890 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "square_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <span>
+
+namespace ghassanpl::geometry::squares
+{
+	/// A function returning the cost of entering a tile. Negative, infinite or NaN costs mark the tile as impassable.
+	/// Cost functions used in batched queries (`find_paths`) are called from many threads at once.
+	template <typename FUNC, typename TILE_DATA>
+	concept tile_cost_callback = requires (FUNC func, TILE_DATA const& td) { { func(glm::ivec2{ 0, 0 }, td) } -> std::convertible_to<float>; };
+
+	struct path_options
+	{
+		/// Whether diagonal moves are allowed; they cost `sqrt(2)` times the cost of the tile entered
+		bool diagonals = true;
+		/// If false, diagonal moves need both tiles they pass between to be passable; if true, one is enough
+		bool cut_corners = false;
+		/// The lowest cost of entering any passable tile; the heuristic is scaled by it so that it never overestimates
+		float min_tile_cost = 1.0f;
+		/// Values above 1 make the search greedier, expanding fewer nodes at the cost of possibly longer paths
+		float heuristic_weight = 1.0f;
+		/// The search gives up after expanding this many nodes; 0 means no limit
+		size_t max_expanded_nodes = 0;
+	};
+
+	struct path_request
+	{
+		glm::ivec2 from{};
+		glm::ivec2 to{};
+	};
+
+	struct path_result
+	{
+		/// The tiles of the path, including the start and the goal; empty if no path was found
+		std::vector<glm::ivec2> path;
+		float cost = std::numeric_limits<float>::infinity();
+		size_t expanded_nodes = 0;
+
+		[[nodiscard]] bool found() const noexcept { return !path.empty(); }
+
+		void clear() noexcept
+		{
+			path.clear();
+			cost = std::numeric_limits<float>::infinity();
+			expanded_nodes = 0;
+		}
+	};
+
+	/// Scratch memory for path searches, meant to be reused between queries.
+	///
+	/// Node records are stamped with the number of the search that wrote them, so starting a new search doesn't need to clear them,
+	/// and the open list (a binary heap with lazy deletion) keeps its capacity. After warming up, searches don't allocate.
+	/// A space can only be used by one search at a time, so concurrent searches each need their own.
+	class path_search_space
+	{
+	public:
+
+		static constexpr uint32_t no_node = ~uint32_t{};
+
+		/// Starts a new search over nodes [0, `node_count`)
+		void begin(size_t node_count)
+		{
+			if (m_nodes.size() < node_count)
+				m_nodes.resize(node_count);
+			if (++m_generation == 0)
+			{
+				for (auto& node : m_nodes)
+					node.generation = 0;
+				m_generation = 1;
+			}
+			m_open.clear();
+		}
+
+		[[nodiscard]] bool visited(uint32_t node) const noexcept { return m_nodes[node].generation == m_generation; }
+		[[nodiscard]] bool closed(uint32_t node) const noexcept { return visited(node) && m_nodes[node].closed; }
+		[[nodiscard]] float cost_to(uint32_t node) const noexcept { return visited(node) ? m_nodes[node].cost : std::numeric_limits<float>::infinity(); }
+		[[nodiscard]] uint32_t parent(uint32_t node) const noexcept { return visited(node) ? m_nodes[node].parent : no_node; }
+
+		/// Records that `node` can be reached through `parent` at `cost` and puts it on the open list with the priority `cost + heuristic`,
+		/// unless it was already reached more cheaply or closed.
+		/// \returns whether the node was updated
+		bool relax(uint32_t node, uint32_t parent, float cost, float heuristic)
+		{
+			auto& record = m_nodes[node];
+			if (record.generation == m_generation && (record.closed || record.cost <= cost))
+				return false;
+			record = { m_generation, parent, cost, false };
+			m_open.push_back({ cost + heuristic, cost, node });
+			std::push_heap(m_open.begin(), m_open.end(), OpenOrder{});
+			return true;
+		}
+
+		/// Removes the open node with the lowest priority from the open list and closes it.
+		/// \returns the node, or \ref no_node if the open list is empty
+		uint32_t pop()
+		{
+			while (!m_open.empty())
+			{
+				std::pop_heap(m_open.begin(), m_open.end(), OpenOrder{});
+				const auto node = m_open.back().node;
+				m_open.pop_back();
+				auto& record = m_nodes[node];
+				if (record.closed) /// A stale entry, left behind when the node was reached more cheaply
+					continue;
+				record.closed = true;
+				return node;
+			}
+			return no_node;
+		}
+
+		/// Calls `func(node)` for `node` and each of its ancestors, ending with the node the search started from
+		template <typename FUNC>
+		void for_each_ancestor(uint32_t node, FUNC&& func) const
+		{
+			for (; node != no_node; node = parent(node))
+				func(node);
+		}
+
+	private:
+
+		struct NodeRecord
+		{
+			uint32_t generation = 0;
+			uint32_t parent = no_node;
+			float cost = 0;
+			bool closed = false;
+		};
+
+		struct OpenEntry
+		{
+			float priority;
+			float cost;
+			uint32_t node;
+		};
+
+		/// Makes a min-heap on priority; on ties, prefers nodes further from the start, which are usually closer to the goal
+		struct OpenOrder
+		{
+			bool operator()(OpenEntry const& a, OpenEntry const& b) const noexcept { return a.priority > b.priority || (a.priority == b.priority && a.cost < b.cost); }
+		};
+
+		std::vector<NodeRecord> m_nodes;
+		std::vector<OpenEntry> m_open;
+		uint32_t m_generation = 0;
+	};
+
+	namespace detail
+	{
+		inline constexpr float sqrt_2 = 1.41421356f;
+
+		[[nodiscard]] inline bool is_passable_cost(float cost) noexcept { return cost >= 0.0f && cost != std::numeric_limits<float>::infinity(); }
+
+		[[nodiscard]] inline float octile_distance(glm::ivec2 a, glm::ivec2 b) noexcept
+		{
+			const auto dx = std::abs(a.x - b.x), dy = std::abs(a.y - b.y);
+			return float(dx + dy) + (sqrt_2 - 2.0f) * float(std::min(dx, dy));
+		}
+
+		[[nodiscard]] inline int manhattan_distance(glm::ivec2 a, glm::ivec2 b) noexcept { return std::abs(a.x - b.x) + std::abs(a.y - b.y); }
+
+		[[nodiscard]] inline bool area_contains(irec2 const& area, glm::ivec2 pos) noexcept
+		{
+			return pos.x >= area.left() && pos.x < area.right() && pos.y >= area.top() && pos.y < area.bottom();
+		}
+
+		/// Solves `requests` on `thread_count` threads (0 meaning one per hardware thread), calling `solve(request, result, space)` for each,
+		/// with one \ref path_search_space per thread
+		template <typename FUNC>
+		std::vector<path_result> solve_path_requests(std::span<path_request const> requests, unsigned thread_count, FUNC const& solve)
+		{
+			std::vector<path_result> results(requests.size());
+			const auto workers = parallel_worker_count(requests.size(), thread_count);
+			std::vector<path_search_space> spaces(workers);
+			parallel_for_each_index(requests.size(), workers, [&](size_t i, unsigned worker) {
+				solve(requests[i], results[i], spaces[worker]);
+			});
+			return results;
+		}
+	}
+
+	/// A* search over the tiles of a \ref grid, with the cost of each tile given by a \ref tile_cost_callback.
+	///
+	/// Node records and the open list live in a \ref path_search_space which is reused between queries, so repeated queries don't
+	/// allocate or clear memory proportional to the grid size. The `const` overloads take the space as an argument and can be used
+	/// from multiple threads at once, as long as the grid isn't modified.
+	template <typename TILE_DATA, bool RESIZABLE = true, typename LAYOUT = row_major_layout>
+	class astar_pathfinder
+	{
+	public:
+
+		using grid_type = grid<TILE_DATA, RESIZABLE, LAYOUT>;
+
+		explicit astar_pathfinder(grid_type const& grid, path_options options = {}) : m_grid(&grid), m_options(options) {}
+
+		[[nodiscard]] grid_type const& get_grid() const noexcept { return *m_grid; }
+		[[nodiscard]] path_options const& options() const noexcept { return m_options; }
+		void set_options(path_options const& options) noexcept { m_options = options; }
+
+		/// \returns the index of the node for the tile at `pos` in a \ref path_search_space used by this pathfinder
+		[[nodiscard]] uint32_t node_index(glm::ivec2 pos) const noexcept { return uint32_t(pos.x + pos.y * m_grid->width()); }
+		[[nodiscard]] glm::ivec2 node_position(uint32_t node) const noexcept { return { int(node % uint32_t(m_grid->width())), int(node / uint32_t(m_grid->width())) }; }
+
+		template <tile_cost_callback<TILE_DATA> COST_FUNC>
+		bool find_path(glm::ivec2 from, glm::ivec2 to, COST_FUNC&& cost, path_result& result)
+		{
+			return find_path(from, to, cost, result, m_space, m_grid->bounds());
+		}
+
+		template <tile_cost_callback<TILE_DATA> COST_FUNC>
+		[[nodiscard]] path_result find_path(glm::ivec2 from, glm::ivec2 to, COST_FUNC&& cost)
+		{
+			path_result result;
+			find_path(from, to, cost, result);
+			return result;
+		}
+
+		/// Finds the cheapest path from `from` to `to` that only goes through tiles inside `area`
+		/// \returns whether a path was found
+		template <tile_cost_callback<TILE_DATA> COST_FUNC>
+		bool find_path(glm::ivec2 from, glm::ivec2 to, COST_FUNC&& cost, path_result& result, path_search_space& space, irec2 const& area) const
+		{
+			result.clear();
+			/// Out-of-grid goals would have node indices outside the search space (or alias other tiles)
+			if (!m_grid->is_valid(to) || !detail::area_contains(area, to))
+				return false;
+			const auto goal = node_index(to);
+			Search({ &from, 1 }, &to, cost, space, area, result.expanded_nodes);
+			if (!space.closed(goal))
+				return false;
+
+			result.cost = space.cost_to(goal);
+			space.for_each_ancestor(goal, [&](uint32_t node) { result.path.push_back(node_position(node)); });
+			std::ranges::reverse(result.path);
+			return true;
+		}
+
+		/// Runs a Dijkstra search from `from` through the tiles inside `area`, stopping at tiles that cost more than `max_cost` to reach.
+		/// Afterwards, `space.cost_to(node_index(pos))` is the cost of the cheapest path to `pos`, and `space.parent()` leads back along it.
+		template <tile_cost_callback<TILE_DATA> COST_FUNC>
+		void explore(glm::ivec2 from, COST_FUNC&& cost, path_search_space& space, irec2 const& area, float max_cost = std::numeric_limits<float>::infinity()) const
+		{
+			explore(std::span<glm::ivec2 const>{ &from, 1 }, cost, space, area, max_cost);
+		}
+
+		/// Like the single-source \ref explore, but the paths can start at any of the `sources`; `space.parent()` then leads back to the nearest one
+		template <tile_cost_callback<TILE_DATA> COST_FUNC>
+		void explore(std::span<glm::ivec2 const> sources, COST_FUNC&& cost, path_search_space& space, irec2 const& area, float max_cost = std::numeric_limits<float>::infinity()) const
+		{
+			size_t expanded = 0;
+			Search(sources, nullptr, cost, space, area, expanded, max_cost);
+		}
+
+		/// Solves all `requests`, spreading them over `thread_count` threads (0 meaning one per hardware thread)
+		template <tile_cost_callback<TILE_DATA> COST_FUNC>
+		[[nodiscard]] std::vector<path_result> find_paths(std::span<path_request const> requests, COST_FUNC const& cost, unsigned thread_count = 0) const
+		{
+			return detail::solve_path_requests(requests, thread_count, [&](path_request const& request, path_result& result, path_search_space& space) {
+				find_path(request.from, request.to, cost, result, space, m_grid->bounds());
+			});
+		}
+
+	private:
+
+		template <typename COST_FUNC>
+		void Search(std::span<glm::ivec2 const> sources, glm::ivec2 const* to, COST_FUNC& cost, path_search_space& space, irec2 const& area, size_t& expanded, float max_cost = std::numeric_limits<float>::infinity()) const
+		{
+			auto const& grid = *m_grid;
+			const auto clipped_area = area.intersection(grid.bounds());
+			const auto tile_cost = [&](glm::ivec2 pos) -> float {
+				if (!detail::area_contains(clipped_area, pos))
+					return -1.0f;
+				return float(cost(pos, grid[pos]));
+			};
+
+			space.begin(size_t(grid.width()) * size_t(grid.height()));
+			if (to && !detail::is_passable_cost(tile_cost(*to)))
+				return;
+
+			const auto heuristic_scale = m_options.heuristic_weight * m_options.min_tile_cost;
+			const auto heuristic = [&](glm::ivec2 pos) -> float {
+				if (!to)
+					return 0.0f;
+				return heuristic_scale * (m_options.diagonals ? detail::octile_distance(pos, *to) : float(detail::manhattan_distance(pos, *to)));
+			};
+
+			static constexpr glm::ivec2 cardinal_offsets[] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+			/// Each diagonal, with the indices of the two cardinal moves it passes between
+			static constexpr struct { glm::ivec2 offset; int first, second; } diagonal_offsets[] = {
+				{ { -1, -1 }, 0, 2 }, { { 1, -1 }, 1, 2 }, { { -1, 1 }, 0, 3 }, { { 1, 1 }, 1, 3 },
+			};
+
+			const auto goal = to ? node_index(*to) : path_search_space::no_node;
+			for (const auto source : sources)
+				if (detail::is_passable_cost(tile_cost(source)))
+					space.relax(node_index(source), path_search_space::no_node, 0.0f, heuristic(source));
+			for (uint32_t node; (node = space.pop()) != path_search_space::no_node; )
+			{
+				if (node == goal)
+					return;
+				if (m_options.max_expanded_nodes && expanded >= m_options.max_expanded_nodes)
+					return;
+				++expanded;
+
+				const auto pos = node_position(node);
+				const auto cost_so_far = space.cost_to(node);
+
+				bool cardinal_passable[4]{};
+				for (int i = 0; i < 4; ++i)
+				{
+					const auto neighbor = pos + cardinal_offsets[i];
+					const auto neighbor_cost = tile_cost(neighbor);
+					if (!(cardinal_passable[i] = detail::is_passable_cost(neighbor_cost)))
+						continue;
+					if (const auto total = cost_so_far + neighbor_cost; total <= max_cost)
+						space.relax(node_index(neighbor), node, total, heuristic(neighbor));
+				}
+
+				if (!m_options.diagonals)
+					continue;
+
+				for (auto const& diagonal : diagonal_offsets)
+				{
+					const auto can_pass = m_options.cut_corners
+						? (cardinal_passable[diagonal.first] || cardinal_passable[diagonal.second])
+						: (cardinal_passable[diagonal.first] && cardinal_passable[diagonal.second]);
+					if (!can_pass)
+						continue;
+					const auto neighbor = pos + diagonal.offset;
+					const auto neighbor_cost = tile_cost(neighbor);
+					if (!detail::is_passable_cost(neighbor_cost))
+						continue;
+					if (const auto total = cost_so_far + neighbor_cost * detail::sqrt_2; total <= max_cost)
+						space.relax(node_index(neighbor), node, total, heuristic(neighbor));
+				}
+			}
+		}
+
+		grid_type const* m_grid;
+		path_options m_options;
+		path_search_space m_space;
+	};
+
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT>
+	astar_pathfinder(grid<TILE_DATA, RESIZABLE, LAYOUT> const&, path_options = {}) -> astar_pathfinder<TILE_DATA, RESIZABLE, LAYOUT>;
+
+	/// Jump Point Search (Harabor & Grastien), an A* for grids where all passable tiles cost the same.
+	///
+	/// Moves are 8-directional and never cut corners. Instead of putting every neighbor on the open list, the search "jumps" along
+	/// straight and diagonal runs of open tiles, stopping only at tiles where an obstacle forces a turn, so only a few nodes are ever
+	/// expanded. The paths are as short as the ones found by \ref astar_pathfinder with `diagonals = true` and `cut_corners = false`.
+	template <typename TILE_DATA, bool RESIZABLE = true, typename LAYOUT = row_major_layout>
+	class jps_pathfinder
+	{
+	public:
+
+		using grid_type = grid<TILE_DATA, RESIZABLE, LAYOUT>;
+
+		explicit jps_pathfinder(grid_type const& grid) : m_grid(&grid) {}
+
+		[[nodiscard]] grid_type const& get_grid() const noexcept { return *m_grid; }
+
+		template <query_tile_callback<TILE_DATA> PASSABLE_FUNC>
+		bool find_path(glm::ivec2 from, glm::ivec2 to, PASSABLE_FUNC&& passable, path_result& result)
+		{
+			return find_path(from, to, passable, result, m_space);
+		}
+
+		template <query_tile_callback<TILE_DATA> PASSABLE_FUNC>
+		[[nodiscard]] path_result find_path(glm::ivec2 from, glm::ivec2 to, PASSABLE_FUNC&& passable)
+		{
+			path_result result;
+			find_path(from, to, passable, result);
+			return result;
+		}
+
+		/// \returns whether a path was found
+		template <query_tile_callback<TILE_DATA> PASSABLE_FUNC>
+		bool find_path(glm::ivec2 from, glm::ivec2 to, PASSABLE_FUNC&& passable, path_result& result, path_search_space& space) const
+		{
+			auto const& grid = *m_grid;
+			const auto width = grid.width();
+			const auto node_index = [width](glm::ivec2 pos) { return uint32_t(pos.x + pos.y * width); };
+			const auto node_position = [width](uint32_t node) { return glm::ivec2{ int(node % uint32_t(width)), int(node / uint32_t(width)) }; };
+			const auto walkable = [&](int x, int y) { return grid.is_valid(x, y) && bool(passable(glm::ivec2{ x, y }, grid[glm::ivec2{ x, y }])); };
+
+			result.clear();
+			space.begin(size_t(width) * size_t(grid.height()));
+			if (!walkable(from.x, from.y) || !walkable(to.x, to.y))
+				return false;
+
+			/// Whether moving straight in `dir` onto `pos` opens up a tile that couldn't be reached more directly, forcing a turn there
+			const auto has_forced_neighbor = [&](glm::ivec2 pos, glm::ivec2 dir) {
+				if (dir.x != 0)
+					return (walkable(pos.x, pos.y - 1) && !walkable(pos.x - dir.x, pos.y - 1)) || (walkable(pos.x, pos.y + 1) && !walkable(pos.x - dir.x, pos.y + 1));
+				return (walkable(pos.x - 1, pos.y) && !walkable(pos.x - 1, pos.y - dir.y)) || (walkable(pos.x + 1, pos.y) && !walkable(pos.x + 1, pos.y - dir.y));
+			};
+
+			const auto jump_straight = [&](glm::ivec2 pos, glm::ivec2 dir) -> std::optional<glm::ivec2> {
+				for (; walkable(pos.x, pos.y); pos += dir)
+					if (pos == to || has_forced_neighbor(pos, dir))
+						return pos;
+				return std::nullopt;
+			};
+
+			/// Walks from `pos` in direction `dir` until reaching a jump point (returned) or a dead end
+			const auto jump = [&](glm::ivec2 pos, glm::ivec2 dir) -> std::optional<glm::ivec2> {
+				if (dir.x == 0 || dir.y == 0)
+					return jump_straight(pos, dir);
+
+				for (; walkable(pos.x, pos.y); pos += dir)
+				{
+					if (pos == to)
+						return pos;
+					if (jump_straight({ pos.x + dir.x, pos.y }, { dir.x, 0 }) || jump_straight({ pos.x, pos.y + dir.y }, { 0, dir.y }))
+						return pos;
+					if (!walkable(pos.x + dir.x, pos.y) || !walkable(pos.x, pos.y + dir.y))
+						break;
+				}
+				return std::nullopt;
+			};
+
+			const auto goal = node_index(to);
+			space.relax(node_index(from), path_search_space::no_node, 0.0f, detail::octile_distance(from, to));
+
+			glm::ivec2 successors[8];
+			for (uint32_t node; (node = space.pop()) != path_search_space::no_node; )
+			{
+				if (node == goal)
+					break;
+				++result.expanded_nodes;
+
+				const auto pos = node_position(node);
+				int successor_count = 0;
+				const auto add_if_walkable = [&](int x, int y) {
+					if (walkable(x, y))
+						successors[successor_count++] = { x, y };
+				};
+
+				if (const auto parent = space.parent(node); parent == path_search_space::no_node)
+				{
+					const bool left = walkable(pos.x - 1, pos.y), right = walkable(pos.x + 1, pos.y), up = walkable(pos.x, pos.y - 1), down = walkable(pos.x, pos.y + 1);
+					add_if_walkable(pos.x - 1, pos.y);
+					add_if_walkable(pos.x + 1, pos.y);
+					add_if_walkable(pos.x, pos.y - 1);
+					add_if_walkable(pos.x, pos.y + 1);
+					if (left && up) add_if_walkable(pos.x - 1, pos.y - 1);
+					if (right && up) add_if_walkable(pos.x + 1, pos.y - 1);
+					if (left && down) add_if_walkable(pos.x - 1, pos.y + 1);
+					if (right && down) add_if_walkable(pos.x + 1, pos.y + 1);
+				}
+				else
+				{
+					const auto parent_pos = node_position(parent);
+					const glm::ivec2 dir{ (pos.x > parent_pos.x) - (pos.x < parent_pos.x), (pos.y > parent_pos.y) - (pos.y < parent_pos.y) };
+					if (dir.x != 0 && dir.y != 0)
+					{
+						const bool vertical = walkable(pos.x, pos.y + dir.y), horizontal = walkable(pos.x + dir.x, pos.y);
+						if (vertical) successors[successor_count++] = { pos.x, pos.y + dir.y };
+						if (horizontal) successors[successor_count++] = { pos.x + dir.x, pos.y };
+						if (vertical && horizontal) add_if_walkable(pos.x + dir.x, pos.y + dir.y);
+					}
+					else
+					{
+						/// `side` is perpendicular to the direction of movement
+						const glm::ivec2 side{ dir.y, dir.x };
+						const bool next = walkable(pos.x + dir.x, pos.y + dir.y);
+						const bool side_a = walkable(pos.x + side.x, pos.y + side.y), side_b = walkable(pos.x - side.x, pos.y - side.y);
+						if (next)
+						{
+							successors[successor_count++] = pos + dir;
+							if (side_a) add_if_walkable(pos.x + dir.x + side.x, pos.y + dir.y + side.y);
+							if (side_b) add_if_walkable(pos.x + dir.x - side.x, pos.y + dir.y - side.y);
+						}
+						if (side_a) successors[successor_count++] = pos + side;
+						if (side_b) successors[successor_count++] = pos - side;
+					}
+				}
+
+				const auto cost_so_far = space.cost_to(node);
+				for (int i = 0; i < successor_count; ++i)
+				{
+					if (const auto jump_point = jump(successors[i], successors[i] - pos))
+						space.relax(node_index(*jump_point), node, cost_so_far + detail::octile_distance(pos, *jump_point), detail::octile_distance(*jump_point, to));
+				}
+			}
+
+			if (!space.closed(goal))
+				return false;
+
+			/// Jump points are connected by straight or diagonal lines; fill them in
+			result.cost = space.cost_to(goal);
+			glm::ivec2 previous = to;
+			result.path.push_back(to);
+			space.for_each_ancestor(space.parent(goal), [&](uint32_t node) {
+				const auto pos = node_position(node);
+				const glm::ivec2 step{ (pos.x > previous.x) - (pos.x < previous.x), (pos.y > previous.y) - (pos.y < previous.y) };
+				while (previous != pos)
+					result.path.push_back(previous += step);
+			});
+			std::ranges::reverse(result.path);
+			return true;
+		}
+
+		/// Solves all `requests`, spreading them over `thread_count` threads (0 meaning one per hardware thread)
+		template <query_tile_callback<TILE_DATA> PASSABLE_FUNC>
+		[[nodiscard]] std::vector<path_result> find_paths(std::span<path_request const> requests, PASSABLE_FUNC const& passable, unsigned thread_count = 0) const
+		{
+			return detail::solve_path_requests(requests, thread_count, [&](path_request const& request, path_result& result, path_search_space& space) {
+				find_path(request.from, request.to, passable, result, space);
+			});
+		}
+
+	private:
+
+		grid_type const* m_grid;
+		path_search_space m_space;
+	};
+
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT>
+	jps_pathfinder(grid<TILE_DATA, RESIZABLE, LAYOUT> const&) -> jps_pathfinder<TILE_DATA, RESIZABLE, LAYOUT>;
+
+	struct hierarchical_path_options
+	{
+		/// The width and height of a cluster, in tiles
+		int cluster_size = 16;
+		/// Runs of passable tiles along a border shorter than this get a single entrance in their middle; longer ones get one at each end
+		int long_entrance_length = 6;
+		/// Options for the searches inside clusters; `max_expanded_nodes` is ignored
+		path_options local{};
+	};
+
+	/// Hierarchical path-finding A* (HPA*, Botea et al.) over a \ref grid.
+	///
+	/// The grid is divided into square clusters. Wherever two neighboring clusters share a run of passable tiles along their border,
+	/// one or two entrances are placed on it, and the cheapest paths between the entrances of each cluster are precomputed. Queries
+	/// search this small abstract graph first, then refine each of its edges with an A* limited to a single cluster, which makes
+	/// long-distance queries much cheaper than a plain A* over the whole grid. The paths found may be slightly longer than optimal.
+	///
+	/// After changing tiles, call \ref tiles_changed with the changed area to rebuild only the clusters it touches.
+	/// The cost function is stored by value, and its answers for a tile must not change without the tile being reported as changed.
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, tile_cost_callback<TILE_DATA> COST_FUNC>
+	class hierarchical_pathfinder
+	{
+	public:
+
+		using grid_type = grid<TILE_DATA, RESIZABLE, LAYOUT>;
+
+		using options = hierarchical_path_options;
+
+		hierarchical_pathfinder(grid_type const& grid, COST_FUNC cost) : hierarchical_pathfinder(grid, std::move(cost), options{}) {}
+		hierarchical_pathfinder(grid_type const& grid, COST_FUNC cost, options opts)
+			: m_local(grid), m_cost(std::move(cost)), m_options(opts)
+		{
+			if (m_options.cluster_size < 2)
+				throw std::invalid_argument("cluster_size must be at least 2");
+			m_options.local.max_expanded_nodes = 0;
+			m_local.set_options(m_options.local);
+			rebuild();
+		}
+
+		[[nodiscard]] grid_type const& get_grid() const noexcept { return m_local.get_grid(); }
+		[[nodiscard]] options const& get_options() const noexcept { return m_options; }
+
+		/// Rebuilds the whole abstract graph
+		void rebuild()
+		{
+			const auto cluster_size = m_options.cluster_size;
+			m_grid_size = m_local.get_grid().size();
+			m_cluster_counts = { (m_grid_size.x + cluster_size - 1) / cluster_size, (m_grid_size.y + cluster_size - 1) / cluster_size };
+
+			const auto cluster_count = size_t(m_cluster_counts.x) * size_t(m_cluster_counts.y);
+			m_clusters.assign(cluster_count, {});
+			m_right_entrances.assign(cluster_count, {});
+			m_bottom_entrances.assign(cluster_count, {});
+
+			for (int y = 0; y < m_cluster_counts.y; ++y)
+				for (int x = 0; x < m_cluster_counts.x; ++x)
+					BuildEntrances({ x, y });
+			for (int y = 0; y < m_cluster_counts.y; ++y)
+				for (int x = 0; x < m_cluster_counts.x; ++x)
+					BuildCluster({ x, y });
+		}
+
+		/// Updates the abstract graph after the tiles in `area` have changed, rebuilding only the clusters affected.
+		/// If the grid was resized, everything is rebuilt.
+		void tiles_changed(irec2 const& area)
+		{
+			if (m_local.get_grid().size() != m_grid_size)
+				return rebuild();
+
+			const auto changed = area.intersection(m_local.get_grid().bounds());
+			if (changed.width() <= 0 || changed.height() <= 0)
+				return;
+
+			const auto cluster_size = m_options.cluster_size;
+			const glm::ivec2 first{ changed.left() / cluster_size, changed.top() / cluster_size };
+			const glm::ivec2 last{ (changed.right() - 1) / cluster_size, (changed.bottom() - 1) / cluster_size };
+
+			/// Entrances on all borders of the changed clusters...
+			for (int y = first.y; y <= last.y; ++y)
+				for (int x = first.x; x <= last.x; ++x)
+				{
+					BuildEntrances({ x, y });
+					if (x > 0) BuildEntrances({ x - 1, y });
+					if (y > 0) BuildEntrances({ x, y - 1 });
+				}
+
+			/// ...which are shared with their neighbors, whose entrance costs need to be recalculated as well
+			for (int y = std::max(first.y - 1, 0); y <= std::min(last.y + 1, m_cluster_counts.y - 1); ++y)
+				for (int x = std::max(first.x - 1, 0); x <= std::min(last.x + 1, m_cluster_counts.x - 1); ++x)
+					BuildCluster({ x, y });
+		}
+
+		void tile_changed(glm::ivec2 pos) { tiles_changed(irec2::from_size(pos, { 1, 1 })); }
+
+		[[nodiscard]] glm::ivec2 cluster_counts() const noexcept { return m_cluster_counts; }
+
+		/// \returns the number of entrance tiles in the abstract graph
+		[[nodiscard]] size_t abstract_node_count() const noexcept
+		{
+			size_t result = 0;
+			for (auto const& cluster : m_clusters)
+				result += cluster.nodes.size();
+			return result;
+		}
+
+		bool find_path(glm::ivec2 from, glm::ivec2 to, path_result& result)
+		{
+			return find_path(from, to, result, m_space);
+		}
+
+		[[nodiscard]] path_result find_path(glm::ivec2 from, glm::ivec2 to)
+		{
+			path_result result;
+			find_path(from, to, result);
+			return result;
+		}
+
+		/// \returns whether a path was found
+		bool find_path(glm::ivec2 from, glm::ivec2 to, path_result& result, path_search_space& space) const
+		{
+			result.clear();
+			auto const& grid = m_local.get_grid();
+			if (!grid.is_valid(from) || !grid.is_valid(to) || !IsPassable(from) || !IsPassable(to))
+				return false;
+
+			const auto start_cluster = ClusterOf(from), goal_cluster = ClusterOf(to);
+			if (start_cluster == goal_cluster && m_local.find_path(from, to, m_cost, result, space, ClusterArea(start_cluster)))
+				return true;
+
+			std::vector<std::pair<glm::ivec2, float>> start_edges, goal_edges;
+			ConnectToEntrances(from, start_edges, space, false);
+			ConnectToEntrances(to, goal_edges, space, true);
+
+			/// Search the abstract graph, whose nodes are the start, the goal, and the entrances
+			auto expanded_nodes = result.expanded_nodes;
+			const auto start = m_local.node_index(from), goal = m_local.node_index(to);
+			const auto heuristic_scale = m_options.local.heuristic_weight * m_options.local.min_tile_cost;
+			const auto heuristic = [&](glm::ivec2 pos) {
+				return heuristic_scale * (m_options.local.diagonals ? detail::octile_distance(pos, to) : float(detail::manhattan_distance(pos, to)));
+			};
+
+			space.begin(size_t(m_grid_size.x) * size_t(m_grid_size.y));
+			space.relax(start, path_search_space::no_node, 0.0f, heuristic(from));
+			for (uint32_t node; (node = space.pop()) != path_search_space::no_node; )
+			{
+				if (node == goal)
+					break;
+				++expanded_nodes;
+
+				const auto pos = m_local.node_position(node);
+				const auto cost_so_far = space.cost_to(node);
+				const auto relax = [&](glm::ivec2 next, float edge_cost) { space.relax(m_local.node_index(next), node, cost_so_far + edge_cost, heuristic(next)); };
+
+				if (node == start)
+				{
+					for (auto const& [next, edge_cost] : start_edges)
+						relax(next, edge_cost);
+				}
+
+				const auto cluster_pos = ClusterOf(pos);
+				auto const& cluster = m_clusters[ClusterIndex(cluster_pos)];
+				if (const auto it = std::ranges::find(cluster.nodes, pos); it != cluster.nodes.end())
+				{
+					const auto node_count = cluster.nodes.size();
+					const auto distances = cluster.distances.data() + size_t(it - cluster.nodes.begin()) * node_count;
+					for (size_t i = 0; i < node_count; ++i)
+						if (cluster.nodes[i] != pos && distances[i] != std::numeric_limits<float>::infinity())
+							relax(cluster.nodes[i], distances[i]);
+					for (auto const& crossing : cluster.crossings)
+						if (crossing.from == pos)
+							relax(crossing.to, crossing.cost);
+				}
+
+				if (cluster_pos == goal_cluster)
+				{
+					for (auto const& [entrance, edge_cost] : goal_edges)
+						if (entrance == pos)
+							relax(to, edge_cost);
+				}
+			}
+
+			if (!space.closed(goal))
+			{
+				result.expanded_nodes = expanded_nodes;
+				return false;
+			}
+
+			/// Refine each abstract edge into tiles: edges between clusters are single steps, the others are searched for within their cluster
+			std::vector<glm::ivec2> waypoints;
+			space.for_each_ancestor(goal, [&](uint32_t node) { waypoints.push_back(m_local.node_position(node)); });
+			std::ranges::reverse(waypoints);
+
+			path_result segment;
+			result.path.push_back(from);
+			result.cost = 0.0f;
+			for (size_t i = 1; i < waypoints.size(); ++i)
+			{
+				const auto a = waypoints[i - 1], b = waypoints[i];
+				if (ClusterOf(a) != ClusterOf(b))
+				{
+					result.path.push_back(b);
+					result.cost += TileCost(b);
+					continue;
+				}
+
+				if (!m_local.find_path(a, b, m_cost, segment, space, ClusterArea(ClusterOf(a))))
+				{
+					result.clear();
+					return false;
+				}
+				result.path.insert(result.path.end(), segment.path.begin() + 1, segment.path.end());
+				result.cost += segment.cost;
+				expanded_nodes += segment.expanded_nodes;
+			}
+			result.expanded_nodes = expanded_nodes;
+			return true;
+		}
+
+		/// Solves all `requests`, spreading them over `thread_count` threads (0 meaning one per hardware thread)
+		[[nodiscard]] std::vector<path_result> find_paths(std::span<path_request const> requests, unsigned thread_count = 0) const
+		{
+			return detail::solve_path_requests(requests, thread_count, [&](path_request const& request, path_result& result, path_search_space& space) {
+				find_path(request.from, request.to, result, space);
+			});
+		}
+
+	private:
+
+		/// A pair of neighboring passable tiles on a border between clusters, the first inside the cluster and the second in its right or bottom neighbor
+		using Entrance = std::pair<glm::ivec2, glm::ivec2>;
+
+		struct Crossing
+		{
+			glm::ivec2 from;
+			glm::ivec2 to;
+			float cost;
+		};
+
+		struct Cluster
+		{
+			/// The entrance tiles inside the cluster
+			std::vector<glm::ivec2> nodes;
+			/// `distances[i * nodes.size() + j]` is the cost of the cheapest path from `nodes[i]` to `nodes[j]` that stays inside the cluster
+			std::vector<float> distances;
+			/// Steps from entrance tiles to entrance tiles of neighboring clusters
+			std::vector<Crossing> crossings;
+		};
+
+		[[nodiscard]] float TileCost(glm::ivec2 pos) const { return float(m_cost(pos, m_local.get_grid()[pos])); }
+		[[nodiscard]] bool IsPassable(glm::ivec2 pos) const { return detail::is_passable_cost(TileCost(pos)); }
+
+		[[nodiscard]] glm::ivec2 ClusterOf(glm::ivec2 pos) const noexcept { return { pos.x / m_options.cluster_size, pos.y / m_options.cluster_size }; }
+		[[nodiscard]] size_t ClusterIndex(glm::ivec2 cluster) const noexcept { return size_t(cluster.x) + size_t(cluster.y) * size_t(m_cluster_counts.x); }
+		[[nodiscard]] irec2 ClusterArea(glm::ivec2 cluster) const noexcept
+		{
+			const glm::ivec2 top_left{ cluster.x * m_options.cluster_size, cluster.y * m_options.cluster_size };
+			return irec2{ top_left, glm::ivec2{ std::min(top_left.x + m_options.cluster_size, m_grid_size.x), std::min(top_left.y + m_options.cluster_size, m_grid_size.y) } };
+		}
+
+		/// Finds the entrances on the right and bottom borders of `cluster`
+		void BuildEntrances(glm::ivec2 cluster)
+		{
+			const auto index = ClusterIndex(cluster);
+			const auto area = ClusterArea(cluster);
+
+			const auto find_entrances = [this](std::vector<Entrance>& entrances, glm::ivec2 first, glm::ivec2 along, glm::ivec2 across, int length) {
+				const auto tile = [&](int i) { return glm::ivec2{ first.x + along.x * i, first.y + along.y * i }; };
+				entrances.clear();
+				for (int i = 0, run_start = 0; i <= length; ++i)
+				{
+					if (i < length && IsPassable(tile(i)) && IsPassable(tile(i) + across))
+						continue;
+
+					if (const auto run_length = i - run_start; run_length >= m_options.long_entrance_length)
+					{
+						entrances.push_back({ tile(run_start), tile(run_start) + across });
+						entrances.push_back({ tile(i - 1), tile(i - 1) + across });
+					}
+					else if (run_length > 0)
+						entrances.push_back({ tile(run_start + run_length / 2), tile(run_start + run_length / 2) + across });
+					run_start = i + 1;
+				}
+			};
+
+			m_right_entrances[index].clear();
+			m_bottom_entrances[index].clear();
+			if (cluster.x + 1 < m_cluster_counts.x)
+				find_entrances(m_right_entrances[index], { area.right() - 1, area.top() }, { 0, 1 }, { 1, 0 }, area.height());
+			if (cluster.y + 1 < m_cluster_counts.y)
+				find_entrances(m_bottom_entrances[index], { area.left(), area.bottom() - 1 }, { 1, 0 }, { 0, 1 }, area.width());
+		}
+
+		/// Gathers the entrances on all borders of `cluster` and calculates the costs of moving between them
+		void BuildCluster(glm::ivec2 cluster_pos)
+		{
+			auto& cluster = m_clusters[ClusterIndex(cluster_pos)];
+			cluster.nodes.clear();
+			cluster.crossings.clear();
+
+			const auto gather = [&](std::vector<Entrance> const& entrances, bool inside_is_first) {
+				for (auto const& [first, second] : entrances)
+				{
+					const auto inside = inside_is_first ? first : second, outside = inside_is_first ? second : first;
+					cluster.nodes.push_back(inside);
+					cluster.crossings.push_back({ inside, outside, TileCost(outside) });
+				}
+			};
+			gather(m_right_entrances[ClusterIndex(cluster_pos)], true);
+			gather(m_bottom_entrances[ClusterIndex(cluster_pos)], true);
+			if (cluster_pos.x > 0)
+				gather(m_right_entrances[ClusterIndex({ cluster_pos.x - 1, cluster_pos.y })], false);
+			if (cluster_pos.y > 0)
+				gather(m_bottom_entrances[ClusterIndex({ cluster_pos.x, cluster_pos.y - 1 })], false);
+
+			std::ranges::sort(cluster.nodes, [](glm::ivec2 a, glm::ivec2 b) { return a.y < b.y || (a.y == b.y && a.x < b.x); });
+			cluster.nodes.erase(std::unique(cluster.nodes.begin(), cluster.nodes.end()), cluster.nodes.end());
+
+			const auto node_count = cluster.nodes.size();
+			const auto area = ClusterArea(cluster_pos);
+			cluster.distances.assign(node_count * node_count, std::numeric_limits<float>::infinity());
+			for (size_t i = 0; i < node_count; ++i)
+			{
+				m_local.explore(cluster.nodes[i], m_cost, m_space, area);
+				for (size_t j = 0; j < node_count; ++j)
+					cluster.distances[i * node_count + j] = m_space.cost_to(m_local.node_index(cluster.nodes[j]));
+			}
+		}
+
+		/// Finds the costs of the paths between `pos` and the entrances of its cluster; from `pos` to them, or from them to `pos` if `to_pos` is set
+		void ConnectToEntrances(glm::ivec2 pos, std::vector<std::pair<glm::ivec2, float>>& edges, path_search_space& space, bool to_pos) const
+		{
+			const auto cluster_pos = ClusterOf(pos);
+			m_local.explore(pos, m_cost, space, ClusterArea(cluster_pos));
+			for (auto const& entrance : m_clusters[ClusterIndex(cluster_pos)].nodes)
+			{
+				const auto cost = space.cost_to(m_local.node_index(entrance));
+				if (cost == std::numeric_limits<float>::infinity())
+					continue;
+				/// Tile costs are paid on entry, so the reverse path pays for `pos` instead of `entrance` (exact for cardinal moves, close enough for diagonal ones)
+				edges.push_back({ entrance, to_pos ? cost - TileCost(entrance) + TileCost(pos) : cost });
+			}
+		}
+
+		astar_pathfinder<TILE_DATA, RESIZABLE, LAYOUT> m_local;
+		COST_FUNC m_cost;
+		options m_options;
+		glm::ivec2 m_grid_size{};
+		glm::ivec2 m_cluster_counts{};
+		std::vector<Cluster> m_clusters;
+		std::vector<std::vector<Entrance>> m_right_entrances;
+		std::vector<std::vector<Entrance>> m_bottom_entrances;
+		path_search_space m_space;
+	};
+
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, typename COST_FUNC>
+	hierarchical_pathfinder(grid<TILE_DATA, RESIZABLE, LAYOUT> const&, COST_FUNC) -> hierarchical_pathfinder<TILE_DATA, RESIZABLE, LAYOUT, COST_FUNC>;
+
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, typename COST_FUNC>
+	hierarchical_pathfinder(grid<TILE_DATA, RESIZABLE, LAYOUT> const&, COST_FUNC, hierarchical_path_options) -> hierarchical_pathfinder<TILE_DATA, RESIZABLE, LAYOUT, COST_FUNC>;
+}
@@ -0,0 +1,449 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "square_grid.h"
+#include <mutex>
+
+namespace ghassanpl::geometry::squares
+{
+	/// Labels the connected regions of passable tiles of a \ref grid, so that checking whether one tile can be reached from another
+	/// is a comparison of two labels.
+	///
+	/// The initial labeling is a union-find pass run in parallel over bands of rows, whose results are then merged along the band borders.
+	/// Labels are compact, numbered in the order their first tile appears in the grid (row by row).
+	///
+	/// After changing tiles, call \ref tiles_changed with the changed area; only the regions touching that area are relabeled (so the cost
+	/// is proportional to their size, not to the size of the grid), and all other regions keep their labels.
+	/// The passability predicate is stored by value, and its answer for a tile must not change without the tile being reported as changed.
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, query_tile_callback<TILE_DATA> PASSABLE_FUNC>
+	class region_map
+	{
+	public:
+
+		using grid_type = grid<TILE_DATA, RESIZABLE, LAYOUT>;
+
+		static constexpr uint32_t no_region = ~uint32_t{};
+
+		struct options
+		{
+			/// Whether diagonal neighbors are connected
+			bool diagonals = false;
+			/// The maximum number of threads to use for full relabeling; 0 means `std::thread::hardware_concurrency()`
+			unsigned thread_count = 0;
+			/// Bands of rows smaller than this are not worth a thread
+			int min_rows_per_thread = 64;
+		};
+
+		region_map(grid_type const& grid, PASSABLE_FUNC passable) : region_map(grid, std::move(passable), options{}) {}
+		region_map(grid_type const& grid, PASSABLE_FUNC passable, options opts)
+			: m_grid(&grid), m_passable(std::move(passable)), m_options(opts)
+		{
+			rebuild();
+		}
+
+		[[nodiscard]] grid_type const& get_grid() const noexcept { return *m_grid; }
+		[[nodiscard]] options const& get_options() const noexcept { return m_options; }
+
+		/// \returns the label of the region containing the tile at `pos`, or \ref no_region if the tile is impassable or outside the grid
+		[[nodiscard]] uint32_t region_at(glm::ivec2 pos) const noexcept
+		{
+			if (pos.x < 0 || pos.y < 0 || pos.x >= m_size.x || pos.y >= m_size.y)
+				return no_region;
+			return m_labels[Index(pos)];
+		}
+
+		/// \returns whether there is a path between the tiles at `from` and `to` going only through passable tiles
+		[[nodiscard]] bool is_reachable(glm::ivec2 from, glm::ivec2 to) const noexcept
+		{
+			const auto region = region_at(from);
+			return region != no_region && region == region_at(to);
+		}
+
+		/// \returns the number of regions
+		[[nodiscard]] size_t region_count() const noexcept { return m_region_count; }
+
+		/// \returns the number of tiles in `region`
+		[[nodiscard]] size_t region_size(uint32_t region) const noexcept { return region < m_region_sizes.size() ? m_region_sizes[region] : 0; }
+
+		/// \returns one past the highest label in use; after incremental updates, some labels below it may be unused (their size is 0)
+		[[nodiscard]] uint32_t label_limit() const noexcept { return uint32_t(m_region_sizes.size()); }
+
+		/// Relabels the whole grid
+		void rebuild()
+		{
+			auto const& grid = *m_grid;
+			m_size = grid.size();
+			const auto tile_count = size_t(m_size.x) * size_t(m_size.y);
+			m_labels.assign(tile_count, no_region);
+			m_region_sizes.clear();
+			m_free_labels.clear();
+			m_region_count = 0;
+			if (tile_count == 0)
+				return;
+
+			/// Each band links its tiles into trees whose roots are their lowest indices, touching only its own part of `parents`
+			std::vector<uint32_t> parents(tile_count, no_region);
+			std::vector<int> band_starts;
+			std::mutex band_starts_mutex;
+			parallel_for_each_band(0, m_size.y, m_options.thread_count, m_options.min_rows_per_thread, [&](int row_begin, int row_end) {
+				{
+					std::lock_guard lock{ band_starts_mutex };
+					band_starts.push_back(row_begin);
+				}
+				for (int y = row_begin; y < row_end; ++y)
+					for (int x = 0; x < m_size.x; ++x)
+					{
+						const glm::ivec2 pos{ x, y };
+						if (!IsPassable(pos))
+							continue;
+						const auto index = Index(pos);
+						parents[index] = index;
+						ForEachEarlierNeighbor(pos, y > row_begin, [&](glm::ivec2 neighbor) { Unite(parents, index, Index(neighbor)); });
+					}
+			});
+
+			/// Merge the bands along the rows where they meet
+			for (const auto band_start : band_starts)
+			{
+				if (band_start == 0)
+					continue;
+				for (int x = 0; x < m_size.x; ++x)
+				{
+					const glm::ivec2 pos{ x, band_start };
+					if (parents[Index(pos)] == no_region)
+						continue;
+					ForEachNeighborAbove(pos, [&](glm::ivec2 neighbor) { Unite(parents, Index(pos), Index(neighbor)); });
+				}
+			}
+
+			/// Find the roots in parallel, without modifying the trees...
+			parallel_for_each_band(0, m_size.y, m_options.thread_count, m_options.min_rows_per_thread, [&](int row_begin, int row_end) {
+				const auto end = size_t(row_end) * size_t(m_size.x);
+				for (auto index = size_t(row_begin) * size_t(m_size.x); index < end; ++index)
+					if (parents[index] != no_region)
+						m_labels[index] = Find(parents, uint32_t(index));
+			});
+
+			/// ...then number them; a root is always the first tile of its region, so it's numbered before any other tile refers to it
+			for (uint32_t index = 0; index < uint32_t(tile_count); ++index)
+			{
+				const auto root = m_labels[index];
+				if (root == no_region)
+					continue;
+				if (root == index)
+				{
+					parents[index] = uint32_t(m_region_sizes.size());
+					m_region_sizes.push_back(0);
+				}
+				m_labels[index] = parents[root];
+				++m_region_sizes[m_labels[index]];
+			}
+			m_region_count = m_region_sizes.size();
+		}
+
+		/// Updates the labels after the tiles in `area` have changed.
+		/// If the grid was resized, everything is relabeled.
+		void tiles_changed(irec2 const& area)
+		{
+			if (m_grid->size() != m_size)
+				return rebuild();
+
+			const auto changed = area.intersection(m_grid->bounds());
+			if (changed.width() <= 0 || changed.height() <= 0)
+				return;
+
+			/// Tiles that stopped being passable leave their regions, which may split apart; every part a region splits into
+			/// contains one of the removed tiles' neighbors
+			m_split_seeds.clear();
+			for (int y = changed.top(); y < changed.bottom(); ++y)
+				for (int x = changed.left(); x < changed.right(); ++x)
+				{
+					auto& label = m_labels[Index({ x, y })];
+					if (label == no_region || IsPassable({ x, y }))
+						continue;
+					const auto old_label = std::exchange(label, no_region);
+					Leave(old_label);
+					ForEachNeighbor({ x, y }, [&](glm::ivec2 neighbor) {
+						if (m_labels[Index(neighbor)] == old_label)
+							m_split_seeds.push_back({ old_label, Index(neighbor) });
+					});
+				}
+
+			std::ranges::sort(m_split_seeds);
+			m_split_seeds.erase(std::unique(m_split_seeds.begin(), m_split_seeds.end()), m_split_seeds.end());
+			for (auto it = m_split_seeds.begin(); it != m_split_seeds.end(); )
+			{
+				const auto end = std::find_if(it, m_split_seeds.end(), [label = it->first](auto const& seed) { return seed.first != label; });
+				SplitIfDisconnected(it->first, std::span{ it, end });
+				it = end;
+			}
+
+			/// Tiles that became passable join the regions around them, merging them together
+			for (int y = changed.top(); y < changed.bottom(); ++y)
+				for (int x = changed.left(); x < changed.right(); ++x)
+					if (m_labels[Index({ x, y })] == no_region && IsPassable({ x, y }))
+						Join({ x, y });
+		}
+
+		void tile_changed(glm::ivec2 pos) { tiles_changed(irec2::from_size(pos, { 1, 1 })); }
+
+	private:
+
+		[[nodiscard]] uint32_t Index(glm::ivec2 pos) const noexcept { return uint32_t(pos.x + pos.y * m_size.x); }
+		[[nodiscard]] bool IsPassable(glm::ivec2 pos) const { return bool(m_passable(pos, (*m_grid)[pos])); }
+		[[nodiscard]] glm::ivec2 Position(uint32_t index) const noexcept { return { int(index % uint32_t(m_size.x)), int(index / uint32_t(m_size.x)) }; }
+
+		/// Calls `func` for the passable neighbors of `pos` that come before it in row order; the ones in the row above only if `with_row_above`
+		template <typename FUNC>
+		void ForEachEarlierNeighbor(glm::ivec2 pos, bool with_row_above, FUNC&& func) const
+		{
+			if (pos.x > 0 && IsPassable({ pos.x - 1, pos.y }))
+				func(glm::ivec2{ pos.x - 1, pos.y });
+			if (with_row_above)
+				ForEachNeighborAbove(pos, func);
+		}
+
+		template <typename FUNC>
+		void ForEachNeighborAbove(glm::ivec2 pos, FUNC&& func) const
+		{
+			if (pos.y == 0)
+				return;
+			if (IsPassable({ pos.x, pos.y - 1 }))
+				func(glm::ivec2{ pos.x, pos.y - 1 });
+			if (!m_options.diagonals)
+				return;
+			if (pos.x > 0 && IsPassable({ pos.x - 1, pos.y - 1 }))
+				func(glm::ivec2{ pos.x - 1, pos.y - 1 });
+			if (pos.x + 1 < m_size.x && IsPassable({ pos.x + 1, pos.y - 1 }))
+				func(glm::ivec2{ pos.x + 1, pos.y - 1 });
+		}
+
+		static uint32_t Find(std::vector<uint32_t> const& parents, uint32_t index) noexcept
+		{
+			while (parents[index] != index)
+				index = parents[index];
+			return index;
+		}
+
+		/// Finds the root of `index`, halving the path to it on the way
+		static uint32_t FindAndCompress(std::vector<uint32_t>& parents, uint32_t index) noexcept
+		{
+			while (parents[index] != index)
+				index = parents[index] = parents[parents[index]];
+			return index;
+		}
+
+		/// Joins the trees of `a` and `b`, keeping the lower root
+		static void Unite(std::vector<uint32_t>& parents, uint32_t a, uint32_t b) noexcept
+		{
+			a = FindAndCompress(parents, a);
+			b = FindAndCompress(parents, b);
+			if (a < b)
+				parents[b] = a;
+			else if (b < a)
+				parents[a] = b;
+		}
+
+		template <typename FUNC>
+		void ForEachNeighbor(glm::ivec2 pos, FUNC&& func) const
+		{
+			for (int dy = -1; dy <= 1; ++dy)
+				for (int dx = -1; dx <= 1; ++dx)
+				{
+					if ((dx == 0 && dy == 0) || (!m_options.diagonals && dx != 0 && dy != 0))
+						continue;
+					const glm::ivec2 neighbor{ pos.x + dx, pos.y + dy };
+					if (neighbor.x >= 0 && neighbor.y >= 0 && neighbor.x < m_size.x && neighbor.y < m_size.y)
+						func(neighbor);
+				}
+		}
+
+		uint32_t NewLabel()
+		{
+			++m_region_count;
+			if (!m_free_labels.empty())
+			{
+				const auto label = m_free_labels.back();
+				m_free_labels.pop_back();
+				return label;
+			}
+			m_region_sizes.push_back(0);
+			return uint32_t(m_region_sizes.size() - 1);
+		}
+
+		/// Removes a tile from the region `label`, freeing the label if it was the last one
+		void Leave(uint32_t label)
+		{
+			if (--m_region_sizes[label] != 0)
+				return;
+			m_free_labels.push_back(label);
+			--m_region_count;
+		}
+
+		void MoveTile(uint32_t index, uint32_t to_label)
+		{
+			const auto from_label = std::exchange(m_labels[index], to_label);
+			++m_region_sizes[to_label];
+			Leave(from_label);
+		}
+
+		/// Gives the passable tile at `pos` the label of the largest region next to it, and relabels the other regions next to it to match
+		void Join(glm::ivec2 pos)
+		{
+			auto target = no_region;
+			ForEachNeighbor(pos, [&](glm::ivec2 neighbor) {
+				const auto label = m_labels[Index(neighbor)];
+				if (label != no_region && (target == no_region || m_region_sizes[label] > m_region_sizes[target]))
+					target = label;
+			});
+			if (target == no_region)
+				target = NewLabel();
+
+			m_labels[Index(pos)] = target;
+			++m_region_sizes[target];
+
+			ForEachNeighbor(pos, [&](glm::ivec2 neighbor) {
+				const auto label = m_labels[Index(neighbor)];
+				if (label == no_region || label == target)
+					return;
+				m_queue.assign(1, Index(neighbor));
+				MoveTile(Index(neighbor), target);
+				for (size_t i = 0; i < m_queue.size(); ++i)
+				{
+					ForEachNeighbor(Position(m_queue[i]), [&](glm::ivec2 next) {
+						if (m_labels[Index(next)] != label)
+							return;
+						MoveTile(Index(next), target);
+						m_queue.push_back(Index(next));
+					});
+				}
+			});
+		}
+
+		/// Checks whether the tiles of region `label` at `seeds` are still connected, giving each part it was split into its own label.
+		///
+		/// Searches from all the seeds at once, one step of each search at a time, merging searches that meet. A search that runs out of
+		/// tiles has found a separate part, and the search stops when only one is left going, so it only visits the smaller parts in full;
+		/// the part being searched last keeps the old label.
+		void SplitIfDisconnected(uint32_t label, std::span<std::pair<uint32_t, uint32_t> const> seeds)
+		{
+			/// Seeds may have been removed themselves
+			const auto still_in_region = [&](auto const& seed) { return m_labels[seed.second] == label; };
+			const auto search_count = uint32_t(std::ranges::count_if(seeds, still_in_region));
+			if (search_count < 2)
+				return;
+
+			++m_region_sizes[label]; /// Keeps the label from being freed while its tiles are taken by the searches
+			m_searches.resize(std::max(m_searches.size(), size_t(search_count)));
+			uint32_t search_index = 0;
+			for (auto const& seed : seeds)
+			{
+				if (!still_in_region(seed))
+					continue;
+				auto& search = m_searches[search_index];
+				search.label = NewLabel();
+				search.merged_into = search_index;
+				search.done = false;
+				search.next = 0;
+				search.tiles.assign(1, seed.second);
+				MoveTile(seed.second, search.label);
+				if (m_search_of_label.size() <= search.label)
+					m_search_of_label.resize(search.label + 1, no_region);
+				m_search_of_label[search.label] = search_index++;
+			}
+
+			const auto find_search = [&](uint32_t search) {
+				while (m_searches[search].merged_into != search)
+					search = m_searches[search].merged_into;
+				return search;
+			};
+
+			for (auto running = search_count; running > 1; )
+			{
+				for (uint32_t i = 0; i < search_count && running > 1; ++i)
+				{
+					if (m_searches[i].merged_into != i || m_searches[i].done)
+						continue;
+					if (m_searches[i].next == m_searches[i].tiles.size())
+					{
+						m_searches[i].done = true;
+						--running;
+						continue;
+					}
+
+					const auto pos = Position(m_searches[i].tiles[m_searches[i].next++]);
+					ForEachNeighbor(pos, [&](glm::ivec2 neighbor) {
+						const auto neighbor_index = Index(neighbor);
+						const auto neighbor_label = m_labels[neighbor_index];
+						auto& search = m_searches[i];
+						if (neighbor_label == label)
+						{
+							MoveTile(neighbor_index, search.label);
+							search.tiles.push_back(neighbor_index);
+						}
+						else if (neighbor_label != no_region && neighbor_label < m_search_of_label.size() && m_search_of_label[neighbor_label] != no_region)
+						{
+							const auto other = find_search(m_search_of_label[neighbor_label]);
+							if (other == i)
+								return;
+							/// Searches only meet while both are running; the other one's visited tiles go before our unvisited ones
+							auto& other_search = m_searches[other];
+							other_search.merged_into = i;
+							search.tiles.insert(search.tiles.begin() + search.next, other_search.tiles.begin(), other_search.tiles.begin() + other_search.next);
+							search.next += other_search.next;
+							search.tiles.insert(search.tiles.end(), other_search.tiles.begin() + other_search.next, other_search.tiles.end());
+							other_search.tiles.clear();
+							--running;
+						}
+					});
+				}
+			}
+
+			/// Separate parts get the label of one of their searches; the part still being searched goes back to the old label
+			for (uint32_t i = 0; i < search_count; ++i)
+			{
+				auto& search = m_searches[i];
+				if (search.merged_into == i)
+				{
+					const auto part_label = search.done ? search.label : label;
+					for (const auto index : search.tiles)
+						if (m_labels[index] != part_label)
+							MoveTile(index, part_label);
+				}
+			}
+			/// The labels of the other searches have lost all their tiles, and have been freed
+			for (uint32_t i = 0; i < search_count; ++i)
+				m_search_of_label[m_searches[i].label] = no_region;
+			Leave(label);
+		}
+
+		grid_type const* m_grid;
+		PASSABLE_FUNC m_passable;
+		options m_options;
+		glm::ivec2 m_size{};
+		std::vector<uint32_t> m_labels;
+		std::vector<size_t> m_region_sizes;
+		size_t m_region_count = 0;
+
+		/// Bookkeeping for incremental updates
+		struct Search
+		{
+			uint32_t label;
+			uint32_t merged_into;
+			bool done;
+			size_t next;
+			std::vector<uint32_t> tiles;
+		};
+		std::vector<uint32_t> m_free_labels;
+		std::vector<std::pair<uint32_t, uint32_t>> m_split_seeds;
+		std::vector<Search> m_searches;
+		std::vector<uint32_t> m_search_of_label;
+		std::vector<uint32_t> m_queue;
+	};
+
+	template <typename TILE_DATA, bool RESIZABLE, typename LAYOUT, typename PASSABLE_FUNC>
+	region_map(grid<TILE_DATA, RESIZABLE, LAYOUT> const&, PASSABLE_FUNC) -> region_map<TILE_DATA, RESIZABLE, LAYOUT, PASSABLE_FUNC>;
+}
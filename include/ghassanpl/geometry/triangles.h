@@ -6,6 +6,7 @@
 
 #include "geometry_common.h"
 #include "./segment.h"
+#include "../ranges.h"
 
 namespace ghassanpl::geometry
 {
@@ -69,7 +70,7 @@ namespace ghassanpl::geometry
 		{
 			const auto A = std::sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
 			const auto B = std::sqrt((b.x - c.x) * (b.x - c.x) + (b.y - c.y) * (b.y - c.y));
-			const auto C = std::sqrt((b.x - c.x) * (a.x - c.x) + (a.y - c.y) * (a.y - c.y));
+			const auto C = std::sqrt((a.x - c.x) * (a.x - c.x) + (a.y - c.y) * (a.y - c.y));
 			const auto s = (A + B + C) * T(0.5);
 			return std::sqrt(s * (s - A) * (s - B) * (s - C));
 		}
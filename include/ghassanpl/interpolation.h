@@ -4,20 +4,421 @@
 
 #pragma once
 
+#include "simd.h"
 #include <glm/fwd.hpp>
 #include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <concepts>
+#include <numbers>
+#include <span>
+#include <stdexcept>
+#include <array>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/spline.hpp>
 #undef GLM_ENABLE_EXPERIMENTAL
 
 /// TODO: 
-///	- lerp, unlerp, etc
-///	- splines
-///	- easing functions 
 /// - approach
 
 namespace ghassanpl
 {
+	/// Robert Penner's easing curves; each maps [0, 1] to a curve that starts at 0 and ends at 1
+	enum class easing : uint8_t
+	{
+		linear,
+		in_quad, out_quad, in_out_quad,
+		in_cubic, out_cubic, in_out_cubic,
+		in_quart, out_quart, in_out_quart,
+		in_quint, out_quint, in_out_quint,
+		in_sine, out_sine, in_out_sine,
+		in_expo, out_expo, in_out_expo,
+		in_circ, out_circ, in_out_circ,
+		/// Overshoots: goes slightly below 0 (or above 1) before heading to the end
+		in_back, out_back, in_out_back,
+		in_elastic, out_elastic, in_out_elastic,
+		in_bounce, out_bounce, in_out_bounce,
+	};
+
+	constexpr inline size_t easing_count = size_t(easing::in_out_bounce) + 1;
+
+	/// The easing curves as functions
+	namespace easings
+	{
+		template <std::floating_point T> [[nodiscard]] constexpr T linear(T t) noexcept { return t; }
+
+		template <std::floating_point T> [[nodiscard]] constexpr T in_quad(T t) noexcept { return t * t; }
+		template <std::floating_point T> [[nodiscard]] constexpr T out_quad(T t) noexcept { const auto u = T(1) - t; return T(1) - u * u; }
+		template <std::floating_point T> [[nodiscard]] constexpr T in_out_quad(T t) noexcept { const auto u = T(2) - T(2) * t; return t < T(0.5) ? T(2) * t * t : T(1) - u * u * T(0.5); }
+
+		template <std::floating_point T> [[nodiscard]] constexpr T in_cubic(T t) noexcept { return t * t * t; }
+		template <std::floating_point T> [[nodiscard]] constexpr T out_cubic(T t) noexcept { const auto u = T(1) - t; return T(1) - u * u * u; }
+		template <std::floating_point T> [[nodiscard]] constexpr T in_out_cubic(T t) noexcept { const auto u = T(2) - T(2) * t; return t < T(0.5) ? T(4) * t * t * t : T(1) - u * u * u * T(0.5); }
+
+		template <std::floating_point T> [[nodiscard]] constexpr T in_quart(T t) noexcept { const auto t2 = t * t; return t2 * t2; }
+		template <std::floating_point T> [[nodiscard]] constexpr T out_quart(T t) noexcept { const auto u = T(1) - t, u2 = u * u; return T(1) - u2 * u2; }
+		template <std::floating_point T> [[nodiscard]] constexpr T in_out_quart(T t) noexcept { const auto u = T(2) - T(2) * t, u2 = u * u, t2 = t * t; return t < T(0.5) ? T(8) * t2 * t2 : T(1) - u2 * u2 * T(0.5); }
+
+		template <std::floating_point T> [[nodiscard]] constexpr T in_quint(T t) noexcept { const auto t2 = t * t; return t2 * t2 * t; }
+		template <std::floating_point T> [[nodiscard]] constexpr T out_quint(T t) noexcept { const auto u = T(1) - t, u2 = u * u; return T(1) - u2 * u2 * u; }
+		template <std::floating_point T> [[nodiscard]] constexpr T in_out_quint(T t) noexcept { const auto u = T(2) - T(2) * t, u2 = u * u, t2 = t * t; return t < T(0.5) ? T(16) * t2 * t2 * t : T(1) - u2 * u2 * u * T(0.5); }
+
+		template <std::floating_point T> [[nodiscard]] inline T in_sine(T t) noexcept { return T(1) - std::cos(t * std::numbers::pi_v<T> * T(0.5)); }
+		template <std::floating_point T> [[nodiscard]] inline T out_sine(T t) noexcept { return std::sin(t * std::numbers::pi_v<T> * T(0.5)); }
+		template <std::floating_point T> [[nodiscard]] inline T in_out_sine(T t) noexcept { return (T(1) - std::cos(t * std::numbers::pi_v<T>)) * T(0.5); }
+
+		template <std::floating_point T> [[nodiscard]] inline T in_expo(T t) noexcept { return t <= T(0) ? T(0) : std::exp2(T(10) * t - T(10)); }
+		template <std::floating_point T> [[nodiscard]] inline T out_expo(T t) noexcept { return t >= T(1) ? T(1) : T(1) - std::exp2(T(-10) * t); }
+		template <std::floating_point T> [[nodiscard]] inline T in_out_expo(T t) noexcept
+		{
+			if (t <= T(0)) return T(0);
+			if (t >= T(1)) return T(1);
+			return t < T(0.5) ? std::exp2(T(20) * t - T(10)) * T(0.5) : T(1) - std::exp2(T(10) - T(20) * t) * T(0.5);
+		}
+
+		template <std::floating_point T> [[nodiscard]] inline T in_circ(T t) noexcept { return T(1) - std::sqrt(std::max(T(0), T(1) - t * t)); }
+		template <std::floating_point T> [[nodiscard]] inline T out_circ(T t) noexcept { const auto u = t - T(1); return std::sqrt(std::max(T(0), T(1) - u * u)); }
+		template <std::floating_point T> [[nodiscard]] inline T in_out_circ(T t) noexcept
+		{
+			const auto u = T(2) * t, v = T(2) - u;
+			return t < T(0.5) ? (T(1) - std::sqrt(std::max(T(0), T(1) - u * u))) * T(0.5) : (std::sqrt(std::max(T(0), T(1) - v * v)) + T(1)) * T(0.5);
+		}
+
+		template <std::floating_point T> [[nodiscard]] constexpr T in_back(T t) noexcept
+		{
+			constexpr T c1 = T(1.70158), c3 = c1 + T(1);
+			return t * t * (c3 * t - c1);
+		}
+		template <std::floating_point T> [[nodiscard]] constexpr T out_back(T t) noexcept
+		{
+			constexpr T c1 = T(1.70158), c3 = c1 + T(1);
+			const auto u = t - T(1);
+			return T(1) + u * u * (c3 * u + c1);
+		}
+		template <std::floating_point T> [[nodiscard]] constexpr T in_out_back(T t) noexcept
+		{
+			constexpr T c2 = T(1.70158) * T(1.525);
+			const auto u = T(2) * t, v = u - T(2);
+			return t < T(0.5) ? u * u * ((c2 + T(1)) * u - c2) * T(0.5) : (v * v * ((c2 + T(1)) * v + c2) + T(2)) * T(0.5);
+		}
+
+		template <std::floating_point T> [[nodiscard]] inline T in_elastic(T t) noexcept
+		{
+			constexpr T c4 = T(2) * std::numbers::pi_v<T> / T(3);
+			if (t <= T(0)) return T(0);
+			if (t >= T(1)) return T(1);
+			return -std::exp2(T(10) * t - T(10)) * std::sin((T(10) * t - T(10.75)) * c4);
+		}
+		template <std::floating_point T> [[nodiscard]] inline T out_elastic(T t) noexcept
+		{
+			constexpr T c4 = T(2) * std::numbers::pi_v<T> / T(3);
+			if (t <= T(0)) return T(0);
+			if (t >= T(1)) return T(1);
+			return std::exp2(T(-10) * t) * std::sin((T(10) * t - T(0.75)) * c4) + T(1);
+		}
+		template <std::floating_point T> [[nodiscard]] inline T in_out_elastic(T t) noexcept
+		{
+			constexpr T c5 = T(2) * std::numbers::pi_v<T> / T(4.5);
+			if (t <= T(0)) return T(0);
+			if (t >= T(1)) return T(1);
+			const auto wave = std::sin((T(20) * t - T(11.125)) * c5);
+			return t < T(0.5) ? -std::exp2(T(20) * t - T(10)) * wave * T(0.5) : std::exp2(T(10) - T(20) * t) * wave * T(0.5) + T(1);
+		}
+
+		template <std::floating_point T> [[nodiscard]] constexpr T out_bounce(T t) noexcept
+		{
+			constexpr T n1 = T(7.5625), d1 = T(2.75);
+			if (t < T(1) / d1) return n1 * t * t;
+			if (t < T(2) / d1) { t -= T(1.5) / d1; return n1 * t * t + T(0.75); }
+			if (t < T(2.5) / d1) { t -= T(2.25) / d1; return n1 * t * t + T(0.9375); }
+			t -= T(2.625) / d1;
+			return n1 * t * t + T(0.984375);
+		}
+		template <std::floating_point T> [[nodiscard]] constexpr T in_bounce(T t) noexcept { return T(1) - out_bounce(T(1) - t); }
+		template <std::floating_point T> [[nodiscard]] constexpr T in_out_bounce(T t) noexcept
+		{
+			return t < T(0.5) ? (T(1) - out_bounce(T(1) - T(2) * t)) * T(0.5) : (T(1) + out_bounce(T(2) * t - T(1))) * T(0.5);
+		}
+	}
+
+	namespace detail
+	{
+		/// Calls `func` with a function object for the given easing curve, so that a loop inside `func` is compiled for that curve
+		template <std::floating_point T, typename FUNC>
+		decltype(auto) VisitEasing(easing curve, FUNC&& func)
+		{
+#define GHPL_EASING_CASE(name) case easing::name: return func([](T t) noexcept { return easings::name(t); });
+			switch (curve)
+			{
+			GHPL_EASING_CASE(in_quad) GHPL_EASING_CASE(out_quad) GHPL_EASING_CASE(in_out_quad)
+			GHPL_EASING_CASE(in_cubic) GHPL_EASING_CASE(out_cubic) GHPL_EASING_CASE(in_out_cubic)
+			GHPL_EASING_CASE(in_quart) GHPL_EASING_CASE(out_quart) GHPL_EASING_CASE(in_out_quart)
+			GHPL_EASING_CASE(in_quint) GHPL_EASING_CASE(out_quint) GHPL_EASING_CASE(in_out_quint)
+			GHPL_EASING_CASE(in_sine) GHPL_EASING_CASE(out_sine) GHPL_EASING_CASE(in_out_sine)
+			GHPL_EASING_CASE(in_expo) GHPL_EASING_CASE(out_expo) GHPL_EASING_CASE(in_out_expo)
+			GHPL_EASING_CASE(in_circ) GHPL_EASING_CASE(out_circ) GHPL_EASING_CASE(in_out_circ)
+			GHPL_EASING_CASE(in_back) GHPL_EASING_CASE(out_back) GHPL_EASING_CASE(in_out_back)
+			GHPL_EASING_CASE(in_elastic) GHPL_EASING_CASE(out_elastic) GHPL_EASING_CASE(in_out_elastic)
+			GHPL_EASING_CASE(in_bounce) GHPL_EASING_CASE(out_bounce) GHPL_EASING_CASE(in_out_bounce)
+			default: GHPL_EASING_CASE(linear)
+			}
+#undef GHPL_EASING_CASE
+		}
+
+		/// The easing curves written for the lane sets in \ref simd.h, with the same operations as the ones in \ref easings;
+		/// the in-out curves (and bounce) compute every piece and select between them
+		namespace easing_lanes
+		{
+			using simd::Exp2;
+
+			template <typename L> using lane = typename L::f;
+
+			template <typename L> lane<L> K(double value) noexcept { return L::broadcast(typename L::real(value)); }
+			template <typename L> lane<L> FirstHalf(lane<L> t, lane<L> first, lane<L> second) noexcept { return L::select(L::less(t, K<L>(0.5)), first, second); }
+			/// 0 where `t <= 0` and 1 where `t >= 1`, like the early returns of the expo and elastic curves
+			template <typename L> lane<L> Ends(lane<L> t, lane<L> value) noexcept { return L::select(L::greater(t, K<L>(0)), L::select(L::less(t, K<L>(1)), value, K<L>(1)), K<L>(0)); }
+			template <typename L> lane<L> SinTurns(lane<L> turns) noexcept { lane<L> sine, cosine; simd::SinCosTurns<L>(turns, sine, cosine); return sine; }
+			template <typename L> lane<L> CosTurns(lane<L> turns) noexcept { lane<L> sine, cosine; simd::SinCosTurns<L>(turns, sine, cosine); return cosine; }
+			template <typename L> lane<L> Sqrt0(lane<L> x) noexcept { return L::sqrt(L::max(x, K<L>(0))); }
+
+			template <typename L> lane<L> linear(lane<L> t) noexcept { return t; }
+
+			template <typename L> lane<L> in_quad(lane<L> t) noexcept { return t * t; }
+			template <typename L> lane<L> out_quad(lane<L> t) noexcept { const auto u = K<L>(1) - t; return K<L>(1) - u * u; }
+			template <typename L> lane<L> in_out_quad(lane<L> t) noexcept { const auto u = K<L>(2) - K<L>(2) * t; return FirstHalf<L>(t, K<L>(2) * t * t, K<L>(1) - u * u * K<L>(0.5)); }
+
+			template <typename L> lane<L> in_cubic(lane<L> t) noexcept { return t * t * t; }
+			template <typename L> lane<L> out_cubic(lane<L> t) noexcept { const auto u = K<L>(1) - t; return K<L>(1) - u * u * u; }
+			template <typename L> lane<L> in_out_cubic(lane<L> t) noexcept { const auto u = K<L>(2) - K<L>(2) * t; return FirstHalf<L>(t, K<L>(4) * t * t * t, K<L>(1) - u * u * u * K<L>(0.5)); }
+
+			template <typename L> lane<L> in_quart(lane<L> t) noexcept { const auto t2 = t * t; return t2 * t2; }
+			template <typename L> lane<L> out_quart(lane<L> t) noexcept { const auto u = K<L>(1) - t, u2 = u * u; return K<L>(1) - u2 * u2; }
+			template <typename L> lane<L> in_out_quart(lane<L> t) noexcept { const auto u = K<L>(2) - K<L>(2) * t, u2 = u * u, t2 = t * t; return FirstHalf<L>(t, K<L>(8) * t2 * t2, K<L>(1) - u2 * u2 * K<L>(0.5)); }
+
+			template <typename L> lane<L> in_quint(lane<L> t) noexcept { const auto t2 = t * t; return t2 * t2 * t; }
+			template <typename L> lane<L> out_quint(lane<L> t) noexcept { const auto u = K<L>(1) - t, u2 = u * u; return K<L>(1) - u2 * u2 * u; }
+			template <typename L> lane<L> in_out_quint(lane<L> t) noexcept { const auto u = K<L>(2) - K<L>(2) * t, u2 = u * u, t2 = t * t; return FirstHalf<L>(t, K<L>(16) * t2 * t2 * t, K<L>(1) - u2 * u2 * u * K<L>(0.5)); }
+
+			template <typename L> lane<L> in_sine(lane<L> t) noexcept { return K<L>(1) - CosTurns<L>(t * K<L>(0.25)); }
+			template <typename L> lane<L> out_sine(lane<L> t) noexcept { return SinTurns<L>(t * K<L>(0.25)); }
+			template <typename L> lane<L> in_out_sine(lane<L> t) noexcept { return (K<L>(1) - CosTurns<L>(t * K<L>(0.5))) * K<L>(0.5); }
+
+			template <typename L> lane<L> in_expo(lane<L> t) noexcept { return L::select(L::greater(t, K<L>(0)), Exp2<L>(K<L>(10) * t - K<L>(10)), K<L>(0)); }
+			template <typename L> lane<L> out_expo(lane<L> t) noexcept { return L::select(L::less(t, K<L>(1)), K<L>(1) - Exp2<L>(K<L>(-10) * t), K<L>(1)); }
+			template <typename L> lane<L> in_out_expo(lane<L> t) noexcept
+			{
+				return Ends<L>(t, FirstHalf<L>(t, Exp2<L>(K<L>(20) * t - K<L>(10)) * K<L>(0.5), K<L>(1) - Exp2<L>(K<L>(10) - K<L>(20) * t) * K<L>(0.5)));
+			}
+
+			template <typename L> lane<L> in_circ(lane<L> t) noexcept { return K<L>(1) - Sqrt0<L>(K<L>(1) - t * t); }
+			template <typename L> lane<L> out_circ(lane<L> t) noexcept { const auto u = t - K<L>(1); return Sqrt0<L>(K<L>(1) - u * u); }
+			template <typename L> lane<L> in_out_circ(lane<L> t) noexcept
+			{
+				const auto u = K<L>(2) * t, v = K<L>(2) - u;
+				return FirstHalf<L>(t, (K<L>(1) - Sqrt0<L>(K<L>(1) - u * u)) * K<L>(0.5), (Sqrt0<L>(K<L>(1) - v * v) + K<L>(1)) * K<L>(0.5));
+			}
+
+			template <typename L> lane<L> in_back(lane<L> t) noexcept
+			{
+				using R = typename L::real;
+				constexpr R c1 = R(1.70158), c3 = c1 + R(1);
+				return t * t * (L::broadcast(c3) * t - L::broadcast(c1));
+			}
+			template <typename L> lane<L> out_back(lane<L> t) noexcept
+			{
+				using R = typename L::real;
+				constexpr R c1 = R(1.70158), c3 = c1 + R(1);
+				const auto u = t - K<L>(1);
+				return K<L>(1) + u * u * (L::broadcast(c3) * u + L::broadcast(c1));
+			}
+			template <typename L> lane<L> in_out_back(lane<L> t) noexcept
+			{
+				using R = typename L::real;
+				constexpr R c2 = R(1.70158) * R(1.525);
+				const auto u = K<L>(2) * t, v = u - K<L>(2);
+				return FirstHalf<L>(t, u * u * (L::broadcast(c2 + R(1)) * u - L::broadcast(c2)) * K<L>(0.5), (v * v * (L::broadcast(c2 + R(1)) * v + L::broadcast(c2)) + K<L>(2)) * K<L>(0.5));
+			}
+
+			/// The sine arguments are in turns: multiplying by 2pi/3 (or 2pi/4.5) radians is dividing by 3 (or 4.5) turns
+			template <typename L> lane<L> in_elastic(lane<L> t) noexcept
+			{
+				return Ends<L>(t, K<L>(0) - Exp2<L>(K<L>(10) * t - K<L>(10)) * SinTurns<L>((K<L>(10) * t - K<L>(10.75)) * K<L>(1.0 / 3)));
+			}
+			template <typename L> lane<L> out_elastic(lane<L> t) noexcept
+			{
+				return Ends<L>(t, Exp2<L>(K<L>(-10) * t) * SinTurns<L>((K<L>(10) * t - K<L>(0.75)) * K<L>(1.0 / 3)) + K<L>(1));
+			}
+			template <typename L> lane<L> in_out_elastic(lane<L> t) noexcept
+			{
+				const auto wave = SinTurns<L>((K<L>(20) * t - K<L>(11.125)) * K<L>(1.0 / 4.5));
+				return Ends<L>(t, FirstHalf<L>(t, K<L>(0) - Exp2<L>(K<L>(20) * t - K<L>(10)) * wave * K<L>(0.5), Exp2<L>(K<L>(10) - K<L>(20) * t) * wave * K<L>(0.5) + K<L>(1)));
+			}
+
+			template <typename L> lane<L> out_bounce(lane<L> t) noexcept
+			{
+				using R = typename L::real;
+				constexpr R n1 = R(7.5625), d1 = R(2.75);
+				const auto piece = [&](R offset, R lift) { const auto u = t - L::broadcast(offset / d1); return L::broadcast(n1) * u * u + L::broadcast(lift); };
+				auto result = piece(R(2.625), R(0.984375));
+				result = L::select(L::less(t, L::broadcast(R(2.5) / d1)), piece(R(2.25), R(0.9375)), result);
+				result = L::select(L::less(t, L::broadcast(R(2) / d1)), piece(R(1.5), R(0.75)), result);
+				return L::select(L::less(t, L::broadcast(R(1) / d1)), L::broadcast(n1) * t * t, result);
+			}
+			template <typename L> lane<L> in_bounce(lane<L> t) noexcept { return K<L>(1) - out_bounce<L>(K<L>(1) - t); }
+			template <typename L> lane<L> in_out_bounce(lane<L> t) noexcept
+			{
+				return FirstHalf<L>(t, (K<L>(1) - out_bounce<L>(K<L>(1) - K<L>(2) * t)) * K<L>(0.5), (K<L>(1) + out_bounce<L>(K<L>(2) * t - K<L>(1))) * K<L>(0.5));
+			}
+		}
+
+		/// Like \ref VisitEasing, but the function object is the curve's lane kernel, called as `kernel(L{}, t)`
+		template <typename FUNC>
+		decltype(auto) VisitEasingLanes(easing curve, FUNC&& func)
+		{
+#define GHPL_EASING_CASE(name) case easing::name: return func([]<typename L>(L, typename L::f t) noexcept { return easing_lanes::name<L>(t); });
+			switch (curve)
+			{
+			GHPL_EASING_CASE(in_quad) GHPL_EASING_CASE(out_quad) GHPL_EASING_CASE(in_out_quad)
+			GHPL_EASING_CASE(in_cubic) GHPL_EASING_CASE(out_cubic) GHPL_EASING_CASE(in_out_cubic)
+			GHPL_EASING_CASE(in_quart) GHPL_EASING_CASE(out_quart) GHPL_EASING_CASE(in_out_quart)
+			GHPL_EASING_CASE(in_quint) GHPL_EASING_CASE(out_quint) GHPL_EASING_CASE(in_out_quint)
+			GHPL_EASING_CASE(in_sine) GHPL_EASING_CASE(out_sine) GHPL_EASING_CASE(in_out_sine)
+			GHPL_EASING_CASE(in_expo) GHPL_EASING_CASE(out_expo) GHPL_EASING_CASE(in_out_expo)
+			GHPL_EASING_CASE(in_circ) GHPL_EASING_CASE(out_circ) GHPL_EASING_CASE(in_out_circ)
+			GHPL_EASING_CASE(in_back) GHPL_EASING_CASE(out_back) GHPL_EASING_CASE(in_out_back)
+			GHPL_EASING_CASE(in_elastic) GHPL_EASING_CASE(out_elastic) GHPL_EASING_CASE(in_out_elastic)
+			GHPL_EASING_CASE(in_bounce) GHPL_EASING_CASE(out_bounce) GHPL_EASING_CASE(in_out_bounce)
+			default: GHPL_EASING_CASE(linear)
+			}
+#undef GHPL_EASING_CASE
+		}
+	}
+
+	/// Evaluates the easing curve at `t`
+	template <std::floating_point T>
+	[[nodiscard]] T ease(easing curve, T t) noexcept
+	{
+		return detail::VisitEasing<T>(curve, [t](auto func) { return func(t); });
+	}
+
+	/// Evaluates the easing curve at every element of `in`, vectorized across the elements; `out` may be the same memory as `in`.
+	/// The polynomial curves give the same results as \ref ease(easing, T); the sine, expo and elastic curves use polynomial
+	/// approximations of sin and exp2, and are within about 1e-6 of it.
+	template <std::floating_point T>
+	void ease(easing curve, std::span<T const> in, std::span<T> out)
+	{
+		if (out.size() < in.size())
+			throw std::invalid_argument("not enough space for the samples");
+		detail::VisitEasingLanes(curve, [&](auto kernel) {
+			simd::ForEachLaneGroup<T>(in.size(), [&]<typename L>(L, size_t i) {
+				L::store(kernel(L{}, L::load(in.data() + i)), out.data() + i);
+			});
+		});
+	}
+
+	/// Fills `out` with `a` at 0 and `b` at 1 for each of `t`, vectorized across the samples
+	template <std::floating_point T>
+	void lerp_samples(T a, T b, std::span<T const> t, std::span<T> out)
+	{
+		if (out.size() < t.size())
+			throw std::invalid_argument("not enough space for the samples");
+		simd::ForEachLaneGroup<T>(t.size(), [&]<typename L>(L, size_t i) {
+			const auto x = L::load(t.data() + i);
+			/// Written this way, the results are exactly `a` at 0 and exactly `b` at 1
+			L::store(L::broadcast(a) * (L::broadcast(T(1)) - x) + L::broadcast(b) * x, out.data() + i);
+		});
+	}
+
+	/// The inverse of \ref lerp_samples: fills `out` with where each of `values` lies between `a` (0) and `b` (1)
+	template <std::floating_point T>
+	void unlerp_samples(T a, T b, std::span<T const> values, std::span<T> out)
+	{
+		if (out.size() < values.size())
+			throw std::invalid_argument("not enough space for the samples");
+		simd::ForEachLaneGroup<T>(values.size(), [&]<typename L>(L, size_t i) {
+			L::store((L::load(values.data() + i) - L::broadcast(a)) / L::broadcast(b - a), out.data() + i);
+		});
+	}
+
+	/// Maps each of `values` from the range [`from_a`, `from_b`] to [`to_a`, `to_b`]
+	template <std::floating_point T>
+	void remap_samples(T from_a, T from_b, T to_a, T to_b, std::span<T const> values, std::span<T> out)
+	{
+		if (out.size() < values.size())
+			throw std::invalid_argument("not enough space for the samples");
+		simd::ForEachLaneGroup<T>(values.size(), [&]<typename L>(L, size_t i) {
+			const auto x = (L::load(values.data() + i) - L::broadcast(from_a)) / L::broadcast(from_b - from_a);
+			L::store(L::broadcast(to_a) * (L::broadcast(T(1)) - x) + L::broadcast(to_b) * x, out.data() + i);
+		});
+	}
+
+	namespace detail
+	{
+		/// Fills `out` with `sum(basis[d][k] * points[k] * t^(K-1-d))` for each of `t`: the curves' weights are polynomials in `t`, so the
+		/// points are folded into one coefficient per power of `t` (highest first) once per call, and each sample then takes K - 1
+		/// multiply-adds per component. The components of `out` are worked on as one flat array, so that the results are stored
+		/// contiguously: a group of samples covers LEN lane groups of components, and the samples are spread out over each of them so
+		/// that every one repeats once per component, to be multiplied by the matching components of the coefficients.
+		template <size_t K, glm::length_t LEN, typename T, glm::qualifier Q>
+		void EvaluateSplineBasis(std::array<std::array<T, K>, K> const& basis, std::array<glm::vec<LEN, T, Q>, K> const& points, std::span<T const> t, std::span<glm::vec<LEN, T, Q>> out)
+		{
+			static_assert(sizeof(glm::vec<LEN, T, Q>) == sizeof(T) * LEN, "the spline functions need tightly packed vectors");
+			if (out.size() < t.size())
+				throw std::invalid_argument("not enough space for the samples");
+
+			std::array<glm::vec<LEN, T, Q>, K> coefficients{};
+			for (size_t d = 0; d < K; ++d)
+				for (size_t k = 0; k < K; ++k)
+					coefficients[d] += basis[d][k] * points[k];
+
+			using L = simd::batch_lanes<T>;
+			constexpr size_t width = L::width;
+
+			/// Lane `l` of the `G`th lane group of components takes its sample from lane `(G * width + l) / LEN` of the group of samples,
+			/// and its component of the coefficients from component `(G * width + l) % LEN`
+			typename L::f coefficient_lanes[LEN][K];
+			for (size_t g = 0; g < LEN; ++g)
+			{
+				for (size_t d = 0; d < K; ++d)
+				{
+					T components[width];
+					for (size_t l = 0; l < width; ++l)
+						components[l] = coefficients[d][glm::length_t((g * width + l) % LEN)];
+					coefficient_lanes[g][d] = L::load(components);
+				}
+			}
+
+			const auto evaluate_group = [&]<size_t G, size_t... LANE>(std::integral_constant<size_t, G>, std::index_sequence<LANE...>, typename L::f samples, T* flat) {
+				const auto s = L::template permute<uint32_t((G * width + LANE) / LEN)...>(samples);
+				auto sum = coefficient_lanes[G][0];
+				for (size_t d = 1; d < K; ++d)
+					sum = L::mul_add(sum, s, coefficient_lanes[G][d]);
+				L::store(sum, flat + G * width);
+			};
+
+			T* flat_out = reinterpret_cast<T*>(out.data());
+			size_t i = 0;
+			for (; i + width <= t.size(); i += width)
+			{
+				const auto samples = L::load(t.data() + i);
+				[&]<size_t... G>(std::index_sequence<G...>) {
+					(evaluate_group(std::integral_constant<size_t, G>{}, std::make_index_sequence<width>{}, samples, flat_out + i * LEN), ...);
+				}(std::make_index_sequence<LEN>{});
+			}
+			for (; i < t.size(); ++i)
+			{
+				auto sum = coefficients[0];
+				for (size_t d = 1; d < K; ++d)
+					sum = sum * t[i] + coefficients[d];
+				out[i] = sum;
+			}
+		}
+	}
+
 	namespace splines
 	{
 		template <typename P, typename T>
@@ -29,5 +430,144 @@ namespace ghassanpl
 		using glm::catmullRom;
 		using glm::cubic;
 		using glm::hermite;
+
+		/// The span versions below evaluate the curve at each of `t` into `out`, vectorized across the samples, through the curves'
+		/// polynomial coefficients (instead of repeated mixing); they match the single-sample versions to within rounding.
+
+		/// Quadratic Bézier curve from `a` to `c`, pulled towards `b`
+		template <glm::length_t LEN, typename T, glm::qualifier Q>
+		void bezier(glm::vec<LEN, T, Q> const& a, glm::vec<LEN, T, Q> const& b, glm::vec<LEN, T, Q> const& c, std::span<std::type_identity_t<T> const> t, std::span<std::type_identity_t<glm::vec<LEN, T, Q>>> out)
+		{
+			static constexpr std::array<std::array<T, 3>, 3> basis{ {
+				{ 1, -2, 1 },
+				{ -2, 2, 0 },
+				{ 1, 0, 0 },
+			} };
+			detail::EvaluateSplineBasis(basis, std::array{ a, b, c }, t, out);
+		}
+
+		/// Cubic Bézier curve from `a` to `d`, with control points `b` and `c`
+		template <glm::length_t LEN, typename T, glm::qualifier Q>
+		void bezier(glm::vec<LEN, T, Q> const& a, glm::vec<LEN, T, Q> const& b, glm::vec<LEN, T, Q> const& c, glm::vec<LEN, T, Q> const& d, std::span<std::type_identity_t<T> const> t, std::span<std::type_identity_t<glm::vec<LEN, T, Q>>> out)
+		{
+			static constexpr std::array<std::array<T, 4>, 4> basis{ {
+				{ -1, 3, -3, 1 },
+				{ 3, -6, 3, 0 },
+				{ -3, 3, 0, 0 },
+				{ 1, 0, 0, 0 },
+			} };
+			detail::EvaluateSplineBasis(basis, std::array{ a, b, c, d }, t, out);
+		}
+
+		/// Catmull-Rom curve from `v2` to `v3`, with `v1` and `v4` as the neighbors, like `glm::catmullRom`
+		template <glm::length_t LEN, typename T, glm::qualifier Q>
+		void catmullRom(glm::vec<LEN, T, Q> const& v1, glm::vec<LEN, T, Q> const& v2, glm::vec<LEN, T, Q> const& v3, glm::vec<LEN, T, Q> const& v4, std::span<std::type_identity_t<T> const> t, std::span<std::type_identity_t<glm::vec<LEN, T, Q>>> out)
+		{
+			static constexpr std::array<std::array<T, 4>, 4> basis{ {
+				{ T(-0.5), T(1.5), T(-1.5), T(0.5) },
+				{ T(1), T(-2.5), T(2), T(-0.5) },
+				{ T(-0.5), T(0), T(0.5), T(0) },
+				{ T(0), T(1), T(0), T(0) },
+			} };
+			detail::EvaluateSplineBasis(basis, std::array{ v1, v2, v3, v4 }, t, out);
+		}
+
+		/// Hermite curve from `v1` to `v2`, with tangents `t1` and `t2`, like `glm::hermite`
+		template <glm::length_t LEN, typename T, glm::qualifier Q>
+		void hermite(glm::vec<LEN, T, Q> const& v1, glm::vec<LEN, T, Q> const& t1, glm::vec<LEN, T, Q> const& v2, glm::vec<LEN, T, Q> const& t2, std::span<std::type_identity_t<T> const> t, std::span<std::type_identity_t<glm::vec<LEN, T, Q>>> out)
+		{
+			static constexpr std::array<std::array<T, 4>, 4> basis{ {
+				{ 2, 1, -2, 1 },
+				{ -3, -2, 3, -1 },
+				{ 0, 1, 0, 0 },
+				{ 1, 0, 0, 0 },
+			} };
+			detail::EvaluateSplineBasis(basis, std::array{ v1, t1, v2, t2 }, t, out);
+		}
 	}
+
+	/// Lets a curve be followed at constant speed. Evenly spaced curve parameters do not give evenly spaced points (Bézier curves bunch up
+	/// near their control points), so the table measures the curve once, along `segments` chords, and stores the parameters at evenly
+	/// spaced distances along it; finding the parameter for a distance is then a lookup and a linear interpolation, instead of integrating
+	/// the curve's speed for every sample.
+	///
+	/// The table is as precise as the chords follow the curve: the parameters are exact at the ends of each chord, and a few hundred
+	/// segments are enough for smooth curves.
+	template <std::floating_point T = float>
+	class arc_length_table
+	{
+	public:
+
+		/// `curve(t)` must return a glm vector (of any length) for parameters `t` in [0, 1]
+		template <typename CURVE>
+		explicit arc_length_table(CURVE&& curve, size_t segments = 256)
+		{
+			if (segments < 1)
+				throw std::invalid_argument("an arc length table needs at least one segment");
+
+			std::vector<T> distances(segments + 1);
+			auto previous = curve(T(0));
+			for (size_t i = 1; i <= segments; ++i)
+			{
+				const auto point = curve(T(i) / T(segments));
+				distances[i] = distances[i - 1] + T(glm::distance(previous, point));
+				previous = point;
+			}
+			m_length = distances.back();
+
+			/// Inverting the distances: both go up, so one pass finds the chord every evenly spaced distance falls on
+			m_parameters.resize(segments + 1);
+			size_t chord = 0;
+			for (size_t i = 0; i <= segments; ++i)
+			{
+				const auto distance = m_length * T(i) / T(segments);
+				while (chord + 1 < segments && distances[chord + 1] < distance)
+					++chord;
+				const auto chord_length = distances[chord + 1] - distances[chord];
+				const auto fraction = chord_length > 0 ? std::clamp((distance - distances[chord]) / chord_length, T(0), T(1)) : T(0);
+				m_parameters[i] = (T(chord) + fraction) / T(segments);
+			}
+			m_scale = m_length > 0 ? T(segments) / m_length : T(0);
+		}
+
+		/// The length of the curve, as measured along the chords
+		[[nodiscard]] T length() const noexcept { return m_length; }
+
+		[[nodiscard]] std::span<T const> parameters() const noexcept { return m_parameters; }
+
+		/// The curve parameter at `distance` along the curve; distances outside [0, \ref length()] are clamped, and NaNs give 0, like in
+		/// \ref parameters_at
+		[[nodiscard]] T parameter_at(T distance) const noexcept
+		{
+			const auto last = T(m_parameters.size() - 1);
+			/// `std::max` returns its first argument when the comparison fails, so a NaN is replaced with 0 here, like the lanes do
+			const auto x = std::min(std::max(T(0), distance * m_scale), last);
+			const auto index = std::min(size_t(x), m_parameters.size() - 2);
+			const auto t = x - T(index);
+			return m_parameters[index] * (T(1) - t) + m_parameters[index + 1] * t;
+		}
+
+		/// Fills `out` with the curve parameters at `distances`, vectorized across the samples; then the curve functions in
+		/// \ref splines can evaluate the points
+		void parameters_at(std::span<T const> distances, std::span<T> out) const
+		{
+			if (out.size() < distances.size())
+				throw std::invalid_argument("not enough space for the samples");
+			simd::ForEachLaneGroup<T>(distances.size(), [&]<typename L>(L, size_t i) {
+				const auto x = L::min(L::max(L::load(distances.data() + i) * L::broadcast(m_scale), L::broadcast(T(0))), L::broadcast(T(m_parameters.size() - 1)));
+				const auto index = L::fastfloor(L::min(x, L::broadcast(T(m_parameters.size() - 2))));
+				const auto t = x - L::to_float(index);
+				const auto a = L::gather(m_parameters.data(), index);
+				const auto b = L::gather(m_parameters.data(), index + L::broadcast(int32_t(1)));
+				L::store(a * (L::broadcast(T(1)) - t) + b * t, out.data() + i);
+			});
+		}
+
+	private:
+
+		std::vector<T> m_parameters;
+		T m_length = 0;
+		/// Table entries per unit of distance
+		T m_scale = 0;
+	};
 }
@@ -0,0 +1,67 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+#include "json_helpers.h"
+#include "async_files.h"
+
+namespace ghassanpl::formats
+{
+	namespace detail
+	{
+		/// Loads all `paths` in one batch and parses each with `parse`; parse exceptions are rethrown after the whole batch is done,
+		/// so no reads are left in flight
+		template <typename PARSE_FUNC>
+		std::vector<expected<nlohmann::json, std::error_code>> load_and_parse_files(std::span<std::filesystem::path const> paths, PARSE_FUNC&& parse)
+		{
+			std::vector<expected<nlohmann::json, std::error_code>> result(paths.size());
+			std::exception_ptr parse_exception;
+			ghassanpl::load_files(paths, [&](size_t index, std::span<char const> contents, std::error_code error) {
+				if (error)
+					result[index] = unexpected(error);
+				else if (!parse_exception)
+				{
+					try { result[index] = parse(contents); }
+					catch (...) { parse_exception = std::current_exception(); }
+				}
+			});
+			if (parse_exception)
+				std::rethrow_exception(parse_exception);
+			return result;
+		}
+	}
+
+	namespace json
+	{
+		/// Loads many files at once (see \ref batch_file_loader)
+		/// \returns the parsed contents of (or the error that occured when loading) each file, in the same order as `paths`
+		inline std::vector<expected<nlohmann::json, std::error_code>> load_files(std::span<std::filesystem::path const> paths)
+		{
+			return detail::load_and_parse_files(paths, [](std::span<char const> contents) { return nlohmann::json::parse(contents.begin(), contents.end()); });
+		}
+	}
+
+	namespace ubjson
+	{
+		/// Loads many files at once (see \ref batch_file_loader)
+		/// \returns the parsed contents of (or the error that occured when loading) each file, in the same order as `paths`
+		inline std::vector<expected<nlohmann::json, std::error_code>> load_files(std::span<std::filesystem::path const> paths)
+		{
+			return detail::load_and_parse_files(paths, [](std::span<char const> contents) { return nlohmann::json::from_ubjson(contents.begin(), contents.end()); });
+		}
+	}
+
+	namespace cbor
+	{
+		/// Loads many files at once (see \ref batch_file_loader)
+		/// \returns the parsed contents of (or the error that occured when loading) each file, in the same order as `paths`
+		inline std::vector<expected<nlohmann::json, std::error_code>> load_files(std::span<std::filesystem::path const> paths)
+		{
+			return detail::load_and_parse_files(paths, [](std::span<char const> contents) {
+				const auto bytes = std::as_bytes(contents);
+				return nlohmann::json::from_cbor(reinterpret_cast<uint8_t const*>(bytes.data()), reinterpret_cast<uint8_t const*>(bytes.data() + bytes.size()));
+			});
+		}
+	}
+}
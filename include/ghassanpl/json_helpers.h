@@ -11,6 +11,8 @@
 #include "expected.h"
 #include "functional.h"
 
+#define GHPL_HAS_JSON_HELPERS
+
 namespace ghassanpl::formats
 {
 	
@@ -502,4 +504,8 @@ namespace ghassanpl::formats
 		/// @}
 	}
 	*/
-}
\ No newline at end of file
+}
+
+#ifdef GHPL_HAS_ASYNC_FILES
+#include "json_helpers+async_files.h"
+#endif
@@ -8,60 +8,13 @@
 #include <string>
 #include <system_error>
 #include <cstdint>
+#include <cstring>
+#include <array>
 #include "span.h"
+#include "enum_flags.h"
 #include <filesystem>
-
-/// TODO: https://www.remi-coulom.fr/joedb/checkpoints.html
-/*
-struct incremental_position_checkpoint
-{
-private:
-	mmap_sink& mapping;
-	struct checkpoint_struct
-	{
-		size_t position[4];
-	};
-	checkpoint_struct* mapped_checkpoint;
-	bool last_version_2 = false;
-public:
-	incremental_position_checkpoint(mmap_sink& in_file, size_at loc)
-		: mapping(in_file),
-		, mapped_checkpoint(mapping.data() + loc)
-	{
-		assert(mapping.size() <= loc + sizeof(checkpoint_struct));
-	}
-
-	void reset(size_t to_position = 0)
-	{
-		mapped_checkpoint = {0,0,0,0};
-		mapping.flush();
-		last_version_2 = false;
-	}
-	
-	void checkpoint(size_t position)
-	{
-		mapped_checkpoint.position[last_version_2 * 2] = position;
-		mapping.flush();
-		mapped_checkpoint.position[last_version_2 * 2 + 1] = position;
-		mapping.flush();
-		last_version_2 = !last_version_2;
-	}
-
-	size_t position() const
-	{
-		const auto copy = *mapped_checkpoint;
-		const auto healthy[2] = { copy.position[0] == copy.position[1], copy.position[2] == copy.position[3] };
-		if (healthy[0] && healthy[1])
-			return std::max(copy.position[0], copy.position[2]);
-		else if (healthy[0])
-			return position[0];
-		else if (healthy[1])
-			return position[2];
-		else
-			throw "no valid position";
-	}
-};
-*/
+#include <algorithm>
+#include <utility>
 
 namespace ghassanpl
 {
@@ -75,6 +28,23 @@ namespace ghassanpl
 
 	const inline file_handle_type invalid_handle = (file_handle_type)-1;
 
+	/// Hints about how a mapping will be accessed, that the OS can use to avoid stalling on page faults
+	/// \ingroup mmap
+	enum class mmap_hint
+	{
+		sequential, ///< The mapping will be read front-to-back, so the OS can read ahead aggressively (`MADV_SEQUENTIAL`; ignored on Windows)
+		random, ///< The mapping will be accessed randomly, so the OS should not read ahead (`MADV_RANDOM`; ignored on Windows)
+		will_need, ///< The mapping will be needed soon, so the OS should start reading it in the background (`MADV_WILLNEED`, `PrefetchVirtualMemory` on Windows)
+		huge_pages, ///< Back the mapping with transparent huge pages if possible, to reduce TLB misses (`MADV_HUGEPAGE`; ignored on Windows)
+		populate, ///< Pre-fault the entire mapping while mapping it, so that no later access stalls (`MAP_POPULATE`; same as `will_need` on Windows)
+	};
+	using mmap_hints = enum_flags<mmap_hint>;
+
+	/// Applies `hints` to an already-mapped memory range. The range is extended to page boundaries. `populate` is treated as `will_need`.
+	/// \note These are only hints, so most callers can safely ignore the `error`
+	/// \ingroup mmap
+	void advise_memory(void const* start, size_t length, mmap_hints hints, std::error_code& error) noexcept;
+
 
 	template <typename VALUE_TYPE>
 	//requires std::is_integral_v<VALUE_TYPE>
@@ -176,10 +146,30 @@ namespace ghassanpl
 			}
 		}
 
+		/// Applies `hints` to the range [`offset`, `offset + length`) of the mapping
+		/// \sa advise_memory
+		void advise(mmap_hints hints, size_type offset, size_type length, std::error_code& error) const noexcept
+		{
+			error.clear();
+			if (!data_ || offset > length_)
+			{
+				error = std::make_error_code(std::errc::invalid_argument);
+				return;
+			}
+			advise_memory(data_ + offset, std::min(length, length_ - offset), hints, error);
+		}
+
+		/// Applies `hints` to the entire mapping
+		/// \sa advise_memory
+		void advise(mmap_hints hints, std::error_code& error) const noexcept { advise(hints, 0, length_, error); }
+
 		void unmap() noexcept;
 
 	protected:
 
+		/// Unmaps the memory but keeps the file open
+		void unmap_view() noexcept;
+
 		struct mmap_context
 		{
 			VALUE_TYPE* data;
@@ -211,10 +201,10 @@ namespace ghassanpl
 		using typename basic_mmap_base<VALUE_TYPE>::pointer;
 
 		basic_mmap() noexcept = default;
-		basic_mmap(const std::filesystem::path& path, const size_type offset = 0, const size_t length = map_entire_file)
+		basic_mmap(const std::filesystem::path& path, const size_type offset = 0, const size_t length = map_entire_file, mmap_hints hints = {})
 		{
 			std::error_code error;
-			map(path, offset, length, error);
+			map(path, offset, length, hints, error);
 			if (error) { throw std::system_error{ error }; }
 		}
 		basic_mmap(const handle_type handle, const size_type offset = 0, const size_type length = map_entire_file)
@@ -251,6 +241,11 @@ namespace ghassanpl
 	protected:
 
 		void map(const std::filesystem::path& path, const size_type offset, const size_type length, std::error_code& error) noexcept
+		{
+			this->map(path, offset, length, {}, error);
+		}
+
+		void map(const std::filesystem::path& path, const size_type offset, const size_type length, mmap_hints hints, std::error_code& error) noexcept
 		{
 			error.clear();
 			if (path.empty())
@@ -288,7 +283,7 @@ namespace ghassanpl
 				return;
 			}
 
-			const auto ctx = static_cast<CRTP*>(this)->memory_map(handle, offset, length == map_entire_file ? (file_size - offset) : length, error);
+			const auto ctx = static_cast<CRTP*>(this)->memory_map(handle, offset, length == map_entire_file ? (file_size - offset) : length, hints, error);
 			if (!error)
 			{
 				// We must unmap the previous mapping that may have existed prior to this call.
@@ -303,6 +298,13 @@ namespace ghassanpl
 				this->length_ = ctx.length;
 				this->mapped_length_ = ctx.mapped_length;
 				this->file_mapping_handle_ = ctx.file_mapping_handle;
+
+				/// Hints are only advisory, so we don't fail the mapping if they cannot be applied
+				if (const auto advice = hints - mmap_hint::populate; !advice.empty())
+				{
+					std::error_code advice_error;
+					advise_memory(this->data_, this->length_, advice, advice_error);
+				}
 			}
 		}
 
@@ -326,14 +328,18 @@ namespace ghassanpl
 
 		template <typename VALUE_TYPE_>
 		friend mmap_source<VALUE_TYPE_> make_mmap_source(const std::filesystem::path& path, typename mmap_source<VALUE_TYPE_>::size_type offset, typename mmap_source<VALUE_TYPE_>::size_type length, std::error_code& error) noexcept;
+		template <typename VALUE_TYPE_>
+		friend mmap_source<VALUE_TYPE_> make_mmap_source(const std::filesystem::path& path, mmap_hints hints, std::error_code& error) noexcept;
 
 	protected:
 
 		friend struct basic_mmap<mmap_source<VALUE_TYPE>, VALUE_TYPE>;
+		template <typename VALUE_TYPE_>
+		friend struct mmap_window_source;
 
 		static file_handle_type open_file(const std::filesystem::path& path, std::error_code& error) noexcept;
 
-		static mmap_context memory_map(const file_handle_type file_handle, const int64_t offset, const int64_t length, std::error_code& error) noexcept;
+		static mmap_context memory_map(const file_handle_type file_handle, const int64_t offset, const int64_t length, mmap_hints hints, std::error_code& error) noexcept;
 
 		void conditional_sync() {}
 	};
@@ -356,6 +362,11 @@ namespace ghassanpl
 		using typename basic_mmap<mmap_sink<VALUE_TYPE>, VALUE_TYPE>::iterator;
 		using typename basic_mmap<mmap_sink<VALUE_TYPE>, VALUE_TYPE>::reverse_iterator;
 
+		template <typename VALUE_TYPE_>
+		friend mmap_sink<VALUE_TYPE_> make_mmap_sink(const std::filesystem::path& path, typename mmap_sink<VALUE_TYPE_>::size_type offset, typename mmap_sink<VALUE_TYPE_>::size_type length, std::error_code& error) noexcept;
+		template <typename VALUE_TYPE_>
+		friend mmap_sink<VALUE_TYPE_> make_mmap_sink(const std::filesystem::path& path, mmap_hints hints, std::error_code& error) noexcept;
+
 		using basic_mmap<mmap_sink<VALUE_TYPE>, VALUE_TYPE>::operator[];
 		[[nodiscard]] reference operator[](const size_type i) const noexcept { return this->data_[i]; }
 
@@ -376,7 +387,10 @@ namespace ghassanpl
 		using basic_mmap<mmap_sink<VALUE_TYPE>, VALUE_TYPE>::rend;
 		[[nodiscard]] reverse_iterator rend() noexcept { return reverse_iterator(this->begin()); }
 
+		/// Flushes the whole mapping to disk
 		void sync(std::error_code& error) noexcept;
+		/// Flushes only the range [`offset`, `offset + length`) of the mapping to disk
+		void sync(size_type offset, size_type length, std::error_code& error) noexcept;
 
 	protected:
 
@@ -384,7 +398,7 @@ namespace ghassanpl
 
 		static file_handle_type open_file(const std::filesystem::path& path, std::error_code& error) noexcept;
 
-		static mmap_context memory_map(const file_handle_type file_handle, const int64_t offset, const int64_t length, std::error_code& error) noexcept;
+		static mmap_context memory_map(const file_handle_type file_handle, const int64_t offset, const int64_t length, mmap_hints hints, std::error_code& error) noexcept;
 
 		pointer get_mapping_start() noexcept
 		{
@@ -424,6 +438,20 @@ namespace ghassanpl
 		return make_mmap_source<VALUE_TYPE>(path, 0, map_entire_file);
 	}
 
+	template <typename VALUE_TYPE = char>
+	[[nodiscard]] mmap_source<VALUE_TYPE> make_mmap_source(const std::filesystem::path& path, mmap_hints hints, std::error_code& error) noexcept
+	{
+		mmap_source<VALUE_TYPE> mmap;
+		mmap.map(path, 0, map_entire_file, hints, error);
+		return mmap;
+	}
+
+	template <typename VALUE_TYPE = char>
+	[[nodiscard]] mmap_source<VALUE_TYPE> make_mmap_source(const std::filesystem::path& path, mmap_hints hints)
+	{
+		return mmap_source<VALUE_TYPE>{ path, 0, map_entire_file, hints };
+	}
+
 	template <typename VALUE_TYPE>
 	[[nodiscard]] mmap_sink<VALUE_TYPE> make_mmap_sink(const std::filesystem::path& path, typename mmap_sink<VALUE_TYPE>::size_type offset, typename mmap_sink<VALUE_TYPE>::size_type length, std::error_code& error) noexcept
 	{
@@ -450,6 +478,337 @@ namespace ghassanpl
 		return make_mmap_sink<VALUE_TYPE>(path, 0, map_entire_file);
 	}
 
+	template <typename VALUE_TYPE>
+	[[nodiscard]] mmap_sink<VALUE_TYPE> make_mmap_sink(const std::filesystem::path& path, mmap_hints hints, std::error_code& error) noexcept
+	{
+		mmap_sink<VALUE_TYPE> mmap;
+		mmap.map(path, 0, map_entire_file, hints, error);
+		return mmap;
+	}
+
+	template <typename VALUE_TYPE>
+	[[nodiscard]] mmap_sink<VALUE_TYPE> make_mmap_sink(const std::filesystem::path& path, mmap_hints hints)
+	{
+		return mmap_sink<VALUE_TYPE>{ path, 0, map_entire_file, hints };
+	}
+
+	/// A read-only view of a fixed-size window into a file, that can be slid across the file.
+	/// Useful for files that are bigger than the address space you want to spend on them.
+	/// \note `data()`, `size()`, iterators, etc. refer to the current window only; use \ref window_offset to find where it starts in the file.
+	template <typename VALUE_TYPE = std::byte>
+	struct mmap_window_source : public basic_mmap_base<VALUE_TYPE>
+	{
+		using typename basic_mmap_base<VALUE_TYPE>::size_type;
+		using typename basic_mmap_base<VALUE_TYPE>::pointer;
+
+		mmap_window_source() noexcept = default;
+
+		/// Opens the file at `path` and maps the first window; an empty file opens with an empty window
+		/// \param window_size the maximum size of the window, in bytes
+		/// \param hints applied to every window as it is mapped
+		mmap_window_source(const std::filesystem::path& path, size_type window_size, mmap_hints hints = {})
+		{
+			std::error_code error;
+			open(path, window_size, hints, error);
+			if (error) { throw std::system_error{ error }; }
+		}
+
+		mmap_window_source(mmap_window_source const&) = delete;
+		mmap_window_source(mmap_window_source&& other) noexcept
+			: basic_mmap_base<VALUE_TYPE>(std::move(other))
+			, m_file_size(std::exchange(other.m_file_size, 0))
+			, m_window_size(std::exchange(other.m_window_size, 0))
+			, m_window_offset(std::exchange(other.m_window_offset, 0))
+			, m_hints(other.m_hints)
+		{
+		}
+		mmap_window_source& operator=(mmap_window_source const&) = delete;
+		mmap_window_source& operator=(mmap_window_source&& other) noexcept
+		{
+			if (this != &other)
+			{
+				this->unmap();
+				this->swap(other);
+				std::swap(m_file_size, other.m_file_size);
+				std::swap(m_window_size, other.m_window_size);
+				std::swap(m_window_offset, other.m_window_offset);
+				std::swap(m_hints, other.m_hints);
+			}
+			return *this;
+		}
+
+		~mmap_window_source() noexcept { this->unmap(); }
+
+		void open(const std::filesystem::path& path, size_type window_size, mmap_hints hints, std::error_code& error) noexcept
+		{
+			error.clear();
+			if (window_size == 0)
+			{
+				error = std::make_error_code(std::errc::invalid_argument);
+				return;
+			}
+
+			const auto file_size = std::filesystem::file_size(path, error);
+			if (error)
+				return;
+
+			const auto handle = mmap_source<VALUE_TYPE>::open_file(path, error);
+			if (error)
+				return;
+
+			this->unmap();
+			this->file_handle_ = handle;
+			m_file_size = file_size;
+			m_window_size = window_size;
+			m_hints = hints;
+			m_window_offset = 0;
+			/// An empty file has nothing to map, so it is left with an empty window
+			if (file_size != 0)
+				slide_to(0, error);
+		}
+
+		/// The size of the whole file, in bytes
+		[[nodiscard]] size_type file_size() const noexcept { return m_file_size; }
+		/// The maximum size of the window, in bytes
+		[[nodiscard]] size_type window_size() const noexcept { return m_window_size; }
+		/// The offset, in bytes, of the start of the current window in the file
+		[[nodiscard]] size_type window_offset() const noexcept { return m_window_offset; }
+
+		/// Remaps the window so that it starts at `file_offset` (and extends at most \ref window_size bytes, or to the end of the file)
+		/// If that fails, the current window is left as it was
+		void slide_to(size_type file_offset, std::error_code& error) noexcept
+		{
+			error.clear();
+			if (!this->is_open() || file_offset >= m_file_size)
+			{
+				error = std::make_error_code(std::errc::invalid_argument);
+				return;
+			}
+
+			const auto ctx = mmap_source<VALUE_TYPE>::memory_map(this->file_handle_, file_offset, std::min(m_window_size, m_file_size - file_offset), m_hints, error);
+			if (error)
+				return;
+
+			/// The old window is only unmapped once the new one is mapped, so that a failure leaves it in place
+			this->unmap_view();
+			this->data_ = reinterpret_cast<pointer>(ctx.data);
+			this->length_ = ctx.length;
+			this->mapped_length_ = ctx.mapped_length;
+			this->file_mapping_handle_ = ctx.file_mapping_handle;
+			m_window_offset = file_offset;
+
+			if (const auto advice = m_hints - mmap_hint::populate; !advice.empty())
+			{
+				std::error_code advice_error;
+				advise_memory(this->data_, this->length_, advice, advice_error);
+			}
+		}
+
+		void slide_to(size_type file_offset)
+		{
+			std::error_code error;
+			slide_to(file_offset, error);
+			if (error) { throw std::system_error{ error }; }
+		}
+
+		/// Returns a view of the `count` bytes starting at `file_offset` in the file, sliding the window if they are not all inside it.
+		/// \pre `count` must not be greater than \ref window_size
+		[[nodiscard]] std::span<VALUE_TYPE const> view(size_type file_offset, size_type count, std::error_code& error) noexcept
+		{
+			error.clear();
+			if (count > m_window_size || file_offset + count > m_file_size)
+			{
+				error = std::make_error_code(std::errc::invalid_argument);
+				return {};
+			}
+			if (count == 0)
+				return {};
+			if (!this->data() || file_offset < m_window_offset || file_offset + count > m_window_offset + this->length())
+			{
+				slide_to(file_offset, error);
+				if (error)
+					return {};
+			}
+			return { this->data() + (file_offset - m_window_offset), count };
+		}
+
+	private:
+
+		size_type m_file_size = 0;
+		size_type m_window_size = 0;
+		size_type m_window_offset = 0;
+		mmap_hints m_hints{};
+	};
+
+	/// Durable commit points for data appended to a file mapped with \ref mmap_sink, without syncing the whole file on every append.
+	/// 
+	/// The last committed position is stored twice, in two pairs of slots (so 4 x 64-bit values) at `checkpoint_offset` in the mapping.
+	/// To commit, the dirty data range is synced, then the position is written and synced to both slots of the older pair, one after another.
+	/// A crash can therefore only ever tear one pair, and the other pair still contains the previous healthy position.
+	/// 
+	/// Appends can be committed in groups: \ref advance records a new end-of-data position, and only commits after `group_size` advances,
+	/// trading durability of the most recent appends for throughput.
+	/// 
+	/// \see https://www.remi-coulom.fr/joedb/checkpoints.html
+	template <typename VALUE_TYPE = std::byte>
+	struct incremental_position_checkpoint
+	{
+		/// Positions and offsets are in bytes, while the mapping indexes `VALUE_TYPE`s; \ref basic_mmap_base already requires them to be
+		/// the same, but the arithmetic below is done on bytes either way
+		static_assert(sizeof(VALUE_TYPE) == sizeof(std::byte), "incremental_position_checkpoint positions are byte offsets");
+
+		/// The size, in bytes, of the checkpoint data stored in the mapping
+		static constexpr size_t checkpoint_size = sizeof(uint64_t) * 4;
+
+		/// Recovers the last healthy position stored at `checkpoint_offset`; a zero-filled checkpoint is a valid checkpoint at position 0
+		/// \param group_size how many calls to \ref advance are grouped into a single commit
+		/// \throws std::system_error if the checkpoint does not fit in the mapping, or if no healthy position could be recovered
+		incremental_position_checkpoint(mmap_sink<VALUE_TYPE>& mapping, size_t checkpoint_offset, size_t group_size = 1)
+			: m_mapping(mapping)
+			, m_checkpoint_offset(checkpoint_offset)
+			, m_group_size(std::max<size_t>(group_size, 1))
+		{
+			std::error_code error;
+			recover(error);
+			if (error) { throw std::system_error{ error }; }
+		}
+
+		/// Re-reads the checkpoint from the mapping, discarding any uncommitted advances
+		void recover(std::error_code& error) noexcept
+		{
+			error.clear();
+			if (!m_mapping.data() || m_checkpoint_offset + checkpoint_size > byte_size())
+			{
+				error = std::make_error_code(std::errc::invalid_argument);
+				return;
+			}
+
+			const auto slots = read_slots();
+			const bool healthy[2] = { slots[0] == slots[1], slots[2] == slots[3] };
+			if (healthy[0] && healthy[1])
+			{
+				m_last_pair = slots[2] > slots[0];
+				m_position = std::max(slots[0], slots[2]);
+			}
+			else if (healthy[0] || healthy[1])
+			{
+				m_last_pair = healthy[1];
+				m_position = slots[m_last_pair * 2];
+			}
+			else
+			{
+				error = std::make_error_code(std::errc::io_error);
+				return;
+			}
+
+			if (m_position > byte_size())
+			{
+				error = std::make_error_code(std::errc::io_error);
+				return;
+			}
+
+			m_pending_position = m_position;
+			m_pending_count = 0;
+		}
+
+		/// The last position that was durably committed
+		[[nodiscard]] size_t position() const noexcept { return m_position; }
+		/// The last position passed to \ref advance, which might not be committed yet
+		[[nodiscard]] size_t pending_position() const noexcept { return m_pending_position; }
+		[[nodiscard]] size_t group_size() const noexcept { return m_group_size; }
+
+		/// Records that the data up to `new_position` has been written, committing it if `group_size` advances have accumulated since the last commit
+		void advance(size_t new_position, std::error_code& error) noexcept
+		{
+			error.clear();
+			m_pending_position = new_position;
+			if (++m_pending_count >= m_group_size)
+				checkpoint(new_position, error);
+		}
+
+		/// Commits the last position passed to \ref advance, if it is not committed yet
+		void flush(std::error_code& error) noexcept
+		{
+			error.clear();
+			if (m_pending_position != m_position)
+				checkpoint(m_pending_position, error);
+		}
+
+		/// Durably commits `new_position`, syncing only the data written since the last commit and the checkpoint itself
+		void checkpoint(size_t new_position, std::error_code& error) noexcept
+		{
+			error.clear();
+			if (new_position > byte_size())
+			{
+				error = std::make_error_code(std::errc::invalid_argument);
+				return;
+			}
+
+			/// Data has to be on disk before a checkpoint that references it
+			if (new_position > m_position)
+			{
+				m_mapping.sync(m_position, new_position - m_position, error);
+				if (error) return;
+			}
+
+			const size_t pair = !m_last_pair;
+			write_slot(pair * 2, new_position);
+			sync_checkpoint(error);
+			if (error) return;
+			write_slot(pair * 2 + 1, new_position);
+			sync_checkpoint(error);
+			if (error) return;
+
+			m_last_pair = pair;
+			m_position = new_position;
+			m_pending_position = new_position;
+			m_pending_count = 0;
+		}
+
+		/// Resets the checkpoint to `to_position`, overwriting both pairs
+		void reset(size_t to_position, std::error_code& error) noexcept
+		{
+			error.clear();
+			for (size_t i = 0; i < 4; ++i)
+				write_slot(i, to_position);
+			sync_checkpoint(error);
+			if (error) return;
+			m_last_pair = 0;
+			m_position = m_pending_position = to_position;
+			m_pending_count = 0;
+		}
+
+	private:
+
+		[[nodiscard]] size_t byte_size() const noexcept { return m_mapping.size() * sizeof(VALUE_TYPE); }
+		[[nodiscard]] std::byte* checkpoint_bytes() const noexcept { return reinterpret_cast<std::byte*>(m_mapping.data()) + m_checkpoint_offset; }
+
+		std::array<uint64_t, 4> read_slots() const noexcept
+		{
+			std::array<uint64_t, 4> result{};
+			std::memcpy(result.data(), checkpoint_bytes(), checkpoint_size);
+			return result;
+		}
+
+		void write_slot(size_t index, uint64_t value) noexcept
+		{
+			std::memcpy(checkpoint_bytes() + index * sizeof(uint64_t), &value, sizeof(value));
+		}
+
+		void sync_checkpoint(std::error_code& error) noexcept
+		{
+			m_mapping.sync(m_checkpoint_offset, checkpoint_size, error);
+		}
+
+		mmap_sink<VALUE_TYPE>& m_mapping;
+		size_t m_checkpoint_offset = 0;
+		size_t m_group_size = 1;
+		size_t m_position = 0;
+		size_t m_pending_position = 0;
+		size_t m_pending_count = 0;
+		size_t m_last_pair = 0;
+	};
+
 	/// @}
 }
 
@@ -6,6 +6,14 @@
 
 #include "mmap.h"
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
 namespace ghassanpl
 {
 #if defined(_WIN32) && !defined(_WINDOWS_) && !defined(WINAPI)
@@ -42,6 +50,13 @@ namespace ghassanpl
 	extern "C" __declspec(dllimport) void __stdcall GetSystemInfo(SYSTEM_INFO * lpSystemInfo);
 	extern "C" __declspec(dllimport) void* __stdcall CreateFileMappingW(void* hFile, void* lpFileMappingAttributes, unsigned long flProtect, unsigned long dwMaximumSizeHigh, unsigned long dwMaximumSizeLow, const wchar_t* lpName);
 	extern "C" __declspec(dllimport) void* __stdcall MapViewOfFile(void* hFileMappingObject, unsigned long dwDesiredAccess, unsigned long dwFileOffsetHigh, unsigned long dwFileOffsetLow, size_t dwNumberOfBytesToMap);
+
+	extern "C" struct WIN32_MEMORY_RANGE_ENTRY {
+		void* VirtualAddress;
+		size_t NumberOfBytes;
+	};
+	extern "C" __declspec(dllimport) void* __stdcall GetCurrentProcess();
+	extern "C" __declspec(dllimport) int __stdcall PrefetchVirtualMemory(void* hProcess, size_t NumberOfEntries, WIN32_MEMORY_RANGE_ENTRY* VirtualAddresses, unsigned long Flags);
 #endif
 
 	namespace
@@ -90,6 +105,39 @@ namespace ghassanpl
 		}
 	}
 
+	inline void advise_memory(void const* start, size_t length, mmap_hints hints, std::error_code& error) noexcept
+	{
+		error.clear();
+		if (!start || length == 0 || hints.empty())
+			return;
+
+		/// Both madvise and PrefetchVirtualMemory want page-aligned ranges
+		const auto address = reinterpret_cast<uintptr_t>(start);
+		const auto aligned_address = address & ~uintptr_t(page_size() - 1);
+		const auto aligned_start = reinterpret_cast<void*>(aligned_address);
+		const auto aligned_length = length + (address - aligned_address);
+
+#ifdef _WIN32
+		if (hints.contains_any_of(mmap_hint::will_need, mmap_hint::populate))
+		{
+			WIN32_MEMORY_RANGE_ENTRY range{ aligned_start, aligned_length };
+			if (PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0) == 0)
+				error = last_error();
+		}
+#else // POSIX
+		const auto apply = [&](int advice) {
+			if (::madvise(aligned_start, aligned_length, advice) != 0 && !error)
+				error = last_error();
+		};
+		if (hints.is_set(mmap_hint::sequential)) apply(MADV_SEQUENTIAL);
+		if (hints.is_set(mmap_hint::random)) apply(MADV_RANDOM);
+		if (hints.contains_any_of(mmap_hint::will_need, mmap_hint::populate)) apply(MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+		if (hints.is_set(mmap_hint::huge_pages)) apply(MADV_HUGEPAGE);
+#endif
+#endif
+	}
+
 	template <typename VALUE_TYPE>
 	void mmap_sink<VALUE_TYPE>::sync(std::error_code& error) noexcept
 	{
@@ -105,7 +153,7 @@ namespace ghassanpl
 #ifdef _WIN32
 			if (FlushViewOfFile(get_mapping_start(), this->mapped_length_) == 0 || FlushFileBuffers(this->file_handle_) == 0)
 #else // POSIX
-			if (::msync(get_mapping_start(), mapped_length_, MS_SYNC) != 0)
+			if (::msync(get_mapping_start(), this->mapped_length_, MS_SYNC) != 0)
 #endif
 			{
 				error = last_error();
@@ -121,6 +169,32 @@ namespace ghassanpl
 #endif
 	}
 
+	template <typename VALUE_TYPE>
+	void mmap_sink<VALUE_TYPE>::sync(size_type offset, size_type length, std::error_code& error) noexcept
+	{
+		error.clear();
+		if (!this->is_open() || !this->data() || offset > this->length_)
+		{
+			error = std::make_error_code(std::errc::invalid_argument);
+			return;
+		}
+		length = std::min(length, this->length_ - offset);
+		if (length == 0)
+			return;
+
+		/// The start of the synced range must be page-aligned
+		const auto start = reinterpret_cast<uintptr_t>(this->data_ + offset);
+		const auto aligned_start = start & ~uintptr_t(page_size() - 1);
+		const auto aligned_length = length + (start - aligned_start);
+
+#ifdef _WIN32
+		if (FlushViewOfFile(reinterpret_cast<void const*>(aligned_start), aligned_length) == 0 || FlushFileBuffers(this->file_handle_) == 0)
+#else // POSIX
+		if (::msync(reinterpret_cast<void*>(aligned_start), aligned_length, MS_SYNC) != 0)
+#endif
+			error = last_error();
+	}
+
 	template <typename VALUE_TYPE>
 	file_handle_type mmap_sink<VALUE_TYPE>::open_file(const std::filesystem::path& path, std::error_code& error) noexcept
 	{
@@ -133,7 +207,7 @@ namespace ghassanpl
 #ifdef _WIN32
 		const auto handle = CreateFileW(path.c_str(), (0x80000000L) | (0x40000000L), 0x00000001 | 0x00000002, 0, 3, 0x00000080, 0);
 #else // POSIX
-		const auto handle = ::open(c_str(path), O_RDWR);
+		const auto handle = ::open(path.c_str(), O_RDWR);
 #endif
 		if (handle == invalid_handle)
 			error = last_error();
@@ -142,7 +216,7 @@ namespace ghassanpl
 	}
 
 	template <typename VALUE_TYPE>
-	typename mmap_sink<VALUE_TYPE>::mmap_context mmap_sink<VALUE_TYPE>::memory_map(const file_handle_type file_handle, const int64_t offset, const int64_t length, std::error_code& error) noexcept
+	typename mmap_sink<VALUE_TYPE>::mmap_context mmap_sink<VALUE_TYPE>::memory_map(const file_handle_type file_handle, const int64_t offset, const int64_t length, mmap_hints hints, std::error_code& error) noexcept
 	{
 		const int64_t aligned_offset = make_offset_page_aligned(offset);
 		const int64_t length_to_map = offset - aligned_offset + length;
@@ -162,7 +236,13 @@ namespace ghassanpl
 			return {};
 		}
 #else // POSIX
-		VALUE_TYPE* mapping_start = static_cast<VALUE_TYPE*>(::mmap(0, length_to_map, PROT_WRITE, MAP_SHARED, file_handle, aligned_offset));
+		int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+		if (hints.is_set(mmap_hint::populate))
+			flags |= MAP_POPULATE;
+#endif
+		VALUE_TYPE* mapping_start = static_cast<VALUE_TYPE*>(::mmap(0, length_to_map, PROT_READ | PROT_WRITE, flags, file_handle, aligned_offset));
+		const auto file_mapping_handle = invalid_handle;
 		if (mapping_start == MAP_FAILED)
 		{
 			error = last_error();
@@ -170,6 +250,14 @@ namespace ghassanpl
 		}
 #endif
 
+#ifdef _WIN32
+		if (hints.is_set(mmap_hint::populate))
+		{
+			WIN32_MEMORY_RANGE_ENTRY range{ mapping_start, size_t(length_to_map) };
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+#endif
+
 		mmap_context ctx{};
 		ctx.data = mapping_start + offset - aligned_offset;
 		ctx.length = length;
@@ -179,9 +267,8 @@ namespace ghassanpl
 	}
 
 	template <typename VALUE_TYPE>
-	void basic_mmap_base<VALUE_TYPE>::unmap() noexcept
+	void basic_mmap_base<VALUE_TYPE>::unmap_view() noexcept
 	{
-		if (!this->is_open()) { return; }
 		// TODO do we care about errors here?
 #ifdef _WIN32
 		if (this->is_mapped())
@@ -193,17 +280,25 @@ namespace ghassanpl
 		if (data_) { ::munmap(const_cast<pointer>(get_mapping_start()), mapped_length_); }
 #endif
 
+		this->data_ = nullptr;
+		this->length_ = this->mapped_length_ = 0;
+		this->file_mapping_handle_ = invalid_handle;
+	}
+
+	template <typename VALUE_TYPE>
+	void basic_mmap_base<VALUE_TYPE>::unmap() noexcept
+	{
+		if (!this->is_open()) { return; }
+
+		this->unmap_view();
+
 #ifdef _WIN32
 		CloseHandle(this->file_handle_);
 #else // POSIX
 		::close(file_handle_);
 #endif
 
-		// Reset fields to their default values.
-		this->data_ = nullptr;
-		this->length_ = this->mapped_length_ = 0;
 		this->file_handle_ = invalid_handle;
-		this->file_mapping_handle_ = invalid_handle;
 	}
 
 	template <typename VALUE_TYPE>
@@ -218,7 +313,7 @@ namespace ghassanpl
 #ifdef _WIN32
 		const auto handle = CreateFileW(path.c_str(), (0x80000000L), 0x00000001 | 0x00000002, 0, 3, 0x00000080, 0);
 #else // POSIX
-		const auto handle = ::open(c_str(path), O_RDONLY);
+		const auto handle = ::open(path.c_str(), O_RDONLY);
 #endif
 		if (handle == invalid_handle)
 		{
@@ -228,7 +323,7 @@ namespace ghassanpl
 	}
 
 	template <typename VALUE_TYPE>
-	typename mmap_source<VALUE_TYPE>::mmap_context mmap_source<VALUE_TYPE>::memory_map(const file_handle_type file_handle, const int64_t offset, const int64_t length, std::error_code& error) noexcept
+	typename mmap_source<VALUE_TYPE>::mmap_context mmap_source<VALUE_TYPE>::memory_map(const file_handle_type file_handle, const int64_t offset, const int64_t length, mmap_hints hints, std::error_code& error) noexcept
 	{
 		const int64_t aligned_offset = make_offset_page_aligned(offset);
 		const int64_t length_to_map = offset - aligned_offset + length;
@@ -249,7 +344,13 @@ namespace ghassanpl
 			return {};
 		}
 #else // POSIX
-		auto mapping_start = static_cast<VALUE_TYPE*>(::mmap(0, length_to_map, PROT_READ, MAP_SHARED, file_handle, aligned_offset));
+		int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+		if (hints.is_set(mmap_hint::populate))
+			flags |= MAP_POPULATE;
+#endif
+		auto mapping_start = static_cast<VALUE_TYPE*>(::mmap(0, length_to_map, PROT_READ, flags, file_handle, aligned_offset));
+		const auto file_mapping_handle = invalid_handle;
 		if (mapping_start == MAP_FAILED)
 		{
 			error = last_error();
@@ -257,6 +358,14 @@ namespace ghassanpl
 		}
 #endif
 
+#ifdef _WIN32
+		if (hints.is_set(mmap_hint::populate))
+		{
+			WIN32_MEMORY_RANGE_ENTRY range{ mapping_start, size_t(length_to_map) };
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+#endif
+
 		mmap_context ctx{};
 		ctx.data = mapping_start + offset - aligned_offset;
 		ctx.length = length;
@@ -0,0 +1,111 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "mmap.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace ghassanpl
+{
+	/// Faults in the pages of a memory range (usually a mapping) on a background thread, staying `read_ahead` bytes ahead of a consumer's cursor.
+	/// \ingroup mmap
+	/// 
+	/// \par Example
+	/// \code{.cpp}
+	/// auto source = make_mmap_source<char>("assets.pak", mmap_hints{ mmap_hint::sequential });
+	/// mmap_prefetcher prefetcher{ source.data(), source.size(), 64 * 1024 * 1024 };
+	/// for (size_t i = 0; i < source.size(); i += chunk_size)
+	/// {
+	///   prefetcher.advance(i);
+	///   process(source.data() + i, chunk_size);
+	/// }
+	/// \endcode
+	struct mmap_prefetcher
+	{
+		/// \param read_ahead how many bytes after the cursor to keep faulted-in
+		/// \param step the granularity, in bytes, with which the prefetcher reads ahead
+		mmap_prefetcher(void const* start, size_t length, size_t read_ahead, size_t step = 1024 * 1024)
+			: m_start(static_cast<std::byte const*>(start))
+			, m_length(length)
+			, m_read_ahead(read_ahead)
+			, m_step(std::max<size_t>(step, 4096))
+			, m_thread([this](std::stop_token stop) { run(stop); })
+		{
+		}
+
+		mmap_prefetcher(mmap_prefetcher const&) = delete;
+		mmap_prefetcher& operator=(mmap_prefetcher const&) = delete;
+
+		~mmap_prefetcher()
+		{
+			m_thread.request_stop();
+			m_wakeup.notify_all();
+		}
+
+		/// Tells the prefetcher that the consumer is now at `cursor` bytes from the start of the range
+		void advance(size_t cursor) noexcept
+		{
+			{
+				std::unique_lock lock{ m_mutex };
+				if (cursor <= m_cursor)
+					return;
+				m_cursor = cursor;
+			}
+			m_wakeup.notify_one();
+		}
+
+		/// \returns how many bytes from the start of the range have been prefetched so far
+		[[nodiscard]] size_t prefetched() const noexcept { return m_prefetched.load(std::memory_order_relaxed); }
+
+	private:
+
+		void run(std::stop_token stop)
+		{
+			while (!stop.stop_requested())
+			{
+				size_t target = 0;
+				{
+					std::unique_lock lock{ m_mutex };
+					m_wakeup.wait(lock, stop, [&] { return std::min(m_cursor + m_read_ahead, m_length) > m_prefetched.load(std::memory_order_relaxed); });
+					if (stop.stop_requested())
+						return;
+					target = std::min(m_cursor + m_read_ahead, m_length);
+				}
+
+				for (auto done = m_prefetched.load(std::memory_order_relaxed); done < target && !stop.stop_requested(); )
+				{
+					const auto chunk = std::min(m_step, target - done);
+					std::error_code error;
+					advise_memory(m_start + done, chunk, mmap_hint::will_need, error);
+
+					/// `MADV_WILLNEED` is asynchronous and only a hint, so we actually touch each page to make sure it is resident
+					const auto pages = static_cast<std::byte const volatile*>(m_start + done);
+					for (size_t i = 0; i < chunk; i += 4096)
+						[[maybe_unused]] const std::byte touched = pages[i];
+
+					done += chunk;
+					m_prefetched.store(done, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		std::byte const* const m_start;
+		size_t const m_length;
+		size_t const m_read_ahead;
+		size_t const m_step;
+
+		std::mutex m_mutex;
+		std::condition_variable_any m_wakeup;
+		size_t m_cursor = 0;
+		std::atomic<size_t> m_prefetched = 0;
+
+		std::jthread m_thread; /// must be last, so that it starts after everything else is initialized
+	};
+}
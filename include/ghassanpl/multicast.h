@@ -9,6 +9,20 @@
 #include <optional>
 #include <utility>
 #include <map>
+#include <vector>
+#include <memory>
+
+/// \ref ghassanpl::fast_multicast_function needs C++20 (concepts, ranges and `std::atomic<std::shared_ptr>`)
+#if defined(__cpp_concepts) && defined(__cpp_lib_ranges) && defined(__cpp_lib_atomic_shared_ptr)
+#define GHPL_HAS_FAST_MULTICAST_FUNCTION 1
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <mutex>
+#else
+#define GHPL_HAS_FAST_MULTICAST_FUNCTION 0
+#endif
 
 // Shamelessly stolen from https://github.com/klmr/multifunction
 namespace ghassanpl
@@ -129,4 +143,281 @@ namespace ghassanpl
 		std::map<handle, std::function<R(ARGS...)>> m_listeners;
 		size_t m_last_id = {};
 	};
+
+#if GHPL_HAS_FAST_MULTICAST_FUNCTION
+	namespace detail
+	{
+		/// A copyable type-erased invocable with inline storage for up to `INLINE_SIZE` bytes; bigger (or throwing-move) invocables are heap-allocated
+		template <typename SIGNATURE, size_t INLINE_SIZE>
+		class inplace_listener;
+
+		template <typename R, typename... ARGS, size_t INLINE_SIZE>
+		class inplace_listener<R(ARGS...), INLINE_SIZE>
+		{
+		public:
+
+			template <typename F>
+			static constexpr bool stored_inline = sizeof(F) <= INLINE_SIZE && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+
+			template <typename F>
+			requires (!std::same_as<std::remove_cvref_t<F>, inplace_listener> && std::is_invocable_r_v<R, std::decay_t<F>&, ARGS...>)
+			explicit inplace_listener(F&& func)
+			{
+				using func_type = std::decay_t<F>;
+				if constexpr (stored_inline<func_type>)
+				{
+					std::construct_at(reinterpret_cast<func_type*>(m_storage), std::forward<F>(func));
+					m_invoke = [](void* storage, ARGS... args) -> R { return std::invoke(*reinterpret_cast<func_type*>(storage), std::forward<ARGS>(args)...); };
+					m_manage = [](operation op, void* dest, void* src) {
+						switch (op)
+						{
+						case operation::copy: std::construct_at(reinterpret_cast<func_type*>(dest), *reinterpret_cast<func_type const*>(src)); break;
+						case operation::move: std::construct_at(reinterpret_cast<func_type*>(dest), std::move(*reinterpret_cast<func_type*>(src))); break;
+						case operation::destroy: std::destroy_at(reinterpret_cast<func_type*>(src)); break;
+						}
+					};
+				}
+				else
+				{
+					*reinterpret_cast<func_type**>(m_storage) = new func_type(std::forward<F>(func));
+					m_invoke = [](void* storage, ARGS... args) -> R { return std::invoke(**reinterpret_cast<func_type**>(storage), std::forward<ARGS>(args)...); };
+					m_manage = [](operation op, void* dest, void* src) {
+						switch (op)
+						{
+						case operation::copy: *reinterpret_cast<func_type**>(dest) = new func_type(**reinterpret_cast<func_type* const*>(src)); break;
+						case operation::move: *reinterpret_cast<func_type**>(dest) = std::exchange(*reinterpret_cast<func_type**>(src), nullptr); break;
+						case operation::destroy: delete *reinterpret_cast<func_type**>(src); break;
+						}
+					};
+				}
+			}
+
+			inplace_listener(inplace_listener const& other)
+				: m_invoke(other.m_invoke), m_manage(other.m_manage)
+			{
+				m_manage(operation::copy, m_storage, const_cast<std::byte*>(other.m_storage));
+			}
+
+			/// Inline invocables are nothrow-move-constructible, and heap ones just hand over their pointer, so this never throws
+			inplace_listener(inplace_listener&& other) noexcept
+				: m_invoke(other.m_invoke), m_manage(other.m_manage)
+			{
+				m_manage(operation::move, m_storage, other.m_storage);
+			}
+
+			/// Copies `other` before destroying the current invocable, so if the copy throws, this listener is left unchanged
+			inplace_listener& operator=(inplace_listener const& other)
+			{
+				if (this != &other)
+					*this = inplace_listener{ other };
+				return *this;
+			}
+
+			inplace_listener& operator=(inplace_listener&& other) noexcept
+			{
+				if (this != &other)
+				{
+					m_manage(operation::destroy, nullptr, m_storage);
+					m_invoke = other.m_invoke;
+					m_manage = other.m_manage;
+					m_manage(operation::move, m_storage, other.m_storage);
+				}
+				return *this;
+			}
+
+			~inplace_listener() { m_manage(operation::destroy, nullptr, m_storage); }
+
+			template <typename... CALL_ARGS>
+			R operator()(CALL_ARGS&&... args) const
+			{
+				return m_invoke(const_cast<std::byte*>(m_storage), std::forward<CALL_ARGS>(args)...);
+			}
+
+		private:
+
+			enum class operation { copy, move, destroy };
+
+			R(*m_invoke)(void*, ARGS...) = nullptr;
+			void(*m_manage)(operation op, void* dest, void* src) = nullptr;
+			alignas(std::max_align_t) std::byte m_storage[std::max(INLINE_SIZE, sizeof(void*))];
+		};
+
+		/// Passes `arg` to a listener parameter of type `PARAM`: forwarded for reference parameters (so that `T&&` parameters get rvalues),
+		/// and as an lvalue for by-value ones, so that each listener copies it instead of moving from it
+		template <typename PARAM, typename ARG>
+		constexpr decltype(auto) ForwardToListener(std::remove_reference_t<ARG>& arg) noexcept
+		{
+			if constexpr (std::is_reference_v<PARAM>)
+				return std::forward<ARG>(arg);
+			else
+				return (arg);
+		}
+	}
+
+	template <typename SIGNATURE, size_t INLINE_SIZE = 32>
+	class fast_multicast_function;
+
+	/// Like \ref mutlticast_function but optimized for very frequent invocation:
+	/// - listeners are stored contiguously, and invocables up to `INLINE_SIZE` bytes are stored inline (without an allocation)
+	/// - listeners can be added and removed at any time, from any thread, including from inside a listener being called;
+	///   this is done by replacing an immutable (copy-on-write) snapshot of the listener list, so invocation does not wait for writers
+	///   or copy the list: it only loads the current snapshot. Note that `std::atomic<std::shared_ptr>` is not lock-free in the common
+	///   standard libraries, so that load may briefly take an internal lock.
+	/// - \ref reduce and \ref for_each_result let you consume return values without allocating a `std::vector`
+	/// 
+	/// An invocation always calls the listeners that were added at the moment it started. Arguments for by-value parameters are passed to
+	/// every listener as lvalues, so no listener can move from an argument that the following ones will see; arguments for reference
+	/// parameters are forwarded, so that listeners like `void(std::string&&)` work.
+	/// \note Adding and removing listeners is O(n) and allocates, so this is a good fit for lists that are invoked much more often than modified.
+	/// \note Invocables must be copy-constructible (just like with `std::function`).
+	/// \ingroup Functional
+	template <typename R, typename... ARGS, size_t INLINE_SIZE>
+	class fast_multicast_function<R(ARGS...), INLINE_SIZE> : public multicast_function_traits<R, ARGS...>
+	{
+		using listener_type = detail::inplace_listener<R(ARGS...), INLINE_SIZE>;
+
+	public:
+
+		enum class handle : size_t {};
+
+		fast_multicast_function() noexcept = default;
+		fast_multicast_function(fast_multicast_function const& other)
+		{
+			std::unique_lock lock{ other.m_write_mutex };
+			m_listeners.store(other.snapshot());
+			m_last_id = other.m_last_id;
+		}
+		fast_multicast_function& operator =(fast_multicast_function const& other)
+		{
+			if (this != &other)
+			{
+				std::scoped_lock lock{ m_write_mutex, other.m_write_mutex };
+				m_listeners.store(other.snapshot());
+				m_last_id = other.m_last_id;
+			}
+			return *this;
+		}
+
+		/// Adds a new invocable to the list
+		/// \returns A handle that can be used to remove the added invocable
+		template <typename F>
+		handle operator+=(F&& listener) { return add(std::forward<F>(listener)); }
+
+		/// Adds a new invocable to the list
+		/// \returns A handle that can be used to remove the added invocable
+		template <typename F>
+		handle add(F&& listener)
+		{
+			listener_type new_listener{ std::forward<F>(listener) };
+			std::unique_lock lock{ m_write_mutex };
+			const auto new_id = handle{ m_last_id++ };
+			const auto old_listeners = m_listeners.load(std::memory_order_relaxed);
+			auto new_listeners = std::make_shared<entry_list>();
+			new_listeners->reserve((old_listeners ? old_listeners->size() : 0) + 1);
+			if (old_listeners)
+				new_listeners->insert(new_listeners->end(), old_listeners->begin(), old_listeners->end());
+			new_listeners->push_back(entry{ new_id, std::move(new_listener) });
+			m_listeners.store(std::move(new_listeners), std::memory_order_release);
+			return new_id;
+		}
+
+		/// Removes the invocable associated with `handle`
+		void operator-=(handle handle) { remove(handle); }
+
+		/// Removes the invocable associated with `handle`
+		void remove(handle handle)
+		{
+			std::unique_lock lock{ m_write_mutex };
+			const auto old_listeners = m_listeners.load(std::memory_order_relaxed);
+			if (!old_listeners)
+				return;
+
+			/// Handles are always increasing, so the entries are sorted by them
+			const auto it = std::ranges::lower_bound(*old_listeners, handle, {}, &entry::id);
+			if (it == old_listeners->end() || it->id != handle)
+				return;
+
+			auto new_listeners = std::make_shared<entry_list>();
+			new_listeners->reserve(old_listeners->size() - 1);
+			new_listeners->insert(new_listeners->end(), old_listeners->begin(), it);
+			new_listeners->insert(new_listeners->end(), std::next(it), old_listeners->end());
+			m_listeners.store(std::move(new_listeners), std::memory_order_release);
+		}
+
+		/// Removes all the invocables from this objects
+		void clear()
+		{
+			std::unique_lock lock{ m_write_mutex };
+			m_listeners.store(nullptr);
+		}
+
+		/// Calls all the invocables added to this object
+		///
+		/// \returns If the return value is void, returns void, otherwise returns a vector of all the return values of the added invocables
+		/// \sa reduce and for_each_result for versions that do not allocate
+		template <typename... CALL_ARGS>
+		auto operator()(CALL_ARGS&&... args) const
+		{
+			const auto listeners = snapshot();
+			if constexpr (std::is_void_v<R>)
+			{
+				if (listeners)
+					for (auto& listener : *listeners)
+						listener.function(detail::ForwardToListener<ARGS, CALL_ARGS>(args)...);
+			}
+			else
+			{
+				std::vector<R> ret;
+				if (listeners)
+				{
+					ret.reserve(listeners->size());
+					for (auto& listener : *listeners)
+						ret.push_back(listener.function(detail::ForwardToListener<ARGS, CALL_ARGS>(args)...));
+				}
+				return ret;
+			}
+		}
+
+		/// Calls all the invocables added to this object, and calls `result_func` with each of their return values, in order
+		template <typename FUNC, typename... CALL_ARGS>
+		requires (!std::is_void_v<R>)
+		void for_each_result(FUNC&& result_func, CALL_ARGS&&... args) const
+		{
+			if (const auto listeners = snapshot())
+				for (auto& listener : *listeners)
+					result_func(listener.function(detail::ForwardToListener<ARGS, CALL_ARGS>(args)...));
+		}
+
+		/// Calls all the invocables added to this object, and folds their return values using `op`, starting with `init`
+		/// \returns `op(...op(op(init, result0), result1)..., resultN)`
+		template <typename T, typename OP, typename... CALL_ARGS>
+		requires (!std::is_void_v<R>) && std::is_invocable_r_v<T, OP&, T, R>
+		[[nodiscard]] T reduce(T init, OP&& op, CALL_ARGS&&... args) const
+		{
+			if (const auto listeners = snapshot())
+				for (auto& listener : *listeners)
+					init = op(std::move(init), listener.function(detail::ForwardToListener<ARGS, CALL_ARGS>(args)...));
+			return init;
+		}
+
+		[[nodiscard]] size_t size() const { const auto listeners = snapshot(); return listeners ? listeners->size() : 0; }
+		[[nodiscard]] bool empty() const { return size() == 0; }
+
+	private:
+
+		struct entry
+		{
+			handle id;
+			listener_type function;
+		};
+
+		using entry_list = std::vector<entry>;
+
+		std::shared_ptr<entry_list const> snapshot() const { return m_listeners.load(std::memory_order_acquire); }
+
+		std::atomic<std::shared_ptr<entry_list const>> m_listeners;
+		size_t m_last_id = {};
+		mutable std::mutex m_write_mutex;
+	};
+#endif
 }
\ No newline at end of file
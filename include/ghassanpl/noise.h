@@ -6,6 +6,7 @@
 
 #include "min-cpp-version/cpp17.h"
 #include <cstdint>
+#include <type_traits>
 
 /// Shamelessly stolen from https://github.com/SRombauts/SimplexNoise/
 
@@ -107,8 +108,8 @@ namespace ghassanpl::noise
 		const F s = (x + y) * F2;
 		const F xs = x + s;
 		const F ys = y + s;
-		const int32_t i = fastfloor(xs);
-		const int32_t j = fastfloor(ys);
+		const int32_t i = detail::fastfloor(xs);
+		const int32_t j = detail::fastfloor(ys);
 
 		const F t = static_cast<F>(i + j) * G2;
 		const F X0 = i - t;
@@ -132,16 +133,16 @@ namespace ghassanpl::noise
 		const F x2 = x0 - F(1.0) + F(2.0) * G2;
 		const F y2 = y0 - F(1.0) + F(2.0) * G2;
 
-		const int gi0 = hash(i + hash(j));
-		const int gi1 = hash(i + i1 + hash(j + j1));
-		const int gi2 = hash(i + 1 + hash(j + 1));
+		const int gi0 = detail::hash(i + detail::hash(j));
+		const int gi1 = detail::hash(i + i1 + detail::hash(j + j1));
+		const int gi2 = detail::hash(i + 1 + detail::hash(j + 1));
 
 		F n0;
 		if (F t0 = F(0.5) - x0 * x0 - y0 * y0; t0 < F(0.0))
 			n0 = F(0.0);
 		else {
 			t0 *= t0;
-			n0 = t0 * t0 * grad(gi0, x0, y0);
+			n0 = t0 * t0 * detail::grad(gi0, x0, y0);
 		}
 
 		F n1;
@@ -149,7 +150,7 @@ namespace ghassanpl::noise
 			n1 = F(0.0);
 		else {
 			t1 *= t1;
-			n1 = t1 * t1 * grad(gi1, x1, y1);
+			n1 = t1 * t1 * detail::grad(gi1, x1, y1);
 		}
 
 		F n2;
@@ -157,7 +158,7 @@ namespace ghassanpl::noise
 			n2 = F(0.0);
 		else {
 			t2 *= t2;
-			n2 = t2 * t2 * grad(gi2, x2, y2);
+			n2 = t2 * t2 * detail::grad(gi2, x2, y2);
 		}
 
 		return F(45.23065) * (n0 + n1 + n2);
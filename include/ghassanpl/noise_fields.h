@@ -0,0 +1,260 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "noise.h"
+#include "parallel.h"
+#include "simd.h"
+#include <span>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <concepts>
+#include <stdexcept>
+#include <cmath>
+#include <bit>
+
+/// Functions that fill whole arrays with noise. For `float`s, samples are evaluated 8 (with AVX2) or 4 (with SSE2) at a time, with branchless
+/// gradients and the per-octave constants calculated once; rows are spread over threads.
+///
+/// Every sample is bit-identical to what the corresponding scalar function in noise.h returns for the same coordinates, regardless of
+/// the instruction set or thread count, as long as the compiler does not contract the scalar code's multiplies and adds into fused
+/// multiply-adds (e.g. GCC and Clang with `-ffp-contract=fast` on FMA-capable targets).
+
+namespace ghassanpl::noise
+{
+	/// Parameters of fractal noise, as taken by \ref fractal_simplex_noise and \ref fractal_simplex_noise_2d
+	template <std::floating_point F>
+	struct fractal_parameters
+	{
+		size_t octaves = 1;
+		F frequency = F(1.0);
+		F amplitude = F(1.0);
+		F lacunarity = F(2.0);
+		F persistence = F(0.5);
+	};
+
+	namespace detail
+	{
+		/// The frequencies and amplitudes of each octave, and the sum of the amplitudes, accumulated exactly like the scalar functions do
+		template <typename F>
+		struct octave_constants
+		{
+			std::vector<F> frequencies;
+			std::vector<F> amplitudes;
+			F denominator{};
+
+			explicit octave_constants(fractal_parameters<F> const& fractal)
+			{
+				auto frequency = fractal.frequency;
+				auto amplitude = fractal.amplitude;
+				for (size_t i = 0; i < fractal.octaves; i++)
+				{
+					frequencies.push_back(frequency);
+					amplitudes.push_back(amplitude);
+					denominator += amplitude;
+					frequency *= fractal.lacunarity;
+					amplitude *= fractal.persistence;
+				}
+			}
+		};
+
+		inline constexpr auto perm32 = [] {
+			std::array<int32_t, 256> result{};
+			for (size_t i = 0; i < 256; ++i)
+				result[i] = perm[i];
+			return result;
+		}();
+
+		/// The lattice hash of \ref noise::detail::hash, on every lane
+		template <typename L>
+		typename L::i Hash(typename L::i value) noexcept { return L::gather(perm32.data(), value & L::broadcast(int32_t(0xFF))); }
+
+#if GHPL_HAS_AVX2 || GHPL_HAS_SSE2
+		/// The same operations as \ref noise::simplex_noise(F), in the same order
+		template <typename L>
+		typename L::f SimplexNoise(typename L::f x) noexcept
+		{
+			using f = typename L::f;
+			using i = typename L::i;
+
+			const f one = L::broadcast(1.0f);
+			const i i0 = L::fastfloor(x);
+			const i i1 = i0 + L::broadcast(int32_t(1));
+
+			const f x0 = x - L::to_float(i0);
+			const f x1 = x0 - one;
+
+			/// grad(hash, x): (1 + (hash & 7)) * x, negated if (hash & 8)
+			const auto grad = [&](i hash, f dx) {
+				const f magnitude = one + L::to_float(hash & L::broadcast(int32_t(7)));
+				return L::template flip_sign_if_bit<3>(hash & L::broadcast(int32_t(8)), magnitude) * dx;
+			};
+
+			f t0 = one - x0 * x0;
+			t0 = t0 * t0;
+			const f n0 = t0 * t0 * grad(Hash<L>(i0), x0);
+
+			f t1 = one - x1 * x1;
+			t1 = t1 * t1;
+			const f n1 = t1 * t1 * grad(Hash<L>(i1), x1);
+
+			return L::broadcast(0.395f) * (n0 + n1);
+		}
+
+		/// The same operations as \ref noise::simplex_noise(F, F), in the same order, with the gradient and corner branches replaced by masks
+		template <typename L>
+		typename L::f SimplexNoise(typename L::f x, typename L::f y) noexcept
+		{
+			using f = typename L::f;
+			using i = typename L::i;
+
+			constexpr float F2 = 0.366025403f;
+			constexpr float G2 = 0.211324865f;
+			const f g2 = L::broadcast(G2);
+			const i one = L::broadcast(int32_t(1));
+
+			const f s = (x + y) * L::broadcast(F2);
+			const i ii = L::fastfloor(x + s);
+			const i jj = L::fastfloor(y + s);
+
+			const f t = L::to_float(ii + jj) * g2;
+			const f x0 = x - (L::to_float(ii) - t);
+			const f y0 = y - (L::to_float(jj) - t);
+
+			const i i1 = L::greater(x0, y0) & one;
+			const i j1 = one - i1;
+
+			const f x1 = x0 - L::to_float(i1) + g2;
+			const f y1 = y0 - L::to_float(j1) + g2;
+			const f x2 = x0 - L::broadcast(1.0f) + L::broadcast(2.0f * G2);
+			const f y2 = y0 - L::broadcast(1.0f) + L::broadcast(2.0f * G2);
+
+			const i gi0 = Hash<L>(ii + Hash<L>(jj));
+			const i gi1 = Hash<L>(ii + i1 + Hash<L>(jj + j1));
+			const i gi2 = Hash<L>(ii + one + Hash<L>(jj + one));
+
+			/// grad(hash, x, y): u +- 2v, with u and v being x and y swapped unless (hash & 0x3F) < 4
+			const auto corner = [&](i hash, f dx, f dy) {
+				const i first_four = L::is_zero(hash & L::broadcast(int32_t(0x3C)));
+				const f u = L::select(first_four, dx, dy);
+				const f v = L::select(first_four, dy, dx);
+				const f grad = L::template flip_sign_if_bit<0>(hash & one, u) + L::template flip_sign_if_bit<1>(hash & L::broadcast(int32_t(2)), L::broadcast(2.0f) * v);
+
+				const f falloff = L::broadcast(0.5f) - dx * dx - dy * dy;
+				const f squared = falloff * falloff;
+				return L::zero_where(L::less(falloff, L::broadcast(0.0f)), squared * squared * grad);
+			};
+
+			const f n0 = corner(gi0, x0, y0);
+			const f n1 = corner(gi1, x1, y1);
+			const f n2 = corner(gi2, x2, y2);
+
+			return L::broadcast(45.23065f) * (n0 + n1 + n2);
+		}
+#endif
+
+		template <typename F>
+		void FractalSimplexRow(octave_constants<F> const& octaves, F origin_x, F step, F y, std::span<F> out) noexcept
+		{
+			size_t column = 0;
+#if GHPL_HAS_AVX2 || GHPL_HAS_SSE2
+			if constexpr (std::same_as<F, float>)
+			{
+				using L = simd::widest_lanes;
+				const auto origin = L::broadcast(origin_x);
+				const auto step_lanes = L::broadcast(step);
+				const auto y_lanes = L::broadcast(y);
+				for (; column + L::width <= out.size(); column += L::width)
+				{
+					const auto x = origin + L::sequence(column) * step_lanes;
+					auto output = L::broadcast(0.0f);
+					for (size_t octave = 0; octave < octaves.frequencies.size(); ++octave)
+					{
+						const auto frequency = L::broadcast(octaves.frequencies[octave]);
+						output = output + L::broadcast(octaves.amplitudes[octave]) * SimplexNoise<L>(x * frequency, y_lanes * frequency);
+					}
+					L::store(output / L::broadcast(octaves.denominator), out.data() + column);
+				}
+			}
+#endif
+			for (; column < out.size(); ++column)
+			{
+				const auto x = origin_x + F(column) * step;
+				F output = 0;
+				for (size_t octave = 0; octave < octaves.frequencies.size(); ++octave)
+					output += octaves.amplitudes[octave] * simplex_noise(x * octaves.frequencies[octave], y * octaves.frequencies[octave]);
+				out[column] = output / octaves.denominator;
+			}
+		}
+
+		template <typename F>
+		void FractalSimplexSpan(octave_constants<F> const& octaves, F origin, F step, size_t first, std::span<F> out) noexcept
+		{
+			size_t index = 0;
+#if GHPL_HAS_AVX2 || GHPL_HAS_SSE2
+			if constexpr (std::same_as<F, float>)
+			{
+				using L = simd::widest_lanes;
+				const auto origin_lanes = L::broadcast(origin);
+				const auto step_lanes = L::broadcast(step);
+				for (; index + L::width <= out.size(); index += L::width)
+				{
+					const auto x = origin_lanes + L::sequence(first + index) * step_lanes;
+					auto output = L::broadcast(0.0f);
+					for (size_t octave = 0; octave < octaves.frequencies.size(); ++octave)
+						output = output + L::broadcast(octaves.amplitudes[octave]) * SimplexNoise<L>(x * L::broadcast(octaves.frequencies[octave]));
+					L::store(output / L::broadcast(octaves.denominator), out.data() + index);
+				}
+			}
+#endif
+			for (; index < out.size(); ++index)
+			{
+				const auto x = origin + F(first + index) * step;
+				F output = 0;
+				for (size_t octave = 0; octave < octaves.frequencies.size(); ++octave)
+					output += octaves.amplitudes[octave] * simplex_noise(x * octaves.frequencies[octave]);
+				out[index] = output / octaves.denominator;
+			}
+		}
+	}
+
+	/// Fills `out` with `count` samples of fractal 1D simplex noise; sample `i` is `fractal_simplex_noise(octaves, origin + F(i) * step, ...)`
+	/// \param thread_count number of threads to spread the work over; 0 means one per hardware thread
+	template <std::floating_point F>
+	void generate_simplex_1d(F origin, F step, size_t count, fractal_parameters<F> const& fractal, std::span<F> out, unsigned thread_count = 0)
+	{
+		if (out.size() < count)
+			throw std::invalid_argument("not enough space for the samples");
+
+		static constexpr size_t chunk_size = 4096;
+		const detail::octave_constants<F> octaves{ fractal };
+		parallel_for_each_index((count + chunk_size - 1) / chunk_size, thread_count, [&](size_t chunk) {
+			const auto first = chunk * chunk_size;
+			detail::FractalSimplexSpan(octaves, origin, step, first, out.subspan(first, std::min(chunk_size, count - first)));
+		});
+	}
+
+	/// Fills `out` with a `width` x `height` grid of fractal 2D simplex noise, row by row; the sample at `column`, `row` is
+	/// `fractal_simplex_noise_2d(octaves, origin_x + F(column) * step, origin_y + F(row) * step, ...)`
+	/// \param thread_count number of threads to spread the rows over; 0 means one per hardware thread
+	template <std::floating_point F>
+	void generate_simplex_2d(F origin_x, F origin_y, F step, size_t width, size_t height, fractal_parameters<F> const& fractal, std::span<F> out, unsigned thread_count = 0)
+	{
+		if (out.size() / std::max<size_t>(width, 1) < height)
+			throw std::invalid_argument("not enough space for the samples");
+
+		const detail::octave_constants<F> octaves{ fractal };
+		parallel_for_each_index(height, thread_count, [&](size_t row) {
+			detail::FractalSimplexRow(octaves, origin_x, step, origin_y + F(row) * step, out.subspan(row * width, width));
+		});
+	}
+
+	template <std::floating_point F>
+	void generate_simplex_2d(F origin_x, F origin_y, F step, size_t width, size_t height, size_t octaves, std::span<F> out, unsigned thread_count = 0)
+	{
+		generate_simplex_2d(origin_x, origin_y, step, width, height, fractal_parameters<F>{ .octaves = octaves }, out, thread_count);
+	}
+}
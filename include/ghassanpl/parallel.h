@@ -0,0 +1,96 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ghassanpl
+{
+	/// \defgroup Parallel Parallel loops
+	/// Spreading independent jobs over a few threads, for the batch functions of this library
+	/// @{
+
+	/// \returns how many threads to use for `count` independent jobs, with a `thread_count` of 0 meaning one per hardware thread
+	[[nodiscard]] inline unsigned parallel_worker_count(size_t count, unsigned thread_count) noexcept
+	{
+		if (thread_count == 0)
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+		return unsigned(std::clamp<size_t>(count, 1, thread_count));
+	}
+
+	/// Calls `func(index, worker)` (or `func(index)`) for every index in [0, `count`), on \ref parallel_worker_count(count, thread_count) threads
+	/// including the calling one; `worker` is in [0, that count), and is the same for all the calls made on one thread. Indices are handed out
+	/// one at a time, so uneven jobs are balanced between the threads.
+	///
+	/// If `func` throws, the remaining indices are skipped, and once all the threads are done, the first exception is rethrown on the calling thread.
+	template <typename FUNC>
+	void parallel_for_each_index(size_t count, unsigned thread_count, FUNC const& func)
+	{
+		const auto workers = parallel_worker_count(count, thread_count);
+
+		std::atomic<size_t> next_index = 0;
+		std::exception_ptr exception;
+		std::mutex exception_mutex;
+		const auto work = [&](unsigned worker) {
+			try
+			{
+				for (size_t i; (i = next_index.fetch_add(1, std::memory_order_relaxed)) < count;)
+				{
+					if constexpr (std::invocable<FUNC const&, size_t, unsigned>)
+						func(i, worker);
+					else
+						func(i);
+				}
+			}
+			catch (...)
+			{
+				next_index.store(count, std::memory_order_relaxed);
+				std::scoped_lock lock{ exception_mutex };
+				if (!exception)
+					exception = std::current_exception();
+			}
+		};
+
+		{
+			std::vector<std::jthread> threads;
+			threads.reserve(workers - 1);
+			for (unsigned worker = 1; worker < workers; ++worker)
+				threads.emplace_back(work, worker);
+			work(0);
+		}
+
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+
+	/// Splits [`begin`, `end`) into at most `thread_count` (0 meaning one per hardware thread) bands of at least `min_per_band` elements
+	/// (except when there are fewer elements than that), and calls `func(band_begin, band_end)` for each, in parallel.
+	/// Exceptions are handled like in \ref parallel_for_each_index.
+	template <typename FUNC>
+	void parallel_for_each_band(int begin, int end, unsigned thread_count, int min_per_band, FUNC const& func)
+	{
+		if (thread_count == 0)
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+		const auto count = end - begin;
+		const auto bands = std::clamp(count / std::max(min_per_band, 1), 1, int(thread_count));
+		if (bands == 1)
+		{
+			func(begin, end);
+			return;
+		}
+
+		const auto band_start = [&](size_t band) { return begin + int(int64_t(count) * int64_t(band) / bands); };
+		parallel_for_each_index(size_t(bands), unsigned(bands), [&](size_t band) { func(band_start(band), band_start(band + 1)); });
+	}
+
+	/// @}
+}
@@ -0,0 +1,623 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "colors.h"
+#include <span>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+#include "simd.h"
+
+/// Functions that convert whole images (or any spans of pixels) between packed 8-bit formats, floating point colors, HSV and sRGB.
+/// Pixels are processed 8 (with AVX2) or 4 (with SSE2) at a time, and the rest one at a time, with the same arithmetic, so the results
+/// do not depend on the instruction set. Byte values become floats by multiplying by 1/255, so they can differ from \ref from_u32_rgba
+/// and friends (which divide) in the last bit; floats become bytes like \ref to_u32_rgba does, except they are clamped to [0, 1] first.
+///
+/// The output spans must be at least as long as the input spans; they may be the same memory as the input.
+
+namespace ghassanpl
+{
+	/// \ingroup Colors
+	///@{
+
+	/// The layouts of packed 8-bit pixels, named from the most significant byte down, like \ref from_u32_rgba and \ref to_u32_rgba
+	enum class pixel_format
+	{
+		rgba,
+		bgra,
+		argb,
+		abgr,
+	};
+
+	namespace detail
+	{
+		/// Every conversion between the formats is an optional byte reversal followed by a rotation
+		struct byte_permutation
+		{
+			bool reverse = false;
+			int rotate_left = 0;
+		};
+
+		[[nodiscard]] constexpr int AlphaShift(pixel_format format) noexcept { return format == pixel_format::rgba || format == pixel_format::bgra ? 0 : 24; }
+		[[nodiscard]] constexpr bool IsRgbOrder(pixel_format format) noexcept { return format == pixel_format::rgba || format == pixel_format::argb; }
+
+		[[nodiscard]] constexpr byte_permutation PermutationBetween(pixel_format from, pixel_format to) noexcept
+		{
+			const bool reverse = IsRgbOrder(from) != IsRgbOrder(to);
+			const auto alpha_shift = reverse ? 24 - AlphaShift(from) : AlphaShift(from);
+			return { reverse, (AlphaShift(to) - alpha_shift + 32) % 32 };
+		}
+
+		[[nodiscard]] constexpr uint32_t Permute(uint32_t value, byte_permutation permutation) noexcept
+		{
+			if (permutation.reverse)
+				value = (value << 24) | ((value << 8) & 0x00FF0000) | ((value >> 8) & 0x0000FF00) | (value >> 24);
+			return std::rotl(value, permutation.rotate_left);
+		}
+
+		/// Floats made from bytes have their channels in memory order, so they correspond to this format
+		inline constexpr auto float_order = pixel_format::abgr;
+
+		[[nodiscard]] inline float MulAdd(float a, float b, float c) noexcept
+		{
+#if defined(__FMA__)
+			return std::fma(a, b, c);
+#else
+			return a * b + c;
+#endif
+		}
+
+		[[nodiscard]] inline uint32_t FloatToByte(float value) noexcept { return uint32_t(MulAdd(std::clamp(value, 0.0f, 1.0f), 255.0f, 0.5f)); }
+
+		[[nodiscard]] inline uint32_t PackPixel(color_t const& color) noexcept
+		{
+			return FloatToByte(color.x) | (FloatToByte(color.y) << 8) | (FloatToByte(color.z) << 16) | (FloatToByte(color.w) << 24);
+		}
+
+		[[nodiscard]] inline color_t UnpackPixel(uint32_t abgr) noexcept
+		{
+			constexpr float scale = 1.0f / 255.0f;
+			return { float(abgr & 0xFF) * scale, float((abgr >> 8) & 0xFF) * scale, float((abgr >> 16) & 0xFF) * scale, float(abgr >> 24) * scale };
+		}
+
+		/// sRGB decoding is a table lookup per byte; encoding interpolates linearly within 104 buckets: 8 per octave of linear values from
+		/// 2^-13 up to 1 (anything below 2^-13 encodes to 0 anyway). The buckets are addressed by the exponent and top 3 mantissa bits
+		/// of the value, and the rest of the mantissa is the position in the bucket. The interpolation is within 0.1 of the exact
+		/// encoded value (out of 255), so about one rounded channel in a hundred is off by one.
+		struct srgb_tables
+		{
+			static constexpr uint32_t first_bucket_bits = 0x39000000; /// 2^-13
+			static constexpr uint32_t last_value_bits = 0x3F7FFFFF; /// The largest float below 1
+			static constexpr size_t bucket_count = 104;
+
+			/// Linear values of sRGB bytes, then the byte values / 255 for alpha
+			std::array<float, 512> decode{};
+			std::array<float, bucket_count> encode_base{};
+			std::array<float, bucket_count> encode_slope{};
+
+			srgb_tables() noexcept
+			{
+				for (size_t i = 0; i < 256; ++i)
+				{
+					decode[i] = srgb_to_linear(float(i) / 255.0f);
+					decode[256 + i] = float(i) * (1.0f / 255.0f);
+				}
+				for (size_t i = 0; i < bucket_count; ++i)
+				{
+					const auto start = double(std::bit_cast<float>(uint32_t(first_bucket_bits + (i << 20))));
+					const auto end = double(std::bit_cast<float>(uint32_t(first_bucket_bits + ((i + 1) << 20))));
+					const auto encode = [](double value) { return 255.0 * (value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055); };
+					const auto base = encode(start);
+					const auto slope = encode(end) - base;
+					/// The curve is concave, so the chord is below it; moving it up by half the gap in the middle halves the error
+					const auto gap = encode((start + end) * 0.5) - (base + slope * 0.5);
+					encode_base[i] = float(base + gap * 0.5 + 0.5);
+					encode_slope[i] = float(slope);
+				}
+			}
+		};
+
+		[[nodiscard]] inline srgb_tables const& SrgbTables()
+		{
+			static const srgb_tables tables;
+			return tables;
+		}
+
+		/// The encoded value + 0.5, ready to be truncated
+		[[nodiscard]] inline uint32_t EncodeSrgb(srgb_tables const& tables, float value) noexcept
+		{
+			const auto bits = std::clamp(std::bit_cast<uint32_t>(std::max(value, 0.0f)), srgb_tables::first_bucket_bits, srgb_tables::last_value_bits);
+			const auto bucket = (bits - srgb_tables::first_bucket_bits) >> 20;
+			const auto position = float(bits & 0xFFFFF) * 0x1p-20f;
+			return uint32_t(MulAdd(tables.encode_slope[bucket], position, tables.encode_base[bucket]));
+		}
+
+		[[nodiscard]] inline color_t HsvToRgb(color_hsva_t const& hsva) noexcept
+		{
+			const auto h = hsva->x, s = hsva->y, v = hsva->z;
+			const auto channel = [&](float n) {
+				auto k = n + h;
+				if (k >= 6.0f) k -= 6.0f;
+				return MulAdd(-v * s, std::clamp(std::min(k, 4.0f - k), 0.0f, 1.0f), v);
+			};
+			return { channel(5.0f), channel(3.0f), channel(1.0f), hsva->w };
+		}
+
+		[[nodiscard]] inline color_hsva_t RgbToHsv(color_t const& rgba) noexcept
+		{
+			const auto max = std::max(std::max(rgba.x, rgba.y), rgba.z);
+			const auto min = std::min(std::min(rgba.x, rgba.y), rgba.z);
+			const auto delta = max - min;
+			const auto inverse_delta = delta > 0 ? 1.0f / delta : 0.0f;
+			auto h = (rgba.y - rgba.z) * inverse_delta;
+			if (h < 0) h += 6.0f;
+			if (rgba.x != max)
+				h = rgba.y == max ? MulAdd(rgba.z - rgba.x, inverse_delta, 2.0f) : MulAdd(rgba.x - rgba.y, inverse_delta, 4.0f);
+			return color_hsva_t{ h, max > 0 ? delta / max : 0.0f, max, rgba.w };
+		}
+
+		[[nodiscard]] inline color_t Unpremultiplied(color_t const& color) noexcept
+		{
+			if (color.w == 0) return { 0, 0, 0, 0 };
+			return { color.x / color.w, color.y / color.w, color.z / color.w, color.w };
+		}
+
+		[[nodiscard]] inline uint32_t PremultiplyChannel(uint32_t channel, uint32_t alpha) noexcept
+		{
+			/// Exactly round(channel * alpha / 255)
+			const auto product = channel * alpha + 128;
+			return (product + (product >> 8)) >> 8;
+		}
+
+		[[nodiscard]] inline uint32_t PremultiplyPixel(uint32_t pixel, int alpha_shift) noexcept
+		{
+			const auto alpha = (pixel >> alpha_shift) & 0xFF;
+			uint32_t result = alpha << alpha_shift;
+			for (int shift = 0; shift < 32; shift += 8)
+				if (shift != alpha_shift)
+					result |= PremultiplyChannel((pixel >> shift) & 0xFF, alpha) << shift;
+			return result;
+		}
+
+		[[nodiscard]] inline uint32_t UnpremultiplyPixel(uint32_t pixel, int alpha_shift) noexcept
+		{
+			const auto alpha = (pixel >> alpha_shift) & 0xFF;
+			if (alpha == 0) return 0;
+			const auto factor = 255.0f / float(alpha);
+			uint32_t result = alpha << alpha_shift;
+			for (int shift = 0; shift < 32; shift += 8)
+				if (shift != alpha_shift)
+					result |= uint32_t(std::min(MulAdd(float((pixel >> shift) & 0xFF), factor, 0.5f), 255.0f)) << shift;
+			return result;
+		}
+
+		/// Each pixel lane set extends the lane set of the same width with byte shuffles: it handles `width` packed pixels at a time as
+		/// int lanes `i`; when widened, they become 4 float lanes `f` of `width / 4` pixels each, with the channels in memory order
+#if GHPL_HAS_AVX2
+		struct avx2_pixels : simd::avx2_lanes
+		{
+			static i permute(i value, byte_permutation permutation) noexcept
+			{
+				const auto control = _mm256_add_epi8(_mm256_set1_epi32(int(Permute(0x03020100, permutation))),
+					_mm256_setr_epi32(0, 0x04040404, 0x08080808, 0x0C0C0C0C, 0, 0x04040404, 0x08080808, 0x0C0C0C0C));
+				return { _mm256_shuffle_epi8(value.v, control) };
+			}
+
+			static void widen(i value, f (&out)[4]) noexcept
+			{
+				const auto low = _mm256_castsi256_si128(value.v);
+				const auto high = _mm256_extracti128_si256(value.v, 1);
+				out[0] = { _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(low)) };
+				out[1] = { _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(low, 8))) };
+				out[2] = { _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(high)) };
+				out[3] = { _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(high, 8))) };
+			}
+
+			/// Truncates the values (which must be in [0, 255]) to bytes
+			static i narrow(f const (&values)[4]) noexcept
+			{
+				const auto low = _mm256_packs_epi32(_mm256_cvttps_epi32(values[0].v), _mm256_cvttps_epi32(values[1].v));
+				const auto high = _mm256_packs_epi32(_mm256_cvttps_epi32(values[2].v), _mm256_cvttps_epi32(values[3].v));
+				/// Packing works within 128-bit halves, which leaves the pixels in the order 0 2 4 6 1 3 5 7
+				return { _mm256_permutevar8x32_epi32(_mm256_packus_epi16(low, high), _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)) };
+			}
+
+			template <int CHANNEL>
+			static f splat_channel(f value) noexcept { return { _mm256_permute_ps(value.v, _MM_SHUFFLE(CHANNEL, CHANNEL, CHANNEL, CHANNEL)) }; }
+			/// A mask of the given channel of every pixel
+			template <int CHANNEL>
+			static i channel_mask() noexcept
+			{
+				constexpr int m0 = CHANNEL == 0 ? -1 : 0, m1 = CHANNEL == 1 ? -1 : 0, m2 = CHANNEL == 2 ? -1 : 0, m3 = CHANNEL == 3 ? -1 : 0;
+				return { _mm256_setr_epi32(m0, m1, m2, m3, m0, m1, m2, m3) };
+			}
+
+			/// Transposes 4x4 blocks within each 128-bit half; turns 4 vectors of pixels into vectors of channels and back
+			static void transpose(f& a, f& b, f& c, f& d) noexcept
+			{
+				const auto t0 = _mm256_unpacklo_ps(a.v, b.v);
+				const auto t1 = _mm256_unpackhi_ps(a.v, b.v);
+				const auto t2 = _mm256_unpacklo_ps(c.v, d.v);
+				const auto t3 = _mm256_unpackhi_ps(c.v, d.v);
+				a.v = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(t0), _mm256_castps_pd(t2)));
+				b.v = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(t0), _mm256_castps_pd(t2)));
+				c.v = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(t1), _mm256_castps_pd(t3)));
+				d.v = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(t1), _mm256_castps_pd(t3)));
+			}
+		};
+#endif
+
+#if GHPL_HAS_SSE2
+		struct sse2_pixels : simd::sse2_lanes
+		{
+			/// SSE2 has no byte shuffle, so this is done with shifts
+			static i permute(i value, byte_permutation permutation) noexcept
+			{
+				auto v = value.v;
+				if (permutation.reverse)
+				{
+					v = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+					v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+				}
+				if (permutation.rotate_left)
+					v = _mm_or_si128(_mm_sll_epi32(v, _mm_cvtsi32_si128(permutation.rotate_left)), _mm_srl_epi32(v, _mm_cvtsi32_si128(32 - permutation.rotate_left)));
+				return { v };
+			}
+
+			static void widen(i value, f (&out)[4]) noexcept
+			{
+				const auto zero = _mm_setzero_si128();
+				const auto low = _mm_unpacklo_epi8(value.v, zero);
+				const auto high = _mm_unpackhi_epi8(value.v, zero);
+				out[0] = { _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)) };
+				out[1] = { _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)) };
+				out[2] = { _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)) };
+				out[3] = { _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)) };
+			}
+
+			static i narrow(f const (&values)[4]) noexcept
+			{
+				const auto low = _mm_packs_epi32(_mm_cvttps_epi32(values[0].v), _mm_cvttps_epi32(values[1].v));
+				const auto high = _mm_packs_epi32(_mm_cvttps_epi32(values[2].v), _mm_cvttps_epi32(values[3].v));
+				return { _mm_packus_epi16(low, high) };
+			}
+
+			template <int CHANNEL>
+			static f splat_channel(f value) noexcept { return { _mm_shuffle_ps(value.v, value.v, _MM_SHUFFLE(CHANNEL, CHANNEL, CHANNEL, CHANNEL)) }; }
+			template <int CHANNEL>
+			static i channel_mask() noexcept
+			{
+				return { _mm_setr_epi32(CHANNEL == 0 ? -1 : 0, CHANNEL == 1 ? -1 : 0, CHANNEL == 2 ? -1 : 0, CHANNEL == 3 ? -1 : 0) };
+			}
+
+			static void transpose(f& a, f& b, f& c, f& d) noexcept { _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v); }
+		};
+#endif
+
+#if GHPL_HAS_AVX2
+		using widest_pixels = avx2_pixels;
+#elif GHPL_HAS_SSE2
+		using widest_pixels = sse2_pixels;
+#endif
+
+		inline void CheckPixelSpans(size_t in_size, size_t out_size)
+		{
+			if (out_size < in_size)
+				throw std::invalid_argument("not enough space for the pixels");
+		}
+
+		/// Calls `func(P{}, first)` for each full group of `P::width` pixels, and returns where the rest starts
+		template <typename FUNC>
+		size_t ForEachPixelGroup(size_t count, FUNC const& func)
+		{
+			size_t i = 0;
+#if GHPL_HAS_AVX2 || GHPL_HAS_SSE2
+			using P = widest_pixels;
+			for (; i + P::width <= count; i += P::width)
+				func(P{}, i);
+#endif
+			return i;
+		}
+
+		[[nodiscard]] inline float* FloatsOf(color_t* colors) noexcept { return &colors->x; }
+		[[nodiscard]] inline float const* FloatsOf(color_t const* colors) noexcept { return &colors->x; }
+		[[nodiscard]] inline float* FloatsOf(color_hsva_t* colors) noexcept { return &colors->value.x; }
+		[[nodiscard]] inline float const* FloatsOf(color_hsva_t const* colors) noexcept { return &colors->value.x; }
+
+		static_assert(sizeof(color_t) == 4 * sizeof(float) && sizeof(color_hsva_t) == sizeof(color_t), "colors must be 4 tightly packed floats");
+	}
+
+	/// Converts packed pixels from one format to another
+	inline void convert_pixels(std::span<uint32_t const> in, pixel_format from, std::span<uint32_t> out, pixel_format to)
+	{
+		detail::CheckPixelSpans(in.size(), out.size());
+		const auto permutation = detail::PermutationBetween(from, to);
+		auto i = detail::ForEachPixelGroup(in.size(), [&]<typename P>(P, size_t first) {
+			P::store(P::permute(P::load(in.data() + first), permutation), out.data() + first);
+		});
+		for (; i < in.size(); ++i)
+			out[i] = detail::Permute(in[i], permutation);
+	}
+
+	/// Converts packed pixels in the given format to colors
+	inline void unpack_pixels(std::span<uint32_t const> in, pixel_format from, std::span<color_t> out)
+	{
+		detail::CheckPixelSpans(in.size(), out.size());
+		const auto permutation = detail::PermutationBetween(from, detail::float_order);
+		float* floats = detail::FloatsOf(out.data());
+		auto i = detail::ForEachPixelGroup(in.size(), [&]<typename P>(P, size_t first) {
+			typename P::f channels[4];
+			P::widen(P::permute(P::load(in.data() + first), permutation), channels);
+			const auto scale = P::broadcast(1.0f / 255.0f);
+			for (size_t k = 0; k < 4; ++k)
+				P::store(channels[k] * scale, floats + first * 4 + k * P::width);
+		});
+		for (; i < in.size(); ++i)
+			out[i] = detail::UnpackPixel(detail::Permute(in[i], permutation));
+	}
+
+	/// Converts colors to packed pixels in the given format; the channels are clamped to [0, 1]
+	inline void pack_pixels(std::span<color_t const> in, std::span<uint32_t> out, pixel_format to)
+	{
+		detail::CheckPixelSpans(in.size(), out.size());
+		const auto permutation = detail::PermutationBetween(detail::float_order, to);
+		float const* floats = detail::FloatsOf(in.data());
+		auto i = detail::ForEachPixelGroup(in.size(), [&]<typename P>(P, size_t first) {
+			typename P::f channels[4];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				const auto clamped = P::min(P::max(P::load(floats + first * 4 + k * P::width), P::broadcast(0.0f)), P::broadcast(1.0f));
+				channels[k] = P::mul_add(clamped, P::broadcast(255.0f), P::broadcast(0.5f));
+			}
+			P::store(P::permute(P::narrow(channels), permutation), out.data() + first);
+		});
+		for (; i < in.size(); ++i)
+			out[i] = detail::Permute(detail::PackPixel(in[i]), permutation);
+	}
+
+	/// Converts packed sRGB-encoded pixels to linear colors; alpha is not encoded, so it is just divided by 255
+	inline void srgb_pixels_to_linear(std::span<uint32_t const> in, pixel_format from, std::span<color_t> out)
+	{
+		detail::CheckPixelSpans(in.size(), out.size());
+		const auto permutation = detail::PermutationBetween(from, detail::float_order);
+		auto const& tables = detail::SrgbTables();
+		size_t i = 0;
+#if GHPL_HAS_AVX2
+		float* floats = detail::FloatsOf(out.data());
+		const auto alpha_offset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+		for (; i + 8 <= in.size(); i += 8)
+		{
+			const auto pixels = detail::avx2_pixels::permute(detail::avx2_pixels::load(in.data() + i), permutation).v;
+			const auto low = _mm256_castsi256_si128(pixels);
+			const auto high = _mm256_extracti128_si256(pixels, 1);
+			const __m128i pairs[4] = { low, _mm_srli_si128(low, 8), high, _mm_srli_si128(high, 8) };
+			for (size_t k = 0; k < 4; ++k)
+			{
+				const auto indices = _mm256_add_epi32(_mm256_cvtepu8_epi32(pairs[k]), alpha_offset);
+				_mm256_storeu_ps(floats + i * 4 + k * 8, _mm256_i32gather_ps(tables.decode.data(), indices, 4));
+			}
+		}
+#endif
+		for (; i < in.size(); ++i)
+		{
+			const auto pixel = detail::Permute(in[i], permutation);
+			out[i] = { tables.decode[pixel & 0xFF], tables.decode[(pixel >> 8) & 0xFF], tables.decode[(pixel >> 16) & 0xFF], tables.decode[256 + (pixel >> 24)] };
+		}
+	}
+
+	/// Converts linear colors to packed sRGB-encoded pixels, with the channels clamped to [0, 1]; alpha is not encoded
+	inline void linear_to_srgb_pixels(std::span<color_t const> in, std::span<uint32_t> out, pixel_format to)
+	{
+		detail::CheckPixelSpans(in.size(), out.size());
+		const auto permutation = detail::PermutationBetween(detail::float_order, to);
+		auto const& tables = detail::SrgbTables();
+		size_t i = 0;
+#if GHPL_HAS_AVX2
+		using P = detail::avx2_pixels;
+		float const* floats = detail::FloatsOf(in.data());
+		const auto alpha_mask = P::channel_mask<3>();
+		for (; i + 8 <= in.size(); i += 8)
+		{
+			P::f channels[4];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				const auto values = P::load(floats + i * 4 + k * 8);
+				const auto clamped = _mm256_castps_si256(_mm256_min_ps(_mm256_max_ps(values.v, _mm256_set1_ps(std::bit_cast<float>(detail::srgb_tables::first_bucket_bits))),
+					_mm256_set1_ps(std::bit_cast<float>(detail::srgb_tables::last_value_bits))));
+				const auto buckets = _mm256_srli_epi32(_mm256_sub_epi32(clamped, _mm256_set1_epi32(int(detail::srgb_tables::first_bucket_bits))), 20);
+				const auto position = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(clamped, _mm256_set1_epi32(0xFFFFF))), _mm256_set1_ps(0x1p-20f));
+				const auto encoded = P::mul_add({ _mm256_i32gather_ps(tables.encode_slope.data(), buckets, 4) }, { position }, { _mm256_i32gather_ps(tables.encode_base.data(), buckets, 4) });
+				const auto alpha = P::mul_add(P::min(P::max(values, P::broadcast(0.0f)), P::broadcast(1.0f)), P::broadcast(255.0f), P::broadcast(0.5f));
+				channels[k] = P::select(alpha_mask, alpha, encoded);
+			}
+			P::store(P::permute(P::narrow(channels), permutation), out.data() + i);
+		}
+#endif
+		for (; i < in.size(); ++i)
+		{
+			const auto& color = in[i];
+			const auto pixel = detail::EncodeSrgb(tables, color.x) | (detail::EncodeSrgb(tables, color.y) << 8) | (detail::EncodeSrgb(tables, color.z) << 16) | (detail::FloatToByte(color.w) << 24);
+			out[i] = detail::Permute(pixel, permutation);
+		}
+	}
+
+	/// Multiplies the color channels of packed pixels by their alpha, rounding to the nearest value
+	inline void premultiply_pixels(std::span<uint32_t> pixels, pixel_format format)
+	{
+		const auto alpha_shift = detail::AlphaShift(format);
+		size_t i = 0;
+#if GHPL_HAS_AVX2
+		{
+			/// Done in 16-bit lanes, with the alpha channel multiplied by 255 so it stays the same
+			const auto alpha_word = alpha_shift / 8;
+			const auto alpha_lanes = _mm256_set1_epi64x(int64_t(0xFFull << (alpha_word * 16)));
+			const auto premultiply = [&](__m256i words) {
+				const auto alphas = alpha_word == 0
+					? _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(words, 0x00), 0x00)
+					: _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(words, 0xFF), 0xFF);
+				const auto factors = _mm256_or_si256(_mm256_andnot_si256(alpha_lanes, alphas), alpha_lanes);
+				const auto products = _mm256_add_epi16(_mm256_mullo_epi16(words, factors), _mm256_set1_epi16(128));
+				return _mm256_srli_epi16(_mm256_add_epi16(products, _mm256_srli_epi16(products, 8)), 8);
+			};
+			for (; i + 8 <= pixels.size(); i += 8)
+			{
+				const auto value = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(pixels.data() + i));
+				const auto zero = _mm256_setzero_si256();
+				const auto result = _mm256_packus_epi16(premultiply(_mm256_unpacklo_epi8(value, zero)), premultiply(_mm256_unpackhi_epi8(value, zero)));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels.data() + i), result);
+			}
+		}
+#elif GHPL_HAS_SSE2
+		{
+			const auto alpha_word = alpha_shift / 8;
+			const auto alpha_lanes = _mm_set1_epi64x(int64_t(0xFFull << (alpha_word * 16)));
+			const auto premultiply = [&](__m128i words) {
+				const auto alphas = alpha_word == 0
+					? _mm_shufflehi_epi16(_mm_shufflelo_epi16(words, 0x00), 0x00)
+					: _mm_shufflehi_epi16(_mm_shufflelo_epi16(words, 0xFF), 0xFF);
+				const auto factors = _mm_or_si128(_mm_andnot_si128(alpha_lanes, alphas), alpha_lanes);
+				const auto products = _mm_add_epi16(_mm_mullo_epi16(words, factors), _mm_set1_epi16(128));
+				return _mm_srli_epi16(_mm_add_epi16(products, _mm_srli_epi16(products, 8)), 8);
+			};
+			for (; i + 4 <= pixels.size(); i += 4)
+			{
+				const auto value = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels.data() + i));
+				const auto zero = _mm_setzero_si128();
+				const auto result = _mm_packus_epi16(premultiply(_mm_unpacklo_epi8(value, zero)), premultiply(_mm_unpackhi_epi8(value, zero)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels.data() + i), result);
+			}
+		}
+#endif
+		for (; i < pixels.size(); ++i)
+			pixels[i] = detail::PremultiplyPixel(pixels[i], alpha_shift);
+	}
+
+	/// Divides the color channels of packed, premultiplied pixels by their alpha; pixels with an alpha of 0 become 0
+	inline void unpremultiply_pixels(std::span<uint32_t> pixels, pixel_format format)
+	{
+		const auto alpha_shift = detail::AlphaShift(format);
+		auto i = detail::ForEachPixelGroup(pixels.size(), [&]<typename P>(P, size_t first) {
+			typename P::f channels[4];
+			P::widen(P::load(pixels.data() + first), channels);
+			const auto is_alpha = alpha_shift == 0 ? P::template channel_mask<0>() : P::template channel_mask<3>();
+			for (auto& values : channels)
+			{
+				const auto alphas = alpha_shift == 0 ? P::template splat_channel<0>(values) : P::template splat_channel<3>(values);
+				const auto factors = P::select(is_alpha, P::broadcast(1.0f), P::broadcast(255.0f) / alphas);
+				const auto scaled = P::min(P::mul_add(values, factors, P::broadcast(0.5f)), P::broadcast(255.0f));
+				values = P::zero_unless(P::greater(alphas, P::broadcast(0.0f)), scaled);
+			}
+			P::store(P::narrow(channels), pixels.data() + first);
+		});
+		for (; i < pixels.size(); ++i)
+			pixels[i] = detail::UnpremultiplyPixel(pixels[i], alpha_shift);
+	}
+
+	/// Multiplies the colors by their alpha, like \ref premultiplied
+	inline void premultiply(std::span<color_t> colors)
+	{
+		float* floats = detail::FloatsOf(colors.data());
+		auto i = detail::ForEachPixelGroup(colors.size(), [&]<typename P>(P, size_t first) {
+			const auto is_alpha = P::template channel_mask<3>();
+			for (size_t k = 0; k < 4; ++k)
+			{
+				auto* ptr = floats + first * 4 + k * P::width;
+				const auto values = P::load(ptr);
+				P::store(P::select(is_alpha, values, values * P::template splat_channel<3>(values)), ptr);
+			}
+		});
+		for (; i < colors.size(); ++i)
+			colors[i] = premultiplied(colors[i]);
+	}
+
+	/// Divides premultiplied colors by their alpha; colors with an alpha of 0 become transparent black
+	inline void unpremultiply(std::span<color_t> colors)
+	{
+		float* floats = detail::FloatsOf(colors.data());
+		auto i = detail::ForEachPixelGroup(colors.size(), [&]<typename P>(P, size_t first) {
+			const auto is_alpha = P::template channel_mask<3>();
+			for (size_t k = 0; k < 4; ++k)
+			{
+				auto* ptr = floats + first * 4 + k * P::width;
+				const auto values = P::load(ptr);
+				const auto alphas = P::template splat_channel<3>(values);
+				const auto divided = P::select(is_alpha, values, values / alphas);
+				P::store(P::zero_unless(P::greater(alphas, P::broadcast(0.0f)), divided), ptr);
+			}
+		});
+		for (; i < colors.size(); ++i)
+			colors[i] = detail::Unpremultiplied(colors[i]);
+	}
+
+	/// Converts RGBA colors to HSVA; unlike the single-color \ref to_hsv, hues are always in [0, 6)
+	inline void to_hsv(std::span<color_t const> in, std::span<color_hsva_t> out)
+	{
+		detail::CheckPixelSpans(in.size(), out.size());
+		float const* in_floats = detail::FloatsOf(in.data());
+		float* out_floats = detail::FloatsOf(out.data());
+		auto i = detail::ForEachPixelGroup(in.size(), [&]<typename P>(P, size_t first) {
+			auto r = P::load(in_floats + first * 4), g = P::load(in_floats + first * 4 + P::width);
+			auto b = P::load(in_floats + first * 4 + P::width * 2), a = P::load(in_floats + first * 4 + P::width * 3);
+			P::transpose(r, g, b, a);
+
+			const auto max = P::max(P::max(r, g), b);
+			const auto min = P::min(P::min(r, g), b);
+			const auto delta = max - min;
+			const auto zero = P::broadcast(0.0f);
+			const auto inverse_delta = P::zero_unless(P::greater(delta, zero), P::broadcast(1.0f) / delta);
+			auto red_hue = (g - b) * inverse_delta;
+			red_hue = red_hue + P::zero_unless(P::less(red_hue, zero), P::broadcast(6.0f));
+			const auto green_hue = P::mul_add(b - r, inverse_delta, P::broadcast(2.0f));
+			const auto blue_hue = P::mul_add(r - g, inverse_delta, P::broadcast(4.0f));
+			auto h = P::select(P::equal(r, max), red_hue, P::select(P::equal(g, max), green_hue, blue_hue));
+			auto s = P::zero_unless(P::greater(max, zero), delta / max);
+			auto v = max;
+
+			P::transpose(h, s, v, a);
+			P::store(h, out_floats + first * 4);
+			P::store(s, out_floats + first * 4 + P::width);
+			P::store(v, out_floats + first * 4 + P::width * 2);
+			P::store(a, out_floats + first * 4 + P::width * 3);
+		});
+		for (; i < in.size(); ++i)
+			out[i] = detail::RgbToHsv(in[i]);
+	}
+
+	/// Converts HSVA colors (with hues in [0, 6]) to RGBA
+	inline void to_rgb(std::span<color_hsva_t const> in, std::span<color_t> out)
+	{
+		detail::CheckPixelSpans(in.size(), out.size());
+		float const* in_floats = detail::FloatsOf(in.data());
+		float* out_floats = detail::FloatsOf(out.data());
+		auto i = detail::ForEachPixelGroup(in.size(), [&]<typename P>(P, size_t first) {
+			auto h = P::load(in_floats + first * 4), s = P::load(in_floats + first * 4 + P::width);
+			auto v = P::load(in_floats + first * 4 + P::width * 2), a = P::load(in_floats + first * 4 + P::width * 3);
+			P::transpose(h, s, v, a);
+
+			const auto six = P::broadcast(6.0f);
+			const auto minus_chroma = P::broadcast(0.0f) - v * s;
+			const auto channel = [&](float n) {
+				auto k = P::broadcast(n) + h;
+				k = k - P::zero_unless(P::greater_equal(k, six), six);
+				const auto ramp = P::min(P::max(P::min(k, P::broadcast(4.0f) - k), P::broadcast(0.0f)), P::broadcast(1.0f));
+				return P::mul_add(minus_chroma, ramp, v);
+			};
+			auto r = channel(5.0f), g = channel(3.0f), b = channel(1.0f);
+
+			P::transpose(r, g, b, a);
+			P::store(r, out_floats + first * 4);
+			P::store(g, out_floats + first * 4 + P::width);
+			P::store(b, out_floats + first * 4 + P::width * 2);
+			P::store(a, out_floats + first * 4 + P::width * 3);
+		});
+		for (; i < in.size(); ++i)
+			out[i] = detail::HsvToRgb(in[i]);
+	}
+
+	///@}
+}
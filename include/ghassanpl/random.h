@@ -7,7 +7,17 @@
 #include "min-cpp-version/cpp20.h"
 #include <random>
 #include <numeric>
+#include <array>
+#include <bit>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <cmath>
+#include <functional>
+#include <ranges>
 #include "span.h"
+#include "hashes.h"
 
 namespace ghassanpl::random
 {
@@ -47,25 +57,376 @@ namespace ghassanpl::random
 #if GHPL_CPP20
 	static_assert(std::uniform_random_bit_generator<good_random_engine>);
 #endif
-	
-	thread_local inline std::default_random_engine default_random_engine;
-	
-	template <typename INTEGER = uint64_t, typename RANDOM = std::default_random_engine>
+
+	namespace detail
+	{
+		/// Just enough of an unsigned 128-bit integer for the engines below; arithmetic wraps around
+		struct uint128
+		{
+			uint64_t high = 0;
+			uint64_t low = 0;
+
+			friend constexpr bool operator==(uint128 const&, uint128 const&) noexcept = default;
+			friend constexpr uint128 operator+(uint128 a, uint128 b) noexcept
+			{
+				const auto low = a.low + b.low;
+				return { a.high + b.high + (low < a.low), low };
+			}
+		};
+
+		/// The full 128-bit product of two 64-bit integers
+		[[nodiscard]] constexpr uint128 multiply_wide(uint64_t a, uint64_t b) noexcept
+		{
+#if defined(__SIZEOF_INT128__)
+			const auto product = static_cast<unsigned __int128>(a) * b;
+			return { uint64_t(product >> 64), uint64_t(product) };
+#else
+			const auto a_low = a & 0xFFFFFFFF, a_high = a >> 32, b_low = b & 0xFFFFFFFF, b_high = b >> 32;
+			const auto low_low = a_low * b_low;
+			const auto high_low = a_high * b_low;
+			const auto low_high = a_low * b_high;
+			const auto middle = (low_low >> 32) + (high_low & 0xFFFFFFFF) + low_high;
+			return { a_high * b_high + (high_low >> 32) + (middle >> 32), (middle << 32) | (low_low & 0xFFFFFFFF) };
+#endif
+		}
+
+		[[nodiscard]] constexpr uint128 operator*(uint128 a, uint128 b) noexcept
+		{
+			auto result = multiply_wide(a.low, b.low);
+			result.high += a.low * b.high + a.high * b.low;
+			return result;
+		}
+
+		/// Whether every call to `RANDOM` gives a full 64 or 32 uniformly distributed bits
+		template <typename RANDOM>
+		constexpr bool gives_64_bits = RANDOM::min() == 0 && RANDOM::max() == std::numeric_limits<uint64_t>::max();
+		template <typename RANDOM>
+		constexpr bool gives_32_bits = RANDOM::min() == 0 && RANDOM::max() == std::numeric_limits<uint32_t>::max();
+
+		/// 64 uniformly distributed bits from any engine
+		template <typename RANDOM>
+		[[nodiscard]] uint64_t Bits64(RANDOM& rng)
+		{
+			if constexpr (gives_64_bits<RANDOM>)
+				return uint64_t(rng());
+			else if constexpr (gives_32_bits<RANDOM>)
+			{
+				const auto high = uint64_t(rng());
+				return (high << 32) | uint64_t(rng());
+			}
+			else
+				return std::uniform_int_distribution<uint64_t>{}(rng);
+		}
+	}
+
+	/// xoshiro256++ by David Blackman and Sebastiano Vigna: a fast all-purpose 64-bit engine with 256 bits of state
+	struct xoshiro256pp_engine
+	{
+		using result_type = uint64_t;
+
+		/// Seeds the state with consecutive outputs of \ref integer::splitmix64, as recommended by the authors
+		constexpr explicit xoshiro256pp_engine(uint64_t seed = 0x853c49e6748fea9bULL) noexcept { this->seed(seed); }
+		constexpr explicit xoshiro256pp_engine(std::array<uint64_t, 4> const& state) noexcept : m_state(state) {}
+
+		constexpr void seed(uint64_t seed) noexcept
+		{
+			integer::splitmix64_state splitmix{ seed };
+			for (auto& word : m_state)
+				word = integer::splitmix64(splitmix);
+		}
+
+		[[nodiscard]] static constexpr result_type min() noexcept { return 0; }
+		[[nodiscard]] static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+		constexpr result_type operator()() noexcept
+		{
+			auto& s = m_state;
+			const auto result = std::rotl(s[0] + s[3], 23) + s[0];
+			const auto t = s[1] << 17;
+			s[2] ^= s[0];
+			s[3] ^= s[1];
+			s[1] ^= s[2];
+			s[0] ^= s[3];
+			s[2] ^= t;
+			s[3] = std::rotl(s[3], 45);
+			return result;
+		}
+
+		/// Advances the engine by 2^128 values; calling this once more for each new engine gives 2^128 non-overlapping sequences
+		constexpr void jump() noexcept { Jump({ 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c }); }
+		/// Advances the engine by 2^192 values, e.g. to give each machine its own range of \ref jump "jumps"
+		constexpr void long_jump() noexcept { Jump({ 0x76e15d3efefdcbbf, 0xc5004e441c522fb3, 0x77710069854ee241, 0x39109bb02acbe635 }); }
+
+		[[nodiscard]] constexpr std::array<uint64_t, 4> const& state() const noexcept { return m_state; }
+
+		friend constexpr bool operator==(xoshiro256pp_engine const&, xoshiro256pp_engine const&) noexcept = default;
+
+	private:
+
+		std::array<uint64_t, 4> m_state{};
+
+		constexpr void Jump(std::array<uint64_t, 4> const& polynomial) noexcept
+		{
+			std::array<uint64_t, 4> result{};
+			for (const auto word : polynomial)
+			{
+				for (int bit = 0; bit < 64; ++bit)
+				{
+					if (word & (uint64_t(1) << bit))
+						for (size_t i = 0; i < 4; ++i)
+							result[i] ^= m_state[i];
+					(void)this->operator()();
+				}
+			}
+			m_state = result;
+		}
+	};
+
+	/// xoroshiro128+ by David Blackman and Sebastiano Vigna: the fastest engine here, with 128 bits of state; its lowest bits are weak,
+	/// which does not matter to the functions in this file, as they use the highest bits
+	struct xoroshiro128p_engine
+	{
+		using result_type = uint64_t;
+
+		constexpr explicit xoroshiro128p_engine(uint64_t seed = 0x853c49e6748fea9bULL) noexcept { this->seed(seed); }
+		constexpr explicit xoroshiro128p_engine(std::array<uint64_t, 2> const& state) noexcept : m_state(state) {}
+
+		constexpr void seed(uint64_t seed) noexcept
+		{
+			integer::splitmix64_state splitmix{ seed };
+			for (auto& word : m_state)
+				word = integer::splitmix64(splitmix);
+		}
+
+		[[nodiscard]] static constexpr result_type min() noexcept { return 0; }
+		[[nodiscard]] static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+		constexpr result_type operator()() noexcept
+		{
+			const auto s0 = m_state[0];
+			auto s1 = m_state[1];
+			const auto result = s0 + s1;
+			s1 ^= s0;
+			m_state[0] = std::rotl(s0, 24) ^ s1 ^ (s1 << 16);
+			m_state[1] = std::rotl(s1, 37);
+			return result;
+		}
+
+		/// Advances the engine by 2^64 values; calling this once more for each new engine gives 2^64 non-overlapping sequences
+		constexpr void jump() noexcept { Jump({ 0xdf900294d8f554a5, 0x170865df4b3201fc }); }
+		/// Advances the engine by 2^96 values
+		constexpr void long_jump() noexcept { Jump({ 0xd2a98b26625eee7b, 0xdddf9b1090aa7ac1 }); }
+
+		[[nodiscard]] constexpr std::array<uint64_t, 2> const& state() const noexcept { return m_state; }
+
+		friend constexpr bool operator==(xoroshiro128p_engine const&, xoroshiro128p_engine const&) noexcept = default;
+
+	private:
+
+		std::array<uint64_t, 2> m_state{};
+
+		constexpr void Jump(std::array<uint64_t, 2> const& polynomial) noexcept
+		{
+			std::array<uint64_t, 2> result{};
+			for (const auto word : polynomial)
+			{
+				for (int bit = 0; bit < 64; ++bit)
+				{
+					if (word & (uint64_t(1) << bit))
+					{
+						result[0] ^= m_state[0];
+						result[1] ^= m_state[1];
+					}
+					(void)this->operator()();
+				}
+			}
+			m_state = result;
+		}
+	};
+
+	/// PCG64 (the 128-bit LCG with the XSL RR output function) by Melissa O'Neill; gives the same values as `pcg64` in the reference
+	/// implementation for the same seed and stream
+	struct pcg64_engine
+	{
+		using result_type = uint64_t;
+
+		/// Engines with different `stream`s give different sequences, even for the same `seed`
+		constexpr explicit pcg64_engine(uint64_t seed = 0xcafef00dd15ea5e5ULL, uint64_t stream = 0) noexcept { this->seed(seed, stream); }
+
+		constexpr void seed(uint64_t seed, uint64_t stream = 0) noexcept
+		{
+			m_increment = { stream >> 63, (stream << 1) | 1 };
+			m_state = {};
+			Step();
+			m_state = m_state + detail::uint128{ 0, seed };
+			Step();
+		}
+
+		[[nodiscard]] static constexpr result_type min() noexcept { return 0; }
+		[[nodiscard]] static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+		constexpr result_type operator()() noexcept
+		{
+			Step();
+			return std::rotr(m_state.high ^ m_state.low, int(m_state.high >> 58));
+		}
+
+		/// Advances the engine by `delta` values in O(log `delta`) time
+		constexpr void discard(uint64_t delta) noexcept { Advance({ 0, delta }); }
+
+		/// Advances the engine by 2^64 values, giving 2^64 non-overlapping sequences of 2^64 values each for every stream
+		constexpr void jump() noexcept { Advance({ 1, 0 }); }
+
+		friend constexpr bool operator==(pcg64_engine const&, pcg64_engine const&) noexcept = default;
+
+	private:
+
+		static constexpr detail::uint128 multiplier{ 0x2360ED051FC65DA4ULL, 0x4385DF649FCCF645ULL };
+
+		detail::uint128 m_state{};
+		detail::uint128 m_increment{};
+
+		constexpr void Step() noexcept { m_state = m_state * multiplier + m_increment; }
+
+		/// Brown's algorithm: composes the affine step with itself, squaring it for each bit of `delta`
+		constexpr void Advance(detail::uint128 delta) noexcept
+		{
+			detail::uint128 total_multiplier{ 0, 1 }, total_increment{};
+			auto step_multiplier = multiplier;
+			auto step_increment = m_increment;
+			while (delta.high || delta.low)
+			{
+				if (delta.low & 1)
+				{
+					total_multiplier = total_multiplier * step_multiplier;
+					total_increment = total_increment * step_multiplier + step_increment;
+				}
+				step_increment = (step_multiplier + detail::uint128{ 0, 1 }) * step_increment;
+				step_multiplier = step_multiplier * step_multiplier;
+				delta = { delta.high >> 1, (delta.low >> 1) | (delta.high << 63) };
+			}
+			m_state = total_multiplier * m_state + total_increment;
+		}
+	};
+
+	/// wyrand by Wang Yi: a Weyl sequence passed through a 64x64-bit multiply; tiny state and very fast where 128-bit products are cheap.
+	/// Its period is only 2^64.
+	struct wyrand_engine
+	{
+		using result_type = uint64_t;
+
+		constexpr explicit wyrand_engine(uint64_t seed = 0) noexcept : m_state(seed) {}
+
+		constexpr void seed(uint64_t seed) noexcept { m_state = seed; }
+
+		[[nodiscard]] static constexpr result_type min() noexcept { return 0; }
+		[[nodiscard]] static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+		constexpr result_type operator()() noexcept
+		{
+			m_state += increment;
+			const auto product = detail::multiply_wide(m_state, m_state ^ 0x8bb84b93962eacc9ULL);
+			return product.high ^ product.low;
+		}
+
+		/// Advances the engine by `delta` values in constant time
+		constexpr void discard(uint64_t delta) noexcept { m_state += delta * increment; }
+
+		/// Advances the engine by 2^48 values, giving 2^16 non-overlapping sequences of 2^48 values each
+		constexpr void jump() noexcept { discard(uint64_t(1) << 48); }
+
+		[[nodiscard]] constexpr uint64_t state() const noexcept { return m_state; }
+
+		friend constexpr bool operator==(wyrand_engine const&, wyrand_engine const&) noexcept = default;
+
+	private:
+
+		static constexpr uint64_t increment = 0x2d358dccaa6c78a5ULL;
+
+		uint64_t m_state = 0;
+	};
+
+#if GHPL_CPP20
+	static_assert(std::uniform_random_bit_generator<xoshiro256pp_engine>);
+	static_assert(std::uniform_random_bit_generator<xoroshiro128p_engine>);
+	static_assert(std::uniform_random_bit_generator<pcg64_engine>);
+	static_assert(std::uniform_random_bit_generator<wyrand_engine>);
+#endif
+
+	/// The type of \ref default_random_engine, and so the default engine type of all functions in this namespace
+	using default_random_engine_type = xoshiro256pp_engine;
+
+	/// Each thread gets its own engine, all starting with the same default seed; as the engine is constant-initialized, using it costs
+	/// no more than using a global variable (there is no lazy-initialization check on every access)
+	constinit thread_local inline default_random_engine_type default_random_engine;
+
+	/// Maps the top 24 bits of `bits` to a float in [0, 1)
+	[[nodiscard]] constexpr float uniform_float_from_bits(uint32_t bits) noexcept { return float(bits >> 8) * 0x1p-24f; }
+
+	/// Maps the top 52 bits of `bits` to a double in [0, 1), by making them the mantissa of a double in [1, 2)
+	[[nodiscard]] constexpr double uniform_double_from_bits(uint64_t bits) noexcept { return std::bit_cast<double>((bits >> 12) | 0x3FF0000000000000ULL) - 1.0; }
+
+	/// Returns a uniformly distributed integer in [0, `bound`) (or any 64-bit integer if `bound` is 0), using Daniel Lemire's nearly
+	/// divisionless method: a single multiply in almost all cases, with the division only needed to reject the rare biased values
+	template <typename RANDOM = default_random_engine_type>
+	[[nodiscard]] uint64_t integer_below(uint64_t bound, RANDOM& rng = ::ghassanpl::random::default_random_engine)
+	{
+		if constexpr (detail::gives_32_bits<RANDOM>)
+		{
+			/// One 32-bit value is enough for small bounds
+			if (bound != 0 && bound <= std::numeric_limits<uint32_t>::max())
+			{
+				const auto bound32 = uint32_t(bound);
+				auto product = uint64_t(uint32_t(rng())) * bound32;
+				if (uint32_t(product) < bound32)
+				{
+					const auto threshold = uint32_t(-bound32) % bound32;
+					while (uint32_t(product) < threshold)
+						product = uint64_t(uint32_t(rng())) * bound32;
+				}
+				return product >> 32;
+			}
+		}
+
+		if (bound == 0)
+			return detail::Bits64(rng);
+
+		auto product = detail::multiply_wide(detail::Bits64(rng), bound);
+		if (product.low < bound)
+		{
+			const auto threshold = (0 - bound) % bound;
+			while (product.low < threshold)
+				product = detail::multiply_wide(detail::Bits64(rng), bound);
+		}
+		return product.high;
+	}
+
+	/// Returns a uniformly distributed integer in [0, `std::numeric_limits<INTEGER>::max()`]
+	template <typename INTEGER = uint64_t, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] constexpr INTEGER integer(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
-		std::uniform_int_distribution<INTEGER> dist;
-		return dist(rng);
+		static_assert(std::is_integral_v<INTEGER> && sizeof(INTEGER) <= sizeof(uint64_t), "integer only works on integer types up to 64 bits");
+		constexpr auto bits = std::bit_width(uint64_t(std::numeric_limits<INTEGER>::max()));
+		return INTEGER(detail::Bits64(rng) >> (64 - bits));
 	}
 
-	template <typename REAL = double, typename RANDOM = std::default_random_engine>
+	/// Returns a uniformly distributed value in [0, 1)
+	template <typename REAL = double, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] REAL percentage(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
-		static std::uniform_real_distribution<REAL> dist;
-		return dist(rng);
+		if constexpr (std::is_same_v<REAL, float> && (detail::gives_32_bits<RANDOM> || detail::gives_64_bits<RANDOM>))
+			return uniform_float_from_bits(uint32_t(uint64_t(rng()) >> (detail::gives_64_bits<RANDOM> ? 32 : 0)));
+		else if constexpr (std::is_same_v<REAL, double> && (detail::gives_32_bits<RANDOM> || detail::gives_64_bits<RANDOM>))
+			return uniform_double_from_bits(detail::Bits64(rng));
+		else
+		{
+			static std::uniform_real_distribution<REAL> dist;
+			return dist(rng);
+		}
 	}
 	
 	/*
-	template <typename REAL = double, typename T, typename RANDOM = std::default_random_engine>
+	template <typename REAL = double, typename T, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] auto between(T const& a, T const& b, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		using std::lerp;
@@ -76,57 +437,55 @@ namespace ghassanpl::random
 	}
 	*/
 
-	template <typename REAL = double, typename RANDOM = std::default_random_engine>
+	template <typename REAL = double, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] REAL normal(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		static std::normal_distribution<REAL> dist;
 		return dist(rng);
 	}
 
-	template <typename RANDOM = std::default_random_engine>
+	template <typename RANDOM = default_random_engine_type>
 	[[nodiscard]] uint64_t dice(uint64_t n_sided, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		if (n_sided < 2) return 0;
-		std::uniform_int_distribution<uint64_t> dist{ 0, n_sided - 1 };
-		return dist(rng) + 1;
+		return integer_below(n_sided, rng) + 1;
 	}
 
-	template <typename RANDOM = std::default_random_engine>
+	template <typename RANDOM = default_random_engine_type>
 	[[nodiscard]] uint64_t dice(uint64_t n_dice, uint64_t n_sided, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		if (n_sided < 2) return 0;
-		std::uniform_int_distribution<uint64_t> dist{ 0, n_sided - 1 };
 		uint64_t sum = 0;
 		for (uint64_t i = 0; i < n_dice; ++i)
-			sum += dist(rng) + 1;
+			sum += integer_below(n_sided, rng) + 1;
 		return sum;
 	}
 	
-	template <uint64_t N_SIDED, typename RANDOM = std::default_random_engine>
+	template <uint64_t N_SIDED, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] uint64_t dice(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		static_assert(N_SIDED >= 2, "you cannot roll a 0 or 1-sided die");
-		static std::uniform_int_distribution<uint64_t> dist{ 0, N_SIDED - 1 };
-		return dist(rng) + 1;
+		return integer_below(N_SIDED, rng) + 1;
 	}
 
-	template <uint64_t N_DICE, uint64_t N_SIDED, typename RANDOM = std::default_random_engine>
+	template <uint64_t N_DICE, uint64_t N_SIDED, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] uint64_t dice(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		static_assert(N_DICE >= 1 , "you cannot roll less than one die");
 		static_assert(N_SIDED >= 2, "you cannot roll a 0 or 1-sided die");
-		static std::uniform_int_distribution<uint64_t> dist{ 0, N_SIDED - 1 };
 		uint64_t sum = 0;
 		for (uint64_t i = 0; i < N_DICE; ++i)
-			sum += dist(rng) + 1;
+			sum += integer_below(N_SIDED, rng) + 1;
 		return sum;
 	}
 
-	template <typename RANDOM = std::default_random_engine>
+	template <typename RANDOM = default_random_engine_type>
 	[[nodiscard]] bool coin(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
-		std::uniform_int_distribution<uint64_t> dist{ 0, 1 };
-		return dist(rng) == 0;
+		if constexpr (detail::gives_64_bits<RANDOM> || detail::gives_32_bits<RANDOM>)
+			return (uint64_t(rng()) >> (detail::gives_64_bits<RANDOM> ? 63 : 31)) == 0;
+		else
+			return integer_below(2, rng) == 0;
 	}
 	 
 	namespace operators
@@ -141,22 +500,23 @@ namespace ghassanpl::random
 		[[nodiscard]] inline int operator""_d100(unsigned long long int n) { return (int)dice(n, 100, default_random_engine); }
 	}
 
-	template <typename RANDOM = std::default_random_engine, std::integral T>
+	template <typename RANDOM = default_random_engine_type, std::integral T>
 	[[nodiscard]] T in_integer_range(T from, T to, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		static_assert(is_any_of_v<T, short, int, long, long long, unsigned short, unsigned int, unsigned long, unsigned long long>, "in_integer_range only works on real integer types");
 		if (from >= to) return T{};
-		std::uniform_int_distribution<T> dist{ from, to };
-		return dist(rng);
+		/// The size of the range wraps around to 0 when it covers all 64-bit integers, which \ref integer_below treats as such
+		const auto size = uint64_t(to) - uint64_t(from) + 1;
+		return T(uint64_t(from) + integer_below(size, rng));
 	}
 
-	template <typename RANDOM = std::default_random_engine, std::integral T>
+	template <typename RANDOM = default_random_engine_type, std::integral T>
 	[[nodiscard]] T in_integer_range(T to, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		return in_integer_range(T{}, to, rng);
 	}
 
-	template <typename RANDOM = std::default_random_engine, std::floating_point T>
+	template <typename RANDOM = default_random_engine_type, std::floating_point T>
 	[[nodiscard]] T in_real_range(T from, T to, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		static_assert(std::is_floating_point_v<T>, "in_real_range only works on floating point types");
@@ -165,13 +525,13 @@ namespace ghassanpl::random
 		return dist(rng);
 	}
 
-	template <typename RANDOM = std::default_random_engine, std::floating_point T>
+	template <typename RANDOM = default_random_engine_type, std::floating_point T>
 	[[nodiscard]] T in_real_range(T to, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		return in_real_range(T{}, to, rng);
 	}
 
-	template <typename RANDOM = std::default_random_engine, typename T>
+	template <typename RANDOM = default_random_engine_type, typename T>
 	[[nodiscard]] auto in_range(T from, T to, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		if constexpr (std::is_enum_v<T>)
@@ -240,27 +600,34 @@ namespace ghassanpl::random
 		return result;
 	}
 
-	template <typename RANDOM = std::default_random_engine>
+	template <typename RANDOM = default_random_engine_type>
 	[[nodiscard]] bool with_probability(double probability, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		return percentage(rng) < std::clamp(probability, 0.0, 1.0);
 	}
 
-	template <typename RANDOM = std::default_random_engine>
+	template <typename RANDOM = default_random_engine_type>
 	[[nodiscard]] bool with_probability(double probability, double& result, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		auto res = result = percentage(rng);
 		return res < std::clamp(probability, 0.0, 1.0);
 	}
 
-	template <typename RANDOM = std::default_random_engine>
+	template <typename RANDOM = default_random_engine_type>
 	[[nodiscard]] bool one_in(size_t n, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		if (n == 0) return false;
 		return with_probability(1.0 / double(n), rng);
 	}
 
-	template <typename RANDOM = std::default_random_engine, typename T>
+	namespace detail
+	{
+		/// A value in (0, 1], so it can be safely passed to `log`
+		template <typename RANDOM>
+		[[nodiscard]] double OpenPercentage(RANDOM& rng) { return 1.0 - percentage<double>(rng); }
+	}
+
+	template <typename RANDOM = default_random_engine_type, typename T>
 	void shuffle(T& cont, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		using std::begin;
@@ -268,16 +635,16 @@ namespace ghassanpl::random
 		std::shuffle(begin(cont), end(cont), rng);
 	}
 
-	template <typename RANDOM = std::default_random_engine, typename T>
+	template <typename RANDOM = default_random_engine_type, typename T>
 	GHPL_REQUIRES(std::ranges::sized_range<T>)
 		[[nodiscard]] auto iterator(T& cont, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		using std::size;
 		using std::begin;
-		return begin(cont) + in_integer_range(0LL, (int64_t)size(cont) - 1, rng);
+		return begin(cont) + in_integer_range(int64_t(0), (int64_t)size(cont) - 1, rng);
 	}
 
-	template <typename RANDOM = std::default_random_engine, typename T, typename PRED>
+	template <typename RANDOM = default_random_engine_type, typename T, typename PRED>
 	GHPL_REQUIRES(std::ranges::sized_range<T>)
 	[[nodiscard]] auto iterator_if(T& cont, PRED&& pred, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
@@ -287,7 +654,7 @@ namespace ghassanpl::random
 		auto begin_it = begin(cont);
 		const auto end_it = end(cont);
 		const auto valid_count = std::count_if(begin_it, end_it, pred);
-		auto item_position = in_integer_range(0LL, (int64_t)valid_count - 1, rng);
+		auto item_position = in_integer_range(int64_t(0), (int64_t)valid_count - 1, rng);
 		for (; begin_it != end_it; ++begin_it)
 		{
 			if (pred(*begin_it) && (item_position--) == 0)
@@ -298,19 +665,19 @@ namespace ghassanpl::random
 		return end_it;
 	}
 
-	template <typename RANDOM = std::default_random_engine, typename T>
+	template <typename RANDOM = default_random_engine_type, typename T>
 	[[nodiscard]] auto index(T& cont, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		return std::distance(begin(cont), iterator(cont, rng));
 	}
 
-	template <typename RANDOM = std::default_random_engine, typename T, typename PRED>
+	template <typename RANDOM = default_random_engine_type, typename T, typename PRED>
 	[[nodiscard]] auto index_if(T& cont, PRED&& pred, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		return std::distance(begin(cont), iterator_if(cont, std::forward<PRED>(pred), rng));
 	}
 
-	template <typename RANDOM = std::default_random_engine, typename T>
+	template <typename RANDOM = default_random_engine_type, typename T>
 	[[nodiscard]] auto* element(T& cont, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		using std::end;
@@ -318,7 +685,7 @@ namespace ghassanpl::random
 		return (result != end(cont)) ? std::addressof(*result) : nullptr;
 	}
 	
-	template <typename RANDOM = std::default_random_engine, typename T, typename PRED>
+	template <typename RANDOM = default_random_engine_type, typename T, typename PRED>
 	[[nodiscard]] auto* element_if(T& cont, PRED&& predicate, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		using std::end;
@@ -335,7 +702,7 @@ namespace ghassanpl::random
 		return std::move(*element(v, ::ghassanpl::random::default_random_engine));
 	}
 
-	template <typename RANDOM = std::default_random_engine, typename T>
+	template <typename RANDOM = default_random_engine_type, typename T>
 	[[nodiscard]] auto one_of(std::initializer_list<T> values, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		if (values.size() == 0) throw std::invalid_argument("values");
@@ -347,7 +714,7 @@ namespace ghassanpl::random
 	/// TODO: template <typename T> T enum_value(enum_flags<T> set);
 	
 
-	template <typename RANDOM = std::default_random_engine, typename T>
+	template <typename RANDOM = default_random_engine_type, typename T>
 	[[nodiscard]] auto make_bag_randomizer(T& container, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		using Iterator = decltype(std::end(container));
@@ -371,7 +738,7 @@ namespace ghassanpl::random
 		return Randomizer{ rng, container };
 	}
 
-	/// When probability calculations are known ahead of time or expensive
+	/// When probability calculations are known ahead of time or expensive; when picking from the same options many times, use \ref alias_table
 	/// \complexity O(N) space, O(N+logN) time
 	/// TODO: Check if works with known-sized spans
 	template <typename T, typename RANDOM>
@@ -412,4 +779,194 @@ namespace ghassanpl::random
 		return end;
 	}
 
+	/// Picks indices with probabilities proportional to a fixed set of weights, in constant time, using Vose's alias method. Meant for
+	/// tables that are picked from many times, like loot or event tables.
+	/// \complexity O(N) space and construction time, O(1) time per pick
+	struct alias_table
+	{
+		alias_table() noexcept = default;
+
+		/// \param weights the weights of the indices (or of each element of `weights`, as returned by `weight_func`); they must be finite
+		/// and non-negative, and at least one of them must be positive
+		template <typename RANGE, typename FUNC = std::identity>
+		requires std::ranges::input_range<RANGE>
+		explicit alias_table(RANGE&& weights, FUNC&& weight_func = {})
+		{
+			std::vector<double> scaled;
+			double sum = 0;
+			for (auto&& item : weights)
+			{
+				const auto weight = double(std::invoke(weight_func, item));
+				if (!(weight >= 0) || !std::isfinite(weight))
+					throw std::invalid_argument("weights must be finite and non-negative");
+				scaled.push_back(weight);
+				sum += weight;
+			}
+			if (!(sum > 0) || !std::isfinite(sum))
+				throw std::invalid_argument("at least one weight must be positive, and their sum must be finite");
+			if (scaled.size() > std::numeric_limits<uint32_t>::max())
+				throw std::invalid_argument("too many weights");
+
+			const auto count = scaled.size();
+			m_buckets.resize(count);
+			m_rejection_threshold = (0 - uint64_t(count)) % count;
+
+			std::vector<uint32_t> small, large;
+			for (size_t i = 0; i < count; ++i)
+			{
+				scaled[i] = scaled[i] * double(count) / sum;
+				(scaled[i] < 1.0 ? small : large).push_back(uint32_t(i));
+			}
+
+			while (!small.empty() && !large.empty())
+			{
+				const auto less = small.back();
+				const auto more = large.back();
+				small.pop_back();
+				large.pop_back();
+				m_buckets[less] = { ToThreshold(scaled[less]), more };
+				scaled[more] = (scaled[more] + scaled[less]) - 1.0;
+				(scaled[more] < 1.0 ? small : large).push_back(more);
+			}
+
+			/// Whatever is left is (up to rounding errors) exactly 1
+			for (const auto index : large)
+				m_buckets[index] = { std::numeric_limits<uint64_t>::max(), index };
+			for (const auto index : small)
+				m_buckets[index] = { std::numeric_limits<uint64_t>::max(), index };
+		}
+
+		[[nodiscard]] size_t size() const noexcept { return m_buckets.size(); }
+		[[nodiscard]] bool empty() const noexcept { return m_buckets.empty(); }
+
+		/// Returns a random index in [0, `size()`), with probability proportional to its weight; uses a single 64-bit random value
+		/// almost always (which makes the probabilities exact to within `size()` / 2^64)
+		/// \pre `!empty()`
+		template <typename RANDOM = default_random_engine_type>
+		[[nodiscard]] size_t operator()(RANDOM& rng = ::ghassanpl::random::default_random_engine) const
+		{
+			const auto count = uint64_t(m_buckets.size());
+			auto product = detail::multiply_wide(detail::Bits64(rng), count);
+			while (product.low < m_rejection_threshold)
+				product = detail::multiply_wide(detail::Bits64(rng), count);
+			const auto& bucket = m_buckets[product.high];
+			return product.low < bucket.threshold ? size_t(product.high) : size_t(bucket.alias);
+		}
+
+		/// Fills `out` with random indices, as if by calling `operator()` for each element
+		/// \pre `!empty()`
+		template <typename RANDOM = default_random_engine_type>
+		void sample_n(std::span<size_t> out, RANDOM& rng = ::ghassanpl::random::default_random_engine) const
+		{
+			for (auto& index : out)
+				index = this->operator()(rng);
+		}
+
+	private:
+
+		/// The threshold and alias are kept together, so a pick touches a single cache line of the table
+		struct bucket
+		{
+			uint64_t threshold = 0;
+			uint32_t alias = 0;
+		};
+
+		std::vector<bucket> m_buckets;
+		uint64_t m_rejection_threshold = 0;
+
+		static uint64_t ToThreshold(double probability) noexcept
+		{
+			return probability >= 1.0 ? std::numeric_limits<uint64_t>::max() : uint64_t(probability * 0x1p64);
+		}
+	};
+
+	/// Copies `out.size()` distinct, randomly chosen elements of `range` (or all of them, if there are fewer) to `out`, keeping their
+	/// order in `range`, with each subset of elements equally likely; uses Robert Floyd's algorithm, so only needs one random number per
+	/// copied element
+	/// \returns the number of elements copied
+	/// \complexity O(k) expected time (plus O(k log k) when k is small relative to N), for k copied elements out of N
+	template <typename RANGE, typename OUTPUT, typename RANDOM = default_random_engine_type>
+	size_t sample_n(RANGE&& range, OUTPUT&& out, RANDOM& rng = ::ghassanpl::random::default_random_engine)
+	{
+		static_assert(std::ranges::random_access_range<RANGE> && std::ranges::sized_range<RANGE>, "sample_n needs a sized, random access range; use reservoir_sample for other ranges");
+		static_assert(std::ranges::random_access_range<OUTPUT> && std::ranges::sized_range<OUTPUT>, "out must be a sized, random access range");
+
+		const auto total = size_t(std::ranges::size(range));
+		const auto count = std::min(size_t(std::ranges::size(out)), total);
+		const auto first = std::ranges::begin(range);
+		const auto out_first = std::ranges::begin(out);
+
+		std::vector<size_t> chosen;
+		chosen.reserve(count);
+		/// When picking a sizeable part of the range, a bitmap is smaller and faster than a hash set
+		if (count >= total / 64)
+		{
+			std::vector<bool> taken(total);
+			for (auto j = total - count; j < total; ++j)
+			{
+				const auto candidate = size_t(integer_below(j + 1, rng));
+				taken[taken[candidate] ? j : candidate] = true;
+			}
+			for (size_t i = 0; i < total; ++i)
+				if (taken[i]) chosen.push_back(i);
+		}
+		else
+		{
+			std::unordered_set<size_t> taken;
+			taken.reserve(count);
+			for (auto j = total - count; j < total; ++j)
+			{
+				auto candidate = size_t(integer_below(j + 1, rng));
+				if (!taken.insert(candidate).second)
+					taken.insert(candidate = j);
+				chosen.push_back(candidate);
+			}
+			std::ranges::sort(chosen);
+		}
+
+		for (size_t i = 0; i < count; ++i)
+			out_first[i] = first[chosen[i]];
+		return count;
+	}
+
+	/// Fills `reservoir` with distinct, randomly chosen elements of `range` in a single pass, with each subset of elements equally likely,
+	/// without needing to know the size of `range`; if `range` has fewer elements than `reservoir`, all of them are copied. Uses Kim-Hung
+	/// Li's "Algorithm L", which skips over runs of elements that would not be chosen (in constant time for random access ranges).
+	/// The order of the chosen elements in `reservoir` is random.
+	/// \returns the number of elements copied
+	/// \complexity O(k (1 + log(N/k))) random numbers for k chosen elements out of N
+	template <typename RANGE, typename OUTPUT, typename RANDOM = default_random_engine_type>
+	size_t reservoir_sample(RANGE&& range, OUTPUT&& reservoir, RANDOM& rng = ::ghassanpl::random::default_random_engine)
+	{
+		static_assert(std::ranges::input_range<RANGE>, "range must be an input range");
+		static_assert(std::ranges::random_access_range<OUTPUT> && std::ranges::sized_range<OUTPUT>, "reservoir must be a sized, random access range");
+
+		auto it = std::ranges::begin(range);
+		const auto end = std::ranges::end(range);
+		const auto count = size_t(std::ranges::size(reservoir));
+		const auto slots = std::ranges::begin(reservoir);
+
+		size_t filled = 0;
+		for (; filled < count && it != end; ++it)
+			slots[filled++] = *it;
+		if (filled < count || count == 0)
+			return filled;
+
+		/// `log_weight` is the log of the largest of the `count` random keys of the chosen elements, had each element been given
+		/// a uniform random key and the ones with the smallest keys chosen
+		auto log_weight = std::log(detail::OpenPercentage(rng)) / double(count);
+		while (true)
+		{
+			const auto skip = std::floor(std::log(detail::OpenPercentage(rng)) / std::log1p(-std::exp(log_weight)));
+			if (!(skip < 0x1p62))
+				break;
+			it = std::ranges::next(std::move(it), std::ranges::range_difference_t<RANGE>(skip), end);
+			if (it == end)
+				break;
+			slots[integer_below(count, rng)] = *it;
+			++it;
+			log_weight += std::log(detail::OpenPercentage(rng)) / double(count);
+		}
+		return count;
+	}
 }
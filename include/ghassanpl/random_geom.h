@@ -6,7 +6,9 @@
 
 #include "random.h"
 #include "rec2.h"
+#include "simd.h"
 #include "geometry/ellipse.h"
+#include "geometry/circle.h"
 #include "geometry/polygon.h"
 #include "geometry/shape_concepts.h"
 #include <glm/ext/scalar_constants.hpp>
@@ -16,48 +18,54 @@
 
 namespace ghassanpl::random
 {
-	template <std::floating_point T = float, typename RANDOM = std::default_random_engine>
+	template <std::floating_point T = float, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] T radians(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		static std::uniform_real_distribution<T> dist{ T{}, glm::pi<T>() * 2 };
 		return dist(rng);
 	}
 
-	template <std::floating_point T = float, typename RANDOM = std::default_random_engine>
+	template <std::floating_point T = float, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] T degrees(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		static std::uniform_real_distribution<T> dist{ T{}, T{360} };
 		return dist(rng);
 	}
 
-	template <std::floating_point T = float, typename RANDOM = std::default_random_engine>
+	template <std::floating_point T = float, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] glm::tvec2<T> unit_vector(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		return glm::rotate(glm::tvec2<T>{ T{ 1 }, T{ 0 } }, radians<T>(rng));
 	}
 
-	template <typename T, typename RANDOM = std::default_random_engine>
+	template <typename T, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] glm::tvec2<T> point_in(trec2<T> const& rect, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		return { in_range(rect.p1.x, rect.p2.x, rng), in_range(rect.p1.y, rect.p2.y, rng) };
 	}
 
-	template <typename T, typename RANDOM = std::default_random_engine>
+	template <typename T, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] glm::tvec2<T> point_in(glm::tvec2<T> const& max, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		return { in_range(T{}, max.x, rng), in_range(T{}, max.y, rng) };
 	}
 
-	/// TODO: This doesn't seem uniform
-	template <typename T, typename RANDOM = std::default_random_engine>
+	/// The square root of the radial fraction makes the points uniformly distributed over the area, rather than bunched up at the center
+	template <typename T, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] glm::tvec2<T> point_in(geometry::tellipse<T> const& el, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
-		const auto phi = between(T{}, glm::two_pi<T>(), rng);
-		const auto p = glm::tvec2<T>{ cos(phi), sin(phi) } * glm::sqrt(percentage<T>(rng)) * el.radii * T(0.5);
+		const auto phi = in_range(T{}, glm::two_pi<T>(), rng);
+		const auto p = glm::tvec2<T>{ std::cos(phi), std::sin(phi) } * glm::sqrt(percentage<T>(rng)) * el.radii;
 		return p + el.center;
 	}
 
-	template <typename T, typename RANDOM = std::default_random_engine>
+	template <typename T, typename RANDOM = default_random_engine_type>
+	[[nodiscard]] glm::tvec2<T> point_in(geometry::tcircle<T> const& circle, RANDOM& rng = ::ghassanpl::random::default_random_engine)
+	{
+		return point_in(geometry::tellipse<T>{ circle.center, { circle.radius, circle.radius } }, rng);
+	}
+
+	template <typename T, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] glm::tvec2<T> point_in(geometry::ttriangle<T> const& tr, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		const auto r1 = glm::sqrt(percentage<T>(rng));
@@ -66,12 +74,12 @@ namespace ghassanpl::random
 		return (tr.a * (T(1) - r1) + tr.b * (r1 * (T(1) - r2)) + tr.c * (r2 * r1));
 	}
 
-	template <typename T, typename RANDOM = std::default_random_engine>
+	template <typename T, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] glm::tvec2<T> point_in(geometry::immutable::tpolygon<T> const& poly, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		if (poly.triangles().empty()) return {};
 
-		auto r = between(T{}, poly.calculate_area());
+		auto r = in_range(T{}, poly.calculate_area(), rng);
 		size_t i = 0;
 		while (r > 0.0)
 		{
@@ -88,13 +96,225 @@ namespace ghassanpl::random
 	}
 
 	/// \brief Returns a random point on the edge of the shape.
-	template <typename T, geometry::shape<T> S, typename RANDOM = std::default_random_engine>
+	template <typename T, geometry::shape<T> S, typename RANDOM = default_random_engine_type>
 	[[nodiscard]] glm::tvec2<T> point_on(S const& shape, RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		return shape.edge_point_alpha(percentage(rng));
 	}
 
-	/// TODO: in(circle), in(poly)?, on(rect), on(circle), on(arc)
+	namespace detail
+	{
+		/// Batches of points are made in chunks of this many, so the random numbers and intermediate values stay in the L1 cache
+		inline constexpr size_t point_chunk_size = 256;
+
+		/// Fills `out` with uniformly distributed values in [0, 1), making two floats out of every 64-bit random value
+		template <typename T, typename RANDOM>
+		void FillUniform(std::span<T> out, RANDOM& rng)
+		{
+			size_t i = 0;
+			if constexpr (std::same_as<T, float> && gives_64_bits<RANDOM>)
+			{
+				for (; i + 2 <= out.size(); i += 2)
+				{
+					const auto bits = uint64_t(rng());
+					out[i] = uniform_float_from_bits(uint32_t(bits));
+					out[i + 1] = uniform_float_from_bits(uint32_t(bits >> 32));
+				}
+			}
+			for (; i < out.size(); ++i)
+				out[i] = percentage<T>(rng);
+		}
+
+		using simd::ForEachLaneGroup;
+		using simd::SinCosTurns;
+
+		/// Fills `out` chunk by chunk: for each chunk, `chunk_func(u, v, xs, ys, count)` gets `count` uniform values in `u` and `v`,
+		/// and writes the coordinates of the points to `xs` and `ys`
+		template <typename T, typename RANDOM, typename FUNC>
+		void FillPointsInChunks(std::span<glm::tvec2<T>> out, RANDOM& rng, FUNC const& chunk_func)
+		{
+			std::array<T, point_chunk_size> u, v, xs, ys;
+			for (size_t first = 0; first < out.size(); first += point_chunk_size)
+			{
+				const auto count = std::min(point_chunk_size, out.size() - first);
+				FillUniform(std::span{ u }.first(count), rng);
+				FillUniform(std::span{ v }.first(count), rng);
+				chunk_func(u.data(), v.data(), xs.data(), ys.data(), count);
+				for (size_t i = 0; i < count; ++i)
+					out[first + i] = { xs[i], ys[i] };
+			}
+		}
+
+		/// Replaces the values with their square roots
+		template <typename T>
+		void SqrtInPlace(T* values, size_t count) noexcept
+		{
+			ForEachLaneGroup<T>(count, [&]<typename L>(L, size_t i) { L::store(L::sqrt(L::load(values + i)), values + i); });
+		}
+
+		/// A triangle as a corner and two edges, so that a point in it is `a + r1 * (ab + r2 * bc)` for `r1` = sqrt(u) and `r2` = v
+		template <typename T>
+		struct sampled_triangle
+		{
+			glm::tvec2<T> a;
+			glm::tvec2<T> ab;
+			glm::tvec2<T> bc;
+
+			sampled_triangle() noexcept = default;
+			explicit sampled_triangle(geometry::ttriangle<T> const& triangle) noexcept : a(triangle.a), ab(triangle.b - triangle.a), bc(triangle.c - triangle.b) {}
+
+			/// The cross product is exact for degenerate triangles, where Heron's formula can end up as the root of a negative number
+			[[nodiscard]] T area() const noexcept { return std::abs(ab.x * bc.y - ab.y * bc.x) * T(0.5); }
+			[[nodiscard]] glm::tvec2<T> at(T r1, T r2) const noexcept { return a + r1 * (ab + r2 * bc); }
+		};
+	}
+
+	/// Fills `out` with uniformly distributed points in `rect`
+	template <typename T, typename RANDOM = default_random_engine_type>
+	void points_in(trec2<T> const& rect, std::type_identity_t<std::span<glm::tvec2<T>>> out, RANDOM& rng = ::ghassanpl::random::default_random_engine)
+	{
+		const auto size = rect.p2 - rect.p1;
+		detail::FillPointsInChunks(out, rng, [&](T const* u, T const* v, T* xs, T* ys, size_t count) {
+			for (size_t i = 0; i < count; ++i)
+			{
+				xs[i] = rect.p1.x + size.x * u[i];
+				ys[i] = rect.p1.y + size.y * v[i];
+			}
+		});
+	}
+
+	/// Fills `out` with uniformly distributed points in `el`; the square roots, sines and cosines are calculated several at a time
+	template <typename T, typename RANDOM = default_random_engine_type>
+	void points_in(geometry::tellipse<T> const& el, std::type_identity_t<std::span<glm::tvec2<T>>> out, RANDOM& rng = ::ghassanpl::random::default_random_engine)
+	{
+		detail::FillPointsInChunks(out, rng, [&](T const* u, T const* v, T* xs, T* ys, size_t count) {
+			detail::ForEachLaneGroup<T>(count, [&]<typename L>(L, size_t i) {
+				typename L::f sine, cosine;
+				detail::SinCosTurns<L>(L::load(v + i), sine, cosine);
+				const auto radius = L::sqrt(L::load(u + i));
+				L::store(L::broadcast(el.center.x) + L::broadcast(el.radii.x) * radius * cosine, xs + i);
+				L::store(L::broadcast(el.center.y) + L::broadcast(el.radii.y) * radius * sine, ys + i);
+			});
+		});
+	}
+
+	/// Fills `out` with uniformly distributed points in `circle`
+	template <typename T, typename RANDOM = default_random_engine_type>
+	void points_in(geometry::tcircle<T> const& circle, std::type_identity_t<std::span<glm::tvec2<T>>> out, RANDOM& rng = ::ghassanpl::random::default_random_engine)
+	{
+		points_in(geometry::tellipse<T>{ circle.center, { circle.radius, circle.radius } }, out, rng);
+	}
+
+	/// Fills `out` with uniformly distributed points in `tr`
+	template <typename T, typename RANDOM = default_random_engine_type>
+	void points_in(geometry::ttriangle<T> const& tr, std::type_identity_t<std::span<glm::tvec2<T>>> out, RANDOM& rng = ::ghassanpl::random::default_random_engine)
+	{
+		const detail::sampled_triangle<T> triangle{ tr };
+		detail::FillPointsInChunks(out, rng, [&](T* u, T const* v, T* xs, T* ys, size_t count) {
+			detail::SqrtInPlace(u, count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const auto point = triangle.at(u[i], v[i]);
+				xs[i] = point.x;
+				ys[i] = point.y;
+			}
+		});
+	}
+
+	/// Samples uniformly distributed points in a set of triangles, e.g. a triangulated polygon. The triangles are picked by area with an
+	/// \ref alias_table built once, so every point takes constant time, however many triangles there are.
+	template <std::floating_point T = float>
+	struct area_sampler
+	{
+		using tvec = glm::tvec2<T>;
+
+		area_sampler() noexcept = default;
+
+		/// \throws std::invalid_argument if the triangles have no area
+		explicit area_sampler(std::span<geometry::ttriangle<T> const> triangles)
+		{
+			m_triangles.reserve(triangles.size());
+			for (auto const& triangle : triangles)
+				m_triangles.emplace_back(triangle);
+			BuildPicker();
+		}
+
+		/// \param vertices a random access range of points, like the vertices of a polygon, or the points of a Delaunay triangulation
+		/// \param triangles triangles, as indices into `vertices`
+		template <std::ranges::random_access_range VERTICES, std::integral IDX>
+		area_sampler(VERTICES const& vertices, std::span<geometry::tindexed_triangle<IDX> const> triangles)
+		{
+			m_triangles.reserve(triangles.size());
+			for (auto const& triangle : triangles)
+				m_triangles.emplace_back(triangle.as_triangle(vertices));
+			BuildPicker();
+		}
+
+		/// Samples the triangulation of `poly`
+		explicit area_sampler(geometry::immutable::tpolygon<T> const& poly)
+			: area_sampler(poly.polygon().vertices, std::span{ poly.triangles() })
+		{
+		}
+
+		/// Samples a \ref geometry::polygon_triangulation or \ref geometry::triangulated_polygon
+		template <typename TRIANGULATION>
+		requires requires (TRIANGULATION const& tr) { tr.poly.vertices; tr.triangles; }
+		explicit area_sampler(TRIANGULATION const& triangulation)
+			: area_sampler(triangulation.poly.vertices, std::span{ triangulation.triangles })
+		{
+		}
+
+		[[nodiscard]] size_t triangle_count() const noexcept { return m_triangles.size(); }
+
+		/// Returns a uniformly distributed point in the triangles
+		/// \pre `triangle_count() > 0`
+		template <typename RANDOM = default_random_engine_type>
+		[[nodiscard]] tvec operator()(RANDOM& rng = ::ghassanpl::random::default_random_engine) const
+		{
+			auto const& triangle = m_triangles[m_picker(rng)];
+			const auto r1 = std::sqrt(percentage<T>(rng));
+			return triangle.at(r1, percentage<T>(rng));
+		}
+
+		/// Fills `out` with uniformly distributed points in the triangles
+		/// \pre `triangle_count() > 0`
+		template <typename RANDOM = default_random_engine_type>
+		void fill(std::span<tvec> out, RANDOM& rng = ::ghassanpl::random::default_random_engine) const
+		{
+			std::array<size_t, detail::point_chunk_size> picks;
+			detail::FillPointsInChunks(out, rng, [&](T* u, T const* v, T* xs, T* ys, size_t count) {
+				m_picker.sample_n(std::span{ picks }.first(count), rng);
+				detail::SqrtInPlace(u, count);
+				for (size_t i = 0; i < count; ++i)
+				{
+					const auto point = m_triangles[picks[i]].at(u[i], v[i]);
+					xs[i] = point.x;
+					ys[i] = point.y;
+				}
+			});
+		}
+
+	private:
+
+		std::vector<detail::sampled_triangle<T>> m_triangles;
+		alias_table m_picker;
+
+		void BuildPicker()
+		{
+			m_picker = alias_table{ m_triangles, [](auto const& triangle) { return triangle.area(); } };
+		}
+	};
+
+	/// Fills `out` with uniformly distributed points in `poly`; builds an \ref area_sampler, so when sampling the same polygon
+	/// repeatedly, keep one of those instead
+	template <typename T, typename RANDOM = default_random_engine_type>
+	void points_in(geometry::immutable::tpolygon<T> const& poly, std::type_identity_t<std::span<glm::tvec2<T>>> out, RANDOM& rng = ::ghassanpl::random::default_random_engine)
+	{
+		if (out.empty() || poly.triangles().empty()) return;
+		area_sampler<T>{ poly }.fill(out, rng);
+	}
+
+	/// TODO: on(rect), on(circle), on(arc)
 	/*
 	template <typename T>
 	auto RandomNotIn(ghassanpl::trec2<T> const& verboten, ghassanpl::trec2<T> const& bounds)
@@ -121,7 +341,7 @@ namespace ghassanpl::random
 	}
 	*/
 
-	template <typename RANDOM = std::default_random_engine>
+	template <typename RANDOM = default_random_engine_type>
 	[[nodiscard]] glm::ivec2 neighbor(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		static std::uniform_int_distribution<typename RANDOM::result_type> dist{ 0, 3 };
@@ -135,7 +355,7 @@ namespace ghassanpl::random
 		return {};
 	}
 
-	template <typename RANDOM = std::default_random_engine>
+	template <typename RANDOM = default_random_engine_type>
 	[[nodiscard]] glm::ivec2 diagonal_neighbor(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		static std::uniform_int_distribution<typename RANDOM::result_type> dist{ 0, 3 };
@@ -149,7 +369,7 @@ namespace ghassanpl::random
 		return {};
 	}
 
-	template <typename RANDOM = std::default_random_engine>
+	template <typename RANDOM = default_random_engine_type>
 	[[nodiscard]] glm::ivec2 surrounding(RANDOM& rng = ::ghassanpl::random::default_random_engine)
 	{
 		static std::uniform_int_distribution<typename RANDOM::result_type> dist{ 0, 7 };
@@ -176,4 +396,113 @@ namespace ghassanpl::random
 		return { halton_sequence<T>(index, base_x), halton_sequence<T>(index, base_y) };
 	}
 
-}
\ No newline at end of file
+	/// Places points at random in `shape` (a rectangle, or any area shape, like a circle or polygon), so that no two are closer than
+	/// `min_distance`, and until no more can be added: the "blue noise" distribution, which looks natural when scattering things like
+	/// foliage. Uses Robert Bridson's algorithm, with a background grid so that each candidate point is only checked against a few neighbours.
+	/// Parts of the shape that cannot be reached from the first point are found by trying random points in its bounding box.
+	/// \param max_attempts how many candidate points to try around each point before giving up on it; more gives denser packings
+	/// \complexity O(N) for N points
+	template <typename T, typename S, typename RANDOM = default_random_engine_type>
+	[[nodiscard]] std::vector<glm::tvec2<T>> poisson_disc_points(S const& shape, T min_distance, RANDOM& rng = ::ghassanpl::random::default_random_engine, unsigned max_attempts = 30)
+	{
+		using tvec = glm::tvec2<T>;
+
+		if (!(min_distance > 0))
+			throw std::invalid_argument("min_distance must be positive");
+
+		trec2<T> bounds;
+		if constexpr (std::same_as<S, trec2<T>>)
+			bounds = shape;
+		else
+			bounds = shape.bounding_box();
+		const auto size = bounds.p2 - bounds.p1;
+		if (!(size.x > 0) || !(size.y > 0))
+			return {};
+
+		/// A cell this size can contain at most one point
+		const auto cell_size = min_distance / std::sqrt(T(2));
+		const auto columns = size_t(std::ceil(size.x / cell_size)) + 1;
+		const auto rows = size_t(std::ceil(size.y / cell_size)) + 1;
+		constexpr auto empty_cell = std::numeric_limits<uint32_t>::max();
+		std::vector<uint32_t> grid(columns * rows, empty_cell);
+
+		std::vector<tvec> points;
+		std::vector<uint32_t> active;
+		const auto min_distance_squared = min_distance * min_distance;
+
+		const auto cell_of = [&](tvec point) {
+			const auto column = std::min(size_t(std::max(T(0), (point.x - bounds.p1.x) / cell_size)), columns - 1);
+			const auto row = std::min(size_t(std::max(T(0), (point.y - bounds.p1.y) / cell_size)), rows - 1);
+			return std::pair{ column, row };
+		};
+
+		const auto fits = [&](tvec point) {
+			if (!bounds.contains(point) || !shape.contains(point))
+				return false;
+			const auto [column, row] = cell_of(point);
+			for (auto y = row > 2 ? row - 2 : 0, last_y = std::min(row + 2, rows - 1); y <= last_y; ++y)
+			{
+				for (auto x = column > 2 ? column - 2 : 0, last_x = std::min(column + 2, columns - 1); x <= last_x; ++x)
+				{
+					if (const auto other = grid[y * columns + x]; other != empty_cell)
+					{
+						const auto d = points[other] - point;
+						if (glm::dot(d, d) < min_distance_squared)
+							return false;
+					}
+				}
+			}
+			return true;
+		};
+
+		const auto add = [&](tvec point) {
+			const auto [column, row] = cell_of(point);
+			grid[row * columns + column] = uint32_t(points.size());
+			active.push_back(uint32_t(points.size()));
+			points.push_back(point);
+		};
+
+		while (true)
+		{
+			if (active.empty())
+			{
+				bool seeded = false;
+				for (unsigned attempt = 0; attempt < max_attempts && !seeded; ++attempt)
+				{
+					const auto candidate = bounds.p1 + size * tvec{ percentage<T>(rng), percentage<T>(rng) };
+					if (fits(candidate))
+					{
+						add(candidate);
+						seeded = true;
+					}
+				}
+				if (!seeded)
+					break;
+			}
+
+			const auto slot = size_t(integer_below(active.size(), rng));
+			const auto center = points[active[slot]];
+			bool added = false;
+			for (unsigned attempt = 0; attempt < max_attempts && !added; ++attempt)
+			{
+				/// Uniformly distributed in the annulus between `min_distance` and twice that
+				const auto distance = min_distance * std::sqrt(T(1) + T(3) * percentage<T>(rng));
+				typename simd::scalar_lanes<T>::f sine, cosine;
+				detail::SinCosTurns<simd::scalar_lanes<T>>({ percentage<T>(rng) }, sine, cosine);
+				const auto candidate = center + distance * tvec{ cosine.v, sine.v };
+				if (fits(candidate))
+				{
+					add(candidate);
+					added = true;
+				}
+			}
+			if (!added)
+			{
+				active[slot] = active.back();
+				active.pop_back();
+			}
+		}
+
+		return points;
+	}
+}
@@ -7,6 +7,10 @@
 #include "random.h"
 //#include "hashes.h"
 #include "noise.h"
+#include "simd.h"
+#include "parallel.h"
+#include <bit>
+#include <utility>
 
 namespace ghassanpl::noise
 {
@@ -140,6 +144,335 @@ namespace ghassanpl::random
 		return uint64_t(ctrPair.first) | (uint64_t(ctrPair.second) << 32ULL);
 	}
 
+	namespace detail
+	{
+		inline constexpr uint32_t philox_multiplier = 0xd256d193;
+		inline constexpr uint32_t philox_key_increment = 0x9E3779B9;
+
+		/// Fills are split into chunks of this many values, spread over threads
+		inline constexpr size_t fill_chunk_size = size_t(1) << 16;
+
+		/// Calls `func(first, count)` for consecutive chunks of [0, `count`), spread over `thread_count` threads (0 meaning one per hardware thread)
+		template <typename FUNC>
+		void ForEachChunk(size_t count, unsigned thread_count, FUNC const& func)
+		{
+			parallel_for_each_index((count + fill_chunk_size - 1) / fill_chunk_size, thread_count, [&](size_t chunk) {
+				const auto first = chunk * fill_chunk_size;
+				func(first, std::min(fill_chunk_size, count - first));
+			});
+		}
+
+		/// Each lane set holds one 64-bit Philox counter per lane, laid out like the 64-bit result (first word low), so a round is a single
+		/// `mul_epu32` of the low words, and the results can be stored directly
+#if GHPL_HAS_AVX2
+		struct philox_avx2
+		{
+			using v = __m256i;
+			static constexpr size_t width = 4;
+
+			static v counters(uint64_t first) noexcept { return _mm256_add_epi64(_mm256_set1_epi64x(int64_t(first)), _mm256_setr_epi64x(0, 1, 2, 3)); }
+			static v key(uint32_t key) noexcept { return _mm256_set1_epi64x(int64_t(key)); }
+			static v round(v counters, v key) noexcept
+			{
+				const auto product = _mm256_mul_epu32(counters, _mm256_set1_epi64x(philox_multiplier));
+				const auto first = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(product, 32), _mm256_srli_epi64(counters, 32)), key);
+				return _mm256_or_si256(first, _mm256_slli_epi64(product, 32));
+			}
+			static void store(v values, uint64_t* out) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), values); }
+			static void store_floats(v values, float* out) noexcept
+			{
+				_mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(values, 8)), _mm256_set1_ps(0x1p-24f)));
+			}
+			static void store_doubles(v values, double* out) noexcept
+			{
+				const auto in_one_to_two = _mm256_or_si256(_mm256_srli_epi64(values, 12), _mm256_set1_epi64x(0x3FF0000000000000LL));
+				_mm256_storeu_pd(out, _mm256_sub_pd(_mm256_castsi256_pd(in_one_to_two), _mm256_set1_pd(1.0)));
+			}
+		};
+#endif
+
+#if GHPL_HAS_SSE2
+		struct philox_sse2
+		{
+			using v = __m128i;
+			static constexpr size_t width = 2;
+
+			static v counters(uint64_t first) noexcept { return _mm_add_epi64(_mm_set1_epi64x(int64_t(first)), _mm_set_epi64x(1, 0)); }
+			static v key(uint32_t key) noexcept { return _mm_set1_epi64x(int64_t(key)); }
+			static v round(v counters, v key) noexcept
+			{
+				const auto product = _mm_mul_epu32(counters, _mm_set1_epi64x(philox_multiplier));
+				const auto first = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi64(product, 32), _mm_srli_epi64(counters, 32)), key);
+				return _mm_or_si128(first, _mm_slli_epi64(product, 32));
+			}
+			static void store(v values, uint64_t* out) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(out), values); }
+			static void store_floats(v values, float* out) noexcept
+			{
+				_mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(values, 8)), _mm_set1_ps(0x1p-24f)));
+			}
+			static void store_doubles(v values, double* out) noexcept
+			{
+				const auto in_one_to_two = _mm_or_si128(_mm_srli_epi64(values, 12), _mm_set1_epi64x(0x3FF0000000000000LL));
+				_mm_storeu_pd(out, _mm_sub_pd(_mm_castsi128_pd(in_one_to_two), _mm_set1_pd(1.0)));
+			}
+		};
+#endif
+
+#if GHPL_HAS_AVX2
+		using philox_lanes = philox_avx2;
+#elif GHPL_HAS_SSE2
+		using philox_lanes = philox_sse2;
+#endif
+
+		/// Number of registers of counters in flight per iteration, to hide the latency of the multiplies
+		inline constexpr size_t philox_interleave = 4;
+
+		/// Evaluates philox64 for `blocks` blocks of `philox_interleave * width` consecutive counters starting at `first`, calling
+		/// `store(block_index, counters)` with each finished block
+		template <typename P, typename STORE>
+		void PhiloxBlocks(uint32_t key, uint64_t first, size_t blocks, STORE&& store) noexcept
+		{
+			typename P::v round_keys[10];
+			for (auto& round_key : round_keys)
+			{
+				round_key = P::key(key);
+				key += philox_key_increment;
+			}
+
+			/// Unrolled by hand, as compilers tend to keep the counters in memory otherwise
+			[&]<size_t... J>(std::index_sequence<J...>) {
+				for (size_t block = 0; block < blocks; ++block)
+				{
+					typename P::v counters[] = { P::counters(first + (block * philox_interleave + J) * P::width)... };
+					for (auto const& round_key : round_keys)
+						((counters[J] = P::round(counters[J], round_key)), ...);
+					store(block, counters);
+				}
+			}(std::make_index_sequence<philox_interleave>{});
+		}
+
+		/// Calls `kernel.template operator()<P>(blocks, done)` with the number of whole blocks of `count` counters, and returns how many
+		/// counters those cover, so the caller can finish the rest with scalar code
+		template <typename KERNEL>
+		size_t PhiloxVectorized([[maybe_unused]] size_t count, [[maybe_unused]] KERNEL&& kernel) noexcept
+		{
+#if GHPL_HAS_AVX2 || GHPL_HAS_SSE2
+			constexpr size_t block_size = philox_interleave * philox_lanes::width;
+			const auto blocks = count / block_size;
+			kernel.template operator()<philox_lanes>(blocks);
+			return blocks * block_size;
+#else
+			return 0;
+#endif
+		}
+
+		inline void PhiloxSpan(uint32_t key, uint64_t first, std::span<uint64_t> out) noexcept
+		{
+			auto done = PhiloxVectorized(out.size(), [&]<typename P>(size_t blocks) {
+				PhiloxBlocks<P>(key, first, blocks, [&](size_t block, auto const& counters) {
+					for (size_t j = 0; j < philox_interleave; ++j)
+						P::store(counters[j], out.data() + (block * philox_interleave + j) * P::width);
+				});
+			});
+			for (; done < out.size(); ++done)
+				out[done] = philox64(first + done, key);
+		}
+
+		/// Floats `2i` and `2i + 1` are made from the low and high words of counter `first + i`
+		inline void PhiloxFloatSpan(uint32_t key, uint64_t first, std::span<float> out) noexcept
+		{
+			const auto done_counters = PhiloxVectorized(out.size() / 2, [&]<typename P>(size_t blocks) {
+				PhiloxBlocks<P>(key, first, blocks, [&](size_t block, auto const& counters) {
+					for (size_t j = 0; j < philox_interleave; ++j)
+						P::store_floats(counters[j], out.data() + (block * philox_interleave + j) * P::width * 2);
+				});
+			});
+			for (auto i = done_counters * 2; i < out.size(); i += 2)
+			{
+				const auto bits = philox64(first + i / 2, key);
+				out[i] = uniform_float_from_bits(uint32_t(bits));
+				if (i + 1 < out.size())
+					out[i + 1] = uniform_float_from_bits(uint32_t(bits >> 32));
+			}
+		}
+
+		inline void PhiloxDoubleSpan(uint32_t key, uint64_t first, std::span<double> out) noexcept
+		{
+			auto done = PhiloxVectorized(out.size(), [&]<typename P>(size_t blocks) {
+				PhiloxBlocks<P>(key, first, blocks, [&](size_t block, auto const& counters) {
+					for (size_t j = 0; j < philox_interleave; ++j)
+						P::store_doubles(counters[j], out.data() + (block * philox_interleave + j) * P::width);
+				});
+			});
+			for (; done < out.size(); ++done)
+				out[done] = uniform_double_from_bits(philox64(first + done, key));
+		}
+
+		/// The same operations as \ref noise::SquirrelNoise5, on every lane
+		template <typename L>
+		typename L::i SquirrelNoise5(uint32_t seed, typename L::i position) noexcept
+		{
+			const auto constant = [](uint32_t value) { return L::broadcast(std::bit_cast<int32_t>(value)); };
+			auto bits = position * constant(0xd2a80a3f);
+			bits = bits + constant(seed);
+			bits = bits ^ L::template shift_right<9>(bits);
+			bits = bits + constant(0xa884f197);
+			bits = bits ^ L::template shift_right<11>(bits);
+			bits = bits * constant(0x6C736F4B);
+			bits = bits ^ L::template shift_right<13>(bits);
+			bits = bits + constant(0xB79F3ABB);
+			bits = bits ^ L::template shift_right<15>(bits);
+			bits = bits * constant(0x1b56c4f5);
+			bits = bits ^ L::template shift_right<17>(bits);
+			return bits;
+		}
+
+		inline void SquirrelSpan(uint32_t seed, uint32_t first_position, std::span<uint32_t> out) noexcept
+		{
+			using L = simd::batch_lanes<float>;
+			size_t i = 0;
+			for (; i + L::width <= out.size(); i += L::width)
+				L::store(SquirrelNoise5<L>(seed, L::broadcast(std::bit_cast<int32_t>(uint32_t(first_position + i))) + L::lane_indices()), out.data() + i);
+			for (; i < out.size(); ++i)
+				out[i] = noise::SquirrelNoise5(seed, std::bit_cast<int32_t>(uint32_t(first_position + i)));
+		}
+	}
+
+	/// Fills `out` with `philox64(start_index + i, key)`, computing several counters per SIMD instruction where available
+	/// \param thread_count number of threads to spread the work over; 0 means one per hardware thread
+	inline void philox_fill(uint32_t key, uint64_t start_index, std::span<uint64_t> out, unsigned thread_count = 0)
+	{
+		detail::ForEachChunk(out.size(), thread_count, [&](size_t first, size_t count) {
+			detail::PhiloxSpan(key, start_index + first, out.subspan(first, count));
+		});
+	}
+
+	/// Fills `out` with uniformly distributed floats in [0, 1), two per Philox counter: elements `2i` and `2i + 1` are made from
+	/// the low and high words of `philox64(start_index + i, key)` by \ref uniform_float_from_bits
+	/// \param thread_count number of threads to spread the work over; 0 means one per hardware thread
+	inline void fill_uniform_float(uint32_t key, uint64_t start_index, std::span<float> out, unsigned thread_count = 0)
+	{
+		/// Chunks start at even elements, so they always start at a whole counter
+		detail::ForEachChunk(out.size(), thread_count, [&](size_t first, size_t count) {
+			detail::PhiloxFloatSpan(key, start_index + first / 2, out.subspan(first, count));
+		});
+	}
+
+	/// Fills `out` with uniformly distributed doubles in [0, 1), element `i` being `uniform_double_from_bits(philox64(start_index + i, key))`
+	/// \param thread_count number of threads to spread the work over; 0 means one per hardware thread
+	inline void fill_uniform_double(uint32_t key, uint64_t start_index, std::span<double> out, unsigned thread_count = 0)
+	{
+		detail::ForEachChunk(out.size(), thread_count, [&](size_t first, size_t count) {
+			detail::PhiloxDoubleSpan(key, start_index + first, out.subspan(first, count));
+		});
+	}
+
+	/// Fills `out` with `noise::SquirrelNoise5(seed, start_position + i)`, the position wrapping around like a 32-bit integer
+	/// \param thread_count number of threads to spread the work over; 0 means one per hardware thread
+	inline void squirrel_fill(uint32_t seed, int32_t start_position, std::span<uint32_t> out, unsigned thread_count = 0)
+	{
+		detail::ForEachChunk(out.size(), thread_count, [&](size_t first, size_t count) {
+			detail::SquirrelSpan(seed, uint32_t(start_position) + uint32_t(first), out.subspan(first, count));
+		});
+	}
+
+	namespace detail
+	{
+		/// Parallel shuffles split the values into a power-of-two number of blocks, each with at least this many values; there are at most
+		/// `max_shuffle_blocks` blocks, as every level of merging blocks is another pass over all the values
+		inline constexpr size_t shuffle_block_size = size_t(1) << 16;
+		inline constexpr size_t max_shuffle_blocks = 64;
+
+		/// Hands out the bits of 64-bit random values one at a time
+		template <typename RANDOM>
+		struct BitSource
+		{
+			RANDOM& rng;
+			uint64_t bits = 0;
+			int left = 0;
+
+			bool operator()()
+			{
+				if (left == 0)
+				{
+					bits = Bits64(rng);
+					left = 64;
+				}
+				--left;
+				const bool result = bits & 1;
+				bits >>= 1;
+				return result;
+			}
+		};
+
+		/// The merge step of MergeShuffle (Bacher, Bodini, Hollender and Lumbroso): if [0, `middle`) and [`middle`, `values.size()`)
+		/// are uniformly shuffled, so will be all of `values`
+		template <typename T, typename RANDOM>
+		void MergeShuffled(std::span<T> values, size_t middle, RANDOM& rng)
+		{
+			const auto count = values.size();
+			size_t i = 0, j = middle;
+			BitSource<RANDOM> bit{ rng };
+			while (true)
+			{
+				if (bit())
+				{
+					if (j == count) break;
+					std::ranges::swap(values[i], values[j++]);
+				}
+				else if (i == j)
+					break;
+				++i;
+			}
+			/// One of the halves ran out; the remaining values are inserted at random positions
+			for (; i < count; ++i)
+				std::ranges::swap(values[i], values[size_t(integer_below(i + 1, rng))]);
+		}
+
+		/// Shuffles blocks of `values` on separate threads, then merges neighbouring blocks, again on separate threads, until the whole
+		/// span is merged. Block `b` is shuffled with `pcg64_engine{ seed, b }`, and every merge uses a stream of its own too, so the
+		/// result does not depend on the number of threads.
+		template <typename T>
+		void MergeShuffle(std::span<T> values, uint64_t seed, size_t block_size, unsigned thread_count)
+		{
+			const auto count = values.size();
+			size_t block_count = 1;
+			while (block_count < max_shuffle_blocks && count / (block_count * 2) >= block_size)
+				block_count *= 2;
+
+			const auto block_start = [&](size_t block) { return (count / block_count) * block + std::min(block, count % block_count); };
+
+			parallel_for_each_index(block_count, thread_count, [&](size_t block) {
+				pcg64_engine rng{ seed, block };
+				std::shuffle(values.begin() + block_start(block), values.begin() + block_start(block + 1), rng);
+			});
+
+			uint64_t first_stream = block_count;
+			for (size_t width = 2; width <= block_count; width *= 2)
+			{
+				parallel_for_each_index(block_count / width, thread_count, [&](size_t merge) {
+					pcg64_engine rng{ seed, first_stream + merge };
+					const auto first = block_start(merge * width);
+					const auto middle = block_start(merge * width + width / 2);
+					const auto last = block_start(merge * width + width);
+					MergeShuffled(values.subspan(first, last - first), middle - first, rng);
+				});
+				first_stream += block_count / width;
+			}
+		}
+	}
+
+	/// Shuffles a contiguous range, with every permutation equally likely, spreading the work over threads using MergeShuffle: blocks
+	/// are shuffled in parallel, then merged pairwise, with the merges on each level also running in parallel.
+	/// Takes a single 64-bit value from `rng`; the result does not depend on `thread_count`.
+	/// \param thread_count number of threads to spread the work over; 0 means one per hardware thread
+	template <typename RANGE, typename RANDOM = default_random_engine_type>
+	void parallel_shuffle(RANGE&& values, RANDOM& rng = ::ghassanpl::random::default_random_engine, unsigned thread_count = 0)
+	{
+		static_assert(std::ranges::contiguous_range<RANGE> && std::ranges::sized_range<RANGE>, "parallel_shuffle needs a contiguous range");
+		detail::MergeShuffle(std::span{ std::ranges::data(values), size_t(std::ranges::size(values)) }, detail::Bits64(rng), detail::shuffle_block_size, thread_count);
+	}
+
 	struct philox64_engine
 	{
 		using result_type = uint64_t;
@@ -158,6 +491,40 @@ namespace ghassanpl::random
 			m_key = key;
 			n = 0;
 		}
+
+		/// Skips the next `count` values in constant time
+		void discard(uint64_t count) noexcept { n += count; }
+
+		/// Default number of values in each substream
+		static constexpr uint64_t default_stream_length = uint64_t(1) << 40;
+
+		/// Returns an engine that starts `stream * stream_length` values after the current position; as long as each draws fewer than
+		/// `stream_length` values, engines for different `stream`s (e.g. one per thread) produce disjoint parts of this sequence
+		[[nodiscard]] philox64_engine substream(uint64_t stream, uint64_t stream_length = default_stream_length) const noexcept
+		{
+			return philox64_engine{ m_index + n + stream * stream_length, m_key };
+		}
+
+		/// Fills `out` with the next `out.size()` values, as if calling `operator()` for each
+		void fill(std::span<uint64_t> out) noexcept
+		{
+			detail::PhiloxSpan(m_key, m_index + n, out);
+			n += out.size();
+		}
+
+		/// Fills `out` with uniform floats in [0, 1), like \ref fill_uniform_float; consumes one value per two floats, rounded up
+		void fill_uniform(std::span<float> out) noexcept
+		{
+			detail::PhiloxFloatSpan(m_key, m_index + n, out);
+			n += (out.size() + 1) / 2;
+		}
+
+		/// Fills `out` with uniform doubles in [0, 1), like \ref fill_uniform_double; consumes one value per double
+		void fill_uniform(std::span<double> out) noexcept
+		{
+			detail::PhiloxDoubleSpan(m_key, m_index + n, out);
+			n += out.size();
+		}
 	private:
 		uint64_t m_index;
 		uint32_t m_key;
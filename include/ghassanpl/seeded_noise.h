@@ -0,0 +1,601 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "noise_fields.h"
+#include "hashes.h"
+#include <bit>
+#include <numbers>
+
+/// Seedable noise. Instead of looking lattice points up in the shared \ref noise::detail::perm table, these hash them together with a
+/// 32-bit seed using \ref integer::triple32, so every seed gives its own independent noise and no state is shared between threads.
+///
+/// Every kernel is written once over the lane sets in simd.h, so the scalar functions below and the batch path of
+/// \ref noise::noise_field::generate run the same operations, and return bit-identical samples (with the same caveat about fused
+/// multiply-adds as noise_fields.h).
+
+namespace ghassanpl::noise
+{
+	/// The base noise of a \ref noise_field
+	enum class noise_type
+	{
+		simplex,
+		opensimplex2,
+		cellular,
+	};
+
+	/// What a \ref noise_field of \ref noise_type::cellular noise returns for each octave
+	enum class cellular_output
+	{
+		distance,                 ///< Distance to the nearest feature point, in [0, ~1.1]
+		distance2,                ///< Distance to the second nearest feature point, in [0, ~1.5]
+		distance2_minus_distance, ///< Difference between the two, in [0, ~1]; zero along the cell borders
+		cell_value,               ///< A value in [-1, 1) unique to the cell of the nearest feature point
+	};
+
+	/// The result of \ref cellular_noise_2d
+	template <std::floating_point F>
+	struct cellular_sample
+	{
+		F distance{};
+		F distance2{};
+		/// Hash of the cell of the nearest feature point
+		uint32_t cell{};
+	};
+
+	namespace detail::seeded
+	{
+		/// Multipliers applied to each lattice coordinate before they are mixed with the seed
+		inline constexpr uint32_t prime_x = 0x9E3779B1u;
+		inline constexpr uint32_t prime_y = 0x85EBCA77u;
+		inline constexpr uint32_t prime_z = 0xC2B2AE3Du;
+		inline constexpr uint32_t prime_w = 0x27D4EB2Fu;
+
+		/// 24 gradients evenly spaced around the circle (at 7.5 + 15k degrees) repeated to fill 128 entries, as in OpenSimplex2,
+		/// stored as interleaved x, y pairs and already divided by the normalizing constant
+		template <typename R>
+		inline constexpr auto opensimplex2_gradients = [] {
+			constexpr double normalizer = 0.05481866495625118;
+			constexpr double quadrant[] = { 0.130526192220052, 0.38268343236509, 0.608761429008721, 0.793353340291235, 0.923879532511287, 0.99144486137381 };
+			std::array<R, 256> result{};
+			for (size_t n = 0; n < 128; ++n)
+			{
+				const auto k = n % 24;
+				double x = quadrant[5 - k % 6], y = quadrant[k % 6];
+				for (size_t q = 0; q < k / 6; ++q)
+				{
+					const auto rotated = -y;
+					y = x;
+					x = rotated;
+				}
+				result[n * 2] = R(x / normalizer);
+				result[n * 2 + 1] = R(y / normalizer);
+			}
+			return result;
+		}();
+
+		template <typename L>
+		typename L::f Constant(double value) noexcept { return L::broadcast(typename L::real(value)); }
+
+		template <typename L>
+		typename L::i Integer(uint32_t value) noexcept { return L::broadcast(std::bit_cast<int32_t>(value)); }
+
+		/// \ref integer::triple32 on every lane
+		template <typename L>
+		typename L::i Triple32(typename L::i x) noexcept
+		{
+			if constexpr (L::width == 1)
+				return { integer::triple32(x.v) };
+			else
+			{
+				x = x ^ L::template shift_right<17>(x);
+				x = x * Integer<L>(0xed5ad4bbU);
+				x = x ^ L::template shift_right<11>(x);
+				x = x * Integer<L>(0xac4c1b51U);
+				x = x ^ L::template shift_right<15>(x);
+				x = x * Integer<L>(0x31848babU);
+				x = x ^ L::template shift_right<14>(x);
+				return x;
+			}
+		}
+
+		/// Falloff of a lattice point's contribution: `(radius_squared - dx^2 - dy^2)^4`, or zero outside the radius
+		template <typename L>
+		typename L::f Falloff(typename L::f radius_squared, typename L::f dx, typename L::f dy) noexcept
+		{
+			const auto a = radius_squared - dx * dx - dy * dy;
+			const auto squared = a * a;
+			return L::zero_where(L::less(a, Constant<L>(0)), squared * squared);
+		}
+
+		/// 2D simplex noise with the gradients of \ref noise::simplex_noise(F, F), picked by hashing the corners with the seed
+		template <typename L>
+		typename L::f Simplex2(typename L::i seed, typename L::f x, typename L::f y) noexcept
+		{
+			using f = typename L::f;
+			using i = typename L::i;
+
+			constexpr double F2 = 0.36602540378443864676;
+			constexpr double G2 = 0.21132486540518711775;
+			const f g2 = Constant<L>(G2);
+			const i one = L::broadcast(int32_t(1));
+			const i px = Integer<L>(prime_x), py = Integer<L>(prime_y);
+
+			const f s = (x + y) * Constant<L>(F2);
+			const i ii = L::fastfloor(x + s);
+			const i jj = L::fastfloor(y + s);
+
+			const f t = L::to_float(ii + jj) * g2;
+			const f x0 = x - (L::to_float(ii) - t);
+			const f y0 = y - (L::to_float(jj) - t);
+
+			const i x_first = L::greater(x0, y0);
+			const i i1 = x_first & one;
+			const i j1 = one - i1;
+
+			const f x1 = x0 - L::to_float(i1) + g2;
+			const f y1 = y0 - L::to_float(j1) + g2;
+			const f x2 = x0 - Constant<L>(1.0 - 2.0 * G2);
+			const f y2 = y0 - Constant<L>(1.0 - 2.0 * G2);
+
+			const i xp = ii * px, yp = jj * py;
+			const i h0 = Triple32<L>(seed ^ xp ^ yp);
+			const i h1 = Triple32<L>(seed ^ (xp + (x_first & px)) ^ (yp + L::select(x_first, L::broadcast(int32_t(0)), py)));
+			const i h2 = Triple32<L>(seed ^ (xp + px) ^ (yp + py));
+
+			const auto corner = [&](i hash, f dx, f dy) {
+				const i first_four = L::is_zero(hash & L::broadcast(int32_t(0x3C)));
+				const f u = L::select(first_four, dx, dy);
+				const f v = L::select(first_four, dy, dx);
+				const f grad = L::template flip_sign_if_bit<0>(hash & one, u) + L::template flip_sign_if_bit<1>(hash & L::broadcast(int32_t(2)), Constant<L>(2) * v);
+				return Falloff<L>(Constant<L>(0.5), dx, dy) * grad;
+			};
+
+			return Constant<L>(45.23065) * (corner(h0, x0, y0) + corner(h1, x1, y1) + corner(h2, x2, y2));
+		}
+
+		/// 4D simplex noise, with the simplex found by ranking the coordinates and the 32 gradients of improved Perlin noise
+		template <typename L>
+		typename L::f Simplex4(typename L::i seed, typename L::f x, typename L::f y, typename L::f z, typename L::f w) noexcept
+		{
+			using f = typename L::f;
+			using i = typename L::i;
+
+			constexpr double F4 = 0.30901699437494742410;
+			constexpr double G4 = 0.13819660112501051518;
+			const i zero = L::broadcast(int32_t(0)), one = L::broadcast(int32_t(1)), two = L::broadcast(int32_t(2));
+
+			const f s = (x + y + z + w) * Constant<L>(F4);
+			const i ii = L::fastfloor(x + s);
+			const i jj = L::fastfloor(y + s);
+			const i kk = L::fastfloor(z + s);
+			const i ll = L::fastfloor(w + s);
+
+			const f t = L::to_float(ii + jj + kk + ll) * Constant<L>(G4);
+			const f x0 = x - (L::to_float(ii) - t);
+			const f y0 = y - (L::to_float(jj) - t);
+			const f z0 = z - (L::to_float(kk) - t);
+			const f w0 = w - (L::to_float(ll) - t);
+
+			/// The rank of each coordinate is how many of the others it is larger than; the simplex steps along the highest first
+			i rank_x = zero, rank_y = zero, rank_z = zero, rank_w = zero;
+			const auto compare = [&](f a, f b, i& rank_a, i& rank_b) {
+				const i a_larger = L::greater(a, b) & one;
+				rank_a = rank_a + a_larger;
+				rank_b = rank_b + (one - a_larger);
+			};
+			compare(x0, y0, rank_x, rank_y);
+			compare(x0, z0, rank_x, rank_z);
+			compare(x0, w0, rank_x, rank_w);
+			compare(y0, z0, rank_y, rank_z);
+			compare(y0, w0, rank_y, rank_w);
+			compare(z0, w0, rank_z, rank_w);
+
+			const i px = Integer<L>(prime_x), py = Integer<L>(prime_y), pz = Integer<L>(prime_z), pw = Integer<L>(prime_w);
+			const i xp = ii * px, yp = jj * py, zp = kk * pz, wp = ll * pw;
+
+			const auto corner = [&](i hash, f dx, f dy, f dz, f dw) {
+				const i index = hash & L::broadcast(int32_t(31));
+				const f u = L::select(L::less(index, L::broadcast(int32_t(24))), dx, dy);
+				const f v = L::select(L::less(index, L::broadcast(int32_t(16))), dy, dz);
+				const f r = L::select(L::less(index, L::broadcast(int32_t(8))), dz, dw);
+				const f grad = L::template flip_sign_if_bit<0>(hash & one, u)
+					+ L::template flip_sign_if_bit<1>(hash & two, v)
+					+ L::template flip_sign_if_bit<2>(hash & L::broadcast(int32_t(4)), r);
+				const f a = Constant<L>(0.6) - dx * dx - dy * dy - dz * dz - dw * dw;
+				const f squared = a * a;
+				return L::zero_where(L::less(a, Constant<L>(0)), squared * squared * grad);
+			};
+
+			/// Corner `n` (1 to 3) offsets the coordinates ranked above `3 - n`
+			const auto middle_corner = [&](i threshold, double g) {
+				const i sx = L::greater(rank_x, threshold), sy = L::greater(rank_y, threshold), sz = L::greater(rank_z, threshold), sw = L::greater(rank_w, threshold);
+				const i hash = Triple32<L>(seed ^ (xp + (sx & px)) ^ (yp + (sy & py)) ^ (zp + (sz & pz)) ^ (wp + (sw & pw)));
+				const f offset = Constant<L>(g);
+				return corner(hash,
+					x0 - L::to_float(sx & one) + offset, y0 - L::to_float(sy & one) + offset,
+					z0 - L::to_float(sz & one) + offset, w0 - L::to_float(sw & one) + offset);
+			};
+
+			const f n0 = corner(Triple32<L>(seed ^ xp ^ yp ^ zp ^ wp), x0, y0, z0, w0);
+			const f n1 = middle_corner(two, G4);
+			const f n2 = middle_corner(one, 2.0 * G4);
+			const f n3 = middle_corner(zero, 3.0 * G4);
+			const f last = Constant<L>(1.0 - 4.0 * G4);
+			const f n4 = corner(Triple32<L>(seed ^ (xp + px) ^ (yp + py) ^ (zp + pz) ^ (wp + pw)), x0 - last, y0 - last, z0 - last, w0 - last);
+
+			return Constant<L>(27.0) * (n0 + n1 + n2 + n3 + n4);
+		}
+
+		/// 2D OpenSimplex2 noise (the smoother "S" variant): the same lattice as simplex noise, but with a larger radius, so each sample sums
+		/// the contributions of 4 lattice points, the two not on the diagonal of the skewed cell being picked with masks
+		template <typename L>
+		typename L::f OpenSimplex2(typename L::i seed, typename L::f x, typename L::f y) noexcept
+		{
+			using f = typename L::f;
+			using i = typename L::i;
+
+			constexpr double SKEW = 0.36602540378443864676;
+			constexpr double UNSKEW = -0.21132486540518711775;
+			const f radius_squared = Constant<L>(2.0 / 3.0);
+			const i zero = L::broadcast(int32_t(0)), one = L::broadcast(int32_t(1)), two = L::broadcast(int32_t(2)), minus_one = L::broadcast(int32_t(-1));
+			const auto gradients = opensimplex2_gradients<typename L::real>.data();
+
+			const f s = (x + y) * Constant<L>(SKEW);
+			const f xs = x + s, ys = y + s;
+			const i xsb = L::fastfloor(xs), ysb = L::fastfloor(ys);
+			const f xi = xs - L::to_float(xsb), yi = ys - L::to_float(ysb);
+
+			const f t = (xi + yi) * Constant<L>(UNSKEW);
+			const f dx0 = xi + t, dy0 = yi + t;
+			const i xp = xsb * Integer<L>(prime_x), yp = ysb * Integer<L>(prime_y);
+
+			const auto vertex = [&](i a, i b) {
+				const f af = L::to_float(a), bf = L::to_float(b);
+				const f unskew = (af + bf) * Constant<L>(UNSKEW);
+				const f dx = dx0 - (af + unskew), dy = dy0 - (bf + unskew);
+				const i hash = Triple32<L>(seed ^ (xp + a * Integer<L>(prime_x)) ^ (yp + b * Integer<L>(prime_y)));
+				const i index = L::template shift_right<24>(hash) & L::broadcast(int32_t(0xFE));
+				const f grad = L::gather(gradients, index) * dx + L::gather(gradients, index + one) * dy;
+				return Falloff<L>(radius_squared, dx, dy) * grad;
+			};
+
+			const f xmyi = xi - yi;
+			const i low = L::less(t, Constant<L>(UNSKEW));
+			const f unit = Constant<L>(1);
+			const i far_x = L::greater(xi + xmyi, unit), far_y = L::greater(yi - xmyi, unit);
+			const i back_x = L::less(xi + xmyi, Constant<L>(0)), back_y = L::less(yi, xmyi);
+
+			/// Third vertex: (2, 1) or (0, 1) below the cell's diagonal, (-1, 0) or (1, 0) above it
+			const i a2 = L::select(low, L::select(far_x, two, zero), L::select(back_x, minus_one, one));
+			const i b2 = L::select(low, one, zero);
+			/// Fourth vertex: (1, 2) or (1, 0) below, (0, -1) or (0, 1) above
+			const i a3 = L::select(low, one, zero);
+			const i b3 = L::select(low, L::select(far_y, two, zero), L::select(back_y, minus_one, one));
+
+			return vertex(zero, zero) + vertex(one, one) + vertex(a2, b2) + vertex(a3, b3);
+		}
+
+		/// `cell` modulo `period`, in [0, `period`); the quotient is estimated in floating point and then corrected
+		template <typename L>
+		typename L::i Wrap(typename L::i cell, typename L::i period, typename L::f inverse_period) noexcept
+		{
+			const auto zero = L::broadcast(int32_t(0));
+			auto result = cell - L::fastfloor(L::to_float(cell) * inverse_period) * period;
+			result = result + (L::less(result, zero) & period);
+			return result - L::select(L::less(result, period), zero, period);
+		}
+
+		template <typename L>
+		struct cellular_lanes
+		{
+			typename L::f distance;
+			typename L::f distance2;
+			typename L::i cell;
+		};
+
+		/// Worley noise: one feature point randomly placed in each unit cell; the 3x3 cells around the sample are searched, as is customary.
+		/// If `wrap` is set, cells are hashed modulo the periods, so the noise repeats every `period_x` by `period_y` cells
+		template <typename L>
+		cellular_lanes<L> Cellular(typename L::i seed, typename L::f x, typename L::f y, bool wrap = false,
+			typename L::i period_x = {}, typename L::i period_y = {}, typename L::f inverse_period_x = {}, typename L::f inverse_period_y = {}) noexcept
+		{
+			using f = typename L::f;
+			using i = typename L::i;
+
+			const i xc = L::fastfloor(x), yc = L::fastfloor(y);
+			const f unit = Constant<L>(1.0 / 65536.0);
+			const i low_bits = L::broadcast(int32_t(0xFFFF));
+
+			f nearest = Constant<L>(1e10), second = Constant<L>(1e10);
+			i cell = L::broadcast(int32_t(0));
+			for (int32_t oy = -1; oy <= 1; ++oy)
+			{
+				const i cy = yc + L::broadcast(oy);
+				const i hy = (wrap ? Wrap<L>(cy, period_y, inverse_period_y) : cy) * Integer<L>(prime_y);
+				const f dy_base = L::to_float(cy) - y;
+				for (int32_t ox = -1; ox <= 1; ++ox)
+				{
+					const i cx = xc + L::broadcast(ox);
+					const i hx = (wrap ? Wrap<L>(cx, period_x, inverse_period_x) : cx) * Integer<L>(prime_x);
+					const i hash = Triple32<L>(seed ^ hx ^ hy);
+
+					const f dx = L::to_float(cx) - x + L::to_float(hash & low_bits) * unit;
+					const f dy = dy_base + L::to_float(L::template shift_right<16>(hash)) * unit;
+					const f distance = dx * dx + dy * dy;
+
+					const i closer = L::less(distance, nearest);
+					second = L::select(closer, nearest, L::min(second, distance));
+					nearest = L::select(closer, distance, nearest);
+					cell = L::select(closer, hash, cell);
+				}
+			}
+			return { L::sqrt(nearest), L::sqrt(second), cell };
+		}
+
+		template <typename L>
+		typename L::f CellularValue(cellular_lanes<L> const& sample, cellular_output output) noexcept
+		{
+			switch (output)
+			{
+			case cellular_output::distance2: return sample.distance2;
+			case cellular_output::distance2_minus_distance: return sample.distance2 - sample.distance;
+			case cellular_output::cell_value: return L::to_float(L::template shift_right<8>(sample.cell)) * Constant<L>(1.0 / 8388608.0) - Constant<L>(1);
+			default: return sample.distance;
+			}
+		}
+
+		template <typename F>
+		using scalar = simd::scalar_lanes<F>;
+
+		template <typename F>
+		typename scalar<F>::i SeedLane(uint32_t seed) noexcept { return { seed }; }
+	}
+
+	/// 2D simplex noise, in [-1, 1], that differs for every `seed`
+	template <std::floating_point F>
+	[[nodiscard]] F simplex_noise_2d(uint32_t seed, F x, F y) noexcept
+	{
+		return detail::seeded::Simplex2<detail::seeded::scalar<F>>(detail::seeded::SeedLane<F>(seed), { x }, { y }).v;
+	}
+
+	/// 4D simplex noise, in [-1, 1], that differs for every `seed`
+	template <std::floating_point F>
+	[[nodiscard]] F simplex_noise_4d(uint32_t seed, F x, F y, F z, F w) noexcept
+	{
+		return detail::seeded::Simplex4<detail::seeded::scalar<F>>(detail::seeded::SeedLane<F>(seed), { x }, { y }, { z }, { w }).v;
+	}
+
+	/// 2D OpenSimplex2 (smooth variant) noise, in [-1, 1], that differs for every `seed`; it has fewer directional artifacts than simplex noise
+	template <std::floating_point F>
+	[[nodiscard]] F opensimplex2_noise_2d(uint32_t seed, F x, F y) noexcept
+	{
+		return detail::seeded::OpenSimplex2<detail::seeded::scalar<F>>(detail::seeded::SeedLane<F>(seed), { x }, { y }).v;
+	}
+
+	/// 2D cellular (Worley) noise with one feature point per unit cell, that differs for every `seed`
+	/// \param period_x, period_y if non-zero, the noise repeats every `period_x` by `period_y` cells
+	template <std::floating_point F>
+	[[nodiscard]] cellular_sample<F> cellular_noise_2d(uint32_t seed, F x, F y, int32_t period_x = 0, int32_t period_y = 0)
+	{
+		using L = detail::seeded::scalar<F>;
+		if (period_x < 0 || period_y < 0 || (period_x == 0) != (period_y == 0))
+			throw std::invalid_argument("periods must either both be positive or both be zero");
+
+		const auto sample = detail::seeded::Cellular<L>(detail::seeded::SeedLane<F>(seed), { x }, { y }, period_x > 0,
+			L::broadcast(period_x), L::broadcast(period_y), { F(1) / F(std::max(period_x, 1)) }, { F(1) / F(std::max(period_y, 1)) });
+		return { sample.distance.v, sample.distance2.v, sample.cell.v };
+	}
+
+	/// A seeded 2D noise function: fractal noise of the chosen \ref noise_type, optionally domain-warped or tileable, that can be
+	/// sampled one point at a time, or generated in batches of a whole grid.
+	///
+	/// Octave `n` uses the seed `seed + n * 0x9E3779B9`. Domain warping offsets the sample position by two more fractal noises of the same
+	/// type (with seeds derived from `seed`) scaled by \ref options::warp_strength.
+	///
+	/// Tileable noise repeats every \ref options::tile_width by \ref options::tile_height units. Simplex and OpenSimplex2 noise are made
+	/// tileable by sampling 4D simplex noise on a torus, so both look the same when tiled; cellular noise wraps its cells, and tiles
+	/// exactly when `tile_width * frequency` and `tile_height * frequency` are integers for every octave (otherwise they are rounded).
+	template <std::floating_point F>
+	class noise_field
+	{
+	public:
+
+		struct options
+		{
+			noise_type type = noise_type::simplex;
+			fractal_parameters<F> fractal{};
+			cellular_output cellular = cellular_output::distance;
+			/// How far the two warping noises displace the sample position; 0 disables domain warping
+			F warp_strength = 0;
+			/// If non-zero, the period of the noise along each axis; either both or neither must be set, and tiling cannot be combined with warping
+			F tile_width = 0;
+			F tile_height = 0;
+		};
+
+		explicit noise_field(uint32_t seed) : noise_field(seed, options{}) {}
+
+		noise_field(uint32_t seed, options const& opts)
+			: m_seed(seed)
+			, m_options(opts)
+		{
+			if (m_options.tile_width < 0 || m_options.tile_height < 0 || (m_options.tile_width == 0) != (m_options.tile_height == 0))
+				throw std::invalid_argument("tile width and height must either both be positive or both be zero");
+			if (tiled() && m_options.warp_strength != 0)
+				throw std::invalid_argument("tileable noise cannot be domain-warped");
+
+			constexpr auto tau = F(2) * std::numbers::pi_v<F>;
+			const detail::octave_constants<F> constants{ m_options.fractal };
+			for (size_t n = 0; n < constants.frequencies.size(); ++n)
+			{
+				auto& oct = m_octaves.emplace_back();
+				oct.frequency = constants.frequencies[n];
+				oct.amplitude = constants.amplitudes[n];
+				if (tiled())
+				{
+					oct.period_x = std::max(1, int32_t(std::lround(m_options.tile_width * oct.frequency)));
+					oct.period_y = std::max(1, int32_t(std::lround(m_options.tile_height * oct.frequency)));
+					oct.inverse_period_x = F(1) / F(oct.period_x);
+					oct.inverse_period_y = F(1) / F(oct.period_y);
+					oct.radius_x = m_options.tile_width * oct.frequency / tau;
+					oct.radius_y = m_options.tile_height * oct.frequency / tau;
+				}
+			}
+			m_denominator = constants.denominator;
+			if (tiled())
+			{
+				m_angle_scale_x = tau / m_options.tile_width;
+				m_angle_scale_y = tau / m_options.tile_height;
+			}
+		}
+
+		[[nodiscard]] uint32_t seed() const noexcept { return m_seed; }
+		[[nodiscard]] options const& settings() const noexcept { return m_options; }
+		[[nodiscard]] bool tiled() const noexcept { return m_options.tile_width > 0; }
+
+		/// Samples the noise at a single point
+		[[nodiscard]] F operator()(F x, F y) const noexcept
+		{
+			using L = simd::scalar_lanes<F>;
+			if (!OnTorus())
+				return Sample<L>({ x }, { y }, nullptr).v;
+			const auto ax = x * m_angle_scale_x, ay = y * m_angle_scale_y;
+			const torus<L> point{ { std::cos(ax) }, { std::sin(ax) }, { std::cos(ay) }, { std::sin(ay) } };
+			return Sample<L>({ x }, { y }, &point).v;
+		}
+
+		/// Fills `out` with a `width` x `height` grid of samples, row by row; the sample at `column`, `row` is bit-identical to
+		/// `(*this)(origin_x + F(column) * step, origin_y + F(row) * step)`
+		/// \param thread_count number of threads to spread the rows over; 0 means one per hardware thread
+		void generate(F origin_x, F origin_y, F step, size_t width, size_t height, std::span<F> out, unsigned thread_count = 0) const
+		{
+			if (out.size() / std::max<size_t>(width, 1) < height)
+				throw std::invalid_argument("not enough space for the samples");
+
+			/// The torus coordinates only depend on the column or the row, so the trigonometry is done once per column here, and once per row below
+			std::vector<F> cos_x, sin_x;
+			if (OnTorus())
+			{
+				cos_x.resize(width);
+				sin_x.resize(width);
+				for (size_t column = 0; column < width; ++column)
+				{
+					const auto ax = (origin_x + F(column) * step) * m_angle_scale_x;
+					cos_x[column] = std::cos(ax);
+					sin_x[column] = std::sin(ax);
+				}
+			}
+
+			parallel_for_each_index(height, thread_count, [&](size_t row) {
+				const auto y = origin_y + F(row) * step;
+				const auto ay = y * m_angle_scale_y;
+				const auto cos_y = OnTorus() ? std::cos(ay) : F(0), sin_y = OnTorus() ? std::sin(ay) : F(0);
+				const auto row_out = out.subspan(row * width, width);
+				size_t column = 0;
+				Columns<simd::batch_lanes<F>>(origin_x, step, y, cos_y, sin_y, cos_x.data(), sin_x.data(), row_out, column);
+				Columns<simd::scalar_lanes<F>>(origin_x, step, y, cos_y, sin_y, cos_x.data(), sin_x.data(), row_out, column);
+			});
+		}
+
+	private:
+
+		struct octave
+		{
+			F frequency{};
+			F amplitude{};
+			int32_t period_x = 0;
+			int32_t period_y = 0;
+			F inverse_period_x{};
+			F inverse_period_y{};
+			F radius_x{};
+			F radius_y{};
+		};
+
+		/// Where a sample lies on the two circles a tileable gradient noise is wrapped around
+		template <typename L>
+		struct torus
+		{
+			typename L::f cos_x, sin_x, cos_y, sin_y;
+		};
+
+		uint32_t m_seed = 0;
+		options m_options{};
+		std::vector<octave> m_octaves;
+		F m_denominator{};
+		F m_angle_scale_x{};
+		F m_angle_scale_y{};
+
+		static constexpr uint32_t warp_seed_x = 0x68E31DA4u;
+		static constexpr uint32_t warp_seed_y = 0xB5297A4Du;
+
+		bool OnTorus() const noexcept { return tiled() && m_options.type != noise_type::cellular; }
+
+		template <typename L>
+		typename L::f Octave(octave const& oct, typename L::i seed, typename L::f x, typename L::f y, torus<L> const* point) const noexcept
+		{
+			using namespace detail::seeded;
+			if (point)
+			{
+				const auto rx = L::broadcast(oct.radius_x), ry = L::broadcast(oct.radius_y);
+				return Simplex4<L>(seed, point->cos_x * rx, point->sin_x * rx, point->cos_y * ry, point->sin_y * ry);
+			}
+
+			const auto frequency = L::broadcast(oct.frequency);
+			x = x * frequency;
+			y = y * frequency;
+			switch (m_options.type)
+			{
+			case noise_type::opensimplex2: return OpenSimplex2<L>(seed, x, y);
+			case noise_type::cellular:
+				return CellularValue<L>(Cellular<L>(seed, x, y, tiled(), L::broadcast(oct.period_x), L::broadcast(oct.period_y),
+					L::broadcast(oct.inverse_period_x), L::broadcast(oct.inverse_period_y)), m_options.cellular);
+			default: return Simplex2<L>(seed, x, y);
+			}
+		}
+
+		template <typename L>
+		typename L::f Fractal(uint32_t seed, typename L::f x, typename L::f y, torus<L> const* point) const noexcept
+		{
+			auto output = L::broadcast(F(0));
+			for (size_t n = 0; n < m_octaves.size(); ++n)
+			{
+				const auto octave_seed = detail::seeded::Integer<L>(seed + uint32_t(n) * 0x9E3779B9u);
+				output = output + L::broadcast(m_octaves[n].amplitude) * Octave<L>(m_octaves[n], octave_seed, x, y, point);
+			}
+			return output / L::broadcast(m_denominator);
+		}
+
+		template <typename L>
+		typename L::f Sample(typename L::f x, typename L::f y, torus<L> const* point) const noexcept
+		{
+			if (m_options.warp_strength == 0)
+				return Fractal<L>(m_seed, x, y, point);
+
+			const auto strength = L::broadcast(m_options.warp_strength);
+			const auto warped_x = x + strength * Fractal<L>(m_seed ^ warp_seed_x, x, y, nullptr);
+			const auto warped_y = y + strength * Fractal<L>(m_seed ^ warp_seed_y, x, y, nullptr);
+			return Fractal<L>(m_seed, warped_x, warped_y, nullptr);
+		}
+
+		template <typename L>
+		void Columns(F origin_x, F step, F y, F cos_y, F sin_y, F const* cos_x, F const* sin_x, std::span<F> out, size_t& column) const noexcept
+		{
+			const auto origin = L::broadcast(origin_x);
+			const auto step_lanes = L::broadcast(step);
+			const auto y_lanes = L::broadcast(y);
+			for (; column + L::width <= out.size(); column += L::width)
+			{
+				const auto x = origin + L::sequence(column) * step_lanes;
+				if (OnTorus())
+				{
+					const torus<L> point{ L::load(cos_x + column), L::load(sin_x + column), L::broadcast(cos_y), L::broadcast(sin_y) };
+					L::store(Sample<L>(x, y_lanes, &point), out.data() + column);
+				}
+				else
+					L::store(Sample<L>(x, y_lanes, nullptr), out.data() + column);
+			}
+		}
+	};
+}
@@ -0,0 +1,381 @@
+/// \copyright This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#define GHPL_HAS_AVX2 1
+#else
+#define GHPL_HAS_AVX2 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GHPL_HAS_SSE2 1
+#else
+#define GHPL_HAS_SSE2 0
+#endif
+
+#if GHPL_HAS_AVX2 || GHPL_HAS_SSE2
+#include <immintrin.h>
+#endif
+
+/// Lane sets: thin wrappers over the SIMD registers available for the target, which the batch functions of this library
+/// (noise fields, pixel conversions, geometry queries, easing, etc.) write their kernels against once. A kernel templated on the lane set
+/// `L` compiles to AVX2, SSE2 or plain scalar code, and \ref simd::scalar_lanes handles whatever is left after the last full batch.
+
+namespace ghassanpl::simd
+{
+	/// Each lane set provides float lanes `f` and int lanes `i` with arithmetic operators, and static functions for the rest;
+	/// masks are int lanes with all bits set where true
+
+#if GHPL_HAS_AVX2
+	struct avx2_lanes
+	{
+		using real = float;
+		static constexpr size_t width = 8;
+
+		struct f
+		{
+			__m256 v;
+			friend f operator+(f a, f b) noexcept { return { _mm256_add_ps(a.v, b.v) }; }
+			friend f operator-(f a, f b) noexcept { return { _mm256_sub_ps(a.v, b.v) }; }
+			friend f operator*(f a, f b) noexcept { return { _mm256_mul_ps(a.v, b.v) }; }
+			friend f operator/(f a, f b) noexcept { return { _mm256_div_ps(a.v, b.v) }; }
+		};
+
+		struct i
+		{
+			__m256i v;
+			friend i operator+(i a, i b) noexcept { return { _mm256_add_epi32(a.v, b.v) }; }
+			friend i operator-(i a, i b) noexcept { return { _mm256_sub_epi32(a.v, b.v) }; }
+			friend i operator&(i a, i b) noexcept { return { _mm256_and_si256(a.v, b.v) }; }
+			friend i operator|(i a, i b) noexcept { return { _mm256_or_si256(a.v, b.v) }; }
+			friend i operator^(i a, i b) noexcept { return { _mm256_xor_si256(a.v, b.v) }; }
+			friend i operator*(i a, i b) noexcept { return { _mm256_mullo_epi32(a.v, b.v) }; }
+		};
+
+		static f broadcast(float value) noexcept { return { _mm256_set1_ps(value) }; }
+		static i broadcast(int32_t value) noexcept { return { _mm256_set1_epi32(value) }; }
+		static i lane_indices() noexcept { return { _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) }; }
+		static f sequence(size_t start) noexcept { return to_float(broadcast(int32_t(start)) + lane_indices()); }
+		static f load(float const* ptr) noexcept { return { _mm256_loadu_ps(ptr) }; }
+		static i load(uint32_t const* ptr) noexcept { return { _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr)) }; }
+		static void store(f value, float* ptr) noexcept { _mm256_storeu_ps(ptr, value.v); }
+		static void store(i value, uint32_t* ptr) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), value.v); }
+		static f min(f a, f b) noexcept { return { _mm256_min_ps(a.v, b.v) }; }
+		static f max(f a, f b) noexcept { return { _mm256_max_ps(a.v, b.v) }; }
+		static f sqrt(f value) noexcept { return { _mm256_sqrt_ps(value.v) }; }
+		/// `a * b + c`, fused where the target has FMA
+		static f mul_add(f a, f b, f c) noexcept
+		{
+#if defined(__FMA__)
+			return { _mm256_fmadd_ps(a.v, b.v, c.v) };
+#else
+			return { _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v) };
+#endif
+		}
+		template <int SHIFT>
+		static i shift_right(i value) noexcept { return { _mm256_srli_epi32(value.v, SHIFT) }; }
+		template <int SHIFT>
+		static i shift_left(i value) noexcept { return { _mm256_slli_epi32(value.v, SHIFT) }; }
+		static f bits_to_float(i value) noexcept { return { _mm256_castsi256_ps(value.v) }; }
+
+		static f to_float(i value) noexcept { return { _mm256_cvtepi32_ps(value.v) }; }
+		static i fastfloor(f value) noexcept
+		{
+			const auto truncated = _mm256_cvttps_epi32(value.v);
+			const auto below = _mm256_castps_si256(_mm256_cmp_ps(value.v, _mm256_cvtepi32_ps(truncated), _CMP_LT_OQ));
+			return { _mm256_add_epi32(truncated, below) };
+		}
+		static i less(f a, f b) noexcept { return { _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)) }; }
+		static i greater(f a, f b) noexcept { return { _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)) }; }
+		static i less_equal(f a, f b) noexcept { return { _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)) }; }
+		static i greater_equal(f a, f b) noexcept { return { _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)) }; }
+		static i equal(f a, f b) noexcept { return { _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)) }; }
+		/// True for NaNs, like `!=`
+		static i not_equal(f a, f b) noexcept { return { _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ)) }; }
+		static i less(i a, i b) noexcept { return { _mm256_cmpgt_epi32(b.v, a.v) }; }
+		static i greater(i a, i b) noexcept { return { _mm256_cmpgt_epi32(a.v, b.v) }; }
+		static i is_zero(i value) noexcept { return { _mm256_cmpeq_epi32(value.v, _mm256_setzero_si256()) }; }
+		static f select(i mask, f a, f b) noexcept { return { _mm256_blendv_ps(b.v, a.v, _mm256_castsi256_ps(mask.v)) }; }
+		static i select(i mask, i a, i b) noexcept { return { _mm256_blendv_epi8(b.v, a.v, mask.v) }; }
+		static f zero_where(i mask, f value) noexcept { return { _mm256_andnot_ps(_mm256_castsi256_ps(mask.v), value.v) }; }
+		static f zero_unless(i mask, f value) noexcept { return { _mm256_and_ps(_mm256_castsi256_ps(mask.v), value.v) }; }
+		/// One bit per lane, set where `mask` is
+		static uint32_t bits(i mask) noexcept { return uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(mask.v))); }
+		/// Flips the sign of `value` in the lanes where bit `BIT_SHIFT` of `bits` is set; `bits` must have no other bits set
+		template <int BIT_SHIFT>
+		static f flip_sign_if_bit(i bits, f value) noexcept { return { _mm256_xor_ps(value.v, _mm256_castsi256_ps(_mm256_slli_epi32(bits.v, 31 - BIT_SHIFT))) }; }
+		/// Lane `l` of the result is lane `LANES[l]` of `value`
+		template <uint32_t... LANES> requires (sizeof...(LANES) == width)
+		static f permute(f value) noexcept { return { _mm256_permutevar8x32_ps(value.v, _mm256_setr_epi32(int32_t(LANES)...)) }; }
+		static f gather(float const* table, i index) noexcept { return { _mm256_i32gather_ps(table, index.v, 4) }; }
+		static i gather(int32_t const* table, i index) noexcept { return { _mm256_i32gather_epi32(table, index.v, 4) }; }
+	};
+#endif
+
+#if GHPL_HAS_SSE2
+	struct sse2_lanes
+	{
+		using real = float;
+		static constexpr size_t width = 4;
+
+		struct f
+		{
+			__m128 v;
+			friend f operator+(f a, f b) noexcept { return { _mm_add_ps(a.v, b.v) }; }
+			friend f operator-(f a, f b) noexcept { return { _mm_sub_ps(a.v, b.v) }; }
+			friend f operator*(f a, f b) noexcept { return { _mm_mul_ps(a.v, b.v) }; }
+			friend f operator/(f a, f b) noexcept { return { _mm_div_ps(a.v, b.v) }; }
+		};
+
+		struct i
+		{
+			__m128i v;
+			friend i operator+(i a, i b) noexcept { return { _mm_add_epi32(a.v, b.v) }; }
+			friend i operator-(i a, i b) noexcept { return { _mm_sub_epi32(a.v, b.v) }; }
+			friend i operator&(i a, i b) noexcept { return { _mm_and_si128(a.v, b.v) }; }
+			friend i operator|(i a, i b) noexcept { return { _mm_or_si128(a.v, b.v) }; }
+			friend i operator^(i a, i b) noexcept { return { _mm_xor_si128(a.v, b.v) }; }
+			/// SSE2 has no 32-bit `mullo`, so multiply the even and odd lanes separately and interleave the low halves
+			friend i operator*(i a, i b) noexcept
+			{
+				const auto even = _mm_mul_epu32(a.v, b.v);
+				const auto odd = _mm_mul_epu32(_mm_srli_epi64(a.v, 32), _mm_srli_epi64(b.v, 32));
+				return { _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))) };
+			}
+		};
+
+		static f broadcast(float value) noexcept { return { _mm_set1_ps(value) }; }
+		static i broadcast(int32_t value) noexcept { return { _mm_set1_epi32(value) }; }
+		static i lane_indices() noexcept { return { _mm_setr_epi32(0, 1, 2, 3) }; }
+		static f sequence(size_t start) noexcept { return to_float(broadcast(int32_t(start)) + lane_indices()); }
+		static f load(float const* ptr) noexcept { return { _mm_loadu_ps(ptr) }; }
+		static i load(uint32_t const* ptr) noexcept { return { _mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr)) }; }
+		static void store(f value, float* ptr) noexcept { _mm_storeu_ps(ptr, value.v); }
+		static void store(i value, uint32_t* ptr) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), value.v); }
+		static f min(f a, f b) noexcept { return { _mm_min_ps(a.v, b.v) }; }
+		static f max(f a, f b) noexcept { return { _mm_max_ps(a.v, b.v) }; }
+		static f sqrt(f value) noexcept { return { _mm_sqrt_ps(value.v) }; }
+		static f mul_add(f a, f b, f c) noexcept
+		{
+#if defined(__FMA__)
+			return { _mm_fmadd_ps(a.v, b.v, c.v) };
+#else
+			return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) };
+#endif
+		}
+		template <int SHIFT>
+		static i shift_right(i value) noexcept { return { _mm_srli_epi32(value.v, SHIFT) }; }
+		template <int SHIFT>
+		static i shift_left(i value) noexcept { return { _mm_slli_epi32(value.v, SHIFT) }; }
+		static f bits_to_float(i value) noexcept { return { _mm_castsi128_ps(value.v) }; }
+
+		static f to_float(i value) noexcept { return { _mm_cvtepi32_ps(value.v) }; }
+		static i fastfloor(f value) noexcept
+		{
+			const auto truncated = _mm_cvttps_epi32(value.v);
+			const auto below = _mm_castps_si128(_mm_cmplt_ps(value.v, _mm_cvtepi32_ps(truncated)));
+			return { _mm_add_epi32(truncated, below) };
+		}
+		static i less(f a, f b) noexcept { return { _mm_castps_si128(_mm_cmplt_ps(a.v, b.v)) }; }
+		static i greater(f a, f b) noexcept { return { _mm_castps_si128(_mm_cmpgt_ps(a.v, b.v)) }; }
+		static i less_equal(f a, f b) noexcept { return { _mm_castps_si128(_mm_cmple_ps(a.v, b.v)) }; }
+		static i greater_equal(f a, f b) noexcept { return { _mm_castps_si128(_mm_cmpge_ps(a.v, b.v)) }; }
+		static i equal(f a, f b) noexcept { return { _mm_castps_si128(_mm_cmpeq_ps(a.v, b.v)) }; }
+		static i not_equal(f a, f b) noexcept { return { _mm_castps_si128(_mm_cmpneq_ps(a.v, b.v)) }; }
+		static i less(i a, i b) noexcept { return { _mm_cmplt_epi32(a.v, b.v) }; }
+		static i greater(i a, i b) noexcept { return { _mm_cmpgt_epi32(a.v, b.v) }; }
+		static i is_zero(i value) noexcept { return { _mm_cmpeq_epi32(value.v, _mm_setzero_si128()) }; }
+		static f select(i mask, f a, f b) noexcept
+		{
+			const auto m = _mm_castsi128_ps(mask.v);
+			return { _mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v)) };
+		}
+		static i select(i mask, i a, i b) noexcept { return { _mm_or_si128(_mm_and_si128(mask.v, a.v), _mm_andnot_si128(mask.v, b.v)) }; }
+		static f zero_where(i mask, f value) noexcept { return { _mm_andnot_ps(_mm_castsi128_ps(mask.v), value.v) }; }
+		static f zero_unless(i mask, f value) noexcept { return { _mm_and_ps(_mm_castsi128_ps(mask.v), value.v) }; }
+		static uint32_t bits(i mask) noexcept { return uint32_t(_mm_movemask_ps(_mm_castsi128_ps(mask.v))); }
+		template <int BIT_SHIFT>
+		static f flip_sign_if_bit(i bits, f value) noexcept { return { _mm_xor_ps(value.v, _mm_castsi128_ps(_mm_slli_epi32(bits.v, 31 - BIT_SHIFT))) }; }
+		template <uint32_t L0, uint32_t L1, uint32_t L2, uint32_t L3>
+		static f permute(f value) noexcept { return { _mm_shuffle_ps(value.v, value.v, _MM_SHUFFLE(L3, L2, L1, L0)) }; }
+		/// SSE2 has no gathers, so look the lanes up one by one
+		static f gather(float const* table, i index) noexcept
+		{
+			alignas(16) int32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes), index.v);
+			return { _mm_setr_ps(table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]) };
+		}
+		static i gather(int32_t const* table, i index) noexcept
+		{
+			alignas(16) int32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes), index.v);
+			return { _mm_setr_epi32(table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]) };
+		}
+	};
+#endif
+
+	/// A single lane of `F`; lets kernels written for the lane sets above double as scalar functions, and finish off the
+	/// samples left over after the last full batch
+	template <typename F>
+	struct scalar_lanes
+	{
+		using real = F;
+		static constexpr size_t width = 1;
+
+		struct f
+		{
+			F v;
+			friend f operator+(f a, f b) noexcept { return { a.v + b.v }; }
+			friend f operator-(f a, f b) noexcept { return { a.v - b.v }; }
+			friend f operator*(f a, f b) noexcept { return { a.v * b.v }; }
+			friend f operator/(f a, f b) noexcept { return { a.v / b.v }; }
+		};
+
+		/// Unsigned, so that the arithmetic wraps around like it does in the vector registers
+		struct i
+		{
+			uint32_t v;
+			friend i operator+(i a, i b) noexcept { return { a.v + b.v }; }
+			friend i operator-(i a, i b) noexcept { return { a.v - b.v }; }
+			friend i operator&(i a, i b) noexcept { return { a.v & b.v }; }
+			friend i operator|(i a, i b) noexcept { return { a.v | b.v }; }
+			friend i operator^(i a, i b) noexcept { return { a.v ^ b.v }; }
+			friend i operator*(i a, i b) noexcept { return { a.v * b.v }; }
+		};
+
+		static f broadcast(F value) noexcept { return { value }; }
+		static i broadcast(int32_t value) noexcept { return { uint32_t(value) }; }
+		static i lane_indices() noexcept { return { 0 }; }
+		static f sequence(size_t start) noexcept { return { F(start) }; }
+		static f load(F const* ptr) noexcept { return { *ptr }; }
+		static i load(uint32_t const* ptr) noexcept { return { *ptr }; }
+		static void store(f value, F* ptr) noexcept { *ptr = value.v; }
+		static void store(i value, uint32_t* ptr) noexcept { *ptr = value.v; }
+		static f min(f a, f b) noexcept { return a.v < b.v ? a : b; }
+		static f max(f a, f b) noexcept { return a.v > b.v ? a : b; }
+		static f sqrt(f value) noexcept { return { std::sqrt(value.v) }; }
+		static f mul_add(f a, f b, f c) noexcept
+		{
+#if defined(__FMA__)
+			return { std::fma(a.v, b.v, c.v) };
+#else
+			return { a.v * b.v + c.v };
+#endif
+		}
+		template <int SHIFT>
+		static i shift_right(i value) noexcept { return { value.v >> SHIFT }; }
+		template <int SHIFT>
+		static i shift_left(i value) noexcept { return { value.v << SHIFT }; }
+		/// Only for float lanes
+		static f bits_to_float(i value) noexcept { return { std::bit_cast<float>(value.v) }; }
+
+		static f to_float(i value) noexcept { return { F(int32_t(value.v)) }; }
+		static i fastfloor(f value) noexcept
+		{
+			const auto truncated = int32_t(value.v);
+			return { uint32_t(truncated - int32_t(value.v < F(truncated))) };
+		}
+		static i less(f a, f b) noexcept { return Mask(a.v < b.v); }
+		static i greater(f a, f b) noexcept { return Mask(a.v > b.v); }
+		static i less_equal(f a, f b) noexcept { return Mask(a.v <= b.v); }
+		static i greater_equal(f a, f b) noexcept { return Mask(a.v >= b.v); }
+		static i equal(f a, f b) noexcept { return Mask(a.v == b.v); }
+		static i not_equal(f a, f b) noexcept { return Mask(a.v != b.v); }
+		static i less(i a, i b) noexcept { return Mask(int32_t(a.v) < int32_t(b.v)); }
+		static i greater(i a, i b) noexcept { return Mask(int32_t(a.v) > int32_t(b.v)); }
+		static i is_zero(i value) noexcept { return Mask(value.v == 0); }
+		static f select(i mask, f a, f b) noexcept { return mask.v ? a : b; }
+		static i select(i mask, i a, i b) noexcept { return mask.v ? a : b; }
+		static f zero_where(i mask, f value) noexcept { return mask.v ? f{ F(0) } : value; }
+		static f zero_unless(i mask, f value) noexcept { return mask.v ? value : f{ F(0) }; }
+		static uint32_t bits(i mask) noexcept { return mask.v & 1; }
+		template <int BIT_SHIFT>
+		static f flip_sign_if_bit(i bits, f value) noexcept { return bits.v ? f{ -value.v } : value; }
+		template <uint32_t LANE> requires (LANE == 0)
+		static f permute(f value) noexcept { return value; }
+		static f gather(F const* table, i index) noexcept { return { table[index.v] }; }
+		static i gather(int32_t const* table, i index) noexcept { return { uint32_t(table[index.v]) }; }
+
+	private:
+
+		static i Mask(bool value) noexcept { return { value ? ~0u : 0u }; }
+	};
+
+#if GHPL_HAS_AVX2
+	using widest_lanes = avx2_lanes;
+#elif GHPL_HAS_SSE2
+	using widest_lanes = sse2_lanes;
+#endif
+
+	/// The lane set batches of `F` are processed with
+	template <typename F>
+#if GHPL_HAS_AVX2 || GHPL_HAS_SSE2
+	using batch_lanes = std::conditional_t<std::same_as<F, float>, widest_lanes, scalar_lanes<F>>;
+#else
+	using batch_lanes = scalar_lanes<F>;
+#endif
+
+	/// Calls `kernel(L{}, i)` for consecutive lane-sized groups of [0, `count`), the widest lanes for `F` first, and scalar lanes
+	/// for the rest
+	template <typename F, typename KERNEL>
+	void ForEachLaneGroup(size_t count, KERNEL const& kernel)
+	{
+		using L = batch_lanes<F>;
+		size_t i = 0;
+		for (; i + L::width <= count; i += L::width)
+			kernel(L{}, i);
+		for (; i < count; ++i)
+			kernel(scalar_lanes<F>{}, i);
+	}
+
+	/// Sine and cosine of 2pi `turns`: the nearest whole quarter turn is taken out, and what is left (at most an eighth of a turn)
+	/// goes through Taylor polynomials, which are accurate to about one ulp of a double there
+	template <typename L>
+	void SinCosTurns(typename L::f turns, typename L::f& sine, typename L::f& cosine) noexcept
+	{
+		using R = typename L::real;
+		const auto k = [](double value) { return L::broadcast(R(value)); };
+
+		const auto quarter_turns = turns * k(4);
+		const auto quadrant = L::fastfloor(quarter_turns + k(0.5));
+		const auto x = (quarter_turns - L::to_float(quadrant)) * k(1.5707963267948966);
+		const auto x2 = x * x;
+		const auto s = x + x * x2 * (k(-1.0 / 6) + x2 * (k(1.0 / 120) + x2 * (k(-1.0 / 5040) + x2 * (k(1.0 / 362880) + x2 * (k(-1.0 / 39916800) + x2 * (k(1.0 / 6227020800) + x2 * k(-1.0 / 1307674368000)))))));
+		const auto c = k(1) + x2 * (k(-1.0 / 2) + x2 * (k(1.0 / 24) + x2 * (k(-1.0 / 720) + x2 * (k(1.0 / 40320) + x2 * (k(-1.0 / 3628800) + x2 * (k(1.0 / 479001600) + x2 * (k(-1.0 / 87178291200) + x2 * k(1.0 / 20922789888000))))))));
+
+		/// Rotating by the quadrant: odd quadrants swap sine and cosine, and the signs follow bit 1 of the quadrant (and the next one)
+		const auto one = L::broadcast(int32_t(1));
+		const auto two = L::broadcast(int32_t(2));
+		const auto no_swap = L::is_zero(quadrant & one);
+		sine = L::template flip_sign_if_bit<1>(quadrant & two, L::select(no_swap, s, c));
+		cosine = L::template flip_sign_if_bit<1>((quadrant + one) & two, L::select(no_swap, c, s));
+	}
+
+	/// 2 to the power of `x`: the nearest integer to `x` goes into the exponent bits, and what is left (at most a half) through a
+	/// Taylor polynomial, accurate to about one ulp of a float; `x` is clamped to the range of normal floats. Double lanes use std::exp2.
+	template <typename L>
+	typename L::f Exp2(typename L::f x) noexcept
+	{
+		if constexpr (!std::same_as<typename L::real, float>)
+			return { std::exp2(x.v) };
+		else
+		{
+			const auto k = [](double value) { return L::broadcast(float(value)); };
+			const auto clamped = L::min(L::max(x, k(-126)), k(127));
+			const auto whole = L::fastfloor(clamped + k(0.5));
+			const auto f = (clamped - L::to_float(whole)) * k(0.6931471805599453);
+			const auto fraction = k(1) + f * (k(1) + f * (k(1.0 / 2) + f * (k(1.0 / 6) + f * (k(1.0 / 24) + f * (k(1.0 / 120) + f * (k(1.0 / 720) + f * k(1.0 / 5040)))))));
+			return fraction * L::bits_to_float(L::template shift_left<23>(whole + L::broadcast(int32_t(127))));
+		}
+	}
+}
@@ -4,63 +4,369 @@
 /// License, v. 2.0. If a copy of the MPL was not distributed with this
 /// file, You can obtain one at https://mozilla.org/MPL/2.0/.
 
-#include "geometry/geometry_common.h"
+#include "interpolation.h"
 #include "enum_flags.h"
+#include "simd.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <array>
+#include <compare>
+#include <functional>
+#include <tuple>
+#include <vector>
 
 namespace ghassanpl
 {
 	enum class tween_flags
 	{
+		/// Every other repeat plays backwards, from the end value to the start value
+		yoyo,
+	};
 
+	struct tween_options
+	{
+		easing curve = easing::linear;
+		/// Time to wait before starting; the target keeps the start value until then
+		float delay = 0;
+		/// How many more times to play after the first; negative repeats forever
+		int repeat = 0;
+		enum_flags<tween_flags> flags = {};
 	};
 
-	template <typename T, enum_flags<uint64_t> FLAGS>
-	struct tween_computer
+	/// Identifies a tween in a \ref tweening_system; it stays safe to use after the tween finishes or is cancelled, it just stops being active
+	struct tween_handle
 	{
+		uint32_t slot = ~uint32_t{};
+		uint32_t generation = 0;
 
+		auto operator<=>(tween_handle const&) const noexcept = default;
 	};
 
-	struct tween_options
+	/// The types that can be tweened, and how many floats they consist of
+	template <typename T>
+	struct tween_traits;
+
+	template <>
+	struct tween_traits<float>
 	{
-		enum_flags<tween_flags> m_flags = {};
-		/// TODO: Easing
-		/// TODO: Loop
-		/// TODO: Start status
+		static constexpr size_t components = 1;
 	};
 
-	struct tweening_system
+	template <glm::length_t L, glm::qualifier Q>
+	struct tween_traits<glm::vec<L, float, Q>>
 	{
-		template <typename GETTER, typename SETTER, typename TYPE_TWEEN, typename DURATION_TYPE>
-		struct ITween
+		static constexpr size_t components = size_t(L);
+	};
+
+	template <typename T>
+	concept tweenable = requires { tween_traits<T>::components; };
+
+	/// Animates float, vector and color (`color_t`) values in place.
+	///
+	/// The tweens are stored as structs of arrays, one group per number of components and easing curve, and \ref update advances each group
+	/// with a few vectorized passes over contiguous arrays: one for the time and progress, one easing pass for the whole group, and one
+	/// per component for the values, which are then written to the targets. Finished tweens are swap-removed, so the
+	/// order of tweens in a group changes, but nothing else is moved.
+	///
+	/// The targets are written through pointers, so they must stay alive (and in place) until their tweens finish or are cancelled.
+	/// Finished-callbacks are called together at the end of \ref update, after all the tweens are written, so they can start and cancel
+	/// tweens.
+	class tweening_system
+	{
+	public:
+
+		using finished_callback = std::function<void(tween_handle)>;
+
+		/// Animates `target` from its current value to `to` over `duration`
+		template <tweenable T>
+		tween_handle tween(T& target, T const& to, float duration, tween_options const& options = {}, finished_callback on_finished = {})
+		{
+			return tween(target, T{ target }, to, duration, options, std::move(on_finished));
+		}
+
+		/// Animates `target` from `from` to `to` over `duration`
+		template <tweenable T>
+		tween_handle tween(T& target, T const& from, T const& to, float duration, tween_options const& options = {}, finished_callback on_finished = {})
+		{
+			if (!(duration >= 0))
+				throw std::invalid_argument("tween duration must not be negative");
+			if (!(options.delay >= 0))
+				throw std::invalid_argument("tween delay must not be negative");
+
+			constexpr auto components = tween_traits<T>::components;
+			const auto handle = AllocateSlot(components, options.curve);
+			auto& group = GroupFor<components>(options.curve);
+			m_slots[handle.slot].index = uint32_t(group.size());
+
+			group.elapsed.push_back(-options.delay);
+			group.duration.push_back(duration);
+			group.inverse_duration.push_back(1.0f / duration);
+			auto const* from_values = reinterpret_cast<float const*>(&from);
+			auto const* to_values = reinterpret_cast<float const*>(&to);
+			for (size_t c = 0; c < components; ++c)
+			{
+				group.from[c].push_back(from_values[c]);
+				group.to[c].push_back(to_values[c]);
+			}
+			group.targets.push_back(reinterpret_cast<float*>(&target));
+			group.slots.push_back(handle.slot);
+			group.repeats.push_back(options.repeat);
+			group.yoyo.push_back(options.flags.contains(tween_flags::yoyo));
+
+			m_callbacks[handle.slot] = std::move(on_finished);
+			++m_active_count;
+			return handle;
+		}
+
+		/// Stops the tween where it is, without calling its finished-callback; returns whether it was active
+		bool cancel(tween_handle handle)
+		{
+			if (!is_active(handle))
+				return false;
+			auto const& slot = m_slots[handle.slot];
+			VisitGroup(slot.components, slot.curve, [&](auto& group) { RemoveAt(group, slot.index); });
+			m_callbacks[handle.slot] = {};
+			FreeSlot(handle.slot);
+			return true;
+		}
+
+		[[nodiscard]] bool is_active(tween_handle handle) const noexcept
 		{
-			virtual ~ITween() noexcept = default;
-
-			ITween(GETTER&& getter, SETTER&& setter, TYPE_TWEEN&& to, DURATION_TYPE&& duration, tween_options options)
-				: m_start_value(getter())
-				, m_end_value(std::forward<TYPE_TWEEN>(to))
-				, m_getter(std::forward<GETTER>(getter))
-				, m_setter(std::forward<SETTER>(setter))
-				, m_options(options)
+			return handle.slot < m_slots.size() && m_slots[handle.slot].active && m_slots[handle.slot].generation == handle.generation;
+		}
+
+		[[nodiscard]] size_t active_count() const noexcept { return m_active_count; }
+
+		/// Cancels all the tweens
+		void clear()
+		{
+			for (uint32_t slot = 0; slot < m_slots.size(); ++slot)
 			{
+				if (m_slots[slot].active)
+				{
+					m_callbacks[slot] = {};
+					FreeSlot(slot);
+				}
 			}
+			ForEachGroup([](auto& group, easing) { group.clear(); });
+		}
 
-		protected:
+		/// Advances all the tweens by `dt` and writes their values to their targets, then calls the finished-callbacks
+		void update(float dt)
+		{
+			m_finished.clear();
+			ForEachGroup([&](auto& group, easing curve) {
+				if (!group.empty())
+					UpdateGroup(group, curve, dt);
+			});
 
-			TYPE_TWEEN m_start_value = {};
-			TYPE_TWEEN m_end_value = {};
-			GETTER m_getter = {};
-			SETTER m_setter = {};
+			for (size_t i = 0; i < m_finished_callbacks.size(); ++i)
+			{
+				auto callback = std::move(m_finished_callbacks[i]);
+				callback.second(callback.first);
+			}
+			m_finished_callbacks.clear();
+		}
+
+		/// The tweens that finished during the last \ref update
+		[[nodiscard]] std::span<tween_handle const> finished() const noexcept { return m_finished; }
+
+	private:
 
-			tween_options m_options = {};
+		template <size_t N>
+		struct tween_group
+		{
+			std::vector<float> elapsed;
+			std::vector<float> duration;
+			std::vector<float> inverse_duration;
+			std::array<std::vector<float>, N> from;
+			std::array<std::vector<float>, N> to;
+			std::vector<float*> targets;
+			std::vector<uint32_t> slots;
+			std::vector<int32_t> repeats;
+			std::vector<uint8_t> yoyo;
+
+			[[nodiscard]] size_t size() const noexcept { return elapsed.size(); }
+			[[nodiscard]] bool empty() const noexcept { return elapsed.empty(); }
+
+			void clear() noexcept
+			{
+				ForEachArray([](auto& array) { array.clear(); });
+			}
 
-			tween_computer<TYPE_TWEEN, enum_flags<uint64_t>{}> m_computer = {};
+			template <typename FUNC>
+			void ForEachArray(FUNC&& func)
+			{
+				func(elapsed); func(duration); func(inverse_duration);
+				for (auto& values : from) func(values);
+				for (auto& values : to) func(values);
+				func(targets); func(slots); func(repeats); func(yoyo);
+			}
 		};
 
-		template <typename GETTER, typename SETTER, typename TYPE_TWEEN, typename DURATION_TYPE>
-		auto tween(TYPE_TWEEN& target, GETTER&& getter, SETTER&& setter, TYPE_TWEEN&& to, DURATION_TYPE&& duration)
+		struct tween_slot
 		{
+			uint32_t generation = 0;
+			uint32_t index = 0;
+			uint8_t components = 0;
+			easing curve = easing::linear;
+			bool active = false;
+		};
 
+		template <size_t N>
+		using tween_groups = std::array<tween_group<N>, easing_count>;
+
+		template <size_t N>
+		tween_group<N>& GroupFor(easing curve) { return std::get<N - 1>(m_groups)[size_t(curve)]; }
+
+		template <typename FUNC>
+		void VisitGroup(size_t components, easing curve, FUNC&& func)
+		{
+			switch (components)
+			{
+			case 1: func(GroupFor<1>(curve)); break;
+			case 2: func(GroupFor<2>(curve)); break;
+			case 3: func(GroupFor<3>(curve)); break;
+			default: func(GroupFor<4>(curve)); break;
+			}
 		}
-	};
 
-}
\ No newline at end of file
+		template <typename FUNC>
+		void ForEachGroup(FUNC&& func)
+		{
+			std::apply([&](auto&... per_size) {
+				const auto visit = [&](auto& all) {
+					for (size_t curve = 0; curve < easing_count; ++curve)
+						func(all[curve], easing(curve));
+				};
+				(visit(per_size), ...);
+			}, m_groups);
+		}
+
+		tween_handle AllocateSlot(size_t components, easing curve)
+		{
+			uint32_t index;
+			if (!m_free_slots.empty())
+			{
+				index = m_free_slots.back();
+				m_free_slots.pop_back();
+			}
+			else
+			{
+				index = uint32_t(m_slots.size());
+				m_slots.emplace_back();
+				m_callbacks.emplace_back();
+			}
+			auto& slot = m_slots[index];
+			slot.components = uint8_t(components);
+			slot.curve = curve;
+			slot.active = true;
+			return { index, slot.generation };
+		}
+
+		void FreeSlot(uint32_t index)
+		{
+			auto& slot = m_slots[index];
+			slot.active = false;
+			++slot.generation;
+			m_free_slots.push_back(index);
+			--m_active_count;
+		}
+
+		template <size_t N>
+		void RemoveAt(tween_group<N>& group, size_t index)
+		{
+			const auto last = group.size() - 1;
+			if (index != last)
+				m_slots[group.slots[last]].index = uint32_t(index);
+			group.ForEachArray([&](auto& array) {
+				array[index] = array[last];
+				array.pop_back();
+			});
+		}
+
+		template <size_t N>
+		void UpdateGroup(tween_group<N>& group, easing curve, float dt)
+		{
+			const auto count = group.size();
+			m_progress.resize(count);
+			m_values.resize(count);
+
+			float* elapsed = group.elapsed.data();
+			float const* inverse_duration = group.inverse_duration.data();
+			float* progress = m_progress.data();
+			simd::ForEachLaneGroup<float>(count, [&]<typename L>(L, size_t i) {
+				const auto time = L::load(elapsed + i) + L::broadcast(dt);
+				L::store(time, elapsed + i);
+				/// With the constant second, max and min turn NaNs (from zero durations) into 0
+				L::store(L::min(L::max(time * L::load(inverse_duration + i), L::broadcast(0.0f)), L::broadcast(1.0f)), progress + i);
+			});
+
+			ease(curve, std::span<float const>{ progress, count }, std::span<float>{ progress, count });
+
+			float* values = m_values.data();
+			float* const* targets = group.targets.data();
+			for (size_t c = 0; c < N; ++c)
+			{
+				float const* from = group.from[c].data();
+				float const* to = group.to[c].data();
+				/// Written this way, the values are exactly `from` at 0 and exactly `to` at 1
+				simd::ForEachLaneGroup<float>(count, [&]<typename L>(L, size_t i) {
+					const auto t = L::load(progress + i);
+					L::store(L::load(from + i) * (L::broadcast(1.0f) - t) + L::load(to + i) * t, values + i);
+				});
+				for (size_t i = 0; i < count; ++i)
+					targets[i][c] = values[i];
+			}
+
+			/// Going backwards, so that swap-removing only moves tweens that were already visited
+			for (size_t i = count; i-- > 0;)
+			{
+				if (!(elapsed[i] * inverse_duration[i] >= 1.0f))
+					continue;
+
+				if (group.repeats[i] != 0)
+				{
+					do
+					{
+						elapsed[i] -= group.duration[i];
+						if (group.repeats[i] > 0)
+							--group.repeats[i];
+						if (group.yoyo[i])
+						{
+							for (size_t c = 0; c < N; ++c)
+								std::swap(group.from[c][i], group.to[c][i]);
+						}
+					} while (group.duration[i] > 0 && elapsed[i] >= group.duration[i] && group.repeats[i] != 0);
+
+					/// The time left over goes into the next play
+					const auto eased = ease(curve, std::min(1.0f, std::max(0.0f, elapsed[i] * inverse_duration[i])));
+					for (size_t c = 0; c < N; ++c)
+						targets[i][c] = group.from[c][i] * (1.0f - eased) + group.to[c][i] * eased;
+					continue;
+				}
+
+				const tween_handle handle{ group.slots[i], m_slots[group.slots[i]].generation };
+				m_finished.push_back(handle);
+				if (auto& callback = m_callbacks[handle.slot])
+					m_finished_callbacks.emplace_back(handle, std::move(callback));
+				m_callbacks[handle.slot] = {};
+				FreeSlot(handle.slot);
+				RemoveAt(group, i);
+			}
+		}
+
+		std::tuple<tween_groups<1>, tween_groups<2>, tween_groups<3>, tween_groups<4>> m_groups;
+		std::vector<tween_slot> m_slots;
+		std::vector<uint32_t> m_free_slots;
+		std::vector<finished_callback> m_callbacks;
+		size_t m_active_count = 0;
+
+		std::vector<tween_handle> m_finished;
+		std::vector<std::pair<tween_handle, finished_callback>> m_finished_callbacks;
+		std::vector<float> m_progress;
+		std::vector<float> m_values;
+	};
+}
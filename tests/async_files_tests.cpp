@@ -0,0 +1,141 @@
+/// This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "../include/ghassanpl/async_files.h"
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include <chrono>
+#include <iostream>
+
+using namespace ghassanpl;
+
+namespace
+{
+	std::vector<std::filesystem::path> make_test_files(std::string_view prefix, size_t count, size_t base_size)
+	{
+		std::vector<std::filesystem::path> result;
+		for (size_t f = 0; f < count; ++f)
+		{
+			auto path = std::filesystem::temp_directory_path() / (std::string{ prefix } + std::to_string(f) + ".bin");
+			std::string contents(base_size * f, '\0');
+			for (size_t i = 0; i < contents.size(); ++i)
+				contents[i] = char((i + f) % 251);
+			std::ofstream{ path, std::ios::binary }.write(contents.data(), contents.size());
+			result.push_back(std::move(path));
+		}
+		return result;
+	}
+
+	void check_loaded_files(std::vector<std::filesystem::path> const& paths, size_t base_size, batch_file_loader_options options)
+	{
+		batch_file_loader loader{ options };
+		const auto loaded = loader.load_files(paths);
+		ASSERT_EQ(loaded.size(), paths.size());
+		for (size_t f = 0; f < paths.size(); ++f)
+		{
+			if (!paths[f].has_filename() || !std::filesystem::exists(paths[f]))
+			{
+				EXPECT_FALSE(loaded[f].has_value());
+				continue;
+			}
+			ASSERT_TRUE(loaded[f].has_value()) << f;
+			ASSERT_EQ(loaded[f]->size(), base_size * f);
+			for (size_t i = 0; i < loaded[f]->size(); i += 997)
+				ASSERT_EQ((*loaded[f])[i], char((i + f) % 251));
+		}
+	}
+}
+
+TEST(batch_file_loader, loads_files_in_any_order)
+{
+	static constexpr size_t base_size = 10'000;
+	auto paths = make_test_files("ghpl_batch_", 50, base_size);
+	std::filesystem::remove(paths[7]);
+	paths[7] = std::filesystem::temp_directory_path() / "ghpl_batch_does_not_exist.bin";
+	/// Files bigger than a registered buffer and a queue smaller than the number of files
+	const batch_file_loader_options small_ring{ .queue_depth = 8, .buffer_size = 64 * 1024 };
+
+	check_loaded_files(paths, base_size, small_ring);
+	auto fallback = small_ring;
+	fallback.force_fallback = true;
+	fallback.fallback_threads = 3;
+	check_loaded_files(paths, base_size, fallback);
+	EXPECT_FALSE(batch_file_loader{ fallback }.uses_io_uring());
+
+	for (auto& path : paths)
+		std::filesystem::remove(path);
+}
+
+TEST(batch_file_loader, callbacks_get_every_index_once)
+{
+	const auto paths = make_test_files("ghpl_batch_cb_", 20, 100);
+	std::vector<int> seen(paths.size());
+	load_files(paths, [&](size_t index, std::span<char const> contents, std::error_code error) {
+		EXPECT_FALSE(error);
+		EXPECT_EQ(contents.size(), index * 100);
+		++seen.at(index);
+	});
+	EXPECT_EQ(size_t(std::count(seen.begin(), seen.end(), 1)), seen.size());
+
+	for (auto& path : paths)
+		std::filesystem::remove(path);
+}
+
+TEST(batch_file_loader, callback_exceptions_wait_for_reads_in_flight)
+{
+	static constexpr size_t base_size = 40'000;
+	const auto paths = make_test_files("ghpl_batch_throw_", 30, base_size);
+	for (bool force_fallback : { false, true })
+	{
+		/// A tiny queue for the workers, so that they are blocked on it when the callback throws
+		batch_file_loader loader{ { .queue_depth = 2, .buffer_size = 64 * 1024, .fallback_threads = 4, .force_fallback = force_fallback } };
+		size_t calls = 0;
+		EXPECT_THROW(loader.load_files(paths, [&](size_t, std::span<char const>, std::error_code) {
+			if (++calls == 3)
+				throw std::runtime_error{ "callback failed" };
+		}), std::runtime_error);
+
+		/// The loader stays usable
+		const auto loaded = loader.load_files(paths);
+		for (size_t f = 0; f < paths.size(); ++f)
+		{
+			ASSERT_TRUE(loaded[f].has_value()) << f;
+			EXPECT_EQ(loaded[f]->size(), base_size * f);
+		}
+	}
+
+	for (auto& path : paths)
+		std::filesystem::remove(path);
+}
+
+TEST(batch_file_loader, DISABLED_benchmark_against_sequential_reads)
+{
+	const auto paths = make_test_files("ghpl_batch_bench_", 500, 400);
+
+	const auto time = [&](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	size_t total = 0;
+	const auto sequential = time([&] {
+		std::string contents;
+		for (auto& path : paths)
+		{
+			detail::read_whole_file(path, contents);
+			total += contents.size();
+		}
+	});
+	batch_file_loader ring;
+	const auto batched = time([&] { ring.load_files(paths, [&](size_t, std::span<char const> contents, std::error_code) { total += contents.size(); }); });
+	batch_file_loader threads{ { .force_fallback = true } };
+	const auto pooled = time([&] { threads.load_files(paths, [&](size_t, std::span<char const> contents, std::error_code) { total += contents.size(); }); });
+
+	std::cout << "sequential: " << sequential << "ms, " << (ring.uses_io_uring() ? "io_uring: " : "batched: ") << batched << "ms, thread pool: " << pooled << "ms (" << total << " bytes)\n";
+
+	for (auto& path : paths)
+		std::filesystem::remove(path);
+}
@@ -53,3 +53,19 @@ TEST(BitTest, BitReference) {
     ASSERT_EQ(ref.integer_value(), 0b11001000);
     ASSERT_EQ(ref.bit_number(), 2);
 }
+
+TEST(BitTest, MortonCodes) {
+    static_assert(ghassanpl::morton_encode(0b11, 0b00) == 0b0101);
+    static_assert(ghassanpl::morton_encode(0b00, 0b11) == 0b1010);
+    static_assert(ghassanpl::morton_decode(0b1110) == std::pair<uint32_t, uint32_t>{ 0b10, 0b11 });
+
+    for (uint32_t x : { 0u, 1u, 7u, 12345u, 0xFFFFFFFFu, 0x80000001u })
+    {
+        for (uint32_t y : { 0u, 3u, 9999u, 0xFFFFFFFFu, 0x7FFFFFFEu })
+        {
+            const auto code = ghassanpl::morton_encode(x, y);
+            ASSERT_EQ(code, ghassanpl::detail::spread_bits(x) | (ghassanpl::detail::spread_bits(y) << 1));
+            ASSERT_EQ(ghassanpl::morton_decode(code), (std::pair{ x, y }));
+        }
+    }
+}
@@ -3,11 +3,17 @@
 /// file, You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "../include/ghassanpl/buffers.h"
+#include "../include/ghassanpl/concurrent_buffers.h"
 #include "../include/ghassanpl/expected.h"
 #include "../include/ghassanpl/json_helpers.h"
 #include "../include/ghassanpl/mmap.h"
 
 #include <gtest/gtest.h>
+#include <thread>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <iostream>
 
 using namespace ghassanpl;
 
@@ -41,6 +47,130 @@ TEST(buffers, basics)
 	EXPECT_EQ(dest, u8"nmadnmad");
 }
 
+TEST(concurrent_buffers, spsc_queue_works_as_buffer)
+{
+	spsc_queue<uint8_t> queue{ 5 };
+	EXPECT_EQ(queue.capacity(), 8);
+	EXPECT_TRUE(queue.empty());
+
+	EXPECT_EQ(buffer_append_varint(queue, 300u), 2);
+	EXPECT_EQ(queue.size(), 2);
+	EXPECT_EQ(queue.try_pop(), uint8_t(0xAC));
+	EXPECT_EQ(queue.try_pop(), uint8_t(0x02));
+	EXPECT_EQ(queue.try_pop(), std::nullopt);
+
+	for (int i = 0; i < 8; ++i)
+		EXPECT_TRUE(buffer_append(queue, uint8_t(i)));
+	EXPECT_FALSE(buffer_append(queue, uint8_t(8)));
+	for (int i = 0; i < 8; ++i)
+		EXPECT_EQ(queue.try_pop(), uint8_t(i));
+	EXPECT_TRUE(queue.empty());
+
+	spsc_queue<std::string> strings{ 2 };
+	EXPECT_TRUE(strings.try_emplace(3, 'a'));
+	EXPECT_EQ(*strings.front(), "aaa");
+	/// Destructor should clean up the remaining string
+}
+
+TEST(concurrent_buffers, spsc_byte_ring_appends_pods_atomically)
+{
+	spsc_byte_ring<> ring{ 16 };
+	const uint64_t value = 0x0123456789ABCDEF;
+	EXPECT_EQ(buffer_append_pod(ring, value), sizeof(value));
+	EXPECT_EQ(buffer_append_pod(ring, value), sizeof(value));
+	EXPECT_EQ(ring.free_space(), 0);
+	EXPECT_EQ(buffer_append_pod(ring, uint32_t{ 5 }), 0);
+
+	uint64_t read = 0;
+	EXPECT_TRUE(ring.try_read_pod(read));
+	EXPECT_EQ(read, value);
+
+	/// Wraps around the end of the storage
+	EXPECT_EQ(buffer_append_pod(ring, uint32_t{ 0xDEADBEEF }), 4);
+	EXPECT_TRUE(ring.try_read_pod(read));
+	EXPECT_EQ(read, value);
+	uint32_t small = 0;
+	EXPECT_TRUE(ring.try_read_pod(small));
+	EXPECT_EQ(small, 0xDEADBEEF);
+	EXPECT_FALSE(ring.try_read_pod(small));
+}
+
+TEST(concurrent_buffers, mpmc_queue_delivers_everything_once)
+{
+	static constexpr int producers = 4;
+	static constexpr int per_producer = 20000;
+	mpmc_queue<int> queue{ 256 };
+	std::atomic<int64_t> sum = 0;
+	std::atomic<int> received = 0;
+
+	std::vector<std::jthread> threads;
+	for (int p = 0; p < producers; ++p)
+		threads.emplace_back([&] {
+			for (int i = 1; i <= per_producer; ++i)
+				while (!buffer_append(queue, i)) std::this_thread::yield();
+		});
+	for (int c = 0; c < 2; ++c)
+		threads.emplace_back([&] {
+			while (received.load() < producers * per_producer)
+			{
+				if (auto val = queue.try_pop())
+				{
+					sum += *val;
+					++received;
+				}
+				else
+					std::this_thread::yield();
+			}
+		});
+	threads.clear();
+
+	EXPECT_EQ(sum.load(), int64_t(producers) * per_producer * (per_producer + 1) / 2);
+	EXPECT_TRUE(queue.empty());
+}
+
+namespace
+{
+	struct mutex_deque
+	{
+		using value_type = uint64_t;
+		bool try_append(uint64_t val) { std::unique_lock lock{ mutex }; queue.push_back(val); return true; }
+		std::optional<uint64_t> try_pop() { std::unique_lock lock{ mutex }; if (queue.empty()) return std::nullopt; auto result = queue.front(); queue.pop_front(); return result; }
+		std::mutex mutex;
+		std::deque<uint64_t> queue;
+	};
+
+	template <typename QUEUE>
+	double items_per_second(QUEUE& queue, size_t count)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		std::jthread producer{ [&] {
+			for (uint64_t i = 0; i < count; ++i)
+				while (!buffer_append(queue, i)) std::this_thread::yield();
+		} };
+		size_t got = 0;
+		while (got < count)
+		{
+			if (queue.try_pop())
+				++got;
+			else
+				std::this_thread::yield();
+		}
+		producer.join();
+		return double(count) / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+TEST(concurrent_buffers, DISABLED_benchmark_against_mutex_deque)
+{
+	static constexpr size_t count = 10'000'000;
+	mutex_deque baseline;
+	spsc_queue<uint64_t> spsc{ 4096 };
+	mpmc_queue<uint64_t> mpmc{ 4096 };
+	std::cout << "mutex + deque: " << items_per_second(baseline, count) / 1e6 << " M items/s\n";
+	std::cout << "spsc_queue:    " << items_per_second(spsc, count) / 1e6 << " M items/s\n";
+	std::cout << "mpmc_queue:    " << items_per_second(mpmc, count) / 1e6 << " M items/s\n";
+}
+
 #if 0
 
 /// https://hugi.scene.org/online/coding/hugi%2012%20-%20colzp.htm
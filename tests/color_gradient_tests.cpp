@@ -0,0 +1,175 @@
+/// This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "tests_common.h"
+#include <gtest/gtest.h>
+
+#include "../include/ghassanpl/color_gradient.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace ghassanpl;
+
+namespace
+{
+	void expect_near(glm::vec4 const& actual, glm::vec4 const& expected, float tolerance)
+	{
+		for (int c = 0; c < 4; ++c)
+			EXPECT_NEAR(actual[c], expected[c], tolerance) << "channel " << c;
+	}
+}
+
+TEST(color_spaces, known_values)
+{
+	expect_near(*to_oklab(color_t{ 1, 1, 1, 1 }), { 1, 0, 0, 1 }, 1e-4f);
+	expect_near(*to_oklab(color_t{ 1, 0, 0, 0.5f }), { 0.62796f, 0.22486f, 0.12585f, 0.5f }, 1e-4f);
+	expect_near(*to_oklch(color_t{ 1, 0, 0, 1 }), { 0.62796f, 0.25768f, 29.234f, 1 }, 1e-3f);
+	expect_near(*to_lab(color_t{ 1, 0, 0, 1 }), { 53.24f, 80.09f, 67.20f, 1 }, 0.02f);
+	expect_near(*to_lab(color_t{ 1, 1, 1, 1 }), { 100, 0, 0, 1 }, 0.01f);
+
+	/// Grays have no hue
+	EXPECT_EQ(to_oklch(color_t{ 0.5f, 0.5f, 0.5f, 1 })->z, 0.0f);
+
+	static_assert(to_oklab(color_t{ 0, 0, 0, 1 })->x == 0);
+	static_assert(to_lab(color_t{ 0, 0, 0, 1 })->x == 0);
+}
+
+TEST(color_spaces, conversions_round_trip)
+{
+	std::mt19937 rng{ 5 };
+	std::uniform_real_distribution<float> dist{ 0.0f, 1.0f };
+	for (int i = 0; i < 1000; ++i)
+	{
+		const color_t color{ dist(rng), dist(rng), dist(rng), dist(rng) };
+		expect_near(to_rgb(to_oklab(color)), color, 1e-4f);
+		expect_near(to_rgb(to_oklch(color)), color, 1e-4f);
+		expect_near(to_rgb(to_lab(color)), color, 1e-4f);
+		expect_near(linear_to_srgb(srgb_to_linear(color)), color, 1e-5f);
+	}
+}
+
+TEST(color_spaces, mix_oklab_changes_lightness_evenly)
+{
+	const auto blue = to_oklab(srgb_to_linear(colors::blue));
+	const auto yellow = to_oklab(srgb_to_linear(colors::yellow));
+	const auto middle = to_oklab(srgb_to_linear(mix_oklab(colors::blue, colors::yellow, 0.5f)));
+	EXPECT_NEAR(middle->x, (blue->x + yellow->x) * 0.5f, 1e-4f);
+	/// Distant hues meet closer to gray
+	EXPECT_LT(std::hypot(middle->y, middle->z), std::hypot(yellow->y, yellow->z));
+	expect_near(mix_oklab(colors::red, colors::green, 0), colors::red, 1e-4f);
+	expect_near(mix_oklab(colors::red, colors::green, 1), colors::green, 1e-4f);
+}
+
+TEST(color_gradient, hits_its_stops_and_clamps)
+{
+	const gradient_stop stops[] = { { 0.0f, colors::black }, { 0.25f, colors::red }, { 1.0f, colors::white } };
+	for (auto space : { gradient_space::srgb, gradient_space::linear, gradient_space::oklab, gradient_space::oklch, gradient_space::cielab })
+	{
+		const color_gradient gradient{ stops, { .space = space, .resolution = 257 } };
+		expect_near(gradient.sample(0), colors::black, 1e-4f);
+		expect_near(gradient.sample(0.25f), colors::red, 1e-4f);
+		expect_near(gradient.sample(1), colors::white, 1e-4f);
+		expect_near(gradient.sample(-3), colors::black, 1e-4f);
+		expect_near(gradient.sample(7), colors::white, 1e-4f);
+		expect_near(gradient.sample(std::numeric_limits<float>::quiet_NaN()), colors::black, 1e-4f);
+	}
+
+	const color_t single[] = { colors::orange };
+	const color_gradient flat{ single };
+	expect_near(flat(0.7f), colors::orange, 1e-4f);
+
+	const gradient_stop unsorted[] = { { 0.5f, colors::black }, { 0.25f, colors::red } };
+	EXPECT_THROW(color_gradient{ unsorted }, std::invalid_argument);
+	EXPECT_THROW(color_gradient(std::span<color_t const>{}), std::invalid_argument);
+	EXPECT_THROW(color_gradient(single, { .resolution = 1 }), std::invalid_argument);
+}
+
+TEST(color_gradient, interpolates_in_the_chosen_space)
+{
+	const color_t ends[] = { colors::blue, colors::yellow };
+	const color_gradient srgb{ ends, { .space = gradient_space::srgb } };
+	const color_gradient oklab{ ends, { .space = gradient_space::oklab } };
+	const color_gradient oklch{ ends, { .space = gradient_space::oklch } };
+
+	expect_near(srgb(0.5f), { 0.5f, 0.5f, 0.5f, 1 }, 2e-3f);
+	expect_near(oklab(0.5f), mix_oklab(colors::blue, colors::yellow, 0.5f), 2e-3f);
+	/// OKLCh keeps the chroma up instead of going through gray
+	const auto middle = to_oklch(srgb_to_linear(oklch(0.5f)));
+	EXPECT_GT(middle->y, 0.1f);
+
+	/// The shorter way around the hue circle from red (29) to magenta (328) goes through 0, not through green
+	const color_t red_to_magenta[] = { colors::red, colors::magenta };
+	const color_gradient hues{ red_to_magenta, { .space = gradient_space::oklch } };
+	const auto hue = to_oklch(srgb_to_linear(hues(0.5f)))->z;
+	EXPECT_TRUE(hue < 30.0f || hue > 320.0f) << hue;
+}
+
+TEST(color_gradient, batch_fills_match_sample)
+{
+	const color_t palette[] = { colors::black, colors::blue, colors::cyan, colors::yellow, colors::red, colors::white };
+	const color_gradient gradient{ palette, { .resolution = 64 } };
+
+	std::vector<float> positions(37);
+	std::mt19937 rng{ 3 };
+	std::uniform_real_distribution<float> dist{ -0.1f, 1.1f };
+	for (auto& position : positions)
+		position = dist(rng);
+	positions[4] = std::numeric_limits<float>::quiet_NaN();
+
+	std::vector<color_t> colors(positions.size());
+	gradient.fill(positions, colors);
+	for (size_t i = 0; i < positions.size(); ++i)
+		ASSERT_EQ(colors[i], gradient.sample(positions[i])) << i;
+
+	std::vector<uint32_t> packed(positions.size());
+	gradient.fill(positions, packed, pixel_format::argb);
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		const auto nearest = std::isnan(positions[i]) ? 0.0f : std::round(std::clamp(positions[i], 0.0f, 1.0f) * 63.0f) / 63.0f;
+		ASSERT_EQ(packed[i], to_u32_argb(gradient.sample(nearest))) << i;
+	}
+
+	std::vector<color_t> strip(10);
+	gradient.fill(strip);
+	for (size_t i = 0; i < strip.size(); ++i)
+		ASSERT_EQ(strip[i], gradient.sample(float(i) / 9.0f)) << i;
+
+	std::vector<uint32_t> too_small(positions.size() - 1);
+	EXPECT_THROW(gradient.fill(positions, too_small, pixel_format::rgba), std::invalid_argument);
+}
+
+TEST(color_gradient, DISABLED_benchmark_heatmap)
+{
+	static constexpr size_t count = 1920 * 1080;
+	const color_t palette[] = { colors::black, colors::blue, colors::cyan, colors::yellow, colors::red, colors::white };
+	const color_gradient gradient{ palette };
+
+	std::vector<float> values(count);
+	std::mt19937 rng{ 3 };
+	std::uniform_real_distribution<float> dist{ 0.0f, 1.0f };
+	for (auto& value : values)
+		value = dist(rng);
+	std::vector<color_t> colors(count);
+	std::vector<uint32_t> packed(count);
+
+	using clock = std::chrono::steady_clock;
+	const auto megapixels_per_second = [](clock::duration time) { return double(count) / std::chrono::duration<double, std::micro>(time).count(); };
+
+	auto start = clock::now();
+	for (size_t i = 0; i < count; ++i)
+		packed[i] = to_u32_rgba(mix_oklab(colors::black, colors::white, values[i]));
+	const auto direct_time = clock::now() - start;
+	start = clock::now();
+	gradient.fill(values, colors);
+	const auto colors_time = clock::now() - start;
+	start = clock::now();
+	gradient.fill(values, packed, pixel_format::rgba);
+	const auto packed_time = clock::now() - start;
+
+	std::cout << "mixing per cell: " << megapixels_per_second(direct_time) << " MP/s, table to colors: " << megapixels_per_second(colors_time)
+		<< " MP/s, table to packed pixels: " << megapixels_per_second(packed_time) << " MP/s\n";
+}
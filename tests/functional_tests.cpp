@@ -6,6 +6,9 @@
 #include "../include/ghassanpl/functional.h"
 #include "tests_common.h"
 #include <print>
+#include <thread>
+#include <chrono>
+#include <iostream>
 #include <gtest/gtest.h>
 
 using namespace ghassanpl;
@@ -84,6 +87,154 @@ TEST(multicast_function, doesnt_break_references)
 	}
 }
 
+TEST(fast_multicast_function, works)
+{
+	fast_multicast_function<int(int)> delegate;
+
+	int called = 0;
+	auto handle_a = delegate += [&](int a) { called++; return a; };
+	delegate += [&](int a) { called++; return a * 2; };
+
+	EXPECT_EQ(delegate(10), (std::vector{ 10, 20 }));
+	EXPECT_EQ(delegate.reduce(0, std::plus<>{}, 10), 30);
+	int max = 0;
+	delegate.for_each_result([&](int r) { max = std::max(max, r); }, 10);
+	EXPECT_EQ(max, 20);
+	EXPECT_EQ(called, 6);
+
+	delegate -= handle_a;
+	EXPECT_EQ(delegate.size(), 1);
+	EXPECT_EQ(delegate.reduce(0, std::plus<>{}, 20), 40);
+
+	/// Too big to be stored inline
+	std::array<char, 128> big{};
+	big[0] = 3;
+	delegate += [&, big](int a) { return a * big[0]; };
+	EXPECT_EQ(delegate.reduce(0, std::plus<>{}, 50), 250);
+
+	auto copy = delegate;
+	delegate.clear();
+	EXPECT_TRUE(delegate.empty());
+	EXPECT_EQ(delegate.reduce(0, std::plus<>{}, 50), 0);
+	EXPECT_EQ(copy.reduce(0, std::plus<>{}, 50), 250);
+}
+
+TEST(fast_multicast_function, can_be_modified_during_invocation)
+{
+	fast_multicast_function<void()> delegate;
+	using handle = decltype(delegate)::handle;
+
+	int called_a = 0, called_b = 0;
+	handle handle_a{};
+	handle_a = delegate += [&] {
+		called_a++;
+		delegate -= handle_a;
+		delegate += [&] { called_b++; };
+	};
+
+	delegate();
+	EXPECT_EQ(called_a, 1);
+	EXPECT_EQ(called_b, 0);
+	delegate();
+	EXPECT_EQ(called_a, 1);
+	EXPECT_EQ(called_b, 1);
+}
+
+TEST(fast_multicast_function, can_be_subscribed_to_from_other_threads)
+{
+	fast_multicast_function<int()> delegate;
+	delegate += [] { return 1; };
+
+	std::atomic<bool> done = false;
+	std::jthread subscriber{ [&] {
+		for (int i = 0; i < 1000; ++i)
+		{
+			auto handle = delegate += [] { return 1; };
+			delegate -= handle;
+		}
+		done = true;
+	} };
+
+	while (!done)
+	{
+		const auto result = delegate.reduce(0, std::plus<>{});
+		ASSERT_TRUE(result == 1 || result == 2);
+	}
+}
+
+TEST(fast_multicast_function, every_listener_sees_the_arguments)
+{
+	fast_multicast_function<void(std::string)> delegate;
+	std::vector<std::string> received;
+	delegate += [&](std::string s) { received.push_back(std::move(s)); };
+	delegate += [&](std::string s) { received.push_back(std::move(s)); };
+
+	delegate("a string too long for the small string optimization"s);
+	EXPECT_EQ(received, std::vector<std::string>(2, "a string too long for the small string optimization"));
+}
+
+TEST(fast_multicast_function, forwards_rvalue_reference_arguments)
+{
+	fast_multicast_function<void(std::string&&)> delegate;
+	std::string received;
+	delegate += [&](std::string&& s) { received = std::move(s); };
+
+	delegate("a string too long for the small string optimization"s);
+	EXPECT_EQ(received, "a string too long for the small string optimization");
+}
+
+TEST(fast_multicast_function, listener_assignment_is_exception_safe)
+{
+	struct throws_on_copy
+	{
+		int value;
+		bool throw_on_copy = false;
+		throws_on_copy(int value, bool throw_on_copy) : value(value), throw_on_copy(throw_on_copy) {}
+		throws_on_copy(throws_on_copy const& other) : value(other.value), throw_on_copy(other.throw_on_copy) { if (throw_on_copy) throw std::runtime_error{ "copy" }; }
+		throws_on_copy(throws_on_copy&&) noexcept = default;
+		int operator()() const { return value; }
+	};
+	using listener = detail::inplace_listener<int(), 32>;
+
+	listener target{ throws_on_copy{ 1, false } };
+	listener const throwing{ throws_on_copy{ 2, true } };
+	EXPECT_THROW(target = throwing, std::runtime_error);
+	EXPECT_EQ(target(), 1);
+
+	listener const big{ [big = std::array<int, 64>{ 3 }] { return big[0]; } };
+	target = big;
+	EXPECT_EQ(target(), 3);
+	target = listener{ throws_on_copy{ 4, false } };
+	EXPECT_EQ(target(), 4);
+}
+
+TEST(fast_multicast_function, DISABLED_benchmark_against_mutlticast_function)
+{
+	static constexpr int iterations = 1'000'000;
+	int total = 0;
+	mutlticast_function<int(int)> slow;
+	fast_multicast_function<int(int)> fast;
+	for (int i = 0; i < 8; ++i)
+	{
+		slow += [i](int a) { return a + i; };
+		fast += [i](int a) { return a + i; };
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		for (auto r : slow(i)) total += r;
+	const auto slow_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		total += fast.reduce(0, std::plus<>{}, i);
+	const auto fast_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "mutlticast_function:      " << iterations / slow_time / 1e6 << " M invocations/s\n";
+	std::cout << "fast_multicast_function:  " << iterations / fast_time / 1e6 << " M invocations/s\n";
+	EXPECT_NE(total, 0);
+}
+
 TEST(make_single_time_function, works)
 {
 	int called = 0;
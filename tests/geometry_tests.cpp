@@ -1,7 +1,17 @@
 //#include "../include/ghassanpl/geometry/angles.h"
 #include "../include/ghassanpl/geometry/square_grid.h"
+#include "../include/ghassanpl/geometry/square_grid_algorithms.h"
+#include "../include/ghassanpl/geometry/square_grid_automata.h"
+#include "../include/ghassanpl/geometry/square_chunked_grid.h"
+#include "../include/ghassanpl/geometry/square_grid_pathfinding.h"
+#include "../include/ghassanpl/geometry/square_grid_regions.h"
+#include "../include/ghassanpl/geometry/square_grid_fields.h"
+#include "../include/ghassanpl/geometry/spatial_index.h"
+#include "../include/ghassanpl/geometry/batch_queries.h"
 #include "../include/ghassanpl/geometry/ellipse.h"
 #include "../include/ghassanpl/geometry/polygon.h"
+#include "../include/ghassanpl/geometry/point_cloud.h"
+#include "../include/ghassanpl/geometry/cached_polygon.h"
 #include "../include/ghassanpl/geometry/segment.h"
 #include "../include/ghassanpl/geometry/circle.h"
 #include "../include/ghassanpl/geometry/capsule.h"
@@ -15,6 +25,10 @@
 
 #include <gtest/gtest.h>
 #include <set>
+#include <ranges>
+#include <random>
+#include <chrono>
+#include <iostream>
 #include <glm/gtc/constants.hpp>
 
 //using namespace glm;
@@ -106,6 +120,1639 @@ TEST(polygon, edges)
 	p.edges();;
 }
 
+namespace
+{
+	template <typename TILE_DATA>
+	grid<TILE_DATA> random_grid(glm::ivec2 size, unsigned seed, int one_in)
+	{
+		std::mt19937 rng{ seed };
+		grid<TILE_DATA> result{ size };
+		for (auto& tile : result.tiles())
+			tile = TILE_DATA(rng() % one_in == 0);
+		return result;
+	}
+
+	/// Rule in the shape taken by `apply_cellular_automata`, where tiles outside the grid do not exist
+	void cave_rule(int& cell, std::span<int const* const> neighbors)
+	{
+		const auto walls = int(std::ranges::count_if(neighbors, [](int const* tile) { return *tile == 1; })) + (8 - int(neighbors.size()));
+		cell = walls >= 5 ? 1 : (walls <= 2 ? 0 : cell);
+	}
+
+	/// The same rule, for `cellular_automaton`, where tiles outside the grid are walls
+	int cave_neighborhood_rule(moore_neighborhood<int> const& neighborhood)
+	{
+		const auto walls = neighborhood.count(1);
+		return walls >= 5 ? 1 : (walls <= 2 ? 0 : neighborhood.self());
+	}
+}
+
+TEST(cellular_automaton, matches_apply_cellular_automata)
+{
+	for (auto size : { glm::ivec2{ 1, 1 }, glm::ivec2{ 1, 9 }, glm::ivec2{ 9, 1 }, glm::ivec2{ 2, 2 }, glm::ivec2{ 67, 300 } })
+	{
+		auto expected = random_grid<int>(size, 5, 2);
+		auto actual = expected;
+		cellular_automaton<int> automaton{ { .outside = 1, .thread_count = 4, .min_rows_per_thread = 16 } };
+		for (int i = 0; i < 3; ++i)
+		{
+			apply_cellular_automata(expected, cave_rule);
+			automaton.step(actual, cave_neighborhood_rule);
+			ASSERT_TRUE(std::ranges::equal(expected.tiles(), actual.tiles()));
+		}
+
+		const irec2 rect = irec2::from_size({ size.x / 3, size.y / 4 }, { size.x, size.y / 2 + 1 });
+		apply_cellular_automata(expected, rect, cave_rule);
+		automaton.step(actual, rect, cave_neighborhood_rule);
+		EXPECT_TRUE(std::ranges::equal(expected.tiles(), actual.tiles()));
+	}
+}
+
+TEST(cellular_automaton, works_without_default_constructible_tiles)
+{
+	struct tile
+	{
+		int value;
+		explicit tile(int value) : value(value) {}
+		bool operator==(tile const&) const = default;
+	};
+
+	const auto size = glm::ivec2{ 9, 7 };
+	auto expected = random_grid<int>(size, 3, 2);
+	grid<tile> actual{ size, tile{ 0 } };
+	for (int i = 0; i < int(expected.tiles().size()); ++i)
+		actual.tiles()[i] = tile{ expected.tiles()[i] };
+
+	cellular_automaton<int> int_automaton{ { .outside = 1 } };
+	cellular_automaton<tile> automaton{ { .outside = tile{ 1 } } };
+	for (int i = 0; i < 3; ++i)
+	{
+		int_automaton.step(expected, cave_neighborhood_rule);
+		automaton.step(actual, [](moore_neighborhood<tile> const& neighborhood) {
+			const auto walls = neighborhood.count(tile{ 1 });
+			return walls >= 5 ? tile{ 1 } : (walls <= 2 ? tile{ 0 } : neighborhood.self());
+		});
+		ASSERT_TRUE(std::ranges::equal(expected.tiles(), actual.tiles(), {}, {}, &tile::value));
+	}
+}
+
+TEST(bit_automaton, matches_cellular_automaton)
+{
+	for (auto size : { glm::ivec2{ 1, 1 }, glm::ivec2{ 63, 5 }, glm::ivec2{ 64, 64 }, glm::ivec2{ 65, 3 }, glm::ivec2{ 200, 130 } })
+	{
+		auto expected = random_grid<uint8_t>(size, 7, 3);
+		bit_automaton actual{ expected, [](uint8_t tile) { return tile != 0; } };
+		cellular_automaton<uint8_t> automaton;
+		grid<uint8_t> stored{ size };
+
+		for (auto rule_string : { "B3/S23", "B36/S23", "B0123478/S01234678", "B2/S" })
+		{
+			const auto rule = life_rule::from_string(rule_string);
+			for (int i = 0; i < 4; ++i)
+			{
+				automaton.step(expected, [rule](moore_neighborhood<uint8_t> const& neighborhood) { return uint8_t(rule(neighborhood.self() != 0, neighborhood.count(1))); });
+				actual.step(rule, 3);
+				actual.store(stored, uint8_t(1), uint8_t(0));
+				ASSERT_TRUE(std::ranges::equal(expected.tiles(), stored.tiles())) << rule_string;
+			}
+		}
+	}
+}
+
+TEST(bit_automaton, runs_conway_life)
+{
+	EXPECT_EQ(life_rule::from_string("B3/S23"), life_rule::conway());
+	EXPECT_THROW((void)life_rule::from_string("B9/S23"), std::invalid_argument);
+
+	bit_automaton blinker{ 5, 5 };
+	blinker.set(1, 2, true);
+	blinker.set(2, 2, true);
+	blinker.set(3, 2, true);
+	blinker.step(life_rule::conway());
+	EXPECT_TRUE(blinker.get(2, 1));
+	EXPECT_TRUE(blinker.get(2, 3));
+	EXPECT_FALSE(blinker.get(1, 2));
+	EXPECT_EQ(blinker.population(), 3);
+	blinker.step(life_rule::conway());
+	EXPECT_TRUE(blinker.get(1, 2));
+	EXPECT_FALSE(blinker.get(2, 1));
+
+	/// A blinker has a period of 2
+	blinker.step_generations(life_rule::conway(), 3);
+	EXPECT_TRUE(blinker.get(2, 1));
+	EXPECT_FALSE(blinker.get(1, 2));
+	blinker.step_generations(life_rule::conway(), 4, 2);
+	EXPECT_TRUE(blinker.get(2, 1));
+	EXPECT_FALSE(blinker.get(1, 2));
+}
+
+TEST(cellular_automaton, DISABLED_benchmark_against_apply_cellular_automata)
+{
+	static constexpr glm::ivec2 size{ 2048, 2048 };
+	static constexpr int steps = 4;
+	const auto time_per_step = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < steps; ++i)
+			func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / steps;
+	};
+
+	auto old_grid = random_grid<int>(size, 1, 2);
+	auto new_grid = old_grid;
+	cellular_automaton<int> automaton{ { .outside = 1 } };
+	bit_automaton bits{ old_grid, [](int tile) { return tile != 0; } };
+
+	std::cout << "apply_cellular_automata: " << time_per_step([&] { apply_cellular_automata(old_grid, cave_rule); }) << "ms/step\n";
+	std::cout << "cellular_automaton: " << time_per_step([&] { automaton.step(new_grid, cave_neighborhood_rule); }) << "ms/step\n";
+	std::cout << "bit_automaton (B5678/S45678): " << time_per_step([&] { bits.step(life_rule::from_string("B5678/S45678")); }) << "ms/step\n";
+}
+
+TEST(chunked_grid, handles_negative_coordinates_and_allocates_lazily)
+{
+	chunked_grid<int, 16> g{ -1 };
+	EXPECT_TRUE(g.empty());
+	EXPECT_EQ(g.get({ 5, 5 }), -1);
+	EXPECT_EQ(g.at(5, 5), nullptr);
+
+	g.set({ 3, 3 }, -1);
+	EXPECT_TRUE(g.empty());
+
+	g[{ -1, -1 }] = 10;
+	g[{ -16, -16 }] = 20;
+	g[{ -17, 0 }] = 30;
+	g[{ 15, 15 }] = 40;
+	EXPECT_EQ(g.chunk_count(), 3);
+	EXPECT_EQ(g.chunk_of({ -1, -1 }), glm::ivec2(-1, -1));
+	EXPECT_EQ(g.chunk_of({ -17, 0 }), glm::ivec2(-2, 0));
+	EXPECT_EQ(g.local_pos_of({ -1, -17 }), glm::ivec2(15, 15));
+	EXPECT_EQ(g.get({ -1, -1 }), 10);
+	EXPECT_EQ(g.get({ -16, -16 }), 20);
+	EXPECT_EQ(g.get({ -17, 0 }), 30);
+	EXPECT_EQ(g.get({ 15, 15 }), 40);
+	EXPECT_EQ(g.get({ -2, -2 }), -1);
+	EXPECT_EQ(g.bounds(), irec2(glm::ivec2{ -32, -16 }, glm::ivec2{ 16, 16 }));
+
+	g[{ -1, -1 }] = -1;
+	g[{ -16, -16 }] = -1;
+	EXPECT_EQ(g.compact(), 1);
+	EXPECT_EQ(g.chunk_count(), 2);
+}
+
+TEST(chunked_grid, iterates_like_grid)
+{
+	grid<int> dense{ 40, 40, 0 };
+	chunked_grid<int, 8> chunked;
+	for (int y = 0; y < 40; ++y)
+		for (int x = 0; x < 40; ++x)
+			dense[{ x, y }] = chunked[{ x, y }] = x * 100 + y;
+
+	const irec2 rect{ glm::ivec2{ 3, 5 }, glm::ivec2{ 29, 17 } };
+	std::set<int> from_dense, from_chunked;
+	dense.for_each_tile_in_rect(rect, [&](glm::ivec2, int& tile) { from_dense.insert(tile); });
+	chunked.for_each_tile_in_rect(rect, [&](glm::ivec2 pos, int& tile) { EXPECT_TRUE(rect.contains(pos)); from_chunked.insert(tile); });
+	EXPECT_EQ(from_dense, from_chunked);
+
+	std::vector<glm::ivec2> dense_neighbors, chunked_neighbors;
+	static constexpr auto flags = ghassanpl::enum_flags{ grid<int>::iteration_flags::diagonals, grid<int>::iteration_flags::only_valid };
+	static constexpr auto chunked_flags = ghassanpl::enum_flags{ chunked_grid<int, 8>::iteration_flags::diagonals, chunked_grid<int, 8>::iteration_flags::only_valid };
+	dense.for_each_neighbor<flags>({ 0, 8 }, [&](glm::ivec2 pos) { dense_neighbors.push_back(pos); });
+	chunked.for_each_neighbor<chunked_flags>({ 0, 8 }, [&](glm::ivec2 pos) { chunked_neighbors.push_back(pos); });
+	EXPECT_EQ(dense_neighbors, chunked_neighbors);
+
+	const auto found = chunked.for_each_tile_in_rect(rect, [](int& tile) { return tile == 1010; });
+	EXPECT_TRUE(found);
+
+	const auto blocks = [&](glm::ivec2 pos) { return chunked.get(pos) == 1010; };
+	EXPECT_FALSE(chunked.line_cast({ 0, 0 }, { 20, 20 }, blocks, false));
+	EXPECT_TRUE(chunked.line_cast({ 0, 0 }, { 20, 0 }, blocks, false));
+}
+
+TEST(chunked_grid, sparse_memory_scales_with_occupied_chunks)
+{
+	chunked_grid<uint8_t> g;
+	for (int i = -500; i < 500; ++i)
+		g[{ i * 1000, i * 997 }] = 1;
+	EXPECT_EQ(g.chunk_count(), 1000);
+	EXPECT_LT(g.allocated_bytes(), 1100 * 1024 + 1000 * 64);
+
+	size_t visited = 0;
+	g.for_each_tile_in_rect(irec2{ glm::ivec2{ -1'000'000, -1'000'000 }, glm::ivec2{ 1'000'000, 1'000'000 } }, [&](uint8_t& tile) { visited += tile; });
+	EXPECT_EQ(visited, 1000);
+}
+
+namespace
+{
+	template <typename LAYOUT>
+	void check_layout_is_a_bijection(int width, int height)
+	{
+		const LAYOUT layout{ width, height };
+		std::vector<int> seen(layout.storage_size());
+		for (int y = 0; y < height; ++y)
+			for (int x = 0; x < width; ++x)
+			{
+				const auto index = layout.index(x, y);
+				ASSERT_GE(index, 0);
+				ASSERT_LT(size_t(index), seen.size());
+				ASSERT_EQ(seen[index]++, 0);
+			}
+	}
+
+	template <typename LAYOUT>
+	grid<int, true, LAYOUT> numbered_grid(int width, int height)
+	{
+		grid<int, true, LAYOUT> result{ width, height };
+		for (int y = 0; y < height; ++y)
+			for (int x = 0; x < width; ++x)
+				result[glm::ivec2{ x, y }] = x * 1000 + y;
+		return result;
+	}
+
+	template <typename LAYOUT>
+	std::vector<int> in_row_order(grid<int, true, LAYOUT> const& g)
+	{
+		std::vector<int> result;
+		for (int y = 0; y < g.height(); ++y)
+			for (int x = 0; x < g.width(); ++x)
+				result.push_back(g[glm::ivec2{ x, y }]);
+		return result;
+	}
+}
+
+TEST(grid_layouts, are_bijections)
+{
+	for (auto [w, h] : { std::pair{ 1, 1 }, { 8, 8 }, { 13, 5 }, { 5, 13 }, { 64, 3 }, { 100, 100 }, { 65, 65 }, { 100, 65 } })
+	{
+		check_layout_is_a_bijection<row_major_layout>(w, h);
+		check_layout_is_a_bijection<tiled_layout<8>>(w, h);
+		check_layout_is_a_bijection<tiled_layout<4>>(w, h);
+		check_layout_is_a_bijection<morton_layout>(w, h);
+	}
+	EXPECT_EQ(morton_layout(64, 3).storage_size(), 64 * 4);
+	EXPECT_EQ(morton_layout(64, 64).storage_size(), 64 * 64);
+	/// A single 128x128 square would be almost 4 times the size of the grid
+	EXPECT_LE(morton_layout(65, 65).storage_size(), 65 * 65 * 3 / 2);
+	EXPECT_LE(morton_layout(100, 65).storage_size(), 100 * 65 * 3 / 2);
+	EXPECT_EQ(tiled_layout<8>(9, 9).storage_size(), 4 * 64);
+}
+
+template <typename LAYOUT>
+struct grid_layout_test : ::testing::Test {};
+using grid_layout_types = ::testing::Types<row_major_layout, tiled_layout<8>, tiled_layout<2>, morton_layout>;
+TYPED_TEST_SUITE(grid_layout_test, grid_layout_types);
+
+TYPED_TEST(grid_layout_test, behaves_like_row_major)
+{
+	auto expected = numbered_grid<row_major_layout>(13, 7);
+	auto actual = numbered_grid<TypeParam>(13, 7);
+	EXPECT_EQ(in_row_order(expected), in_row_order(actual));
+
+	const auto apply_all = [](auto& g) {
+		g.flip_horizontal();
+		g.flip_vertical();
+		g.rotate_180();
+		g.flip_row(3);
+		g.shift_rows(2, -1);
+		g.shift_rows(-3, -2);
+		g.resize(glm::uvec2{ 20, 5 }, -3);
+		g.resize(glm::uvec2{ 9, 11 }, -4);
+	};
+	apply_all(expected);
+	apply_all(actual);
+	EXPECT_EQ(expected.size(), actual.size());
+	EXPECT_EQ(in_row_order(expected), in_row_order(actual));
+
+	flood_at(expected, { 0, 10 }, 77);
+	flood_at(actual, { 0, 10 }, 77);
+	EXPECT_EQ(in_row_order(expected), in_row_order(actual));
+
+	int expected_sum = 0, actual_sum = 0;
+	expected.for_each_neighbor({ 4, 4 }, [&](int tile) { expected_sum += tile; });
+	actual.for_each_neighbor({ 4, 4 }, [&](int tile) { actual_sum += tile; });
+	EXPECT_EQ(expected_sum, actual_sum);
+}
+
+namespace
+{
+	template <typename LAYOUT>
+	void benchmark_layout(const char* name)
+	{
+		static constexpr int size = 1024;
+		grid<int, true, LAYOUT> g{ size, size, 0 };
+		std::mt19937 rng{ 3 };
+		for (int y = 0; y < size; ++y)
+			for (int x = 0; x < size; ++x)
+				g[glm::ivec2{ x, y }] = rng() % 3 == 0;
+
+		const auto time = [](auto&& func) {
+			const auto start = std::chrono::steady_clock::now();
+			func();
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		};
+
+		int64_t sum = 0;
+		const auto neighbors = time([&] {
+			for (int y = 0; y < size; ++y)
+				for (int x = 0; x < size; ++x)
+					g.template for_each_neighbor<ghassanpl::enum_flags{ grid<int, true, LAYOUT>::iteration_flags::only_valid, grid<int, true, LAYOUT>::iteration_flags::diagonals }>({ x, y }, [&](int tile) { sum += tile; });
+		});
+		const auto small_rects = time([&] {
+			for (int i = 0; i < 200'000; ++i)
+			{
+				const glm::ivec2 at{ int(rng() % (size - 6)), int(rng() % (size - 6)) };
+				g.for_each_tile_in_rect(irec2::from_size(at, { 6, 6 }), [&](int tile) { sum += tile; });
+			}
+		});
+		const auto floods = time([&] {
+			for (int i = 0; i < 200; ++i)
+			{
+				const glm::ivec2 at{ int(rng() % size), int(rng() % size) };
+				flood_at(g, at, [](glm::ivec2, int& tile) { tile += 2; }, [](glm::ivec2, int const& tile) { return tile == 0; });
+			}
+		});
+		const auto automaton = time([&] {
+			apply_cellular_automata(g, [](int& cell, std::span<int const* const> neighbors) { cell = int(std::ranges::count_if(neighbors, [](int const* tile) { return *tile == 1; })) >= 5; });
+		});
+		std::cout << name << ": neighbors " << neighbors << "ms, small rects " << small_rects << "ms, floods " << floods << "ms, cellular automata " << automaton << "ms (" << sum << ")\n";
+	}
+}
+
+TEST(grid_layouts, DISABLED_benchmark_neighborhood_algorithms)
+{
+	benchmark_layout<row_major_layout>("row major");
+	benchmark_layout<tiled_layout<8>>("tiled 8x8");
+	benchmark_layout<morton_layout>("morton");
+}
+
+namespace
+{
+	float floor_cost(glm::ivec2, int const& tile) { return tile == 0 ? 1.0f : -1.0f; }
+	bool is_floor(glm::ivec2, int const& tile) { return tile == 0; }
+
+	/// Checks that `result` is a connected, 8-directional path over floor tiles that doesn't cut corners, and returns its cost
+	float checked_path_cost(grid<int> const& map, path_result const& result, glm::ivec2 from, glm::ivec2 to)
+	{
+		EXPECT_EQ(result.path.front(), from);
+		EXPECT_EQ(result.path.back(), to);
+		float cost = 0;
+		for (size_t i = 1; i < result.path.size(); ++i)
+		{
+			const auto a = result.path[i - 1], b = result.path[i];
+			const auto step = b - a;
+			EXPECT_TRUE(std::abs(step.x) <= 1 && std::abs(step.y) <= 1 && step != glm::ivec2{}) << "from " << a.x << "," << a.y << " to " << b.x << "," << b.y;
+			EXPECT_EQ(map.safe_at(b, 1), 0);
+			if (step.x != 0 && step.y != 0)
+			{
+				EXPECT_EQ(map.safe_at({ a.x + step.x, a.y }, 1), 0);
+				EXPECT_EQ(map.safe_at({ a.x, a.y + step.y }, 1), 0);
+				cost += 1.41421356f;
+			}
+			else
+				cost += 1.0f;
+		}
+		return cost;
+	}
+
+	std::vector<path_request> random_path_requests(grid<int> const& map, size_t count, unsigned seed)
+	{
+		std::mt19937 rng{ seed };
+		std::vector<path_request> requests;
+		while (requests.size() < count)
+		{
+			const glm::ivec2 from{ int(rng() % map.width()), int(rng() % map.height()) };
+			const glm::ivec2 to{ int(rng() % map.width()), int(rng() % map.height()) };
+			if (map[from] == 0 && map[to] == 0)
+				requests.push_back({ from, to });
+		}
+		return requests;
+	}
+}
+
+TEST(astar_pathfinder, finds_shortest_paths)
+{
+	auto map = random_grid<int>({ 40, 30 }, 5, 4);
+	astar_pathfinder pathfinder{ map, path_options{ .diagonals = false } };
+	path_search_space bfs_space;
+
+	for (auto const& [from, to] : random_path_requests(map, 50, 6))
+	{
+		/// With cardinal moves and uniform costs, a breadth-first flood gives the reference distances
+		std::vector<int> distance(map.width() * map.height(), -1);
+		std::vector<glm::ivec2> queue{ from };
+		distance[from.x + from.y * map.width()] = 0;
+		for (size_t i = 0; i < queue.size(); ++i)
+			map.for_each_neighbor<ghassanpl::enum_flags{ grid<int>::iteration_flags::only_valid }>(queue[i], [&](glm::ivec2 pos, int const& tile) {
+				if (tile == 0 && distance[pos.x + pos.y * map.width()] < 0)
+				{
+					distance[pos.x + pos.y * map.width()] = distance[queue[i].x + queue[i].y * map.width()] + 1;
+					queue.push_back(pos);
+				}
+			});
+
+		const auto result = pathfinder.find_path(from, to, floor_cost);
+		const auto expected = distance[to.x + to.y * map.width()];
+		ASSERT_EQ(result.found(), expected >= 0);
+		if (!result.found())
+			continue;
+		EXPECT_EQ(result.cost, float(expected));
+		EXPECT_EQ(result.path.size(), size_t(expected + 1));
+		for (size_t i = 1; i < result.path.size(); ++i)
+			EXPECT_EQ(std::abs(result.path[i].x - result.path[i - 1].x) + std::abs(result.path[i].y - result.path[i - 1].y), 1);
+
+		pathfinder.explore(from, floor_cost, bfs_space, map.bounds());
+		EXPECT_EQ(bfs_space.cost_to(pathfinder.node_index(to)), float(expected));
+	}
+
+	EXPECT_FALSE(pathfinder.find_path({ 0, 0 }, { 100, 100 }, floor_cost).found());
+}
+
+TEST(astar_pathfinder, rejects_goals_outside_the_grid)
+{
+	grid<int> map{ glm::ivec2{ 8, 8 } };
+	astar_pathfinder pathfinder{ map };
+	EXPECT_FALSE(pathfinder.find_path({ 0, 0 }, { 3, 8 }, floor_cost).found());
+	EXPECT_FALSE(pathfinder.find_path({ 0, 0 }, { -1, 2 }, floor_cost).found());
+	/// (8, 0) would have the node index of (0, 1)
+	EXPECT_FALSE(pathfinder.find_path({ 0, 0 }, { 8, 0 }, floor_cost).found());
+
+	path_result result;
+	path_search_space space;
+	EXPECT_FALSE(pathfinder.find_path({ 0, 0 }, { 5, 5 }, floor_cost, result, space, irec2{ 0, 0, 4, 4 }));
+	EXPECT_TRUE(pathfinder.find_path({ 0, 0 }, { 3, 3 }, floor_cost, result, space, irec2{ 0, 0, 4, 4 }));
+}
+
+TEST(jps_pathfinder, matches_astar)
+{
+	const auto map = random_grid<int>({ 64, 48 }, 7, 4);
+	astar_pathfinder astar{ map };
+	jps_pathfinder jps{ map };
+
+	size_t found = 0;
+	for (auto const& [from, to] : random_path_requests(map, 200, 8))
+	{
+		const auto expected = astar.find_path(from, to, floor_cost);
+		const auto result = jps.find_path(from, to, is_floor);
+		ASSERT_EQ(result.found(), expected.found());
+		if (!result.found())
+			continue;
+		++found;
+		EXPECT_NEAR(result.cost, expected.cost, 1e-3f);
+		EXPECT_NEAR(checked_path_cost(map, result, from, to), expected.cost, 1e-3f);
+		EXPECT_LE(result.expanded_nodes, expected.expanded_nodes);
+	}
+	EXPECT_GT(found, 50);
+}
+
+TEST(hierarchical_pathfinder, finds_paths_whenever_astar_does)
+{
+	const auto map = random_grid<int>({ 100, 70 }, 9, 4);
+	astar_pathfinder astar{ map };
+	hierarchical_pathfinder hpa{ map, floor_cost, hierarchical_path_options{ .cluster_size = 10 } };
+	EXPECT_EQ(hpa.cluster_counts(), (glm::ivec2{ 10, 7 }));
+	EXPECT_GT(hpa.abstract_node_count(), 0);
+
+	for (auto const& [from, to] : random_path_requests(map, 200, 10))
+	{
+		const auto expected = astar.find_path(from, to, floor_cost);
+		const auto result = hpa.find_path(from, to);
+		ASSERT_EQ(result.found(), expected.found());
+		if (!result.found())
+			continue;
+		EXPECT_NEAR(checked_path_cost(map, result, from, to), result.cost, 1e-3f);
+		EXPECT_GE(result.cost, expected.cost - 1e-3f);
+		EXPECT_LE(result.cost, expected.cost * 1.5f + 2.0f);
+	}
+}
+
+TEST(hierarchical_pathfinder, updates_incrementally)
+{
+	auto map = random_grid<int>({ 64, 64 }, 11, 5);
+	hierarchical_pathfinder hpa{ map, floor_cost };
+
+	/// Wall off the left half, then open a single door, checking against a freshly built graph each time
+	const auto check = [&] {
+		hierarchical_pathfinder fresh{ map, floor_cost };
+		EXPECT_EQ(hpa.abstract_node_count(), fresh.abstract_node_count());
+		for (auto const& [from, to] : random_path_requests(map, 50, 12))
+		{
+			const auto expected = fresh.find_path(from, to);
+			const auto result = hpa.find_path(from, to);
+			ASSERT_EQ(result.found(), expected.found());
+			EXPECT_EQ(result.cost, expected.cost);
+		}
+	};
+
+	for (int y = 0; y < map.height(); ++y)
+	{
+		map[glm::ivec2{ 30, y }] = 1;
+		hpa.tile_changed({ 30, y });
+	}
+	check();
+	EXPECT_FALSE(hpa.find_path({ 29, 0 }, { 31, 0 }).found());
+
+	map.for_each_tile_in_rect(irec2::from_size({ 28, 40 }, { 5, 1 }), [](int& tile) { tile = 0; });
+	hpa.tiles_changed(irec2::from_size({ 28, 40 }, { 5, 1 }));
+	check();
+}
+
+TEST(pathfinding, batches_match_single_queries)
+{
+	const auto map = random_grid<int>({ 80, 80 }, 13, 4);
+	const auto requests = random_path_requests(map, 64, 14);
+	astar_pathfinder astar{ map };
+	jps_pathfinder jps{ map };
+	hierarchical_pathfinder hpa{ map, floor_cost };
+
+	const auto astar_results = astar.find_paths(requests, floor_cost, 4);
+	const auto jps_results = jps.find_paths(requests, is_floor, 4);
+	const auto hpa_results = hpa.find_paths(requests, 4);
+	ASSERT_EQ(astar_results.size(), requests.size());
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		EXPECT_EQ(astar_results[i].path, astar.find_path(requests[i].from, requests[i].to, floor_cost).path);
+		EXPECT_EQ(jps_results[i].path, jps.find_path(requests[i].from, requests[i].to, is_floor).path);
+		EXPECT_EQ(hpa_results[i].path, hpa.find_path(requests[i].from, requests[i].to).path);
+	}
+}
+
+TEST(pathfinding, DISABLED_benchmark_engines)
+{
+	auto map = random_grid<int>({ 1024, 1024 }, 15, 5);
+	const auto requests = random_path_requests(map, 200, 16);
+
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	/// What the pathfinders replace: A* with a node-based open list and per-query hash maps
+	const auto naive_astar = [&](glm::ivec2 from, glm::ivec2 to) {
+		struct node { float f, g; glm::ivec2 pos; bool operator<(node const& other) const { return f > other.f; } };
+		std::priority_queue<node> open;
+		std::unordered_map<glm::ivec2, float> best;
+		std::unordered_map<glm::ivec2, bool> closed;
+		open.push({ 0, 0, from });
+		best[from] = 0;
+		while (!open.empty())
+		{
+			const auto current = open.top();
+			open.pop();
+			if (current.pos == to)
+				return current.g;
+			if (std::exchange(closed[current.pos], true))
+				continue;
+			map.for_each_neighbor<ghassanpl::enum_flags{ grid<int>::iteration_flags::only_valid }>(current.pos, [&](glm::ivec2 pos, int const& tile) {
+				if (tile != 0)
+					return;
+				const auto g = current.g + 1.0f;
+				if (auto it = best.find(pos); it == best.end() || g < it->second)
+				{
+					best[pos] = g;
+					open.push({ g + float(std::abs(pos.x - to.x) + std::abs(pos.y - to.y)), g, pos });
+				}
+			});
+		}
+		return -1.0f;
+	};
+
+	astar_pathfinder astar{ map };
+	jps_pathfinder jps{ map };
+	std::optional<hierarchical_pathfinder<int, true, row_major_layout, decltype(&floor_cost)>> hpa;
+	const auto hpa_build = time([&] { hpa.emplace(map, &floor_cost); });
+
+	size_t sink = 0;
+	const auto naive = time([&] { for (auto const& [from, to] : requests) sink += naive_astar(from, to) >= 0; });
+	const auto astar_time = time([&] { for (auto const& [from, to] : requests) sink += astar.find_path(from, to, floor_cost).found(); });
+	const auto jps_time = time([&] { for (auto const& [from, to] : requests) sink += jps.find_path(from, to, is_floor).found(); });
+	const auto hpa_time = time([&] { for (auto const& [from, to] : requests) sink += hpa->find_path(from, to).found(); });
+	const auto update_time = time([&] { for (int i = 0; i < 100; ++i) hpa->tile_changed({ i * 10, i * 10 }); });
+	const auto batch_time = time([&] { sink += hpa->find_paths(requests).size(); });
+
+	std::cout << requests.size() << " queries on 1024x1024: naive A* " << naive << "ms, A* " << astar_time << "ms, JPS " << jps_time << "ms, HPA* " << hpa_time
+		<< "ms (build " << hpa_build << "ms, 100 tile updates " << update_time << "ms, batched " << batch_time << "ms) (" << sink << ")\n";
+}
+
+namespace
+{
+	/// Checks that `regions` splits the floor tiles of `map` the same way as flooding each of them does
+	template <typename REGION_MAP>
+	void expect_regions_match_floods(grid<int>& map, REGION_MAP const& regions, bool diagonals)
+	{
+		std::vector<int> component(map.tile_count(), -1);
+		std::vector<uint32_t> label_of_component;
+		std::vector<glm::ivec2> queue;
+		for (int y = 0; y < map.height(); ++y)
+			for (int x = 0; x < map.width(); ++x)
+			{
+				if (map[glm::ivec2{ x, y }] != 0 || component[map.index(x, y)] >= 0)
+				{
+					if (map[glm::ivec2{ x, y }] != 0)
+					{
+						ASSERT_EQ(regions.region_at({ x, y }), REGION_MAP::no_region);
+					}
+					continue;
+				}
+
+				const auto id = int(label_of_component.size());
+				label_of_component.push_back(regions.region_at({ x, y }));
+				ASSERT_NE(label_of_component.back(), REGION_MAP::no_region);
+				size_t size = 0;
+				queue.assign(1, { x, y });
+				component[map.index(x, y)] = id;
+				while (!queue.empty())
+				{
+					const auto pos = queue.back();
+					queue.pop_back();
+					++size;
+					ASSERT_EQ(regions.region_at(pos), label_of_component[id]);
+					const auto visit = [&](glm::ivec2 neighbor, int const& tile) {
+						if (tile == 0 && component[map.index(neighbor)] < 0)
+						{
+							component[map.index(neighbor)] = id;
+							queue.push_back(neighbor);
+						}
+					};
+					if (diagonals)
+						map.for_each_neighbor<ghassanpl::enum_flags{ grid<int>::iteration_flags::only_valid, grid<int>::iteration_flags::diagonals }>(pos, visit);
+					else
+						map.for_each_neighbor<ghassanpl::enum_flags{ grid<int>::iteration_flags::only_valid }>(pos, visit);
+				}
+				EXPECT_EQ(regions.region_size(label_of_component[id]), size);
+			}
+
+		EXPECT_EQ(regions.region_count(), label_of_component.size());
+		std::ranges::sort(label_of_component);
+		EXPECT_EQ(std::ranges::adjacent_find(label_of_component), label_of_component.end()) << "two components share a label";
+	}
+}
+
+TEST(region_map, labels_connected_regions)
+{
+	for (const bool diagonals : { false, true })
+	{
+		auto map = random_grid<int>({ 97, 203 }, 17, 2);
+		region_map single_threaded{ map, is_floor, { .diagonals = diagonals, .thread_count = 1 } };
+		expect_regions_match_floods(map, single_threaded, diagonals);
+
+		/// Bands of 8 rows, so that plenty of regions cross band borders
+		region_map banded{ map, is_floor, { .diagonals = diagonals, .thread_count = 16, .min_rows_per_thread = 8 } };
+		for (int y = 0; y < map.height(); ++y)
+			for (int x = 0; x < map.width(); ++x)
+				ASSERT_EQ(banded.region_at({ x, y }), single_threaded.region_at({ x, y }));
+
+		EXPECT_FALSE(banded.is_reachable({ -1, 0 }, { 0, 0 }));
+	}
+}
+
+TEST(region_map, updates_incrementally)
+{
+	for (const bool diagonals : { false, true })
+	{
+		auto map = random_grid<int>({ 60, 50 }, 19, 3);
+		region_map regions{ map, is_floor, { .diagonals = diagonals } };
+
+		std::mt19937 rng{ 20 };
+		for (int i = 0; i < 300; ++i)
+		{
+			const auto area = irec2::from_size({ int(rng() % map.width()), int(rng() % map.height()) }, { int(rng() % 4 + 1), int(rng() % 4 + 1) });
+			const auto wall = int(rng() % 2);
+			map.for_each_tile_in_rect(area, [&](int& tile) { tile = wall; });
+			regions.tiles_changed(area);
+			if (i % 25 == 0)
+				expect_regions_match_floods(map, regions, diagonals);
+		}
+		expect_regions_match_floods(map, regions, diagonals);
+
+		/// Splitting a region in two
+		map.reset(9, 3, 0);
+		regions.rebuild();
+		EXPECT_TRUE(regions.is_reachable({ 0, 0 }, { 8, 2 }));
+		map.for_each_tile_in_rect(irec2::from_size({ 4, 0 }, { 1, 3 }), [](int& tile) { tile = 1; });
+		regions.tiles_changed(irec2::from_size({ 4, 0 }, { 1, 3 }));
+		EXPECT_FALSE(regions.is_reachable({ 0, 0 }, { 8, 2 }));
+		EXPECT_EQ(regions.region_count(), 2);
+		expect_regions_match_floods(map, regions, diagonals);
+	}
+}
+
+TEST(region_map, DISABLED_benchmark_reachability)
+{
+	auto map = random_grid<int>({ 2048, 2048 }, 21, 3);
+	const auto requests = random_path_requests(map, 1000, 22);
+
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	size_t sink = 0;
+	const auto flood_time = time([&] {
+		/// Flooding with a marker value and flooding back, once per query
+		for (auto const& [from, to] : requests | std::views::take(50))
+		{
+			flood_at(map, from, 2);
+			sink += map[to] == 2;
+			flood_at(map, from, 0);
+		}
+	});
+
+	std::optional<region_map<int, true, row_major_layout, decltype(&is_floor)>> regions;
+	const auto single_time = time([&] { regions.emplace(map, &is_floor, region_map<int, true, row_major_layout, decltype(&is_floor)>::options{ .thread_count = 1 }); });
+	const auto parallel_time = time([&] { regions.emplace(map, &is_floor); });
+	const auto query_time = time([&] { for (auto const& [from, to] : requests) sink += regions->is_reachable(from, to); });
+	const auto update_time = time([&] {
+		for (int i = 0; i < 100; ++i)
+		{
+			map[glm::ivec2{ i * 20, i * 20 }] ^= 1;
+			regions->tile_changed({ i * 20, i * 20 });
+		}
+	});
+
+	std::cout << "2048x2048: 50 flood queries " << flood_time << "ms, labeling " << single_time << "ms (1 thread) / " << parallel_time << "ms (all threads), "
+		<< requests.size() << " queries " << query_time << "ms, 100 tile updates " << update_time << "ms (" << sink << ")\n";
+}
+
+TEST(fov, is_symmetric_and_bounded_by_radius)
+{
+	auto map = random_grid<int>({ 40, 30 }, 23, 4);
+	const auto blocks_sight = [](glm::ivec2, int const& tile) { return tile != 0; };
+
+	std::vector<bit_grid> views(size_t(map.width()) * size_t(map.height()));
+	for (int y = 0; y < map.height(); ++y)
+		for (int x = 0; x < map.width(); ++x)
+			if (map[glm::ivec2{ x, y }] == 0)
+				compute_fov(map, { x, y }, 1000, blocks_sight, views[map.index(x, y)] = bit_grid{ map.size() });
+
+	for (int y = 0; y < map.height(); ++y)
+		for (int x = 0; x < map.width(); ++x)
+		{
+			if (map[glm::ivec2{ x, y }] != 0) continue;
+			auto const& view = views[map.index(x, y)];
+			EXPECT_TRUE(view.get(x, y));
+			for (int oy = 0; oy < map.height(); ++oy)
+				for (int ox = 0; ox < map.width(); ++ox)
+					if (map[glm::ivec2{ ox, oy }] == 0)
+					{
+						ASSERT_EQ(view.get(ox, oy), views[map.index(ox, oy)].get(x, y)) << x << "," << y << " and " << ox << "," << oy;
+					}
+		}
+
+	/// With nothing in the way, the radius alone decides what is visible
+	grid<int> open{ { 21, 21 }, 0 };
+	bit_grid visible{ open.size() };
+	compute_fov(open, { 10, 10 }, 5, blocks_sight, visible);
+	for (int y = 0; y < 21; ++y)
+		for (int x = 0; x < 21; ++x)
+		{
+			const auto d2 = (x - 10) * (x - 10) + (y - 10) * (y - 10);
+			EXPECT_EQ(visible.get(x, y), d2 <= 5 * 5 + 5) << x << "," << y;
+		}
+}
+
+TEST(fov, multiple_viewers_match_single_ones)
+{
+	auto map = random_grid<int>({ 64, 48 }, 24, 5);
+	const auto blocks_sight = [](glm::ivec2, int const& tile) { return tile != 0; };
+
+	std::mt19937 rng{ 25 };
+	std::vector<fov_viewer> viewers;
+	for (int i = 0; i < 20; ++i)
+		viewers.push_back({ { int(rng() % map.width()), int(rng() % map.height()) }, int(rng() % 20) });
+
+	std::vector<bit_grid> views(viewers.size());
+	compute_fov(map, viewers, blocks_sight, views, 4);
+
+	bit_grid expected_combined{ map.size() };
+	for (size_t i = 0; i < viewers.size(); ++i)
+	{
+		bit_grid expected{ map.size() };
+		compute_fov(map, viewers[i].position, viewers[i].radius, blocks_sight, expected);
+		EXPECT_EQ(views[i], expected);
+		expected_combined |= expected;
+	}
+
+	bit_grid combined;
+	compute_combined_fov(map, viewers, blocks_sight, combined, 4);
+	EXPECT_EQ(combined, expected_combined);
+	EXPECT_GT(combined.count(), 0);
+}
+
+TEST(distance_field, matches_nearest_source_and_flows_to_it)
+{
+	auto map = random_grid<int>({ 50, 40 }, 26, 4);
+	const auto sources = random_path_requests(map, 3, 27);
+	const std::vector<glm::ivec2> source_tiles{ sources[0].from, sources[1].from, sources[2].from };
+
+	distance_field field;
+	for (const bool diagonals : { false, true })
+	{
+		const path_options options{ .diagonals = diagonals };
+		field.compute(map, source_tiles, floor_cost, options);
+
+		astar_pathfinder pathfinder{ map, options };
+		std::vector<path_search_space> single(source_tiles.size());
+		for (size_t i = 0; i < source_tiles.size(); ++i)
+			pathfinder.explore(source_tiles[i], floor_cost, single[i], map.bounds());
+
+		for (int y = 0; y < map.height(); ++y)
+			for (int x = 0; x < map.width(); ++x)
+			{
+				const glm::ivec2 pos{ x, y };
+				auto nearest = std::numeric_limits<float>::infinity();
+				for (auto const& space : single)
+					nearest = std::min(nearest, space.cost_to(pathfinder.node_index(pos)));
+				ASSERT_EQ(field.is_reachable(pos), nearest != std::numeric_limits<float>::infinity());
+
+				/// Following the flow gets to a source, losing exactly the cost of each step
+				if (!field.is_reachable(pos)) continue;
+				ASSERT_NEAR(field.distance(pos), nearest, 1e-3f);
+				auto at = pos;
+				while (field.flow(at) != glm::ivec2{})
+				{
+					const auto next = field.next_step(at);
+					const auto step = next - at;
+					ASSERT_TRUE(diagonals || step.x == 0 || step.y == 0);
+					ASSERT_NEAR(field.distance(at) - field.distance(next), (step.x != 0 && step.y != 0) ? 1.41421356f : 1.0f, 1e-3f);
+					at = next;
+				}
+				EXPECT_TRUE(std::ranges::find(source_tiles, at) != source_tiles.end());
+			}
+	}
+
+	std::vector<distance_field> fields(2);
+	const std::vector<std::vector<glm::ivec2>> source_sets{ { source_tiles[0] }, source_tiles };
+	compute_distance_fields(map, fields, source_sets, floor_cost, {}, 2);
+	for (int y = 0; y < map.height(); ++y)
+		for (int x = 0; x < map.width(); ++x)
+			ASSERT_EQ(fields[1].distance({ x, y }), field.distance({ x, y }));
+}
+
+TEST(euclidean_distance_transform, matches_brute_force)
+{
+	const auto is_wall = [](glm::ivec2, int const& tile) { return tile != 0; };
+	for (const auto size : { glm::ivec2{ 1, 1 }, glm::ivec2{ 37, 91 }, glm::ivec2{ 130, 20 } })
+	{
+		auto map = random_grid<int>(size, 28, 29);
+		std::vector<glm::ivec2> walls;
+		map.for_each_tile([&](glm::ivec2 pos, int const& tile) { if (tile) walls.push_back(pos); });
+
+		grid<float> distances, squared;
+		euclidean_distance_transform(map, is_wall, distances, false, 1);
+		euclidean_distance_transform(map, is_wall, squared, true, 3);
+		for (int y = 0; y < size.y; ++y)
+			for (int x = 0; x < size.x; ++x)
+			{
+				auto nearest = std::numeric_limits<float>::infinity();
+				for (auto const& wall : walls)
+					nearest = std::min(nearest, float((wall.x - x) * (wall.x - x) + (wall.y - y) * (wall.y - y)));
+				ASSERT_EQ(*squared.at({ x, y }), nearest) << x << "," << y;
+				ASSERT_FLOAT_EQ(*distances.at({ x, y }), std::sqrt(nearest));
+			}
+	}
+}
+
+TEST(fov, DISABLED_benchmark_fields)
+{
+	auto map = random_grid<int>({ 1024, 1024 }, 30, 8);
+	const auto blocks_sight = [](glm::ivec2, int const& tile) { return tile != 0; };
+
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	std::mt19937 rng{ 31 };
+	std::vector<fov_viewer> viewers;
+	for (int i = 0; i < 256; ++i)
+		viewers.push_back({ { int(rng() % map.width()), int(rng() % map.height()) }, 32 });
+
+	size_t sink = 0;
+	const auto line_cast_time = time([&] {
+		/// A line cast to every tile within the radius, for the first few viewers
+		for (auto const& viewer : viewers | std::views::take(8))
+			for (int y = -viewer.radius; y <= viewer.radius; ++y)
+				for (int x = -viewer.radius; x <= viewer.radius; ++x)
+				{
+					const auto to = viewer.position + glm::ivec2{ x, y };
+					if (!map.is_valid(to) || x * x + y * y > viewer.radius * viewer.radius + viewer.radius) continue;
+					sink += line_cast(viewer.position, to, [&](glm::ivec2 pos) { return pos != to && map[pos] != 0; }, true);
+				}
+	});
+
+	bit_grid combined;
+	const auto single_time = time([&] { compute_combined_fov(map, viewers, blocks_sight, combined, 1); sink += combined.count(); });
+	const auto parallel_time = time([&] { compute_combined_fov(map, viewers, blocks_sight, combined); sink += combined.count(); });
+
+	distance_field field;
+	const std::vector<glm::ivec2> sources{ { 10, 10 }, { 1000, 1000 }, { 500, 20 } };
+	const auto field_time = time([&] { field.compute(map, sources, floor_cost); });
+	const auto field_again_time = time([&] { field.compute(map, sources, floor_cost); sink += size_t(field.distance({ 512, 512 })); });
+
+	grid<float> distances;
+	const auto edt_single_time = time([&] { euclidean_distance_transform(map, blocks_sight, distances, false, 1); });
+	const auto edt_parallel_time = time([&] { euclidean_distance_transform(map, blocks_sight, distances); });
+
+	std::cout << "1024x1024: line casts for 8 viewers " << line_cast_time << "ms, shadowcasting for 256 viewers " << single_time << "ms (1 thread) / "
+		<< parallel_time << "ms (all threads), distance field " << field_time << "ms (first) / " << field_again_time << "ms (reused), EDT "
+		<< edt_single_time << "ms (1 thread) / " << edt_parallel_time << "ms (all threads) (" << sink << ")\n";
+}
+
+namespace
+{
+	std::vector<circle> random_circles(size_t count, unsigned seed)
+	{
+		std::mt19937 rng{ seed };
+		std::uniform_real_distribution<float> position{ 0.0f, 1000.0f }, radius{ 1.0f, 20.0f }, outside{ -300.0f, 1300.0f };
+		std::vector<circle> result;
+		for (size_t i = 0; i < count; ++i)
+		{
+			/// A few large ones and a few outside the usual area
+			const auto big = i % 97 == 0, away = i % 101 == 0;
+			result.push_back({ { away ? outside(rng) : position(rng), away ? outside(rng) : position(rng) }, radius(rng) * (big ? 8.0f : 1.0f) });
+		}
+		return result;
+	}
+
+	float circle_distance(circle const& c, glm::vec2 pt) { return std::max(0.0f, glm::distance(c.center, pt) - c.radius); }
+
+	template <typename INDEX> INDEX make_spatial_index() { return INDEX{}; }
+	template <> loose_quadtree make_spatial_index<loose_quadtree>() { return loose_quadtree{ { .bounds = { 0, 0, 1000, 1000 }, .max_depth = 6 } }; }
+	template <> hash_grid make_spatial_index<hash_grid>() { return hash_grid{ { .cell_size = 25 } }; }
+
+	std::vector<std::pair<uint32_t, uint32_t>> brute_force_pairs(std::span<rec2 const> boxes)
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> result;
+		for (uint32_t a = 0; a < boxes.size(); ++a)
+			for (uint32_t b = a + 1; b < boxes.size(); ++b)
+				if (boxes[a].intersects(boxes[b]))
+					result.emplace_back(a, b);
+		return result;
+	}
+
+	template <typename INDEX>
+	void expect_index_matches_brute_force(INDEX const& index, std::span<circle const> circles, unsigned seed)
+	{
+		std::vector<rec2> boxes;
+		for (auto const& c : circles)
+			boxes.push_back(c.bounding_box());
+
+		std::mt19937 rng{ seed };
+		std::uniform_real_distribution<float> position{ -100.0f, 1100.0f }, size{ 0.0f, 150.0f }, angle{ 0.0f, 6.2831853f };
+		for (int i = 0; i < 100; ++i)
+		{
+			const auto range = rec2::from_size({ position(rng), position(rng) }, { size(rng), size(rng) });
+			std::vector<uint32_t> expected, actual;
+			for (uint32_t id = 0; id < boxes.size(); ++id)
+				if (boxes[id].intersects(range))
+					expected.push_back(id);
+			index.query(range, [&](uint32_t id) { actual.push_back(id); });
+			std::ranges::sort(actual);
+			ASSERT_EQ(actual, expected);
+
+			const glm::vec2 start{ position(rng), position(rng) }, dir{ std::cos(angle(rng)), std::sin(angle(rng)) };
+			const auto max_distance = i % 10 == 0 ? std::numeric_limits<float>::infinity() : size(rng) * 4;
+			const ghassanpl::geometry::detail::ray_segment<float> ray{ start, dir, max_distance };
+			std::vector<uint32_t> expected_hits, actual_hits;
+			std::optional<float> expected_closest;
+			for (uint32_t id = 0; id < boxes.size(); ++id)
+				if (const auto entry = ray.entry(boxes[id]))
+				{
+					expected_hits.push_back(id);
+					expected_closest = std::min(expected_closest.value_or(*entry), *entry);
+				}
+			index.raycast(start, dir, max_distance, [&](uint32_t id, float distance) {
+				EXPECT_EQ(ray.entry(boxes[id]), distance);
+				actual_hits.push_back(id);
+			});
+			std::ranges::sort(actual_hits);
+			ASSERT_EQ(actual_hits, expected_hits);
+			const auto closest = index.closest_hit(start, dir, max_distance);
+			ASSERT_EQ(closest.has_value(), expected_closest.has_value());
+			if (closest)
+			{
+				EXPECT_EQ(closest->distance, *expected_closest);
+			}
+
+			auto expected_nearest = std::numeric_limits<float>::infinity();
+			for (auto const& c : circles)
+				expected_nearest = std::min(expected_nearest, circle_distance(c, start));
+			const auto nearest = index.nearest(start, [&](uint32_t id, glm::vec2 pt) { return circle_distance(circles[id], pt); });
+			ASSERT_TRUE(nearest.has_value());
+			EXPECT_EQ(nearest->distance, expected_nearest);
+			EXPECT_EQ(circle_distance(circles[nearest->id], start), expected_nearest);
+			const auto limited = index.nearest(start, [&](uint32_t id, glm::vec2 pt) { return circle_distance(circles[id], pt); }, 5.0f);
+			EXPECT_EQ(limited.has_value(), expected_nearest <= 5.0f);
+		}
+
+		const auto expected_pairs = brute_force_pairs(boxes);
+		auto pairs = index.overlapping_pairs(1);
+		EXPECT_EQ(index.overlapping_pairs(4), pairs) << "the order of pairs should not depend on the number of threads";
+		std::ranges::sort(pairs);
+		EXPECT_EQ(pairs, expected_pairs);
+
+		std::vector<std::pair<uint32_t, uint32_t>> visited;
+		index.for_each_overlapping_pair([&](uint32_t a, uint32_t b) { EXPECT_LT(a, b); visited.emplace_back(a, b); });
+		std::ranges::sort(visited);
+		EXPECT_EQ(visited, expected_pairs);
+
+		const auto touching = [&](uint32_t a, uint32_t b) { return glm::distance(circles[a].center, circles[b].center) <= circles[a].radius + circles[b].radius; };
+		auto narrow = index.overlapping_pairs(touching, 3);
+		std::ranges::sort(narrow);
+		std::vector<std::pair<uint32_t, uint32_t>> expected_narrow;
+		std::ranges::copy_if(expected_pairs, std::back_inserter(expected_narrow), [&](auto const& pair) { return touching(pair.first, pair.second); });
+		EXPECT_EQ(narrow, expected_narrow);
+
+		size_t calls = 0;
+		EXPECT_TRUE(index.query(rec2{ -1000, -1000, 2000, 2000 }, [&](uint32_t) { return ++calls == 3; }));
+		EXPECT_EQ(calls, 3);
+	}
+}
+
+template <typename INDEX>
+struct spatial_index_test : ::testing::Test {};
+using spatial_index_types = ::testing::Types<bvh, loose_quadtree, hash_grid>;
+TYPED_TEST_SUITE(spatial_index_test, spatial_index_types);
+
+TYPED_TEST(spatial_index_test, matches_brute_force)
+{
+	auto circles = random_circles(1500, 32);
+	auto index = make_spatial_index<TypeParam>();
+	index.build(std::span<circle const>{ circles });
+	EXPECT_EQ(index.size(), circles.size());
+	expect_index_matches_brute_force(index, circles, 33);
+
+	/// Moving a third of the objects around
+	std::mt19937 rng{ 34 };
+	std::uniform_real_distribution<float> offset{ -50.0f, 50.0f };
+	for (uint32_t id = 0; id < circles.size(); id += 3)
+	{
+		circles[id].center += glm::vec2{ offset(rng), offset(rng) };
+		index.update(id, circles[id].bounding_box());
+	}
+	if constexpr (requires { index.refit(); })
+		index.refit();
+	expect_index_matches_brute_force(index, circles, 35);
+
+	TypeParam empty = make_spatial_index<TypeParam>();
+	EXPECT_FALSE(empty.nearest({ 0, 0 }).has_value());
+	EXPECT_FALSE(empty.closest_hit({ 0, 0 }, { 1, 0 }).has_value());
+	EXPECT_TRUE(empty.overlapping_pairs().empty());
+}
+
+TEST(spatial_index, dynamic_indices_insert_and_remove)
+{
+	const auto circles = random_circles(500, 36);
+	loose_quadtree quadtree{ { .bounds = { 0, 0, 1000, 1000 } } };
+	hash_grid grid{ { .cell_size = 40 } };
+	for (uint32_t id = 0; id < circles.size(); id += 2)
+	{
+		quadtree.insert(id, circles[id].bounding_box());
+		grid.insert(id, circles[id].bounding_box());
+	}
+	EXPECT_THROW(quadtree.insert(0, {}), std::invalid_argument);
+	EXPECT_THROW(grid.update(1, {}), std::invalid_argument);
+
+	for (uint32_t id = 0; id < circles.size(); id += 4)
+	{
+		EXPECT_TRUE(quadtree.remove(id));
+		EXPECT_TRUE(grid.remove(id));
+	}
+	EXPECT_FALSE(grid.remove(0));
+
+	std::vector<uint32_t> expected;
+	for (uint32_t id = 2; id < circles.size(); id += 4)
+		expected.push_back(id);
+	for (auto const* index : { static_cast<void const*>(&quadtree), static_cast<void const*>(&grid) })
+	{
+		std::vector<uint32_t> found;
+		const auto collect = [&](uint32_t id) { found.push_back(id); };
+		if (index == &quadtree) quadtree.query(rec2{ -1000, -1000, 2000, 2000 }, collect);
+		else grid.query(rec2{ -1000, -1000, 2000, 2000 }, collect);
+		std::ranges::sort(found);
+		EXPECT_EQ(found, expected);
+	}
+	EXPECT_EQ(quadtree.size(), expected.size());
+	EXPECT_EQ(grid.size(), expected.size());
+}
+
+TEST(spatial_index, DISABLED_benchmark_broad_phase)
+{
+	std::mt19937 rng{ 37 };
+	std::uniform_real_distribution<float> position{ 0.0f, 10000.0f }, size{ 2.0f, 20.0f }, offset{ -2.0f, 2.0f };
+	std::vector<rec2> boxes;
+	for (int i = 0; i < 100000; ++i)
+		boxes.push_back(rec2::from_size({ position(rng), position(rng) }, { size(rng), size(rng) }));
+
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	const auto benchmark = [&](auto& index, char const* name) {
+		size_t sink = 0;
+		const auto build_time = time([&] { index.build(std::span<rec2 const>{ boxes }); });
+		const auto pairs_time = time([&] { sink += index.overlapping_pairs(1).size(); });
+		const auto parallel_pairs_time = time([&] { sink += index.overlapping_pairs().size(); });
+		const auto query_time = time([&] {
+			for (int i = 0; i < 10000; ++i)
+				index.query(rec2::from_size({ position(rng), position(rng) }, { 50, 50 }), [&](uint32_t) { ++sink; });
+		});
+		const auto nearest_time = time([&] { for (int i = 0; i < 10000; ++i) sink += index.nearest({ position(rng), position(rng) })->id; });
+		const auto ray_time = time([&] { for (int i = 0; i < 10000; ++i) sink += index.closest_hit({ position(rng), position(rng) }, { 0.6f, 0.8f }).has_value(); });
+		auto moved = boxes;
+		for (auto& box : moved)
+			box += glm::vec2{ offset(rng), offset(rng) };
+		const auto update_time = time([&] {
+			if constexpr (requires { index.refit(moved); })
+				index.refit(moved);
+			else
+				for (uint32_t id = 0; id < moved.size(); ++id)
+					index.update(id, moved[id]);
+		});
+		std::cout << name << ": build " << build_time << "ms, all pairs " << pairs_time << "ms (1 thread) / " << parallel_pairs_time << "ms (all threads), 10k range queries "
+			<< query_time << "ms, 10k nearest " << nearest_time << "ms, 10k rays " << ray_time << "ms, moving everything " << update_time << "ms (" << sink << ")\n";
+	};
+
+	bvh tree;
+	loose_quadtree quadtree{ { .bounds = { 0, 0, 10000, 10000 } } };
+	hash_grid grid{ { .cell_size = 32 } };
+	benchmark(tree, "bvh");
+	benchmark(quadtree, "loose quadtree");
+	benchmark(grid, "hash grid");
+}
+
+namespace
+{
+	template <typename T>
+	struct random_points
+	{
+		std::vector<T> xs, ys;
+		random_points(size_t count, unsigned seed, T low = T(-1.5), T high = T(1.5))
+		{
+			std::mt19937 rng{ seed };
+			std::uniform_real_distribution<T> coordinate{ low, high };
+			for (size_t i = 0; i < count; ++i)
+			{
+				xs.push_back(coordinate(rng));
+				ys.push_back(coordinate(rng));
+			}
+		}
+	};
+
+	template <typename T, typename SHAPE>
+	void expect_contains_batch_matches(SHAPE const& shape)
+	{
+		for (const auto count : { size_t(0), size_t(1), size_t(7), size_t(64), size_t(203), size_t(1000) })
+		{
+			const random_points<T> points{ count, unsigned(count) };
+			std::vector<uint64_t> bits((count + 63) / 64 + 1, ~uint64_t{});
+			contains_batch(shape, std::span<T const>{ points.xs }, std::span<T const>{ points.ys }, std::span{ bits });
+			for (size_t i = 0; i < count; ++i)
+				ASSERT_EQ(((bits[i / 64] >> (i % 64)) & 1) != 0, shape.contains({ points.xs[i], points.ys[i] })) << "point " << i << " of " << count;
+			if (count % 64)
+			{
+				EXPECT_EQ(bits[count / 64] >> (count % 64), 0) << "unused bits should be cleared";
+			}
+		}
+	}
+
+	template <typename T>
+	void expect_contains_batch_matches_all_shapes()
+	{
+		expect_contains_batch_matches<T>(tcircle<T>{ { T(0.1), T(-0.2) }, T(0.9) });
+		expect_contains_batch_matches<T>(ghassanpl::trec2<T>{ T(-0.5), T(-0.25), T(0.75), T(1) });
+		expect_contains_batch_matches<T>(ttriangle<T>{ { T(-1), T(-1) }, { T(1), T(-0.5) }, { T(0), T(1.2) } });
+		expect_contains_batch_matches<T>(ttriangle<T>{ { T(0), T(1.2) }, { T(1), T(-0.5) }, { T(-1), T(-1) } });
+
+		/// A star, which is concave
+		tpolygon<T> star;
+		for (int i = 0; i < 10; ++i)
+		{
+			const auto angle = T(i) * T(0.6283185307);
+			const auto radius = i % 2 ? T(0.4) : T(1.2);
+			star.vertices.push_back({ std::cos(angle) * radius, std::sin(angle) * radius });
+		}
+		expect_contains_batch_matches<T>(star);
+	}
+}
+
+TEST(batch_queries, contains_matches_scalar_functions)
+{
+	expect_contains_batch_matches_all_shapes<float>();
+	expect_contains_batch_matches_all_shapes<double>();
+
+	const random_points<float> points{ 10, 1 };
+	std::vector<uint64_t> too_small;
+	EXPECT_THROW(contains_batch(circle{ {}, 1 }, std::span<float const>{ points.xs }, std::span<float const>{ points.ys }, std::span{ too_small }), std::invalid_argument);
+}
+
+TEST(batch_queries, ray_intersections_match_scalar_function)
+{
+	const random_points<float> starts{ 1003, 2, -2.0f, 2.0f }, dirs{ 1003, 3, -1.0f, 1.0f };
+	const rays_soa rays{ starts.xs, starts.ys, dirs.xs, dirs.ys };
+
+	std::vector<segment> segments;
+	const random_points<float> ends{ 32, 4, -2.0f, 2.0f };
+	for (size_t i = 0; i < ends.xs.size(); i += 2)
+		segments.push_back({ { ends.xs[i], ends.ys[i] }, { ends.xs[i + 1], ends.ys[i + 1] } });
+
+	std::vector<float> single(rays.size()), closest(rays.size());
+	intersect_batch(rays, segments[0], std::span{ single });
+	intersect_batch(rays, std::span<segment const>{ segments }, std::span{ closest });
+
+	size_t hits = 0;
+	for (size_t i = 0; i < rays.size(); ++i)
+	{
+		const ray r{ { starts.xs[i], starts.ys[i] }, { dirs.xs[i], dirs.ys[i] } };
+		ASSERT_EQ(single[i], r.intersection_distance(segments[0]).value_or(std::numeric_limits<float>::infinity())) << i;
+
+		auto expected = std::numeric_limits<float>::infinity();
+		for (auto const& s : segments)
+			expected = std::min(expected, r.intersection_distance(s).value_or(std::numeric_limits<float>::infinity()));
+		ASSERT_EQ(closest[i], expected) << i;
+		hits += expected != std::numeric_limits<float>::infinity();
+	}
+	EXPECT_GT(hits, rays.size() / 4);
+}
+
+TEST(batch_queries, DISABLED_benchmark_against_scalar)
+{
+	const random_points<float> points{ 1 << 20, 5 };
+	polygon gon;
+	for (int i = 0; i < 32; ++i)
+		gon.vertices.push_back({ std::cos(float(i) * 0.19634954f), std::sin(float(i) * 0.19634954f) });
+
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	size_t sink = 0;
+	std::vector<uint64_t> bits(points.xs.size() / 64);
+	const auto scalar_time = time([&] { for (size_t i = 0; i < points.xs.size(); ++i) sink += gon.contains({ points.xs[i], points.ys[i] }); });
+	const auto batch_time = time([&] { contains_batch(gon, std::span<float const>{ points.xs }, std::span<float const>{ points.ys }, std::span{ bits }); sink += bits[5]; });
+	const auto circle_scalar_time = time([&] { for (size_t i = 0; i < points.xs.size(); ++i) sink += circle{ {}, 1 }.contains({ points.xs[i], points.ys[i] }); });
+	const auto circle_batch_time = time([&] { contains_batch(circle{ {}, 1 }, std::span<float const>{ points.xs }, std::span<float const>{ points.ys }, std::span{ bits }); sink += bits[5]; });
+
+	std::vector<segment> occluders;
+	for (size_t i = 0; i < 64; ++i)
+		occluders.push_back({ { points.xs[i], points.ys[i] }, { points.xs[i + 64], points.ys[i + 64] } });
+	const rays_soa rays{ std::span{ points.xs }.first(1 << 16), std::span{ points.ys }.first(1 << 16), std::span{ points.ys }.last(1 << 16), std::span{ points.xs }.last(1 << 16) };
+	std::vector<float> distances(rays.size());
+	const auto ray_scalar_time = time([&] {
+		for (size_t i = 0; i < rays.size(); ++i)
+		{
+			const ray r{ { rays.start_xs[i], rays.start_ys[i] }, { rays.dir_xs[i], rays.dir_ys[i] } };
+			for (auto const& o : occluders)
+				sink += r.intersection_distance(o).has_value();
+		}
+	});
+	const auto ray_batch_time = time([&] { intersect_batch(rays, std::span<segment const>{ occluders }, std::span{ distances }); sink += size_t(distances[7]); });
+
+	std::cout << "1M points in a 32-gon: scalar " << scalar_time << "ms, batch " << batch_time << "ms; in a circle: scalar " << circle_scalar_time << "ms, batch " << circle_batch_time
+		<< "ms; 64k rays against 64 segments: scalar " << ray_scalar_time << "ms, batch " << ray_batch_time << "ms (" << sink << ")\n";
+}
+
+namespace
+{
+	double triangle_signed_area(std::span<glm::vec2 const> vertices, indexed_triangle const& tr)
+	{
+		const glm::dvec2 a{ vertices[tr.indices[0]] }, b{ vertices[tr.indices[1]] }, c{ vertices[tr.indices[2]] };
+		return ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)) / 2;
+	}
+
+	double ring_area(std::span<glm::vec2 const> ring)
+	{
+		double result = 0;
+		for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+			result += double(ring[j].x) * ring[i].y - double(ring[i].x) * ring[j].y;
+		return std::abs(result) / 2;
+	}
+
+	/// A star with jittered radii, so it has plenty of reflex vertices
+	std::vector<glm::vec2> noisy_star(size_t count, unsigned seed)
+	{
+		std::mt19937 rng{ seed };
+		std::uniform_real_distribution<float> radius{ 0.3f, 1.0f };
+		std::vector<glm::vec2> result;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto angle = float(i) * glm::two_pi<float>() / float(count);
+			const auto r = i % 2 ? radius(rng) : 1.0f;
+			result.push_back({ std::cos(angle) * r, std::sin(angle) * r });
+		}
+		return result;
+	}
+
+	std::vector<glm::vec2> to_points(random_points<float> const& points)
+	{
+		std::vector<glm::vec2> result;
+		for (size_t i = 0; i < points.xs.size(); ++i)
+			result.push_back({ points.xs[i], points.ys[i] });
+		return result;
+	}
+}
+
+TEST(triangulation, earcut_covers_polygons)
+{
+	polygon square;
+	square.vertices = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+	const auto square_triangulation = triangulate(square);
+	EXPECT_EQ(square_triangulation.triangles.size(), 2);
+	EXPECT_FLOAT_EQ(calculate_total_area(square_triangulation), 1.0f);
+
+	for (const auto count : { size_t(3), size_t(5), size_t(50), size_t(500), size_t(5000) })
+	{
+		auto star = noisy_star(count, unsigned(count));
+		for (int reversed = 0; reversed < 2; ++reversed)
+		{
+			const auto triangles = earcut(star);
+			ASSERT_EQ(triangles.size(), count - 2) << count;
+			double area = 0;
+			for (auto const& tr : triangles)
+			{
+				const auto tr_area = triangle_signed_area(star, tr);
+				EXPECT_GT(tr_area, 0) << "triangles should be counter-clockwise";
+				area += tr_area;
+			}
+			EXPECT_NEAR(area, ring_area(star), ring_area(star) * 1e-6) << count;
+			std::ranges::reverse(star);
+		}
+	}
+
+	EXPECT_TRUE(earcut(std::vector<glm::vec2>{ { 0, 0 }, { 1, 1 } }).empty());
+}
+
+TEST(triangulation, earcut_handles_holes)
+{
+	const std::vector<glm::vec2> vertices{
+		{ 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 }, /// outer
+		{ 2, 2 }, { 4, 2 }, { 4, 4 }, { 2, 4 }, /// counter-clockwise hole
+		{ 6, 6 }, { 6, 8 }, { 8, 8 }, { 8, 6 }, /// clockwise hole
+	};
+	const std::vector<size_t> hole_starts{ 4, 8 };
+	const auto triangles = earcut(vertices, hole_starts);
+	ASSERT_EQ(triangles.size(), 14);
+
+	double area = 0;
+	for (auto const& tr : triangles)
+	{
+		area += triangle_signed_area(vertices, tr);
+		const auto centroid = (vertices[tr.indices[0]] + vertices[tr.indices[1]] + vertices[tr.indices[2]]) / 3.0f;
+		EXPECT_FALSE(centroid.x > 2 && centroid.x < 4 && centroid.y > 2 && centroid.y < 4);
+		EXPECT_FALSE(centroid.x > 6 && centroid.x < 8 && centroid.y > 6 && centroid.y < 8);
+	}
+	EXPECT_DOUBLE_EQ(area, 92.0);
+
+	const std::vector<size_t> bad_hole_starts{ 8, 4 };
+	EXPECT_THROW(earcut(vertices, bad_hole_starts), std::invalid_argument);
+}
+
+TEST(triangulation, delaunay_triangles_have_empty_circumcircles)
+{
+	auto points = to_points({ 1000, 11 });
+	delaunay_triangulation dt{ points };
+	ASSERT_EQ(dt.triangles.size(), 2 * points.size() - 2 - dt.hull.size());
+	ASSERT_EQ(dt.neighbors.size(), dt.triangles.size());
+
+	size_t hull_edges = 0;
+	for (size_t t = 0; t < dt.triangles.size(); ++t)
+	{
+		auto const& tr = dt.triangles[t];
+		ASSERT_GT(triangle_signed_area(points, tr), 0);
+
+		for (size_t k = 0; k < 3; ++k)
+		{
+			const auto other = dt.neighbors[t][k];
+			if (other == invalid_index)
+			{
+				++hull_edges;
+				continue;
+			}
+			const auto back = std::ranges::find(dt.neighbors[other], t) - dt.neighbors[other].begin();
+			ASSERT_LT(back, 3);
+			EXPECT_EQ(dt.triangles[other].indices[back], tr.indices[(k + 1) % 3]);
+			EXPECT_EQ(dt.triangles[other].indices[(back + 1) % 3], tr.indices[k]);
+		}
+
+		const glm::dvec2 a{ points[tr.indices[0]] }, b{ points[tr.indices[1]] }, c{ points[tr.indices[2]] };
+		const double d = 2 * (a.x * (b.y - c.y) + b.x * (c.y - a.y) + c.x * (a.y - b.y));
+		const glm::dvec2 center{
+			(glm::dot(a, a) * (b.y - c.y) + glm::dot(b, b) * (c.y - a.y) + glm::dot(c, c) * (a.y - b.y)) / d,
+			(glm::dot(a, a) * (c.x - b.x) + glm::dot(b, b) * (a.x - c.x) + glm::dot(c, c) * (b.x - a.x)) / d,
+		};
+		const auto radius_squared = glm::dot(a - center, a - center);
+		for (auto const& p : points)
+			ASSERT_GE(glm::dot(glm::dvec2{ p } - center, glm::dvec2{ p } - center), radius_squared * (1 - 1e-9)) << "triangle " << t;
+	}
+	EXPECT_EQ(hull_edges, dt.hull.size());
+
+	/// The hull is convex
+	for (size_t i = 0; i < dt.hull.size(); ++i)
+	{
+		const auto a = points[dt.hull[i]], b = points[dt.hull[(i + 1) % dt.hull.size()]], c = points[dt.hull[(i + 2) % dt.hull.size()]];
+		EXPECT_LT((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x), 0);
+	}
+
+	/// Cocircular points on a lattice still give a full triangulation
+	std::vector<glm::vec2> lattice;
+	for (int y = 0; y < 20; ++y)
+		for (int x = 0; x < 20; ++x)
+			lattice.push_back({ float(x), float(y) });
+	delaunay_triangulation lattice_dt{ lattice };
+	EXPECT_EQ(lattice_dt.hull.size(), 76);
+	EXPECT_EQ(lattice_dt.triangles.size(), 2 * 19 * 19);
+	double lattice_area = 0;
+	for (auto const& tr : lattice_dt.triangles)
+		lattice_area += triangle_signed_area(lattice, tr);
+	EXPECT_DOUBLE_EQ(lattice_area, 19.0 * 19.0);
+
+	std::vector<glm::vec2> collinear{ { 0, 0 }, { 1, 1 }, { 2, 2 }, { 3, 3 } };
+	EXPECT_TRUE(delaunay_triangulation{ collinear }.triangles.empty());
+}
+
+TEST(triangulation, triangle_at_matches_brute_force)
+{
+	auto points = to_points({ 2000, 12 });
+	const delaunay_triangulation dt{ points };
+	const auto queries = to_points({ 2000, 13, -1.7f, 1.7f });
+
+	const auto contains = [&](size_t t, glm::vec2 p) {
+		auto const& tr = dt.triangles[t];
+		for (size_t k = 0; k < 3; ++k)
+		{
+			const glm::dvec2 a{ points[tr.indices[k]] }, b{ points[tr.indices[(k + 1) % 3]] };
+			if ((b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x) < 0)
+				return false;
+		}
+		return true;
+	};
+
+	size_t inside = 0, previous = invalid_index;
+	for (auto const& q : queries)
+	{
+		size_t expected = invalid_index;
+		for (size_t t = 0; t < dt.triangles.size() && expected == invalid_index; ++t)
+			if (contains(t, q))
+				expected = t;
+
+		const auto found = dt.triangle_at(q);
+		if (expected == invalid_index)
+		{
+			ASSERT_EQ(found, invalid_index);
+		}
+		else
+		{
+			ASSERT_NE(found, invalid_index);
+			ASSERT_TRUE(contains(found, q));
+			ASSERT_EQ(dt.triangle_at(q, previous), found);
+			previous = found;
+			++inside;
+
+			const auto weights = dt.interpolation_of(q);
+			EXPECT_NEAR(weights[0].weight + weights[1].weight + weights[2].weight, 1.0f, 1e-4f);
+		}
+	}
+	EXPECT_GT(inside, queries.size() / 2);
+}
+
+TEST(triangulation, DISABLED_benchmark)
+{
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	/// A coastline-like outline: large scale bays, with jitter on the scale of the vertex spacing
+	std::vector<glm::vec2> coast;
+	std::mt19937 rng{ 1 };
+	std::uniform_real_distribution<float> jitter{ -1.0f, 1.0f };
+	for (size_t i = 0; i < 100000; ++i)
+	{
+		const auto angle = float(i) * glm::two_pi<float>() / 100000.0f;
+		const auto r = 1.0f + 0.3f * std::sin(angle * 7) + 0.1f * std::sin(angle * 53) + (glm::two_pi<float>() / 100000.0f) * jitter(rng);
+		coast.push_back({ std::cos(angle) * r, std::sin(angle) * r });
+	}
+	size_t sink = 0;
+	const auto earcut_time = time([&] { sink += earcut(coast).size(); });
+
+	auto points = to_points({ 100000, 2 });
+	delaunay_triangulation<float> dt;
+	const auto delaunay_time = time([&] { dt = delaunay_triangulation{ points }; });
+
+	const auto queries = to_points({ 100000, 3 });
+	const auto jump_time = time([&] { for (auto const& q : queries) sink += dt.triangle_at(q); });
+	/// Coherent queries along a random walk, where each result is a good hint for the next query
+	std::vector<glm::vec2> path{ { 0, 0 } };
+	for (size_t i = 1; i < queries.size(); ++i)
+		path.push_back(glm::clamp(path.back() + queries[i] * 0.01f, glm::vec2{ -1.5f }, glm::vec2{ 1.5f }));
+	size_t hint = invalid_index;
+	const auto hinted_time = time([&] { for (auto const& q : path) sink += (hint = dt.triangle_at(q, hint)); });
+
+	std::cout << "100k vertex polygon earcut: " << earcut_time << "ms; 100k point Delaunay: " << delaunay_time << "ms; 100k triangle_at: " << jump_time
+		<< "ms, along a path with hints: " << hinted_time << "ms (" << sink << ")\n";
+}
+
+TEST(cached_polygon, matches_polygon_queries)
+{
+	const polygon poly{ noisy_star(500, 21) };
+	const cached_polygon cached{ poly };
+
+	EXPECT_NEAR(cached.edge_length(), poly.edge_length(), 1e-4f);
+	EXPECT_NEAR(cached.calculate_area(), poly.calculate_area(), 1e-5f);
+	EXPECT_NEAR(glm::distance(cached.centroid(), poly.centroid()), 0.0f, 1e-5f);
+	EXPECT_EQ(cached.bounding_box(), poly.bounding_box());
+
+	for (float t = -0.5f; t < 2.0f; t += 0.0137f)
+	{
+		/// Sums of the edge lengths differ slightly in float, as they are accumulated differently
+		EXPECT_NEAR(glm::distance(cached.edge_point_alpha(t), poly.edge_point_alpha(t)), 0.0f, 5e-4f) << t;
+		EXPECT_NEAR(glm::distance(cached.edge_point(t * 3), poly.edge_point(t * 3)), 0.0f, 5e-4f) << t;
+	}
+
+	const random_points<float> points{ 2000, 22, -1.2f, 1.2f };
+	for (size_t i = 0; i < points.xs.size(); ++i)
+	{
+		const glm::vec2 p{ points.xs[i], points.ys[i] };
+		ASSERT_EQ(cached.contains(p), poly.contains(p)) << i;
+		ASSERT_NEAR(glm::distance(cached.closest_point_to(p), p), glm::distance(poly.closest_point_to(p), p), 1e-5f) << i;
+	}
+}
+
+TEST(cached_polygon, classifies_polygons)
+{
+	cached_polygon square{ std::vector<glm::vec2>{ { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } } };
+	EXPECT_TRUE(square.classify().is_convex());
+	EXPECT_EQ(square.classify().winding, winding_order::counter_clockwise);
+	EXPECT_FLOAT_EQ(square.calculate_area(), 1.0f);
+
+	square.modify([](auto& vertices) { std::ranges::reverse(vertices); });
+	EXPECT_TRUE(square.classify().is_convex());
+	EXPECT_EQ(square.classify().winding, winding_order::clockwise);
+	EXPECT_FLOAT_EQ(square.calculate_area(), -1.0f);
+
+	const cached_polygon star{ noisy_star(50, 23) };
+	EXPECT_TRUE(star.classify().is_concave());
+
+	const cached_polygon bowtie{ std::vector<glm::vec2>{ { 0, 0 }, { 1, 1 }, { 1, 0 }, { 0, 1 } } };
+	EXPECT_TRUE(bowtie.classify().intersects_itself());
+	EXPECT_FALSE(bowtie.classify().is_convex());
+}
+
+TEST(cached_polygon, modifications_invalidate_cached_data)
+{
+	cached_polygon poly{ std::vector<glm::vec2>{ { 0, 0 }, { 2, 0 }, { 2, 2 }, { 0, 2 } } };
+	poly.precalculate();
+	EXPECT_FLOAT_EQ(poly.calculate_area(), 4.0f);
+	EXPECT_FLOAT_EQ(poly.edge_length(), 6.0f);
+
+	poly.set_vertex(2, { 4, 4 });
+	EXPECT_FLOAT_EQ(poly.calculate_area(), 8.0f);
+	EXPECT_TRUE(poly.contains({ 3, 2.5f }));
+	EXPECT_EQ(poly.bounding_box(), (ghassanpl::trec2<float>{ 0, 0, 4, 4 }));
+
+	poly.translate({ 10, 0 });
+	EXPECT_FLOAT_EQ(poly.calculate_area(), 8.0f);
+	EXPECT_FALSE(poly.contains({ 3, 2.5f }));
+	EXPECT_TRUE(poly.contains({ 13, 2.5f }));
+	EXPECT_EQ(poly.closest_point_to({ 0, 1 }), glm::vec2(10, 1));
+	EXPECT_EQ(poly.bounding_box(), (ghassanpl::trec2<float>{ 10, 0, 14, 4 }));
+
+	poly.insert(1, { 12, -2 });
+	EXPECT_FLOAT_EQ(poly.calculate_area(), 10.0f);
+	poly.erase(1);
+	EXPECT_FLOAT_EQ(poly.calculate_area(), 8.0f);
+	poly.push_back({ 8, 2 });
+	EXPECT_FLOAT_EQ(poly.calculate_area(), 10.0f);
+	EXPECT_THROW(poly.erase(5), std::invalid_argument);
+
+	poly.clear();
+	EXPECT_EQ(poly.edge_length(), 0.0f);
+	EXPECT_FALSE(poly.contains({ 0, 0 }));
+}
+
+TEST(cached_polygon, DISABLED_benchmark_edge_point_alpha)
+{
+	const polygon poly{ noisy_star(1000, 24) };
+	const cached_polygon cached{ poly };
+
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	glm::vec2 sink{};
+	const auto polygon_time = time([&] { for (int i = 0; i < 10000; ++i) sink += poly.edge_point_alpha(float(i) / 10000.0f); });
+	const auto cached_time = time([&] { for (int i = 0; i < 10000; ++i) sink += cached.edge_point_alpha(float(i) / 10000.0f); });
+	std::cout << "10k edge_point_alpha on a 1000-gon: polygon " << polygon_time << "ms, cached " << cached_time << "ms (" << sink.x << ")\n";
+}
+
 /*
 
 struct tile_data {};
@@ -0,0 +1,173 @@
+/// This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "tests_common.h"
+#include <gtest/gtest.h>
+
+#include "../include/ghassanpl/interpolation.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace ghassanpl;
+
+namespace
+{
+	/// 1001 samples from 0 to 1, so that every function goes through both the vectorized loop and the remainder
+	std::vector<float> sample_parameters(size_t count = 1001)
+	{
+		std::vector<float> result(count);
+		for (size_t i = 0; i < count; ++i)
+			result[i] = float(i) / float(count - 1);
+		return result;
+	}
+
+	template <typename VEC>
+	void expect_near(VEC const& a, VEC const& b, float tolerance)
+	{
+		for (glm::length_t c = 0; c < VEC::length(); ++c)
+			ASSERT_NEAR(a[c], b[c], tolerance) << c;
+	}
+
+	const glm::vec2 p0{ 0, 0 }, p1{ 1, 3 }, p2{ 4, 3 }, p3{ 5, -1 };
+}
+
+TEST(interpolation, lerp_unlerp_and_remap_samples)
+{
+	const auto t = sample_parameters();
+	std::vector<float> values(t.size()), back(t.size());
+
+	lerp_samples(-2.0f, 6.0f, std::span<float const>{ t }, std::span<float>{ values });
+	EXPECT_EQ(values.front(), -2.0f);
+	EXPECT_EQ(values.back(), 6.0f);
+	for (size_t i = 0; i < t.size(); ++i)
+		ASSERT_NEAR(values[i], -2.0f + 8.0f * t[i], 1e-5f) << i;
+
+	unlerp_samples(-2.0f, 6.0f, std::span<float const>{ values }, std::span<float>{ back });
+	for (size_t i = 0; i < t.size(); ++i)
+		ASSERT_NEAR(back[i], t[i], 1e-6f) << i;
+
+	remap_samples(-2.0f, 6.0f, 10.0f, 0.0f, std::span<float const>{ values }, std::span<float>{ back });
+	for (size_t i = 0; i < t.size(); ++i)
+		ASSERT_NEAR(back[i], 10.0f - 10.0f * t[i], 1e-5f) << i;
+
+	std::vector<float> too_small(t.size() - 1);
+	EXPECT_THROW(lerp_samples(0.0f, 1.0f, std::span<float const>{ t }, std::span<float>{ too_small }), std::invalid_argument);
+}
+
+TEST(interpolation, span_splines_match_single_samples)
+{
+	const auto t = sample_parameters();
+	std::vector<glm::vec2> out(t.size());
+
+	splines::bezier(p0, p1, p2, t, out);
+	for (size_t i = 0; i < t.size(); ++i)
+		expect_near(out[i], splines::bezier(p0, p1, p2, t[i]), 1e-5f);
+
+	splines::bezier(p0, p1, p2, p3, t, out);
+	for (size_t i = 0; i < t.size(); ++i)
+		expect_near(out[i], splines::bezier(p0, p1, p2, p3, t[i]), 1e-5f);
+	EXPECT_EQ(out.front(), p0);
+	EXPECT_EQ(out.back(), p3);
+
+	splines::catmullRom(p0, p1, p2, p3, t, out);
+	for (size_t i = 0; i < t.size(); ++i)
+		expect_near(out[i], splines::catmullRom(p0, p1, p2, p3, t[i]), 1e-5f);
+
+	splines::hermite(p0, p1, p2, p3, t, out);
+	for (size_t i = 0; i < t.size(); ++i)
+		expect_near(out[i], splines::hermite(p0, p1, p2, p3, t[i]), 1e-5f);
+
+	/// Doubles and other vector lengths go through the same engine
+	const std::vector<double> t_double(t.begin(), t.end());
+	std::vector<glm::dvec3> out3(t.size());
+	const glm::dvec3 a{ 1, 2, 3 }, b{ -1, 0, 5 }, c{ 2, 2, 2 };
+	splines::bezier(a, b, c, t_double, out3);
+	for (size_t i = 0; i < t.size(); ++i)
+		expect_near(out3[i], splines::bezier(a, b, c, t_double[i]), 1e-12f);
+
+	/// Three components do not divide the lane width, so the samples are spread differently over each lane group
+	std::vector<glm::vec3> out3f(t.size());
+	const glm::vec3 d{ 4, -3, 1 };
+	splines::bezier(glm::vec3{ a }, glm::vec3{ b }, glm::vec3{ c }, d, t, out3f);
+	for (size_t i = 0; i < t.size(); ++i)
+		expect_near(out3f[i], splines::bezier(glm::vec3{ a }, glm::vec3{ b }, glm::vec3{ c }, d, t[i]), 1e-5f);
+
+	std::vector<glm::vec2> too_small(t.size() - 1);
+	EXPECT_THROW(splines::bezier(p0, p1, p2, t, too_small), std::invalid_argument);
+}
+
+TEST(interpolation, arc_length_table_gives_even_spacing)
+{
+	const auto curve = [](float t) { return splines::bezier(p0, p1, p2, p3, t); };
+	const arc_length_table<float> table{ curve, 512 };
+
+	/// The length of a finely sampled polyline
+	float expected_length = 0;
+	for (int i = 1; i <= 100000; ++i)
+		expected_length += glm::distance(curve(float(i - 1) / 100000.0f), curve(float(i) / 100000.0f));
+	EXPECT_NEAR(table.length(), expected_length, expected_length * 1e-4f);
+
+	EXPECT_EQ(table.parameter_at(0), 0.0f);
+	EXPECT_FLOAT_EQ(table.parameter_at(table.length()), 1.0f);
+	EXPECT_EQ(table.parameter_at(-5), 0.0f);
+	EXPECT_FLOAT_EQ(table.parameter_at(table.length() * 2), 1.0f);
+	const std::vector<float> nan_distances(9, std::numeric_limits<float>::quiet_NaN());
+	std::vector<float> nan_parameters(nan_distances.size(), 1.0f);
+	table.parameters_at(nan_distances, nan_parameters);
+	for (size_t i = 0; i < nan_distances.size(); ++i)
+		ASSERT_EQ(nan_parameters[i], 0.0f) << i;
+	EXPECT_EQ(table.parameter_at(nan_distances[0]), 0.0f);
+
+	/// Points at evenly spaced distances are evenly spaced along the curve
+	constexpr size_t steps = 101;
+	std::vector<float> distances(steps), parameters(steps);
+	for (size_t i = 0; i < steps; ++i)
+		distances[i] = table.length() * float(i) / float(steps - 1);
+	table.parameters_at(distances, parameters);
+	for (size_t i = 0; i < steps; ++i)
+		ASSERT_FLOAT_EQ(parameters[i], table.parameter_at(distances[i])) << i;
+
+	std::vector<glm::vec2> points(steps);
+	splines::bezier(p0, p1, p2, p3, parameters, points);
+	const auto step = table.length() / float(steps - 1);
+	for (size_t i = 1; i < steps; ++i)
+		ASSERT_NEAR(glm::distance(points[i - 1], points[i]), step, step * 0.01f) << i;
+
+	EXPECT_THROW(arc_length_table<float>(curve, 0), std::invalid_argument);
+}
+
+TEST(interpolation, DISABLED_benchmark_span_evaluation)
+{
+	static constexpr size_t count = 1 << 20;
+	const auto t = sample_parameters(count);
+	std::vector<float> eased(count);
+	std::vector<glm::vec2> points(count);
+	const arc_length_table<float> table{ [](float s) { return splines::bezier(p0, p1, p2, p3, s); } };
+
+	const auto measure = [&](const char* name, auto&& per_sample, auto&& batch) {
+		using clock = std::chrono::steady_clock;
+		const auto millions_per_second = [](clock::duration time) { return double(count) / std::chrono::duration<double, std::micro>(time).count(); };
+		auto start = clock::now();
+		for (size_t i = 0; i < count; ++i)
+			per_sample(i);
+		const auto scalar_time = clock::now() - start;
+		start = clock::now();
+		batch();
+		const auto batch_time = clock::now() - start;
+		std::cout << name << ": " << millions_per_second(scalar_time) << " M/s per sample, " << millions_per_second(batch_time) << " M/s batched\n";
+	};
+
+	measure("in_out_cubic", [&](size_t i) { eased[i] = ease(easing::in_out_cubic, t[i]); }, [&] { ease(easing::in_out_cubic, std::span<float const>{ t }, std::span<float>{ eased }); });
+	measure("out_elastic", [&](size_t i) { eased[i] = ease(easing::out_elastic, t[i]); }, [&] { ease(easing::out_elastic, std::span<float const>{ t }, std::span<float>{ eased }); });
+	measure("out_bounce", [&](size_t i) { eased[i] = ease(easing::out_bounce, t[i]); }, [&] { ease(easing::out_bounce, std::span<float const>{ t }, std::span<float>{ eased }); });
+	measure("cubic bezier", [&](size_t i) { points[i] = splines::bezier(p0, p1, p2, p3, t[i]); }, [&] { splines::bezier(p0, p1, p2, p3, t, points); });
+	measure("catmull-rom", [&](size_t i) { points[i] = splines::catmullRom(p0, p1, p2, p3, t[i]); }, [&] { splines::catmullRom(p0, p1, p2, p3, t, points); });
+	measure("arc length parameters", [&](size_t i) { eased[i] = table.parameter_at(t[i] * table.length()); }, [&] { table.parameters_at(t, eased); });
+}
@@ -1 +1,234 @@
+/// This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "../include/ghassanpl/mmap.h"
+#include "../include/ghassanpl/mmap_prefetch.h"
+#include "../include/ghassanpl/mmap_impl.h"
+
 #include <gtest/gtest.h>
+#include <fstream>
+#include <numeric>
+#include <chrono>
+#include <iostream>
+
+using namespace ghassanpl;
+
+namespace
+{
+	std::filesystem::path make_test_file(std::string_view name, size_t size)
+	{
+		auto path = std::filesystem::temp_directory_path() / name;
+		std::vector<char> contents(size);
+		for (size_t i = 0; i < size; ++i)
+			contents[i] = char(i % 251);
+		std::ofstream{ path, std::ios::binary }.write(contents.data(), contents.size());
+		return path;
+	}
+
+	std::filesystem::path make_zeroed_file(std::string_view name, size_t size)
+	{
+		auto path = std::filesystem::temp_directory_path() / name;
+		std::filesystem::remove(path);
+		std::ofstream{ path, std::ios::binary };
+		std::filesystem::resize_file(path, size);
+		return path;
+	}
+}
+
+TEST(mmap, hints_do_not_change_contents)
+{
+	const auto path = make_test_file("ghpl_mmap_hints.bin", 100'000);
+
+	std::error_code error;
+	auto source = make_mmap_source<char>(path, mmap_hints{ mmap_hint::sequential, mmap_hint::populate, mmap_hint::huge_pages }, error);
+	ASSERT_FALSE(error);
+	ASSERT_EQ(source.size(), 100'000);
+	EXPECT_EQ(source[1000], char(1000 % 251));
+
+	source.advise(mmap_hint::will_need, 4000, 50'000, error);
+	EXPECT_FALSE(error);
+	source.advise(mmap_hint::random, 200'000, 1, error);
+	EXPECT_TRUE(error);
+
+	source.unmap();
+	std::filesystem::remove(path);
+}
+
+TEST(mmap, window_source_slides_across_file)
+{
+	static constexpr size_t file_size = 1024 * 1024 + 123;
+	static constexpr size_t window_size = 64 * 1024;
+	const auto path = make_test_file("ghpl_mmap_window.bin", file_size);
+
+	{
+		mmap_window_source<char> window{ path, window_size, mmap_hint::sequential };
+		EXPECT_EQ(window.file_size(), file_size);
+		EXPECT_EQ(window.window_offset(), 0);
+		EXPECT_EQ(window.size(), window_size);
+
+		std::error_code error;
+		for (size_t offset : { size_t{ 10 }, window_size - 2, size_t{ 500'000 }, file_size - 16, size_t{ 3 } })
+		{
+			const auto view = window.view(offset, 16, error);
+			ASSERT_FALSE(error);
+			ASSERT_EQ(view.size(), 16);
+			for (size_t i = 0; i < view.size(); ++i)
+				EXPECT_EQ(view[i], char((offset + i) % 251));
+			EXPECT_LE(window.size(), window_size);
+		}
+
+		window.slide_to(file_size - 100);
+		EXPECT_EQ(window.size(), 100);
+
+		std::ignore = window.view(file_size - 8, 16, error);
+		EXPECT_TRUE(error);
+	}
+
+	std::filesystem::remove(path);
+}
+
+TEST(mmap, empty_files)
+{
+	const auto path = make_test_file("ghpl_mmap_empty.bin", 0);
+
+	std::error_code error;
+	std::ignore = make_mmap_source<char>(path, error);
+	EXPECT_EQ(error, std::errc::file_too_large);
+
+	{
+		mmap_window_source<char> window{ path, 4096 };
+		EXPECT_TRUE(window.is_open());
+		EXPECT_EQ(window.file_size(), 0);
+		EXPECT_TRUE(window.empty());
+
+		EXPECT_TRUE(window.view(0, 0, error).empty());
+		EXPECT_FALSE(error);
+		std::ignore = window.view(0, 1, error);
+		EXPECT_TRUE(error);
+	}
+
+	std::filesystem::remove(path);
+}
+
+TEST(mmap, prefetcher_stays_ahead_of_cursor)
+{
+	static constexpr size_t file_size = 8 * 1024 * 1024;
+	const auto path = make_test_file("ghpl_mmap_prefetch.bin", file_size);
+
+	{
+		auto source = make_mmap_source<char>(path, mmap_hint::sequential);
+		mmap_prefetcher prefetcher{ source.data(), source.size(), 2 * 1024 * 1024, 256 * 1024 };
+		prefetcher.advance(1);
+
+		size_t sum = 0;
+		for (size_t i = 0; i < source.size(); i += 4096)
+		{
+			prefetcher.advance(i);
+			sum += uint8_t(source[i]);
+		}
+		EXPECT_NE(sum, 0);
+
+		for (int tries = 0; prefetcher.prefetched() < file_size && tries < 1000; ++tries)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		EXPECT_EQ(prefetcher.prefetched(), file_size);
+	}
+
+	std::filesystem::remove(path);
+}
+
+TEST(incremental_position_checkpoint, recovers_last_healthy_position)
+{
+	const auto path = make_zeroed_file("ghpl_checkpoint.bin", 64 * 1024);
+
+	{
+		auto sink = make_mmap_sink<std::byte>(path);
+		incremental_position_checkpoint checkpoint{ sink, 0 };
+		EXPECT_EQ(checkpoint.position(), 0);
+
+		std::error_code error;
+		checkpoint.checkpoint(1000, error);
+		ASSERT_FALSE(error);
+		checkpoint.checkpoint(2000, error);
+		ASSERT_FALSE(error);
+		EXPECT_EQ(checkpoint.position(), 2000);
+	}
+
+	{
+		auto sink = make_mmap_sink<std::byte>(path);
+		incremental_position_checkpoint checkpoint{ sink, 0 };
+		EXPECT_EQ(checkpoint.position(), 2000);
+
+		/// Simulate a crash in the middle of writing the next checkpoint (which goes into the older pair)
+		const uint64_t torn = 3000;
+		std::memcpy(sink.data() + 2 * sizeof(uint64_t), &torn, sizeof(torn));
+		std::error_code error;
+		checkpoint.recover(error);
+		ASSERT_FALSE(error);
+		EXPECT_EQ(checkpoint.position(), 2000);
+
+		/// Both pairs broken
+		std::memcpy(sink.data() + 1 * sizeof(uint64_t), &torn, sizeof(torn));
+		checkpoint.recover(error);
+		EXPECT_TRUE(error);
+	}
+
+	std::filesystem::remove(path);
+}
+
+TEST(incremental_position_checkpoint, groups_commits)
+{
+	const auto path = make_zeroed_file("ghpl_checkpoint_group.bin", 64 * 1024);
+
+	{
+		auto sink = make_mmap_sink<std::byte>(path);
+		incremental_position_checkpoint checkpoint{ sink, 0, 4 };
+		std::error_code error;
+		checkpoint.reset(32, error);
+		ASSERT_FALSE(error);
+
+		for (size_t i = 1; i <= 3; ++i)
+		{
+			checkpoint.advance(32 + i * 10, error);
+			EXPECT_EQ(checkpoint.position(), 32);
+		}
+		checkpoint.advance(72, error);
+		EXPECT_EQ(checkpoint.position(), 72);
+
+		checkpoint.advance(100, error);
+		EXPECT_EQ(checkpoint.position(), 72);
+		EXPECT_EQ(checkpoint.pending_position(), 100);
+		checkpoint.flush(error);
+		EXPECT_EQ(checkpoint.position(), 100);
+	}
+
+	std::filesystem::remove(path);
+}
+
+TEST(incremental_position_checkpoint, DISABLED_benchmark_appends_per_second)
+{
+	static constexpr size_t record_size = 64;
+	static constexpr size_t records = 20'000;
+	const auto path = make_zeroed_file("ghpl_checkpoint_bench.bin", 64 + record_size * records);
+
+	for (size_t group_size : { size_t{ 1 }, size_t{ 16 }, size_t{ 256 }, size_t{ 4096 } })
+	{
+		auto sink = make_mmap_sink<std::byte>(path);
+		incremental_position_checkpoint checkpoint{ sink, 0, group_size };
+		std::error_code error;
+		checkpoint.reset(64, error);
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < records; ++i)
+		{
+			const auto position = 64 + i * record_size;
+			std::memset(sink.data() + position, int(i), record_size);
+			checkpoint.advance(position + record_size, error);
+		}
+		checkpoint.flush(error);
+		const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "group size " << group_size << ": " << records / seconds << " appends/s\n";
+	}
+
+	std::filesystem::remove(path);
+}
@@ -0,0 +1,291 @@
+/// This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "tests_common.h"
+#include <gtest/gtest.h>
+
+#include "../include/ghassanpl/noise_fields.h"
+#include "../include/ghassanpl/seeded_noise.h"
+
+#include <bit>
+#include <chrono>
+#include <iostream>
+
+using namespace ghassanpl::noise;
+
+namespace
+{
+	template <typename F>
+	auto bits_of(F value)
+	{
+		if constexpr (sizeof(F) == 4)
+			return std::bit_cast<uint32_t>(value);
+		else
+			return std::bit_cast<uint64_t>(value);
+	}
+
+	template <typename F>
+	void expect_2d_field_matches_scalar(F origin_x, F origin_y, F step, size_t width, size_t height, fractal_parameters<F> const& fractal)
+	{
+		std::vector<F> field(width * height);
+		generate_simplex_2d(origin_x, origin_y, step, width, height, fractal, std::span{ field }, 1);
+
+		for (size_t row = 0; row < height; ++row)
+		{
+			for (size_t column = 0; column < width; ++column)
+			{
+				const auto expected = fractal_simplex_noise_2d(fractal.octaves, origin_x + F(column) * step, origin_y + F(row) * step, fractal.frequency, fractal.amplitude, fractal.lacunarity, fractal.persistence);
+				ASSERT_EQ(bits_of(field[row * width + column]), bits_of(expected)) << column << ", " << row << ": " << field[row * width + column] << " vs " << expected;
+			}
+		}
+
+		std::vector<F> threaded(width * height);
+		generate_simplex_2d(origin_x, origin_y, step, width, height, fractal, std::span{ threaded }, 4);
+		EXPECT_EQ(field, threaded);
+	}
+}
+
+TEST(noise, simplex_noise_stays_in_range)
+{
+	for (int i = 0; i < 10000; ++i)
+	{
+		const auto x = float(i) * 0.0173f - 50.0f;
+		const auto y = float(i % 97) * 0.31f - 15.0f;
+		EXPECT_LE(std::abs(simplex_noise(x)), 1.0f) << x;
+		EXPECT_LE(std::abs(simplex_noise(x, y)), 1.0f) << x << ", " << y;
+	}
+	EXPECT_NE(simplex_noise(0.5f, 0.25f), simplex_noise(0.25f, 0.5f));
+}
+
+TEST(noise, generated_2d_fields_are_bit_identical_to_scalar_noise)
+{
+	expect_2d_field_matches_scalar(-3.7f, -1.25f, 0.043f, 67, 13, fractal_parameters<float>{});
+	expect_2d_field_matches_scalar(100.5f, -20.0f, 0.31f, 8, 9, fractal_parameters<float>{ .octaves = 5, .frequency = 0.7f, .amplitude = 2.0f });
+	expect_2d_field_matches_scalar(0.0f, 0.0f, 1.0f, 3, 3, fractal_parameters<float>{ .octaves = 2 });
+	expect_2d_field_matches_scalar(-3.7, -1.25, 0.043, 21, 5, fractal_parameters<double>{ .octaves = 3 });
+}
+
+TEST(noise, generated_1d_samples_are_bit_identical_to_scalar_noise)
+{
+	const fractal_parameters<float> fractal{ .octaves = 4, .frequency = 0.5f, .persistence = 0.6f };
+	const size_t count = 10007;
+	std::vector<float> samples(count);
+	generate_simplex_1d(-40.0f, 0.0191f, count, fractal, std::span{ samples });
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto expected = fractal_simplex_noise(fractal.octaves, -40.0f + float(i) * 0.0191f, fractal.frequency, fractal.amplitude, fractal.lacunarity, fractal.persistence);
+		ASSERT_EQ(bits_of(samples[i]), bits_of(expected)) << i;
+	}
+}
+
+TEST(noise, generators_reject_small_outputs)
+{
+	std::vector<float> small(10);
+	EXPECT_THROW(generate_simplex_2d(0.0f, 0.0f, 1.0f, 4, 3, 1, std::span{ small }), std::invalid_argument);
+	EXPECT_THROW(generate_simplex_1d(0.0f, 1.0f, 11, fractal_parameters<float>{}, std::span{ small }), std::invalid_argument);
+	EXPECT_NO_THROW(generate_simplex_2d(0.0f, 0.0f, 1.0f, 5, 2, 1, std::span{ small }));
+}
+
+TEST(noise, DISABLED_benchmark_field_generation)
+{
+	const size_t width = 2048, height = 2048;
+	std::vector<float> field(width * height);
+
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	for (const size_t octaves : { size_t(1), size_t(4) })
+	{
+		const auto scalar_time = time([&] {
+			for (size_t row = 0; row < height; ++row)
+				for (size_t column = 0; column < width; ++column)
+					field[row * width + column] = fractal_simplex_noise_2d(octaves, float(column) * 0.01f, float(row) * 0.01f);
+		});
+		const auto single_thread_time = time([&] { generate_simplex_2d(0.0f, 0.0f, 0.01f, width, height, octaves, std::span{ field }, 1); });
+		const auto threaded_time = time([&] { generate_simplex_2d(0.0f, 0.0f, 0.01f, width, height, octaves, std::span{ field }); });
+
+		const auto samples = double(width * height);
+		std::cout << octaves << " octave(s): scalar " << samples / scalar_time / 1e6 << "M samples/s, batch " << samples / single_thread_time / 1e6
+			<< "M samples/s on one thread, " << samples / threaded_time / 1e6 << "M samples/s on all threads (" << field[12345] << ")\n";
+	}
+}
+
+namespace
+{
+	template <typename F>
+	void expect_noise_field_matches_scalar(uint32_t seed, typename noise_field<F>::options const& opts, F origin_x, F origin_y, F step, size_t width, size_t height)
+	{
+		const noise_field<F> field{ seed, opts };
+		std::vector<F> samples(width * height);
+		field.generate(origin_x, origin_y, step, width, height, std::span{ samples }, 1);
+
+		for (size_t row = 0; row < height; ++row)
+		{
+			for (size_t column = 0; column < width; ++column)
+			{
+				const auto expected = field(origin_x + F(column) * step, origin_y + F(row) * step);
+				ASSERT_EQ(bits_of(samples[row * width + column]), bits_of(expected)) << column << ", " << row << ": " << samples[row * width + column] << " vs " << expected;
+			}
+		}
+
+		std::vector<F> threaded(width * height);
+		field.generate(origin_x, origin_y, step, width, height, std::span{ threaded }, 3);
+		EXPECT_EQ(samples, threaded);
+	}
+
+	/// Largest difference between neighbouring samples `epsilon` apart, over a line through the noise
+	template <typename FUNC>
+	float max_step(FUNC&& func, float epsilon)
+	{
+		float result = 0;
+		for (int i = 0; i < 20000; ++i)
+		{
+			const auto x = float(i) * 0.00731f - 60.0f;
+			const auto y = float(i) * 0.00377f + 3.0f;
+			result = std::max(result, std::abs(func(x + epsilon, y + epsilon * 0.5f) - func(x, y)));
+		}
+		return result;
+	}
+}
+
+TEST(noise, seeded_noise_is_bounded_continuous_and_depends_on_the_seed)
+{
+	const auto simplex = [](uint32_t seed) { return [=](float x, float y) { return simplex_noise_2d(seed, x, y); }; };
+	const auto simplex4 = [](uint32_t seed) { return [=](float x, float y) { return simplex_noise_4d(seed, x, y, y * 0.7f - x, x * 0.3f + 2.0f); }; };
+	const auto opensimplex = [](uint32_t seed) { return [=](float x, float y) { return opensimplex2_noise_2d(seed, x, y); }; };
+	const auto cellular = [](uint32_t seed) { return [=](float x, float y) { return cellular_noise_2d(seed, x, y).distance; }; };
+
+	const auto check = [](auto make, float low, float high) {
+		const auto a = make(1), b = make(2);
+		float min = 1e9f, max = -1e9f;
+		int different = 0;
+		for (int i = 0; i < 40000; ++i)
+		{
+			const auto x = float(i % 200) * 0.137f - 13.0f;
+			const auto y = float(i / 200) * 0.113f - 11.0f;
+			const auto value = a(x, y);
+			min = std::min(min, value);
+			max = std::max(max, value);
+			different += value != b(x, y);
+		}
+		EXPECT_GE(min, low);
+		EXPECT_LE(max, high);
+		EXPECT_GT(max - min, (high - low) * 0.5f);
+		EXPECT_GT(different, 38000);
+		EXPECT_LT(max_step(a, 1e-3f), 0.05f);
+	};
+
+	check(simplex, -1.0f, 1.0f);
+	check(simplex4, -1.0f, 1.0f);
+	check(opensimplex, -1.0f, 1.0f);
+	check(cellular, 0.0f, 1.5f);
+
+	EXPECT_EQ(simplex_noise_2d(7u, 1.5, -2.25), simplex_noise_2d(7u, 1.5, -2.25));
+	EXPECT_NE(simplex_noise_2d(7u, 1.5, -2.25), simplex_noise_2d(8u, 1.5, -2.25));
+}
+
+TEST(noise, cellular_noise_finds_the_nearest_feature_points)
+{
+	for (int i = 0; i < 2000; ++i)
+	{
+		const auto x = float(i % 50) * 0.173f, y = float(i / 50) * 0.191f;
+		const auto sample = cellular_noise_2d(99u, x, y);
+		EXPECT_LE(sample.distance, sample.distance2);
+		/// The cell value is constant around the feature point, so moving towards it keeps it
+		const auto nearby = cellular_noise_2d(99u, x + 1e-3f, y);
+		if (nearby.cell != sample.cell)
+		{
+			EXPECT_LT(std::abs(nearby.distance2 - nearby.distance), 0.01f);
+		}
+	}
+
+	EXPECT_THROW((void)cellular_noise_2d(1u, 0.0f, 0.0f, 4, 0), std::invalid_argument);
+	EXPECT_THROW((void)cellular_noise_2d(1u, 0.0f, 0.0f, -1, -1), std::invalid_argument);
+}
+
+TEST(noise, noise_fields_are_bit_identical_to_sampling)
+{
+	using options = noise_field<float>::options;
+	for (const auto type : { noise_type::simplex, noise_type::opensimplex2, noise_type::cellular })
+	{
+		SCOPED_TRACE(int(type));
+		expect_noise_field_matches_scalar<float>(1234u, options{ .type = type }, -3.7f, -1.25f, 0.043f, 67, 13);
+		expect_noise_field_matches_scalar<float>(5u, options{ .type = type, .fractal = { .octaves = 3, .frequency = 0.7f } }, 100.5f, -20.0f, 0.31f, 9, 9);
+		expect_noise_field_matches_scalar<float>(77u, options{ .type = type, .fractal = { .octaves = 2 }, .warp_strength = 0.8f }, 0.0f, 0.0f, 0.05f, 21, 7);
+		expect_noise_field_matches_scalar<float>(77u, options{ .type = type, .fractal = { .octaves = 2 }, .tile_width = 4.0f, .tile_height = 2.0f }, -1.0f, 0.5f, 0.1f, 43, 6);
+		expect_noise_field_matches_scalar<double>(3u, noise_field<double>::options{ .type = type, .fractal = { .octaves = 2 } }, -3.7, -1.25, 0.043, 11, 5);
+	}
+
+	for (const auto output : { cellular_output::distance2, cellular_output::distance2_minus_distance, cellular_output::cell_value })
+		expect_noise_field_matches_scalar<float>(9u, options{ .type = noise_type::cellular, .cellular = output }, 0.25f, 0.5f, 0.07f, 19, 4);
+}
+
+TEST(noise, tileable_noise_fields_repeat)
+{
+	for (const auto type : { noise_type::simplex, noise_type::opensimplex2, noise_type::cellular })
+	{
+		SCOPED_TRACE(int(type));
+		const noise_field<float> field{ 42u, { .type = type, .fractal = { .octaves = 3, .frequency = 2.0f }, .tile_width = 5.0f, .tile_height = 3.0f } };
+		const noise_field<float> untiled{ 42u, { .type = type, .fractal = { .octaves = 3, .frequency = 2.0f } } };
+		int different_from_untiled = 0;
+		for (int i = 0; i < 500; ++i)
+		{
+			const auto x = float(i % 25) * 0.2f, y = float(i / 25) * 0.15f;
+			const auto value = field(x, y);
+			EXPECT_NEAR(value, field(x + 5.0f, y), 2e-3f) << x << ", " << y;
+			EXPECT_NEAR(value, field(x, y - 3.0f), 2e-3f) << x << ", " << y;
+			EXPECT_NEAR(value, field(x - 10.0f, y + 6.0f), 2e-3f) << x << ", " << y;
+			different_from_untiled += value != untiled(x, y);
+		}
+		EXPECT_GT(different_from_untiled, 0);
+	}
+}
+
+TEST(noise, noise_field_rejects_bad_options)
+{
+	EXPECT_THROW(noise_field<float>(1u, { .tile_width = 4.0f }), std::invalid_argument);
+	EXPECT_THROW(noise_field<float>(1u, { .tile_width = -1.0f, .tile_height = -1.0f }), std::invalid_argument);
+	EXPECT_THROW(noise_field<float>(1u, { .warp_strength = 1.0f, .tile_width = 4.0f, .tile_height = 4.0f }), std::invalid_argument);
+
+	std::vector<float> small(10);
+	EXPECT_THROW(noise_field<float>(1u).generate(0.0f, 0.0f, 1.0f, 4, 3, std::span{ small }), std::invalid_argument);
+}
+
+TEST(noise, DISABLED_benchmark_seeded_field_generation)
+{
+	const size_t width = 1024, height = 1024;
+	std::vector<float> field(width * height);
+
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	using options = noise_field<float>::options;
+	const std::pair<char const*, options> configurations[] = {
+		{ "simplex", options{ .fractal = { .octaves = 4 } } },
+		{ "opensimplex2", options{ .type = noise_type::opensimplex2, .fractal = { .octaves = 4 } } },
+		{ "cellular", options{ .type = noise_type::cellular, .fractal = { .octaves = 4 } } },
+		{ "warped simplex", options{ .fractal = { .octaves = 4 }, .warp_strength = 1.0f } },
+		{ "tiled simplex", options{ .fractal = { .octaves = 4 }, .tile_width = 10.0f, .tile_height = 10.0f } },
+	};
+
+	for (auto const& [name, opts] : configurations)
+	{
+		const noise_field<float> noise{ 1u, opts };
+		const auto scalar_time = time([&] {
+			for (size_t row = 0; row < height; ++row)
+				for (size_t column = 0; column < width; ++column)
+					field[row * width + column] = noise(float(column) * 0.01f, float(row) * 0.01f);
+		});
+		const auto batch_time = time([&] { noise.generate(0.0f, 0.0f, 0.01f, width, height, std::span{ field }, 1); });
+
+		const auto samples = double(width * height);
+		std::cout << name << ", 4 octaves: scalar " << samples / scalar_time / 1e6 << "M samples/s, batch " << samples / batch_time / 1e6 << "M samples/s (" << field[12345] << ")\n";
+	}
+}
@@ -0,0 +1,79 @@
+/// This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "tests_common.h"
+#include <gtest/gtest.h>
+
+#include "../include/ghassanpl/parallel.h"
+
+#include <stdexcept>
+
+using namespace ghassanpl;
+
+TEST(parallel, worker_count_is_clamped_to_the_job_count)
+{
+	EXPECT_EQ(parallel_worker_count(3, 8), 3u);
+	EXPECT_EQ(parallel_worker_count(100, 8), 8u);
+	EXPECT_EQ(parallel_worker_count(0, 8), 1u);
+	EXPECT_GE(parallel_worker_count(100, 0), 1u);
+}
+
+TEST(parallel, for_each_index_visits_every_index_once)
+{
+	for (unsigned threads : { 1u, 3u, 0u })
+	{
+		std::vector<std::atomic<int>> visits(1000);
+		std::vector<std::atomic<int>> by_worker(parallel_worker_count(visits.size(), threads));
+		parallel_for_each_index(visits.size(), threads, [&](size_t i, unsigned worker) {
+			++visits[i];
+			++by_worker.at(worker);
+		});
+		for (auto const& count : visits)
+			ASSERT_EQ(count.load(), 1);
+
+		int total = 0;
+		for (auto const& count : by_worker)
+			total += count.load();
+		EXPECT_EQ(total, 1000);
+	}
+
+	bool called = false;
+	parallel_for_each_index(0, 4, [&](size_t) { called = true; });
+	EXPECT_FALSE(called);
+}
+
+TEST(parallel, for_each_band_covers_the_range)
+{
+	for (int min_per_band : { 1, 10, 1000 })
+	{
+		std::vector<std::atomic<int>> visits(250);
+		std::atomic<int> bands = 0;
+		parallel_for_each_band(-50, 200, 4, min_per_band, [&](int begin, int end) {
+			++bands;
+			for (int i = begin; i < end; ++i)
+				++visits[size_t(i + 50)];
+		});
+		for (auto const& count : visits)
+			ASSERT_EQ(count.load(), 1);
+		EXPECT_LE(bands.load(), 4);
+		EXPECT_EQ(bands.load() == 1, min_per_band == 1000);
+	}
+}
+
+TEST(parallel, worker_exceptions_are_rethrown_on_the_calling_thread)
+{
+	std::atomic<int> calls = 0;
+	EXPECT_THROW(parallel_for_each_index(10'000, 4, [&](size_t i) {
+		++calls;
+		if (i == 100)
+			throw std::runtime_error{ "job failed" };
+	}), std::runtime_error);
+	/// The remaining jobs are skipped
+	EXPECT_LT(calls.load(), 10'000);
+
+	EXPECT_THROW(parallel_for_each_band(0, 100, 4, 1, [](int begin, int) {
+		if (begin > 0)
+			throw std::logic_error{ "band failed" };
+	}), std::logic_error);
+}
@@ -0,0 +1,277 @@
+/// This Source Code Form is subject to the terms of the Mozilla Public
+/// License, v. 2.0. If a copy of the MPL was not distributed with this
+/// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "tests_common.h"
+#include <gtest/gtest.h>
+
+#include "../include/ghassanpl/pixels.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace ghassanpl;
+
+namespace
+{
+	/// 37 is not a multiple of any vector width, so every test covers both the vectorized loop and the remainder
+	constexpr size_t pixel_count = 37;
+
+	std::vector<uint32_t> random_pixels(size_t count, uint32_t seed = 1)
+	{
+		std::mt19937 rng{ seed };
+		std::vector<uint32_t> result(count);
+		for (auto& pixel : result)
+			pixel = uint32_t(rng());
+		return result;
+	}
+
+	std::vector<color_t> random_colors(size_t count, float low = 0.0f, float high = 1.0f, uint32_t seed = 2)
+	{
+		std::mt19937 rng{ seed };
+		std::uniform_real_distribution<float> dist{ low, high };
+		std::vector<color_t> result(count);
+		for (auto& color : result)
+			color = { dist(rng), dist(rng), dist(rng), dist(rng) };
+		return result;
+	}
+
+	uint32_t to_format(color_t const& color, pixel_format format)
+	{
+		switch (format)
+		{
+		case pixel_format::rgba: return to_u32_rgba(color);
+		case pixel_format::bgra: return to_u32_bgra(color);
+		case pixel_format::argb: return to_u32_argb(color);
+		default: return to_u32_abgr(color);
+		}
+	}
+
+	color_t from_format(uint32_t pixel, pixel_format format)
+	{
+		switch (format)
+		{
+		case pixel_format::rgba: return from_u32_rgba(pixel);
+		case pixel_format::bgra: return from_u32_bgra(pixel);
+		case pixel_format::argb: return from_u32_argb(pixel);
+		default: return from_u32_abgr(pixel);
+		}
+	}
+
+	int channel_difference(uint32_t a, uint32_t b)
+	{
+		int result = 0;
+		for (int shift = 0; shift < 32; shift += 8)
+			result = std::max(result, std::abs(int((a >> shift) & 0xFF) - int((b >> shift) & 0xFF)));
+		return result;
+	}
+
+	constexpr pixel_format all_formats[] = { pixel_format::rgba, pixel_format::bgra, pixel_format::argb, pixel_format::abgr };
+}
+
+TEST(pixels, convert_pixels_matches_per_pixel_conversions)
+{
+	const auto pixels = random_pixels(pixel_count);
+	std::vector<uint32_t> converted(pixel_count);
+	for (auto from : all_formats)
+	{
+		for (auto to : all_formats)
+		{
+			convert_pixels(pixels, from, converted, to);
+			for (size_t i = 0; i < pixel_count; ++i)
+				ASSERT_EQ(converted[i], to_format(from_format(pixels[i], from), to)) << i;
+		}
+	}
+
+	std::vector<uint32_t> too_small(pixel_count - 1);
+	EXPECT_THROW(convert_pixels(pixels, pixel_format::rgba, too_small, pixel_format::bgra), std::invalid_argument);
+}
+
+TEST(pixels, unpack_and_pack_round_trip)
+{
+	const auto pixels = random_pixels(pixel_count);
+	std::vector<color_t> colors(pixel_count);
+	std::vector<uint32_t> packed(pixel_count);
+	for (auto format : all_formats)
+	{
+		unpack_pixels(pixels, format, colors);
+		for (size_t i = 0; i < pixel_count; ++i)
+		{
+			const auto expected = from_format(pixels[i], format);
+			for (int c = 0; c < 4; ++c)
+				ASSERT_NEAR(colors[i][c], expected[c], 1e-7f) << i;
+		}
+
+		pack_pixels(colors, packed, format);
+		EXPECT_EQ(packed, pixels);
+	}
+}
+
+TEST(pixels, pack_pixels_clamps_and_rounds_like_to_u32)
+{
+	auto colors = random_colors(pixel_count, -0.5f, 1.5f);
+	std::vector<uint32_t> packed(pixel_count);
+	pack_pixels(colors, packed, pixel_format::argb);
+	for (size_t i = 0; i < pixel_count; ++i)
+		EXPECT_EQ(packed[i], to_u32_argb(saturated(colors[i]))) << i;
+}
+
+TEST(pixels, srgb_conversions_match_the_exact_functions)
+{
+	std::vector<uint32_t> pixels(256);
+	for (uint32_t i = 0; i < 256; ++i)
+		pixels[i] = (i << 24) | (i << 16) | ((255 - i) << 8) | (i * 7 % 256);
+
+	std::vector<color_t> linear(pixels.size());
+	srgb_pixels_to_linear(pixels, pixel_format::rgba, linear);
+	for (size_t i = 0; i < pixels.size(); ++i)
+	{
+		const auto expected = srgb_to_linear(from_u32_rgba(pixels[i]));
+		for (int c = 0; c < 4; ++c)
+			ASSERT_NEAR(linear[i][c], expected[c], 1e-6f) << i;
+	}
+
+	/// Decoding then encoding every byte value gets it back
+	std::vector<uint32_t> encoded(pixels.size());
+	linear_to_srgb_pixels(linear, encoded, pixel_format::rgba);
+	EXPECT_EQ(encoded, pixels);
+
+	const auto colors = random_colors(1000, -0.1f, 1.1f);
+	encoded.resize(colors.size());
+	linear_to_srgb_pixels(colors, encoded, pixel_format::bgra);
+	size_t off_by_one = 0;
+	for (size_t i = 0; i < colors.size(); ++i)
+	{
+		const auto expected = to_u32_bgra(linear_to_srgb(saturated(colors[i])));
+		const auto difference = channel_difference(encoded[i], expected);
+		ASSERT_LE(difference, 1) << i;
+		off_by_one += difference;
+	}
+	EXPECT_LT(off_by_one, colors.size() / 20);
+
+	EXPECT_NEAR(srgb_to_linear(0.5f), 0.21404f, 1e-5f);
+	EXPECT_NEAR(linear_to_srgb(srgb_to_linear(0.8f)), 0.8f, 1e-6f);
+}
+
+TEST(pixels, premultiply_pixels_rounds_exactly)
+{
+	for (auto format : { pixel_format::rgba, pixel_format::argb })
+	{
+		const int alpha_shift = format == pixel_format::rgba ? 0 : 24;
+		auto pixels = random_pixels(pixel_count);
+		pixels[3] &= ~(0xFFu << alpha_shift);
+		pixels[4] |= 0xFFu << alpha_shift;
+		const auto original = pixels;
+
+		premultiply_pixels(pixels, format);
+		for (size_t i = 0; i < pixel_count; ++i)
+		{
+			const auto alpha = (original[i] >> alpha_shift) & 0xFF;
+			for (int shift = 0; shift < 32; shift += 8)
+			{
+				const auto channel = (original[i] >> shift) & 0xFF;
+				const auto expected = shift == alpha_shift ? alpha : uint32_t(std::lround(channel * alpha / 255.0));
+				ASSERT_EQ((pixels[i] >> shift) & 0xFF, expected) << i << " " << shift;
+			}
+		}
+		EXPECT_EQ(pixels[4], original[4]);
+
+		/// Unpremultiplying loses precision, but premultiplying again gets back the same pixels
+		auto round_trip = pixels;
+		unpremultiply_pixels(round_trip, format);
+		EXPECT_EQ(round_trip[3], 0);
+		EXPECT_EQ(round_trip[4], original[4]);
+		for (size_t i = 0; i < pixel_count; ++i)
+			ASSERT_EQ((round_trip[i] >> alpha_shift) & 0xFF, (original[i] >> alpha_shift) & 0xFF) << i;
+		premultiply_pixels(round_trip, format);
+		EXPECT_EQ(round_trip, pixels);
+	}
+}
+
+TEST(pixels, premultiply_colors_matches_premultiplied)
+{
+	auto colors = random_colors(pixel_count);
+	colors[5].w = 0;
+	const auto original = colors;
+
+	premultiply(colors);
+	for (size_t i = 0; i < pixel_count; ++i)
+		ASSERT_EQ(colors[i], premultiplied(original[i])) << i;
+
+	unpremultiply(colors);
+	for (size_t i = 0; i < pixel_count; ++i)
+	{
+		if (i == 5)
+		{
+			EXPECT_EQ(colors[i], color_t(0, 0, 0, 0));
+			continue;
+		}
+		for (int c = 0; c < 4; ++c)
+			ASSERT_NEAR(colors[i][c], original[i][c], 1e-5f) << i;
+	}
+}
+
+TEST(pixels, hsv_conversions_match_the_per_color_functions)
+{
+	auto colors = random_colors(pixel_count);
+	colors[0] = { 0.5f, 0.5f, 0.5f, 1.0f };
+	colors[1] = { 0, 0, 0, 0.25f };
+	colors[2] = { 1.0f, 0.2f, 0.6f, 1.0f }; /// red is the largest and green < blue, so the hue wraps around
+	colors[3] = { 0.1f, 0.9f, 0.9f, 0.5f };
+
+	std::vector<color_hsva_t> hsv(pixel_count);
+	to_hsv(colors, hsv);
+	for (size_t i = 0; i < pixel_count; ++i)
+	{
+		const auto expected = to_hsv(colors[i]);
+		ASSERT_GE(hsv[i]->x, 0.0f) << i;
+		ASSERT_LT(hsv[i]->x, 6.0f) << i;
+		for (int c = 0; c < 4; ++c)
+			ASSERT_NEAR(hsv[i].value[c], expected.value[c], 1e-5f) << i;
+	}
+
+	std::vector<color_t> rgb(pixel_count);
+	to_rgb(hsv, rgb);
+	for (size_t i = 0; i < pixel_count; ++i)
+	{
+		const auto expected = to_rgb(hsv[i]);
+		for (int c = 0; c < 4; ++c)
+		{
+			ASSERT_NEAR(rgb[i][c], expected[c], 1e-5f) << i;
+			ASSERT_NEAR(rgb[i][c], colors[i][c], 1e-5f) << i;
+		}
+	}
+}
+
+TEST(pixels, DISABLED_benchmark_pixel_conversions)
+{
+	static constexpr size_t count = 1920 * 1080;
+	const auto pixels = random_pixels(count);
+	std::vector<color_t> colors(count);
+	std::vector<uint32_t> packed(count);
+	std::vector<color_hsva_t> hsv(count);
+
+	const auto measure = [&](const char* name, auto&& per_pixel, auto&& batch) {
+		using clock = std::chrono::steady_clock;
+		const auto megapixels_per_second = [](clock::duration time) { return double(count) / std::chrono::duration<double, std::micro>(time).count(); };
+		auto start = clock::now();
+		for (size_t i = 0; i < count; ++i)
+			per_pixel(i);
+		const auto scalar_time = clock::now() - start;
+		start = clock::now();
+		batch();
+		const auto batch_time = clock::now() - start;
+		std::cout << name << ": " << megapixels_per_second(scalar_time) << " MP/s per pixel, " << megapixels_per_second(batch_time) << " MP/s batched\n";
+	};
+
+	measure("bgra to rgba", [&](size_t i) { packed[i] = to_u32_rgba(from_u32_bgra(pixels[i])); }, [&] { convert_pixels(pixels, pixel_format::bgra, packed, pixel_format::rgba); });
+	measure("unpack", [&](size_t i) { colors[i] = from_u32_argb(pixels[i]); }, [&] { unpack_pixels(pixels, pixel_format::argb, colors); });
+	measure("pack", [&](size_t i) { packed[i] = to_u32_argb(saturated(colors[i])); }, [&] { pack_pixels(colors, packed, pixel_format::argb); });
+	measure("srgb to linear", [&](size_t i) { colors[i] = srgb_to_linear(from_u32_rgba(pixels[i])); }, [&] { srgb_pixels_to_linear(pixels, pixel_format::rgba, colors); });
+	measure("linear to srgb", [&](size_t i) { packed[i] = to_u32_rgba(linear_to_srgb(saturated(colors[i]))); }, [&] { linear_to_srgb_pixels(colors, packed, pixel_format::rgba); });
+	measure("premultiply", [&](size_t i) { packed[i] = to_u32_rgba(premultiplied(from_u32_rgba(pixels[i]))); }, [&] { packed = pixels; premultiply_pixels(packed, pixel_format::rgba); });
+	measure("to hsv", [&](size_t i) { hsv[i] = to_hsv(colors[i]); }, [&] { to_hsv(colors, hsv); });
+	measure("to rgb", [&](size_t i) { colors[i] = to_rgb(hsv[i]); }, [&] { to_rgb(hsv, colors); });
+}
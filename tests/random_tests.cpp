@@ -10,7 +10,11 @@
 #include "../include/ghassanpl/random_seq.h"
 
 #include <ranges>
+#include <list>
+#include <numbers>
 #include <print>
+#include <chrono>
+#include <iostream>
 
 using namespace ghassanpl;
 
@@ -106,6 +110,383 @@ TEST(random, basics)
 		EXPECT_LE(v, 7);
 	}
 }
+TEST(random, engines_match_reference_outputs)
+{
+	random::xoshiro256pp_engine xoshiro{ std::array<uint64_t, 4>{ 1, 2, 3, 4 } };
+	EXPECT_EQ(xoshiro(), 41943041);
+
+	random::xoroshiro128p_engine xoroshiro{ std::array<uint64_t, 2>{ 1, 2 } };
+	EXPECT_EQ(xoroshiro(), 3);
+
+	random::pcg64_engine pcg{ 42, 54 };
+	for (const auto expected : { 0x86b1da1d72062b68ULL, 0x1304aa46c9853d39ULL, 0xa3670e9e0dd50358ULL, 0xf9090e529a7dae00ULL, 0xc85b9fd837996f2cULL, 0x606121f8e3919196ULL })
+		EXPECT_EQ(pcg(), expected);
+
+	random::xoshiro256pp_engine seeded_a{ 123 }, seeded_b{ 123 }, seeded_c{ 124 };
+	EXPECT_EQ(seeded_a, seeded_b);
+	EXPECT_NE(seeded_a(), seeded_c());
+}
+
+TEST(random, engines_jump_and_advance)
+{
+	random::xoshiro256pp_engine xoshiro{ 5 };
+	auto xoshiro_jumped = xoshiro;
+	xoshiro_jumped.jump();
+	EXPECT_NE(xoshiro, xoshiro_jumped);
+	auto xoshiro_long_jumped = xoshiro;
+	xoshiro_long_jumped.long_jump();
+	EXPECT_NE(xoshiro_long_jumped, xoshiro_jumped);
+	EXPECT_NE(xoshiro(), xoshiro_jumped());
+
+	random::xoroshiro128p_engine xoroshiro{ 5 };
+	auto xoroshiro_jumped = xoroshiro;
+	xoroshiro_jumped.jump();
+	EXPECT_NE(xoroshiro, xoroshiro_jumped);
+
+	/// A jump is linear over GF(2), so jumping from the xor of two states gives the xor of the jumped states
+	random::xoroshiro128p_engine other{ 6 };
+	auto other_jumped = other;
+	other_jumped.jump();
+	random::xoroshiro128p_engine combined{ std::array{ xoroshiro.state()[0] ^ other.state()[0], xoroshiro.state()[1] ^ other.state()[1] } };
+	combined.jump();
+	EXPECT_EQ(combined.state()[0], xoroshiro_jumped.state()[0] ^ other_jumped.state()[0]);
+	EXPECT_EQ(combined.state()[1], xoroshiro_jumped.state()[1] ^ other_jumped.state()[1]);
+
+	random::pcg64_engine pcg{ 7, 3 };
+	auto pcg_skipped = pcg;
+	pcg_skipped.discard(1000);
+	for (int i = 0; i < 1000; ++i)
+		ignore = pcg();
+	EXPECT_EQ(pcg, pcg_skipped);
+	auto pcg_jumped = pcg;
+	pcg_jumped.jump();
+	EXPECT_NE(pcg(), pcg_jumped());
+
+	random::wyrand_engine wyrand{ 9 };
+	auto wyrand_skipped = wyrand;
+	wyrand_skipped.discard(1000);
+	for (int i = 0; i < 1000; ++i)
+		ignore = wyrand();
+	EXPECT_EQ(wyrand, wyrand_skipped);
+}
+
+TEST(random, bounded_integers_are_uniform)
+{
+	random::xoshiro256pp_engine rng{ 77 };
+	std::mt19937 rng32{ 77 };
+
+	for (const uint64_t bound : { 1ULL, 2ULL, 3ULL, 7ULL, 1000ULL, (1ULL << 32) + 1, ~0ULL })
+	{
+		for (int i = 0; i < 1000; ++i)
+		{
+			EXPECT_LT(random::integer_below(bound, rng), bound);
+			EXPECT_LT(random::integer_below(bound, rng32), bound);
+		}
+	}
+
+	std::array<int, 6> counts{};
+	std::array<int, 6> counts32{};
+	constexpr int rolls = 60000;
+	for (int i = 0; i < rolls; ++i)
+	{
+		++counts[random::dice(6, rng) - 1];
+		++counts32[random::dice<6>(rng32) - 1];
+	}
+	for (size_t i = 0; i < 6; ++i)
+	{
+		EXPECT_NEAR(counts[i], rolls / 6, 500) << i;
+		EXPECT_NEAR(counts32[i], rolls / 6, 500) << i;
+	}
+
+	int heads = 0;
+	for (int i = 0; i < rolls; ++i)
+		heads += random::coin(rng);
+	EXPECT_NEAR(heads, rolls / 2, 600);
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		const auto full = random::in_integer_range(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), rng);
+		ignore = full;
+		const auto small = random::in_integer_range(-3, 3, rng);
+		EXPECT_GE(small, -3);
+		EXPECT_LE(small, 3);
+		const auto unsigned_value = random::in_integer_range(10u, 12u, rng32);
+		EXPECT_GE(unsigned_value, 10u);
+		EXPECT_LE(unsigned_value, 12u);
+		EXPECT_LE(random::integer<uint8_t>(rng), 255);
+		EXPECT_GE(random::integer<int>(rng), 0);
+		const auto f = random::percentage<float>(rng);
+		EXPECT_GE(f, 0.0f);
+		EXPECT_LT(f, 1.0f);
+	}
+}
+
+TEST(random, alias_table_matches_weights)
+{
+	const std::vector<double> weights{ 1, 0, 3, 6 };
+	const random::alias_table table{ weights };
+	ASSERT_EQ(table.size(), 4);
+
+	random::xoshiro256pp_engine rng{ 3 };
+	std::vector<size_t> picks(100000);
+	table.sample_n(picks, rng);
+	std::array<int, 4> counts{};
+	for (const auto pick : picks)
+		++counts[pick];
+	EXPECT_NEAR(counts[0], 10000, 500);
+	EXPECT_EQ(counts[1], 0);
+	EXPECT_NEAR(counts[2], 30000, 700);
+	EXPECT_NEAR(counts[3], 60000, 700);
+
+	struct loot { const char* name; int weight; };
+	const std::array<loot, 3> loot_table{ { { "sword", 1 }, { "coin", 8 }, { "gem", 1 } } };
+	const random::alias_table loot_picker{ loot_table, &loot::weight };
+	std::mt19937 rng32{ 3 };
+	int coins = 0;
+	for (int i = 0; i < 10000; ++i)
+		coins += loot_table[loot_picker(rng32)].name == std::string_view{ "coin" };
+	EXPECT_NEAR(coins, 8000, 250);
+
+	EXPECT_THROW(random::alias_table(std::vector<double>{}), std::invalid_argument);
+	EXPECT_THROW(random::alias_table(std::vector<double>{ 0, 0 }), std::invalid_argument);
+	EXPECT_THROW(random::alias_table(std::vector<double>{ 1, -1 }), std::invalid_argument);
+}
+
+TEST(random, sample_n_and_reservoir_sample_pick_uniform_subsets)
+{
+	random::xoshiro256pp_engine rng{ 4 };
+	std::vector<int> values(10);
+	std::iota(values.begin(), values.end(), 0);
+
+	std::array<int, 10> sample_counts{};
+	std::array<int, 10> reservoir_counts{};
+	for (int trial = 0; trial < 20000; ++trial)
+	{
+		std::array<int, 3> sample{};
+		ASSERT_EQ(random::sample_n(values, sample, rng), 3);
+		EXPECT_TRUE(std::ranges::is_sorted(sample));
+		EXPECT_EQ(std::ranges::adjacent_find(sample), sample.end());
+		for (const auto v : sample)
+			++sample_counts[v];
+
+		/// A list is not random access, so the reservoir has to walk it
+		std::list<int> list{ values.begin(), values.end() };
+		std::array<int, 3> reservoir{};
+		ASSERT_EQ(random::reservoir_sample(list, reservoir, rng), 3);
+		std::ranges::sort(reservoir);
+		EXPECT_EQ(std::ranges::adjacent_find(reservoir), reservoir.end());
+		for (const auto v : reservoir)
+			++reservoir_counts[v];
+	}
+	for (size_t i = 0; i < 10; ++i)
+	{
+		EXPECT_NEAR(sample_counts[i], 6000, 300) << i;
+		EXPECT_NEAR(reservoir_counts[i], 6000, 300) << i;
+	}
+
+	/// Small samples of large ranges use a different path
+	std::vector<int> large(100000);
+	std::iota(large.begin(), large.end(), 0);
+	std::array<int, 100> small_sample{};
+	ASSERT_EQ(random::sample_n(large, small_sample, rng), 100);
+	EXPECT_TRUE(std::ranges::is_sorted(small_sample));
+	EXPECT_EQ(std::ranges::adjacent_find(small_sample), small_sample.end());
+
+	std::array<int, 100> large_reservoir{};
+	ASSERT_EQ(random::reservoir_sample(std::views::iota(0, 100000), large_reservoir, rng), 100);
+	std::ranges::sort(large_reservoir);
+	EXPECT_EQ(std::ranges::adjacent_find(large_reservoir), large_reservoir.end());
+	EXPECT_GT(large_reservoir.back(), 50000);
+
+	std::array<int, 20> too_large{};
+	EXPECT_EQ(random::sample_n(values, too_large, rng), 10);
+	EXPECT_EQ(random::reservoir_sample(values, too_large, rng), 10);
+}
+
+TEST(random, DISABLED_benchmark_engines)
+{
+	constexpr size_t count = size_t(1) << 26;
+	const auto time = [](auto engine) {
+		uint64_t sum = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < count; ++i)
+			sum += random::integer_below(1000, engine);
+		return std::pair{ double(count) / 1e6 / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), sum };
+	};
+
+	const auto report = [](const char* name, std::pair<double, uint64_t> result) {
+		std::cout << name << ": " << result.first << "M bounded integers/s (" << result.second << ")\n";
+	};
+	report("std::default_random_engine", time(std::default_random_engine{}));
+	report("std::mt19937_64", time(std::mt19937_64{}));
+	report("xoshiro256++", time(random::xoshiro256pp_engine{}));
+	report("xoroshiro128+", time(random::xoroshiro128p_engine{}));
+	report("pcg64", time(random::pcg64_engine{}));
+	report("wyrand", time(random::wyrand_engine{}));
+
+	std::uniform_int_distribution<uint64_t> dist{ 0, 999 };
+	std::mt19937_64 mt;
+	uint64_t sum = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; ++i)
+		sum += dist(mt);
+	std::cout << "std::uniform_int_distribution with std::mt19937_64: " << double(count) / 1e6 / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "M/s (" << sum << ")\n";
+}
+
+TEST(random_geom, sin_cos_turns_is_accurate)
+{
+	using namespace simd;
+	for (int i = 0; i <= 1000; ++i)
+	{
+		const double turns = i / 1000.0;
+		scalar_lanes<double>::f sine, cosine;
+		random::detail::SinCosTurns<scalar_lanes<double>>({ turns }, sine, cosine);
+		EXPECT_NEAR(sine.v, std::sin(turns * 2 * std::numbers::pi), 1e-15) << turns;
+		EXPECT_NEAR(cosine.v, std::cos(turns * 2 * std::numbers::pi), 1e-15) << turns;
+
+		scalar_lanes<float>::f sine_f, cosine_f;
+		random::detail::SinCosTurns<scalar_lanes<float>>({ float(turns) }, sine_f, cosine_f);
+		EXPECT_NEAR(sine_f.v, std::sin(turns * 2 * std::numbers::pi), 1e-6) << turns;
+		EXPECT_NEAR(cosine_f.v, std::cos(turns * 2 * std::numbers::pi), 1e-6) << turns;
+	}
+}
+
+TEST(random_geom, batch_points_are_uniform_in_shapes)
+{
+	random::xoshiro256pp_engine rng{ 6 };
+	std::vector<glm::vec2> points(100001);
+
+	const trec2<float> rect{ { -1, 2 }, { 3, 4 } };
+	random::points_in(rect, points, rng);
+	EXPECT_TRUE(std::ranges::all_of(points, [&](glm::vec2 p) { return rect.contains(p); }));
+
+	const geometry::tellipse<float> ellipse{ { 5, -5 }, { 4, 2 } };
+	random::points_in(ellipse, points, rng);
+	size_t in_inner_half = 0, right = 0, top = 0;
+	for (auto p : points)
+	{
+		ASSERT_TRUE(geometry::tellipse<float>(ellipse.center, ellipse.radii * 1.0001f).contains(p)) << p.x << "," << p.y;
+		in_inner_half += geometry::tellipse<float>{ ellipse.center, ellipse.radii * 0.5f }.contains(p);
+		right += p.x > ellipse.center.x;
+		top += p.y > ellipse.center.y;
+	}
+	EXPECT_NEAR(double(in_inner_half) / points.size(), 0.25, 0.01);
+	EXPECT_NEAR(double(right) / points.size(), 0.5, 0.01);
+	EXPECT_NEAR(double(top) / points.size(), 0.5, 0.01);
+
+	const auto single = random::point_in(ellipse, rng);
+	EXPECT_TRUE(geometry::tellipse<float>(ellipse.center, ellipse.radii * 1.0001f).contains(single));
+
+	std::vector<glm::dvec2> double_points(1001);
+	random::points_in(geometry::tcircle<double>{ { 1, 1 }, 2 }, double_points, rng);
+	EXPECT_TRUE(std::ranges::all_of(double_points, [](glm::dvec2 p) { return glm::distance(p, glm::dvec2{ 1, 1 }) <= 2 + 1e-12; }));
+
+	const geometry::ttriangle<float> triangle{ { 0, 0 }, { 4, 0 }, { 0, 4 } };
+	random::points_in(triangle, points, rng);
+	size_t near_corner = 0;
+	for (auto p : points)
+	{
+		EXPECT_GE(p.x, -1e-5f);
+		EXPECT_GE(p.y, -1e-5f);
+		EXPECT_LE(p.x + p.y, 4.0001f);
+		near_corner += p.x + p.y < 2;
+	}
+	EXPECT_NEAR(double(near_corner) / points.size(), 0.25, 0.01);
+}
+
+TEST(random_geom, area_sampler_picks_triangles_by_area)
+{
+	/// An L shape: a 4x2 bar, and a 2x2 square on top of its left end
+	const geometry::immutable::polygon shape{ std::vector<glm::vec2>{ { 0, 0 }, { 4, 0 }, { 4, 2 }, { 2, 2 }, { 2, 4 }, { 0, 4 } } };
+	const random::area_sampler<float> sampler{ shape };
+	EXPECT_EQ(sampler.triangle_count(), 4);
+
+	random::xoshiro256pp_engine rng{ 7 };
+	std::vector<glm::vec2> points(60000);
+	sampler.fill(points, rng);
+	size_t in_top = 0, in_right = 0;
+	for (auto p : points)
+	{
+		ASSERT_TRUE(p.x >= -1e-4f && p.y >= -1e-4f && p.x <= 4.0001f && p.y <= 4.0001f && !(p.x > 2.0001f && p.y > 2.0001f)) << p.x << "," << p.y;
+		in_top += p.y > 2;
+		in_right += p.x > 2;
+	}
+	EXPECT_NEAR(double(in_top) / points.size(), 1.0 / 3, 0.01);
+	EXPECT_NEAR(double(in_right) / points.size(), 1.0 / 3, 0.01);
+
+	random::points_in(shape, std::span{ points }.first(10), rng);
+	const auto single = sampler(rng);
+	EXPECT_TRUE(single.x <= 2.0001f || single.y <= 2.0001f);
+
+	const std::array triangles{ geometry::ttriangle<float>{ { 0, 0 }, { 1, 0 }, { 0, 1 } }, geometry::ttriangle<float>{ { 5, 5 }, { 5, 5 }, { 5, 5 } } };
+	const random::area_sampler<float> skips_degenerate{ triangles };
+	for (int i = 0; i < 100; ++i)
+		EXPECT_LT(skips_degenerate(rng).x, 1.0001f);
+	EXPECT_THROW(random::area_sampler<float>{ std::span{ triangles }.last(1) }, std::invalid_argument);
+}
+
+TEST(random_geom, poisson_disc_points_keep_their_distance)
+{
+	random::xoshiro256pp_engine rng{ 8 };
+	const trec2<float> rect{ { 0, 0 }, { 50, 30 } };
+	const auto points = random::poisson_disc_points(rect, 1.5f, rng);
+	/// A maximal packing with this distance has a density of at least 1 / (pi * 1.5^2 * 2) per unit area
+	EXPECT_GT(points.size(), 1500 / (std::numbers::pi * 1.5 * 1.5 * 2));
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		ASSERT_TRUE(rect.contains(points[i]));
+		for (size_t j = i + 1; j < points.size(); ++j)
+			ASSERT_GE(glm::distance(points[i], points[j]), 1.5f) << i << " " << j;
+	}
+
+	/// Nothing more fits
+	for (int i = 0; i < 1000; ++i)
+	{
+		const auto candidate = random::point_in(rect, rng);
+		EXPECT_TRUE(std::ranges::any_of(points, [&](glm::vec2 p) { return glm::distance(p, candidate) < 3.0f; }));
+	}
+
+	const geometry::tcircle<float> circle{ { 10, 10 }, 5 };
+	const auto in_circle = random::poisson_disc_points(circle, 1.0f, rng);
+	EXPECT_GT(in_circle.size(), 20);
+	EXPECT_TRUE(std::ranges::all_of(in_circle, [&](glm::vec2 p) { return circle.contains(p); }));
+
+	EXPECT_THROW(ignore = random::poisson_disc_points(rect, 0.0f, rng), std::invalid_argument);
+}
+
+TEST(random_geom, DISABLED_benchmark_batch_points)
+{
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	constexpr size_t count = size_t(1) << 22;
+	std::vector<glm::vec2> points(count);
+	random::xoshiro256pp_engine rng{ 9 };
+
+	const geometry::tellipse<float> ellipse{ { 0, 0 }, { 10, 5 } };
+	const auto single_ellipse = time([&] { for (auto& p : points) p = random::point_in(ellipse, rng); });
+	const auto batch_ellipse = time([&] { random::points_in(ellipse, points, rng); });
+
+	std::vector<glm::vec2> ring;
+	for (int i = 0; i < 64; ++i)
+		ring.push_back(glm::vec2{ std::cos(i * 0.0982f), std::sin(i * 0.0982f) } * (i % 2 ? 10.0f : 7.0f));
+	const geometry::immutable::polygon star{ ring };
+	const auto single_polygon = time([&] { for (auto& p : points) p = random::point_in(star, rng); });
+	const random::area_sampler<float> sampler{ star };
+	const auto batch_polygon = time([&] { sampler.fill(points, rng); });
+
+	std::vector<glm::vec2> scatter;
+	const auto poisson = time([&] { scatter = random::poisson_disc_points(trec2<float>{ { 0, 0 }, { 1000, 1000 } }, 1.0f, rng); });
+
+	const auto millions = double(count) / 1e6;
+	std::cout << "ellipse: point_in " << millions / single_ellipse << "M/s, points_in " << millions / batch_ellipse << "M/s\n"
+		<< "64-gon: point_in " << millions / single_polygon << "M/s, area_sampler " << millions / batch_polygon << "M/s\n"
+		<< "poisson_disc_points: " << scatter.size() / poisson / 1e6 << "M points/s\n";
+}
+
 TEST(random_seq, philox64_gives_reasonable_results)
 {
 	//auto results = std::ranges::to<std::vector>(std::views::iota(0, 16) | std::views::transform([](auto i) { return random::philox64(i, 0xCAFEBEEB); }));
@@ -130,3 +511,190 @@ TEST(random_seq, philox64_engine_gives_reasonable_results)
 	//EXPECT_EQ(results, results2);
 	//EXPECT_NE(results, results3);
 }
+
+TEST(random_seq, philox_fill_matches_philox64)
+{
+	for (const size_t count : { size_t(0), size_t(1), size_t(15), size_t(16), size_t(17), size_t(1000), size_t(200003) })
+	{
+		std::vector<uint64_t> values(count);
+		random::philox_fill(0xCAFEBEEB, 123456789, std::span{ values }, 3);
+		for (size_t i = 0; i < count; ++i)
+			ASSERT_EQ(values[i], random::philox64(123456789 + i, 0xCAFEBEEB)) << count << ": " << i;
+	}
+
+	/// Counters carry into the high word
+	std::vector<uint64_t> values(40);
+	random::philox_fill(7, 0xFFFFFFF0ULL, std::span{ values });
+	for (size_t i = 0; i < values.size(); ++i)
+		EXPECT_EQ(values[i], random::philox64(0xFFFFFFF0ULL + i, 7)) << i;
+}
+
+TEST(random_seq, uniform_fills_match_philox64_and_are_uniform)
+{
+	std::vector<float> floats(200001);
+	random::fill_uniform_float(99, 5, std::span{ floats }, 2);
+	double sum = 0;
+	for (size_t i = 0; i < floats.size(); ++i)
+	{
+		const auto bits = random::philox64(5 + i / 2, 99);
+		ASSERT_EQ(floats[i], random::uniform_float_from_bits(uint32_t(i % 2 ? bits >> 32 : bits))) << i;
+		ASSERT_GE(floats[i], 0.0f);
+		ASSERT_LT(floats[i], 1.0f);
+		sum += floats[i];
+	}
+	EXPECT_NEAR(sum / double(floats.size()), 0.5, 0.005);
+
+	std::vector<double> doubles(100003);
+	random::fill_uniform_double(99, 5, std::span{ doubles }, 2);
+	sum = 0;
+	for (size_t i = 0; i < doubles.size(); ++i)
+	{
+		ASSERT_EQ(doubles[i], random::uniform_double_from_bits(random::philox64(5 + i, 99))) << i;
+		ASSERT_GE(doubles[i], 0.0);
+		ASSERT_LT(doubles[i], 1.0);
+		sum += doubles[i];
+	}
+	EXPECT_NEAR(sum / double(doubles.size()), 0.5, 0.005);
+
+	EXPECT_EQ(random::uniform_float_from_bits(0), 0.0f);
+	EXPECT_LT(random::uniform_float_from_bits(~0u), 1.0f);
+	EXPECT_EQ(random::uniform_double_from_bits(0), 0.0);
+	EXPECT_LT(random::uniform_double_from_bits(~0ULL), 1.0);
+}
+
+TEST(random_seq, squirrel_fill_matches_squirrel_noise)
+{
+	std::vector<uint32_t> values(70001);
+	random::squirrel_fill(0xB00B1E5, -1000, std::span{ values }, 2);
+	for (size_t i = 0; i < values.size(); ++i)
+		ASSERT_EQ(values[i], noise::SquirrelNoise5(0xB00B1E5, int32_t(i) - 1000)) << i;
+
+	std::vector<uint32_t> wrapping(20);
+	random::squirrel_fill(1, std::numeric_limits<int32_t>::max() - 9, std::span{ wrapping });
+	EXPECT_EQ(wrapping[10], noise::SquirrelNoise5(1, std::numeric_limits<int32_t>::min()));
+}
+
+TEST(random_seq, philox64_engine_fills_and_substreams)
+{
+	random::philox64_engine engine{ 10, 20 };
+	random::philox64_engine reference{ 10, 20 };
+
+	std::vector<uint64_t> values(37);
+	engine.fill(std::span{ values });
+	for (auto value : values)
+		EXPECT_EQ(value, reference());
+	EXPECT_EQ(engine(), reference());
+
+	std::vector<float> floats(5);
+	engine.fill_uniform(std::span{ floats });
+	const auto bits = reference();
+	EXPECT_EQ(floats[0], random::uniform_float_from_bits(uint32_t(bits)));
+	EXPECT_EQ(floats[1], random::uniform_float_from_bits(uint32_t(bits >> 32)));
+	reference.discard(2);
+	EXPECT_EQ(engine(), reference());
+
+	std::vector<double> doubles(3);
+	engine.fill_uniform(std::span{ doubles });
+	EXPECT_EQ(doubles[2], (reference.discard(2), random::uniform_double_from_bits(reference())));
+
+	auto first = engine.substream(0, 1000);
+	auto second = engine.substream(1, 1000);
+	auto skipped = first;
+	skipped.discard(1000);
+	EXPECT_EQ(second.key(), engine.key());
+	EXPECT_EQ(second(), skipped());
+	EXPECT_NE(first(), second());
+}
+
+TEST(random_seq, parallel_shuffle_gives_uniform_permutations)
+{
+	/// Blocks of a single value exercise every level of merges
+	std::array<int, 24> counts{};
+	for (uint64_t seed = 0; seed < 48000; ++seed)
+	{
+		std::array<int, 4> values{ 0, 1, 2, 3 };
+		random::detail::MergeShuffle(std::span<int>{ values }, seed, 1, 1);
+		int permutation_index = 0;
+		for (int i = 0; i < 4; ++i)
+			permutation_index = permutation_index * (4 - i) + int(std::count_if(values.begin() + i + 1, values.end(), [&](int v) { return v < values[i]; }));
+		++counts[permutation_index];
+	}
+	for (size_t i = 0; i < counts.size(); ++i)
+		EXPECT_NEAR(counts[i], 2000, 200) << i;
+
+	std::vector<uint32_t> large(size_t(1) << 19);
+	std::iota(large.begin(), large.end(), 0u);
+	auto single_threaded = large;
+	random::xoshiro256pp_engine rng{ 5 };
+	auto rng_copy = rng;
+	random::parallel_shuffle(large, rng, 4);
+	random::parallel_shuffle(single_threaded, rng_copy, 1);
+	EXPECT_EQ(large, single_threaded);
+
+	size_t fixed_points = 0;
+	for (size_t i = 0; i < large.size(); ++i)
+		fixed_points += large[i] == i;
+	EXPECT_LT(fixed_points, 10);
+	std::ranges::sort(large);
+	for (size_t i = 0; i < large.size(); ++i)
+		ASSERT_EQ(large[i], i);
+}
+
+TEST(random_seq, DISABLED_benchmark_sampling)
+{
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	std::vector<double> weights(256);
+	for (size_t i = 0; i < weights.size(); ++i)
+		weights[i] = double(i % 17 + 1);
+	random::xoshiro256pp_engine rng{ 1 };
+	constexpr size_t picks = 1 << 22;
+	size_t sum = 0;
+	const auto linear_time = time([&] {
+		for (size_t i = 0; i < picks / 64; ++i)
+			sum += random::option_with_probability(std::span<double const>{ weights }, rng);
+	}) * 64;
+	const random::alias_table table{ weights };
+	const auto alias_time = time([&] {
+		for (size_t i = 0; i < picks; ++i)
+			sum += table(rng);
+	});
+
+	std::vector<uint32_t> values(size_t(1) << 24);
+	std::iota(values.begin(), values.end(), 0u);
+	const auto std_shuffle_time = time([&] { std::shuffle(values.begin(), values.end(), rng); });
+	const auto shuffle_time = time([&] { random::shuffle(values, rng); });
+	const auto parallel_time = time([&] { random::parallel_shuffle(values, rng); });
+
+	std::cout << "weighted picks: option_with_probability " << double(picks) / 1e6 / linear_time << "M/s, alias_table " << double(picks) / 1e6 / alias_time
+		<< "M/s (" << sum << ")\nshuffling 16M values: std::shuffle " << std_shuffle_time << "s, random::shuffle " << shuffle_time << "s, parallel_shuffle " << parallel_time << "s\n";
+}
+
+TEST(random_seq, DISABLED_benchmark_bulk_fills)
+{
+	const size_t count = size_t(1) << 24;
+	std::vector<uint64_t> values(count);
+	std::vector<float> floats(count);
+
+	const auto time = [](auto&& func) {
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	const auto scalar_time = time([&] {
+		for (size_t i = 0; i < count; ++i)
+			values[i] = random::philox64(i, 1);
+	});
+	const auto fill_time = time([&] { random::philox_fill(1, 0, std::span{ values }, 1); });
+	const auto threaded_time = time([&] { random::philox_fill(1, 0, std::span{ values }); });
+	const auto float_time = time([&] { random::fill_uniform_float(1, 0, std::span{ floats }, 1); });
+
+	const auto millions = double(count) / 1e6;
+	std::cout << "philox64: scalar " << millions / scalar_time << "M/s, philox_fill " << millions / fill_time << "M/s on one thread, "
+		<< millions / threaded_time << "M/s on all threads; fill_uniform_float " << millions / float_time << "M floats/s (" << values[12345] + uint64_t(floats[54321]) << ")\n";
+}
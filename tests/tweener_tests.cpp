@@ -5,3 +5,191 @@
 #include "../include/ghassanpl/tweener.h"
 
 #include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+using namespace ghassanpl;
+
+TEST(easings, start_at_0_and_end_at_1)
+{
+	for (size_t curve = 0; curve < easing_count; ++curve)
+	{
+		EXPECT_NEAR(ease(easing(curve), 0.0f), 0.0f, 1e-6f) << curve;
+		EXPECT_EQ(ease(easing(curve), 1.0f), 1.0f) << curve;
+		EXPECT_NEAR(ease(easing(curve), 1.0), 1.0, 1e-12) << curve;
+	}
+
+	EXPECT_FLOAT_EQ(ease(easing::in_quad, 0.5f), 0.25f);
+	EXPECT_FLOAT_EQ(ease(easing::out_cubic, 0.5f), 0.875f);
+	EXPECT_FLOAT_EQ(ease(easing::in_out_sine, 0.5f), 0.5f);
+	EXPECT_LT(ease(easing::in_back, 0.2f), 0.0f);
+	EXPECT_GT(ease(easing::out_back, 0.8f), 1.0f);
+	static_assert(easings::in_out_bounce(0.5) == 0.5);
+}
+
+TEST(easings, span_evaluation_matches_scalar)
+{
+	/// 1001 samples, so every curve goes through both the vectorized loop and the remainder
+	std::vector<float> t(1001);
+	for (size_t i = 0; i < t.size(); ++i)
+		t[i] = float(i) / 1000.0f;
+	std::vector<float> out(t.size());
+	for (size_t curve = 0; curve < easing_count; ++curve)
+	{
+		ease(easing(curve), std::span<float const>{ t }, std::span<float>{ out });
+		for (size_t i = 0; i < t.size(); ++i)
+			ASSERT_NEAR(out[i], ease(easing(curve), t[i]), 1e-6f) << curve << " " << i;
+		EXPECT_EQ(out.front(), 0.0f) << curve;
+		EXPECT_EQ(out.back(), 1.0f) << curve;
+	}
+
+	std::vector<double> t_double(t.begin(), t.end());
+	std::vector<double> out_double(t.size());
+	ease(easing::in_out_elastic, std::span<double const>{ t_double }, std::span<double>{ out_double });
+	for (size_t i = 0; i < t.size(); ++i)
+		ASSERT_NEAR(out_double[i], ease(easing::in_out_elastic, t_double[i]), 1e-12) << i;
+	std::vector<float> too_small(t.size() - 1);
+	EXPECT_THROW(ease(easing::linear, std::span<float const>{ t }, std::span<float>{ too_small }), std::invalid_argument);
+}
+
+TEST(tweening_system, animates_values_and_ends_exactly)
+{
+	tweening_system tweens;
+	float value = 2;
+	glm::vec2 position{ 0, 10 };
+	glm::vec4 color{ 1, 0, 0, 1 };
+
+	tweens.tween(value, 4.0f, 1.0f);
+	const auto position_tween = tweens.tween(position, glm::vec2{ 10, 0 }, 2.0f, { .curve = easing::in_quad });
+	tweens.tween(color, glm::vec4{ 0, 0, 1, 0.5f }, 0.5f, { .delay = 0.5f });
+	EXPECT_EQ(tweens.active_count(), 3);
+
+	tweens.update(0.5f);
+	EXPECT_FLOAT_EQ(value, 3.0f);
+	EXPECT_FLOAT_EQ(position.x, 10 * 0.0625f);
+	EXPECT_FLOAT_EQ(position.y, 10 - 10 * 0.0625f);
+	EXPECT_EQ(color, glm::vec4(1, 0, 0, 1));
+
+	tweens.update(0.25f);
+	EXPECT_FLOAT_EQ(color.x, 0.5f);
+	EXPECT_FLOAT_EQ(color.w, 0.75f);
+
+	tweens.update(0.35f);
+	EXPECT_EQ(value, 4.0f);
+	EXPECT_EQ(color, glm::vec4(0, 0, 1, 0.5f));
+	EXPECT_EQ(tweens.finished().size(), 2);
+	EXPECT_EQ(tweens.active_count(), 1);
+	EXPECT_TRUE(tweens.is_active(position_tween));
+
+	tweens.update(5.0f);
+	EXPECT_EQ(position, glm::vec2(10, 0));
+	EXPECT_FALSE(tweens.is_active(position_tween));
+	EXPECT_EQ(tweens.active_count(), 0);
+
+	EXPECT_THROW(tweens.tween(value, 1.0f, -1.0f), std::invalid_argument);
+}
+
+TEST(tweening_system, cancels_and_swap_removes)
+{
+	tweening_system tweens;
+	std::vector<float> values(5, 0.0f);
+	std::vector<tween_handle> handles;
+	for (auto& value : values)
+		handles.push_back(tweens.tween(value, 1.0f, 1.0f));
+
+	EXPECT_TRUE(tweens.cancel(handles[1]));
+	EXPECT_FALSE(tweens.cancel(handles[1]));
+	EXPECT_FALSE(tweens.is_active(handles[1]));
+
+	tweens.update(0.5f);
+	EXPECT_EQ(values, (std::vector<float>{ 0.5f, 0.0f, 0.5f, 0.5f, 0.5f }));
+
+	/// The cancelled tween's slot is reused, but its old handle stays inactive
+	float other = 0;
+	const auto reused = tweens.tween(other, 2.0f, 1.0f);
+	EXPECT_EQ(reused.slot, handles[1].slot);
+	EXPECT_FALSE(tweens.is_active(handles[1]));
+	EXPECT_TRUE(tweens.cancel(handles[4]));
+
+	tweens.update(0.5f);
+	EXPECT_EQ(values, (std::vector<float>{ 1.0f, 0.0f, 1.0f, 1.0f, 0.5f }));
+	EXPECT_EQ(other, 1.0f);
+
+	tweens.clear();
+	EXPECT_EQ(tweens.active_count(), 0);
+	tweens.update(1.0f);
+	EXPECT_EQ(other, 1.0f);
+}
+
+TEST(tweening_system, repeats_and_yoyos)
+{
+	tweening_system tweens;
+	float value = 0;
+	int finished = 0;
+	tweens.tween(value, 0.0f, 1.0f, 1.0f, { .repeat = 2, .flags = tween_flags::yoyo }, [&](tween_handle) { ++finished; });
+
+	tweens.update(0.75f);
+	EXPECT_FLOAT_EQ(value, 0.75f);
+	tweens.update(0.5f);
+	EXPECT_FLOAT_EQ(value, 0.75f); /// 0.25 of the way back
+	tweens.update(0.5f);
+	EXPECT_FLOAT_EQ(value, 0.25f);
+	tweens.update(0.5f);
+	EXPECT_FLOAT_EQ(value, 0.25f); /// forwards again
+	EXPECT_EQ(finished, 0);
+	tweens.update(0.75f);
+	EXPECT_EQ(value, 1.0f);
+	EXPECT_EQ(finished, 1);
+	EXPECT_EQ(tweens.active_count(), 0);
+}
+
+TEST(tweening_system, callbacks_are_batched_and_can_start_tweens)
+{
+	tweening_system tweens;
+	std::vector<float> values(4, 0.0f);
+	std::vector<tween_handle> order;
+	float chained = 0;
+	for (auto& value : values)
+	{
+		tweens.tween(value, 1.0f, 1.0f, {}, [&](tween_handle handle) {
+			order.push_back(handle);
+			/// All the tweens are written before any callback is called
+			EXPECT_EQ(values, std::vector<float>(4, 1.0f));
+			if (order.size() == 1)
+				tweens.tween(chained, 5.0f, 1.0f);
+		});
+	}
+
+	tweens.update(1.0f);
+	EXPECT_EQ(order.size(), 4);
+	EXPECT_EQ(std::vector<tween_handle>(tweens.finished().begin(), tweens.finished().end()), order);
+	EXPECT_EQ(tweens.active_count(), 1);
+	tweens.update(1.0f);
+	EXPECT_EQ(chained, 5.0f);
+	EXPECT_EQ(order.size(), 4);
+}
+
+TEST(tweening_system, DISABLED_benchmark_50k_properties)
+{
+	static constexpr size_t count = 50'000;
+	tweening_system tweens;
+	auto floats = std::make_unique<float[]>(count);
+	auto positions = std::make_unique<glm::vec2[]>(count);
+	auto colors = std::make_unique<glm::vec4[]>(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto curve = easing(i % easing_count);
+		tweens.tween(floats[i], 1.0f, 1000.0f, { .curve = curve });
+		tweens.tween(positions[i], glm::vec2{ 1, 2 }, 1000.0f, { .curve = curve });
+		tweens.tween(colors[i], glm::vec4{ 1, 0, 1, 1 }, 1000.0f, { .curve = curve });
+	}
+
+	constexpr int frames = 200;
+	const auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+		tweens.update(1.0f / 60.0f);
+	const auto time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+	std::cout << 3 * count << " tweens: " << time << " us/frame, " << time * 1000.0 / double(3 * count) << " ns/tween\n";
+}